@@ -0,0 +1,309 @@
+/**
+ * @file bench.hpp
+ * @author Dario Loi
+ * @brief Minimal in-tree micro-benchmark harness.
+ *
+ * @date 2026-10-17
+ *
+ * @copyright MIT License
+ *
+ * @details A tiny subset of the Google Benchmark interface, kept in-tree so that the
+ * benchmarks do not add any dependency to the repository. <br>
+ *
+ * Each benchmark is a function taking a `bench::state&` and looping over it, the harness
+ * picks the number of iterations so that every run lasts at least `--min_time` seconds.
+ * Results are printed to the console and, with `--json=<path>`, written in the same JSON
+ * schema as Google Benchmark so that its tooling (e.g. `compare.py`) can be used to
+ * track trends.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace bench {
+
+using clock = std::chrono::steady_clock;
+
+/**
+ * @brief Per-run state handed to every benchmark function.
+ *
+ * @details Iterate over it with a range-based for loop, everything inside the loop body is
+ * timed unless wrapped in `pause_timing()`/`resume_timing()`.
+ */
+class state {
+public:
+    state(std::int64_t range, std::uint64_t iterations) noexcept
+        : m_range { range }
+        , m_iterations { iterations }
+    {
+    }
+
+    // so that `for (auto _ : state)` does not trigger unused variable warnings.
+    struct [[maybe_unused]] value { };
+
+    struct iterator {
+        state* parent;
+        std::uint64_t remaining;
+
+        auto operator*() const noexcept -> value { return {}; }
+        auto operator++() noexcept -> iterator&
+        {
+            --remaining;
+            return *this;
+        }
+        auto operator!=(iterator const& /*end*/) noexcept -> bool
+        {
+            if (remaining == 0) {
+                parent->stop();
+                return false;
+            }
+            return true;
+        }
+    };
+
+    auto begin() noexcept -> iterator
+    {
+        m_elapsed = clock::duration::zero();
+        m_cpu_elapsed = 0;
+        start();
+        return { this, m_iterations };
+    }
+
+    auto end() noexcept -> iterator { return { this, 0 }; }
+
+    /**
+     * @brief Stop the timer, e.g. to exclude per-iteration setup from the measurement.
+     *
+     */
+    void pause_timing() noexcept { stop(); }
+
+    /**
+     * @brief Restart the timer after a call to pause_timing.
+     *
+     */
+    void resume_timing() noexcept { start(); }
+
+    /**
+     * @brief The size parameter the benchmark was registered with.
+     *
+     */
+    [[nodiscard]] auto range() const noexcept -> std::int64_t { return m_range; }
+
+    [[nodiscard]] auto iterations() const noexcept -> std::uint64_t { return m_iterations; }
+
+    /**
+     * @brief Report how many items each iteration processed, reported as items_per_second.
+     *
+     */
+    void set_items_processed(std::uint64_t items) noexcept { m_items = items; }
+
+    [[nodiscard]] auto items_processed() const noexcept -> std::uint64_t { return m_items; }
+    [[nodiscard]] auto elapsed() const noexcept -> clock::duration { return m_elapsed; }
+    [[nodiscard]] auto cpu_elapsed() const noexcept -> double { return m_cpu_elapsed; }
+
+    /**
+     * @brief Hook invoked right before the timer stops, used to wait for the GPU.
+     *
+     */
+    std::function<void()> on_stop;
+
+private:
+    void start() noexcept
+    {
+        if (m_running) {
+            return;
+        }
+        m_running = true;
+        m_start = clock::now();
+        m_cpu_start = std::clock();
+    }
+
+    void stop()
+    {
+        if (!m_running) {
+            return;
+        }
+        m_running = false;
+        if (on_stop) {
+            on_stop();
+        }
+        m_elapsed += clock::now() - m_start;
+        m_cpu_elapsed += static_cast<double>(std::clock() - m_cpu_start) / CLOCKS_PER_SEC;
+    }
+
+    std::int64_t m_range {};
+    std::uint64_t m_iterations {};
+    std::uint64_t m_items {};
+    clock::time_point m_start {};
+    std::clock_t m_cpu_start {};
+    clock::duration m_elapsed {};
+    double m_cpu_elapsed {};
+    bool m_running {};
+};
+
+struct benchmark {
+    std::string name;
+    std::function<void(state&)> function;
+    std::vector<std::int64_t> ranges;
+};
+
+struct result {
+    std::string name;
+    std::uint64_t iterations {};
+    double real_ns {};
+    double cpu_ns {};
+    double items_per_second {};
+};
+
+inline auto registry() -> std::vector<benchmark>&
+{
+    static std::vector<benchmark> benchmarks;
+    return benchmarks;
+}
+
+/**
+ * @brief Register a benchmark, run once for every value in `ranges`.
+ *
+ */
+inline void add(std::string name, std::function<void(state&)> function, std::vector<std::int64_t> ranges = { 0 })
+{
+    registry().push_back({ std::move(name), std::move(function), std::move(ranges) });
+}
+
+struct options {
+    double min_time { 0.2 };
+    std::string json_path;
+    std::string filter;
+    std::function<void()> sync;
+    std::vector<std::pair<std::string, std::string>> context;
+};
+
+inline auto parse_options(int argc, char** argv) -> options
+{
+    options opts;
+    for (int i = 1; i < argc; ++i) {
+        std::string_view const arg { argv[i] }; // NOLINT (pointer-arithmetic)
+        auto value_of = [&](std::string_view flag) -> std::string_view {
+            return arg.starts_with(flag) ? arg.substr(flag.size()) : std::string_view {};
+        };
+
+        if (auto json = value_of("--json="); !json.empty()) {
+            opts.json_path = json;
+        } else if (auto filter = value_of("--filter="); !filter.empty()) {
+            opts.filter = filter;
+        } else if (auto min_time = value_of("--min_time="); !min_time.empty()) {
+            opts.min_time = std::stod(std::string { min_time });
+        } else {
+            std::cerr << "usage: " << argv[0] << " [--json=<path>] [--filter=<substring>] [--min_time=<seconds>]\n"; // NOLINT
+        }
+    }
+    return opts;
+}
+
+inline auto run_one(benchmark const& bench, std::int64_t range, options const& opts) -> result
+{
+    using std::chrono::duration;
+
+    std::uint64_t iterations = 1;
+    while (true) {
+        state st { range, iterations };
+        st.on_stop = opts.sync;
+        bench.function(st);
+
+        double const seconds = duration<double>(st.elapsed()).count();
+        if (seconds >= opts.min_time || iterations >= (1ULL << 30U)) {
+            double const per_iter = seconds / static_cast<double>(iterations);
+            return { .name = bench.name + "/" + std::to_string(range),
+                .iterations = iterations,
+                .real_ns = per_iter * 1e9,
+                .cpu_ns = st.cpu_elapsed() / static_cast<double>(iterations) * 1e9,
+                .items_per_second = st.items_processed() == 0
+                    ? 0.0
+                    : static_cast<double>(st.items_processed() * iterations) / seconds };
+        }
+
+        // aim slightly past the minimum time, growing at most 10x per attempt.
+        double const scale = seconds <= 0.0 ? 10.0 : std::min(10.0, 1.4 * opts.min_time / seconds);
+        iterations = std::max(iterations + 1, static_cast<std::uint64_t>(static_cast<double>(iterations) * scale));
+    }
+}
+
+inline void write_json(std::ostream& out, std::vector<result> const& results, options const& opts)
+{
+    auto const now = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+    std::array<char, 32> date {};
+    std::strftime(date.data(), date.size(), "%Y-%m-%dT%H:%M:%S", std::localtime(&now)); // NOLINT (concurrency-mt-unsafe)
+
+    out << "{\n  \"context\": {\n    \"date\": \"" << date.data() << "\",\n"
+        << "    \"num_cpus\": " << std::thread::hardware_concurrency() << ",\n"
+        << "    \"library_build_type\": \"staplegl-bench\"";
+    for (auto const& [key, value] : opts.context) {
+        out << ",\n    \"" << key << "\": \"" << value << '"';
+    }
+    out << "\n  },\n  \"benchmarks\": [";
+
+    for (bool first = true; auto const& res : results) {
+        out << (first ? "\n" : ",\n");
+        first = false;
+        out << "    {\"name\": \"" << res.name << "\", \"run_name\": \"" << res.name
+            << "\", \"run_type\": \"iteration\", \"iterations\": " << res.iterations
+            << ", \"real_time\": " << res.real_ns << ", \"cpu_time\": " << res.cpu_ns
+            << ", \"time_unit\": \"ns\"";
+        if (res.items_per_second > 0.0) {
+            out << ", \"items_per_second\": " << res.items_per_second;
+        }
+        out << '}';
+    }
+    out << "\n  ]\n}\n";
+}
+
+/**
+ * @brief Run every registered benchmark matching the filter.
+ *
+ * @return int the process exit code.
+ */
+inline auto run_all(options const& opts) -> int
+{
+    std::vector<result> results;
+
+    std::printf("%-48s %14s %14s %12s\n", "Benchmark", "Time (ns)", "CPU (ns)", "Iterations"); // NOLINT
+    for (auto const& bench : registry()) {
+        for (auto const range : bench.ranges) {
+            std::string const full_name = bench.name + "/" + std::to_string(range);
+            if (!opts.filter.empty() && full_name.find(opts.filter) == std::string::npos) {
+                continue;
+            }
+
+            auto const res = run_one(bench, range, opts);
+            std::printf("%-48s %14.1f %14.1f %12llu\n", res.name.c_str(), res.real_ns, res.cpu_ns, // NOLINT
+                static_cast<unsigned long long>(res.iterations));
+            results.push_back(res);
+        }
+    }
+
+    if (!opts.json_path.empty()) {
+        std::ofstream out { opts.json_path };
+        if (!out.is_open()) {
+            std::cerr << "could not open " << opts.json_path << " for writing\n";
+            return 1;
+        }
+        write_json(out, results, opts);
+    }
+
+    return 0;
+}
+
+} // namespace bench
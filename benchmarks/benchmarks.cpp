@@ -0,0 +1,554 @@
+/**
+ * @file benchmarks.cpp
+ * @author Dario Loi
+ * @brief Micro-benchmarks for the staplegl hot paths.
+ *
+ * @date 2026-10-17
+ *
+ * @copyright MIT License
+ *
+ * @details Runs headless on an EGL surfaceless context, see headless_context.hpp. <br>
+ *
+ * When built with `STAPLEGL_INSTRUMENT` (the `benchmarks_mock` target) the calls are swallowed
+ * by staplegl::instrument::mock_gl instead, measuring the CPU-side cost of the wrappers in
+ * isolation, without a context. <br>
+ *
+ * Usage: `benchmarks [--json=results.json] [--filter=add_instance] [--min_time=0.5]`,
+ * the JSON output follows the Google Benchmark schema.
+ */
+
+#include "bench.hpp"
+
+#include "staplegl.hpp"
+
+#ifdef STAPLEGL_INSTRUMENT
+#include "gl_recorder.hpp"
+#else
+#include "headless_context.hpp"
+#endif // STAPLEGL_INSTRUMENT
+
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace {
+
+using namespace staplegl::shader_data_type;
+
+// a model matrix and a color per instance, like in batches.cpp.
+auto instance_layout() -> staplegl::vertex_buffer_layout
+{
+    return { { u_type::mat4, "instance_model" }, { u_type::vec4, "instance_color" } };
+}
+
+constexpr std::size_t instance_floats = 20;
+
+void add_instance(bench::state& state)
+{
+    auto const instances = static_cast<std::size_t>(state.range());
+    std::array<float, instance_floats> const instance {};
+
+    for (auto _ : state) {
+        state.pause_timing();
+        staplegl::vertex_buffer_inst vbo { {}, instance_layout() };
+        state.resume_timing();
+
+        for (std::size_t i = 0; i < instances; ++i) {
+            vbo.add_instance(instance);
+        }
+
+        state.pause_timing(); // exclude the buffer deletion
+    }
+
+    state.set_items_processed(instances);
+}
+
+void resize_buffer(bench::state& state)
+{
+    auto const instances = static_cast<std::size_t>(state.range());
+    std::array<float, instance_floats> const instance {};
+
+    for (auto _ : state) {
+        state.pause_timing();
+        staplegl::vertex_buffer_inst vbo { {}, instance_layout() };
+        vbo.add_instance(instance);
+        state.resume_timing();
+
+        // grows the buffer once, copying the existing contents through a temporary buffer.
+        vbo.reserve(instances);
+
+        state.pause_timing();
+    }
+
+    state.set_items_processed(instances);
+}
+
+auto uniform_block_layout(std::size_t uniforms) -> staplegl::vertex_buffer_layout
+{
+    std::vector<staplegl::vertex_attribute> attributes;
+    for (std::size_t i = 0; i < uniforms; ++i) {
+        attributes.emplace_back(u_type::vec4, "u_value" + std::to_string(i));
+    }
+    return staplegl::vertex_buffer_layout { std::move(attributes) };
+}
+
+void set_attribute_data_by_name(bench::state& state)
+{
+    auto const uniforms = static_cast<std::size_t>(state.range());
+    staplegl::uniform_buffer ubo { uniform_block_layout(uniforms), 0 };
+    ubo.bind();
+
+    std::vector<std::string> names;
+    for (std::size_t i = 0; i < uniforms; ++i) {
+        names.push_back("u_value" + std::to_string(i));
+    }
+
+    std::array<float, 4> const value { 1.0F, 2.0F, 3.0F, 4.0F };
+    for (auto _ : state) {
+        for (auto const& name : names) {
+            ubo.set_attribute_data(value, name);
+        }
+    }
+
+    state.set_items_processed(uniforms);
+}
+
+void set_attribute_data_by_index(bench::state& state)
+{
+    auto const uniforms = static_cast<std::size_t>(state.range());
+    staplegl::uniform_buffer ubo { uniform_block_layout(uniforms), 0 };
+    ubo.bind();
+
+    std::array<float, 4> const value { 1.0F, 2.0F, 3.0F, 4.0F };
+    for (auto _ : state) {
+        for (std::size_t i = 0; i < uniforms; ++i) {
+            ubo.set_attribute_data(value, i);
+        }
+    }
+
+    state.set_items_processed(uniforms);
+}
+
+auto shader_source(std::size_t uniforms) -> std::string
+{
+    std::string decls;
+    std::string sum { "vec4(0.0)" };
+    for (std::size_t i = 0; i < uniforms; ++i) {
+        decls += "uniform vec4 u_value" + std::to_string(i) + ";\n";
+        sum += " + u_value" + std::to_string(i);
+    }
+
+    return "#type vertex\n#version 330 core\nlayout (location = 0) in vec3 aPos;\n" + decls
+        + "void main() { gl_Position = vec4(aPos, 1.0) + " + sum + "; }\n"
+        + "#type fragment\n#version 330 core\nout vec4 FragColor;\n"
+          "void main() { FragColor = vec4(1.0); }\n";
+}
+
+void uniform_location(bench::state& state)
+{
+    auto const uniforms = static_cast<std::size_t>(state.range());
+
+    // shader programs are loaded from disk, go through a temporary file.
+    auto const path = std::filesystem::temp_directory_path() / "staplegl_bench_shader.glsl";
+    {
+        std::ofstream out { path };
+        out << shader_source(uniforms);
+    }
+
+    staplegl::shader_program program { "bench", path.string() };
+    std::filesystem::remove(path);
+
+    std::vector<std::string> names;
+    for (std::size_t i = 0; i < uniforms; ++i) {
+        names.push_back("u_value" + std::to_string(i));
+    }
+
+    int sink {};
+    for (auto _ : state) {
+        for (auto const& name : names) {
+            sink += program.uniform_location(name);
+        }
+    }
+
+    if (sink == -1) {
+        std::printf(" "); // NOLINT (keep the lookups observable)
+    }
+    state.set_items_processed(uniforms);
+}
+
+void parse_shaders(bench::state& state)
+{
+    auto const lines = static_cast<std::size_t>(state.range());
+
+    // two shaders, half of the lines each.
+    std::string source { "#type vertex\n" };
+    for (std::size_t i = 0; i < lines / 2; ++i) {
+        source += "vec4 v" + std::to_string(i) + " = vec4(0.0);\n";
+    }
+    source += "#type fragment\n";
+    for (std::size_t i = 0; i < lines / 2; ++i) {
+        source += "vec4 f" + std::to_string(i) + " = vec4(1.0);\n";
+    }
+
+    std::size_t sink {};
+    for (auto _ : state) {
+        sink += staplegl::shader_program::parse_shaders(source).size();
+    }
+
+    if (sink == 0) {
+        std::printf(" "); // NOLINT (keep the parsing observable)
+    }
+    state.set_items_processed(lines);
+}
+
+// a scene of 8 programs, 64 meshes and 32 materials drawn in random order.
+auto random_packets(std::size_t count) -> std::vector<staplegl::draw_packet>
+{
+    std::mt19937 rng { 42 }; // NOLINT (fixed seed, reproducible runs)
+    std::vector<staplegl::draw_packet> packets(count);
+    for (auto& packet : packets) {
+        packet.program = rng() % 8 + 1;
+        packet.vertex_array = rng() % 64 + 1;
+        packet.texture_count = 1;
+        packet.textures[0].id = rng() % 32 + 1;
+        packet.count = 36;
+        packet.key = staplegl::make_sort_key(packet.program, packet.vertex_array, packet.textures[0].id,
+            std::uniform_real_distribution<float> {}(rng));
+    }
+    return packets;
+}
+
+void command_queue_sort(bench::state& state)
+{
+    auto const packets = random_packets(static_cast<std::size_t>(state.range()));
+    staplegl::command_queue queue;
+    queue.reserve(packets.size());
+
+    for (auto _ : state) {
+        state.pause_timing();
+        queue.clear();
+        for (auto const& packet : packets) {
+            queue.push(packet);
+        }
+        state.resume_timing();
+
+        queue.sort();
+    }
+
+    state.set_items_processed(packets.size());
+}
+
+// records 65536 draws, each with a 64-byte uniform buffer update, split across range() threads.
+void command_buffer_record(bench::state& state)
+{
+    constexpr std::size_t draws = 65536;
+    auto const threads = static_cast<std::size_t>(state.range());
+    auto packets = random_packets(draws);
+    for (std::size_t i = 0; i < draws; ++i) {
+        packets[i].uniforms = { .binding = 0, .buffer = 1, .offset = static_cast<std::uint32_t>(i * 64), .size = 64 };
+    }
+    std::vector<staplegl::command_buffer> buffers(threads);
+
+    for (auto _ : state) {
+        std::vector<std::thread> workers;
+        for (std::size_t worker = 0; worker < threads; ++worker) {
+            workers.emplace_back([&, worker] {
+                auto& buffer = buffers[worker];
+                buffer.reset();
+                for (std::size_t i = worker; i < draws; i += threads) {
+                    std::array<float, 16> transform {};
+                    transform.fill(static_cast<float>(i));
+                    buffer.draw(packets[i], std::span { transform });
+                }
+            });
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    }
+
+    state.set_items_processed(draws);
+}
+
+// creates range() objects per iteration, their destruction (hence retiring) is not timed.
+template <typename Object, bool Pooled>
+void create_objects(bench::state& state)
+{
+    auto const count = static_cast<std::size_t>(state.range());
+    std::array<float, 4> const vertex {};
+    std::vector<Object> objects;
+    objects.reserve(count);
+
+    staplegl::name_pools pools;
+    if constexpr (Pooled) {
+        staplegl::set_name_pools(&pools);
+    }
+
+    for (auto _ : state) {
+        for (std::size_t i = 0; i < count; ++i) {
+            if constexpr (std::is_same_v<Object, staplegl::vertex_buffer>) {
+                objects.emplace_back(std::span<const float> { vertex });
+            } else {
+                objects.emplace_back();
+            }
+        }
+
+        state.pause_timing();
+        objects.clear();
+        state.resume_timing();
+    }
+
+    staplegl::set_name_pools(nullptr);
+    state.set_items_processed(count);
+}
+
+// transforms the positions of range() instances, the GPU upload is not timed.
+template <bool Pooled>
+void instance_shadow_transform(bench::state& state)
+{
+    auto const instances = static_cast<std::size_t>(state.range());
+    staplegl::instance_shadow shadow { staplegl::vertex_buffer_layout { { u_type::vec3, "instance_pos" } } };
+    shadow.resize(instances);
+
+    std::array<float, 16> const matrix { 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0.5F, 0.25F, 0, 1 };
+    staplegl::thread_pool pool;
+
+    for (auto _ : state) {
+        shadow.transform(0, matrix, Pooled ? &pool : nullptr);
+    }
+
+    state.set_items_processed(instances);
+}
+
+// packs the transforms of range() instances into host memory, laid out like an instance buffer.
+template <staplegl::transform_format Format>
+void pack_transforms(bench::state& state)
+{
+    auto const instances = static_cast<std::size_t>(state.range());
+    std::vector<float> const ones(instances, 1.0F);
+    std::vector<float> const zeros(instances, 0.0F);
+    staplegl::trs_view const trs { { ones, zeros, ones }, { zeros, zeros, zeros, ones }, { ones, ones, ones } };
+
+    auto const stride = staplegl::transform_floats(Format);
+    std::vector<float> out(instances * stride);
+    staplegl::thread_pool pool;
+
+    for (auto _ : state) {
+        staplegl::pack_transforms(trs, Format, out, stride, 0, &pool);
+    }
+
+    state.set_items_processed(instances);
+}
+
+// range() instances scattered in a cube, about 2% of them inside a 90-degree frustum along +x.
+auto random_instance_bounds(std::size_t count) -> std::vector<staplegl::aabb>
+{
+    std::mt19937 rng { 42 }; // NOLINT (fixed seed, reproducible runs)
+    std::uniform_real_distribution<float> coordinate { -100.0F, 100.0F };
+
+    std::vector<staplegl::aabb> bounds(count);
+    for (auto& box : bounds) {
+        std::array<float, 3> const center { coordinate(rng), coordinate(rng), coordinate(rng) };
+        box = staplegl::aabb::around(center, 0.5F);
+    }
+    return bounds;
+}
+
+constexpr staplegl::frustum bench_frustum { { { { 1, -1, 0, 0 }, { 1, 1, 0, 0 }, { 1, 0, -1, 0 }, { 1, 0, 1, 0 },
+    { 1, 0, 0, -0.1F }, { -1, 0, 0, 50 } } } };
+
+void instance_bvh_cull(bench::state& state)
+{
+    staplegl::instance_bvh bvh { random_instance_bounds(static_cast<std::size_t>(state.range())) };
+    std::vector<std::uint32_t> visible;
+
+    for (auto _ : state) {
+        bvh.cull(bench_frustum, visible);
+    }
+
+    state.set_items_processed(bvh.size());
+}
+
+// moves 1% of range() instances, then culls, as in a frame.
+void instance_bvh_update(bench::state& state)
+{
+    auto const bounds = random_instance_bounds(static_cast<std::size_t>(state.range()));
+    staplegl::instance_bvh bvh { bounds };
+    std::vector<std::uint32_t> visible;
+    auto const moved = std::max<std::size_t>(bounds.size() / 100, 1);
+    std::size_t next {};
+
+    for (auto _ : state) {
+        for (std::size_t i = 0; i < moved; ++i, next = (next + 7919) % bounds.size()) { // NOLINT (a prime stride)
+            auto box = bounds[next];
+            box.min[0] += 0.25F;
+            box.max[0] += 0.25F;
+            bvh.update(static_cast<std::int32_t>(next), box);
+        }
+        bvh.cull(bench_frustum, visible);
+    }
+
+    state.set_items_processed(bvh.size());
+}
+
+// buckets range() instances scattered around the camera into three levels of detail.
+void lod_assign(bench::state& state)
+{
+    auto const bounds = random_instance_bounds(static_cast<std::size_t>(state.range()));
+    std::array<std::vector<float>, 3> positions;
+    for (std::size_t axis = 0; axis < 3; ++axis) {
+        for (auto const& box : bounds) {
+            positions[axis].push_back(box.centroid(axis));
+        }
+    }
+
+    staplegl::lod_mesh mesh;
+    mesh.add_level(0, 36864, 64.0F); // NOLINT (arbitrary index ranges)
+    mesh.add_level(36864, 9216, 16.0F); // NOLINT
+    mesh.add_level(46080, 2304, 0.0F); // NOLINT
+
+    staplegl::lod_view const view { {}, staplegl::lod_view::projection_scale(1.0F, 1080.0F) };
+    staplegl::lod_buckets buckets;
+
+    for (auto _ : state) {
+        buckets.assign(mesh, view, { positions[0], positions[1], positions[2] }, 0.5F);
+    }
+
+    state.set_items_processed(bounds.size());
+}
+
+// encodes a range() x range() RGBA picture (a gradient with some noise, about as compressible as
+// a render) to a file in memory, as image_writer does on its workers: 8 bits per channel for
+// PNG, float for EXR.
+template <staplegl::image_format Format>
+void encode_image(bench::state& state)
+{
+    constexpr bool is_float = Format == staplegl::image_format::exr;
+    constexpr staplegl::readback_format pixel_format { .format = GL_RGBA, .datatype = is_float ? GL_FLOAT : GL_UNSIGNED_BYTE };
+
+    auto const side = static_cast<std::int32_t>(state.range());
+    auto const channels = static_cast<std::size_t>(side) * static_cast<std::size_t>(side) * 4;
+    std::vector<std::byte> pixels(channels * pixel_format.pixel_size() / 4);
+
+    std::mt19937 rng { 42 }; // NOLINT (cert-msc32-c)
+    for (std::size_t i = 0; i < channels; ++i) {
+        auto const pixel = i / 4;
+        auto const x = pixel % static_cast<std::size_t>(side);
+        auto const y = pixel / static_cast<std::size_t>(side);
+        auto const value = static_cast<std::uint8_t>((x + y * (i % 4 + 1) + (rng() & 3U)) & 0xFFU); // NOLINT (arbitrary pattern)
+
+        if constexpr (is_float) {
+            auto const channel = static_cast<float>(value) / 255.0F;
+            std::memcpy(&pixels[i * sizeof(float)], &channel, sizeof(float));
+        } else {
+            pixels[i] = static_cast<std::byte>(value);
+        }
+    }
+
+    std::vector<std::byte> file;
+    for (auto _ : state) {
+        if (!staplegl::encode_image(Format, { side, side }, pixel_format, pixels, file)) {
+            return;
+        }
+    }
+
+    state.set_items_processed(channels / 4);
+}
+
+// clears a range() x range() render target and reads it back, as an offline renderer does every
+// frame: with glReadPixels into client memory, or through the pixel buffers of async_readback.
+template <bool Async>
+void readback(bench::state& state)
+{
+    auto const side = static_cast<std::int32_t>(state.range());
+    staplegl::texture_2d const color {
+        std::span<const std::uint8_t> {}, { side, side },
+        staplegl::texture_color { .internal_format = GL_RGBA8, .format = GL_RGBA, .datatype = GL_UNSIGNED_BYTE },
+        staplegl::texture_filter { .min_filter = GL_NEAREST, .mag_filter = GL_NEAREST, .clamping = GL_CLAMP_TO_EDGE }
+    };
+    staplegl::framebuffer fbo;
+    fbo.bind();
+    fbo.set_texture(color);
+    staplegl::framebuffer::set_viewport({ side, side });
+
+    std::vector<std::byte> pixels(static_cast<std::size_t>(side) * static_cast<std::size_t>(side) * 4);
+    staplegl::async_readback readback;
+    auto const sink = [&pixels](std::uint64_t /*tag*/, staplegl::readback_region const& /*region*/, std::span<const std::byte> data) {
+        std::copy(data.begin(), data.end(), pixels.begin());
+    };
+
+    std::uint64_t frame {};
+    for (auto _ : state) {
+        glClearColor(static_cast<float>(frame % 256) / 255.0F, 0.5F, 0.5F, 1.0F); // NOLINT (arbitrary color)
+        glClear(GL_COLOR_BUFFER_BIT);
+
+        if constexpr (Async) {
+            readback.read({ 0, 0, side, side }, frame, sink);
+            readback.poll(sink);
+        } else {
+            glPixelStorei(GL_PACK_ALIGNMENT, 1);
+            glReadPixels(0, 0, side, side, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+        }
+        ++frame;
+    }
+    readback.drain(sink);
+
+    staplegl::framebuffer::bind_default();
+    state.set_items_processed(pixels.size() / 4);
+}
+
+} // namespace
+
+auto main(int argc, char** argv) -> int
+{
+    auto opts = bench::parse_options(argc, argv);
+
+#ifdef STAPLEGL_INSTRUMENT
+    staplegl::instrument::mock_gl mock { false }; // no log, it would grow for the whole run
+    staplegl::instrument::scoped_backend const guard { mock };
+    opts.context.emplace_back("gl_renderer", "staplegl mock");
+#else
+    staplegl::headless_context const context;
+    if (!context.is_valid()) {
+        std::fprintf(stderr, "bench: could not create a headless OpenGL context\n");
+        return 1;
+    }
+
+    opts.sync = [] { glFinish(); };
+    opts.context.emplace_back("gl_renderer", staplegl::headless_context::renderer());
+#endif // STAPLEGL_INSTRUMENT
+
+    bench::add("add_instance", add_instance, { 64, 1024, 16384 });
+    bench::add("resize_buffer", resize_buffer, { 1024, 16384, 262144 });
+    bench::add("set_attribute_data/name", set_attribute_data_by_name, { 4, 16, 64 });
+    bench::add("set_attribute_data/index", set_attribute_data_by_index, { 4, 16, 64 });
+    bench::add("uniform_location", uniform_location, { 4, 16, 64 });
+    bench::add("parse_shaders", parse_shaders, { 16, 256, 4096 });
+    bench::add("command_queue_sort", command_queue_sort, { 1024, 16384, 262144 });
+    bench::add("command_buffer_record", command_buffer_record, { 1, 2, 4, 8 });
+    bench::add("create_buffers/direct", create_objects<staplegl::vertex_buffer, false>, { 1024, 16384 });
+    bench::add("create_buffers/pooled", create_objects<staplegl::vertex_buffer, true>, { 1024, 16384 });
+    bench::add("create_vertex_arrays/direct", create_objects<staplegl::vertex_array, false>, { 1024, 16384 });
+    bench::add("create_vertex_arrays/pooled", create_objects<staplegl::vertex_array, true>, { 1024, 16384 });
+    bench::add("instance_shadow_transform/serial", instance_shadow_transform<false>, { 16384, 262144, 1048576 });
+    bench::add("instance_shadow_transform/pooled", instance_shadow_transform<true>, { 16384, 262144, 1048576 });
+    bench::add("pack_transforms/mat4", pack_transforms<staplegl::transform_format::mat4>, { 10000, 100000, 1000000 });
+    bench::add("pack_transforms/affine_rows", pack_transforms<staplegl::transform_format::affine_rows>, { 10000, 100000, 1000000 });
+    bench::add("instance_bvh_cull", instance_bvh_cull, { 10000, 100000, 1000000 });
+    bench::add("instance_bvh_update", instance_bvh_update, { 10000, 100000, 1000000 });
+    bench::add("lod_assign", lod_assign, { 10000, 100000, 1000000 });
+    bench::add("encode_image/png", encode_image<staplegl::image_format::png>, { 256, 1024 });
+    bench::add("encode_image/exr", encode_image<staplegl::image_format::exr>, { 256, 1024 });
+    bench::add("readback/sync", readback<false>, { 256, 1024, 2048 });
+    bench::add("readback/async", readback<true>, { 256, 1024, 2048 });
+
+    return bench::run_all(opts);
+}
@@ -13,12 +13,13 @@
 #include "staplegl.hpp"
 
 #include <GLFW/glfw3.h>
+#include <algorithm>
 #include <array>
 #include <cmath>
+#include <cstddef>
 #include <cstdint>
 #include <cstdio>
 #include <ctime>
-#include <execution>
 #include <iostream>
 #include <optional>
 #include <span>
@@ -37,12 +38,6 @@ constexpr auto lerp(float a, float b, float f) -> float
     return a * (1.0F - f) + b * f;
 }
 
-struct vec3 {
-    float x;
-    float y;
-    float z;
-};
-
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void processInput(GLFWwindow* window);
 
@@ -170,6 +165,13 @@ auto main() -> int
     std::srand(static_cast<unsigned int>(std::time(nullptr)));
     constexpr int32_t NUM_INSTANCES = 65535;
 
+    // the instances are kept on the CPU too, one array per component, so that updating them never
+    // reads the GPU's copy back and runs on every core, with SIMD.
+    staplegl::instance_shadow shadow { instance_layout };
+    auto const position = shadow.index_of("instancePos");
+    auto const home = shadow.add_host_attribute(u_type::vec3, "home");
+    auto const target = shadow.add_host_attribute(u_type::vec3, "target");
+
     for (int i = 0; i < NUM_INSTANCES; i++) {
         std::array<float, 3> offset = {
             lerp(START, END,
@@ -182,7 +184,20 @@ auto main() -> int
 
         // I know the instance is set since it is in the optional, so I go for direct access
         VAO.instanced_data()->add_instance(offset);
+        shadow.push_instance(offset);
+    }
+
+    // every instance sways between its starting position and a random spot to its left or right
+    for (std::size_t c = 0; c < 3; ++c) {
+        auto const start = shadow.component(position, c);
+        std::copy(start.begin(), start.end(), shadow.component(home, c).begin());
+        std::copy(start.begin(), start.end(), shadow.component(target, c).begin());
     }
+    for (float& x : shadow.component(target, 0)) {
+        x += ((static_cast<float>(std::rand()) / static_cast<float>(RAND_MAX)) - 0.5F) / 20.0F;
+    }
+
+    staplegl::thread_pool pool;
 
     while (glfwWindowShouldClose(window) == 0) {
 
@@ -202,27 +217,11 @@ auto main() -> int
             UBO_block.set_attribute_data(std::span { &color[i], 1 }, "u_color", i);
         }
 
-// define a struct for the instance data
-#pragma pack(push, 1)
-        struct vec3 {
-            float x;
-            float y;
-            float z;
-        };
-#pragma pack(pop)
-
-        static_assert(sizeof(vec3) == 3 * sizeof(float));
-
-        // apply a lambda to the instance data, reading it as a span of vec3
-        VAO.instanced_data()->apply<vec3>(
-            [](std::span<vec3> data) {
-                // thanks to std::span, we can pass this GPU buffer to a parallel algorithm!
-                std::for_each(std::execution::par_unseq, data.begin(), data.end(),
-                    [](vec3& v) { // randomly shift the position of the instance left or right
-                        const float speed = ((static_cast<float>(std::rand()) / static_cast<float>(RAND_MAX)) - 0.5F) / 1000.0F;
-                        v.x += speed;
-                    });
-            });
+        shadow.lerp(position, home, target, std::sin(timeNow) / 2.0F + 0.5F, &pool);
+
+        // then stream them to the instance buffer: the old storage is orphaned and the new one
+        // is mapped write-only, so neither a readback nor a wait for the previous frame happens.
+        shadow.upload(*VAO.instanced_data());
 
         // draw the instances
         glDrawElementsInstanced(GL_TRIANGLES, VAO.index_data().count(), GL_UNSIGNED_INT, nullptr,
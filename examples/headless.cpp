@@ -0,0 +1,202 @@
+/**
+ * @file headless.cpp
+ * @author Dario Loi
+ * @brief Offscreen rendering example, without a window.
+ * @date 2026-10-17
+ *
+ * @copyright MIT License
+ *
+ * @details Renders the instances of batches.cpp into a framebuffer object on a headless EGL
+ * context (Mesa's llvmpipe is enough), reports the throughput, and writes the last frame to a
+ * binary PPM file. <br>
+ *
+ * Usage: `headless [--frames=<n>] [--width=<w>] [--height=<h>] [--out=<file.ppm>]`
+ *
+ * The throughput is reported both in frames per second and in frames per CPU second, the latter
+ * being the number of frames a single core renders in a second: llvmpipe rasterizes on every
+ * core, so it is the figure to size a farm of renderers by.
+ *
+ * @example headless.cpp
+ */
+
+#include "headless_context.hpp"
+#include "staplegl.hpp"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <random>
+#include <span>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace {
+
+/**
+ * @brief Write RGBA8 pixels, as read back by glReadPixels (bottom row first), to a binary PPM.
+ *
+ */
+auto write_ppm(const char* path, std::span<const std::uint8_t> pixels, std::int32_t width, std::int32_t height) -> bool
+{
+    std::FILE* file = std::fopen(path, "wb"); // NOLINT (owning-memory)
+    if (file == nullptr) {
+        return false;
+    }
+
+    std::fprintf(file, "P6\n%d %d\n255\n", width, height); // NOLINT (vararg)
+
+    std::vector<std::uint8_t> row(static_cast<std::size_t>(width) * 3);
+    for (std::int32_t y = height - 1; y >= 0; --y) {
+        auto const* src = pixels.data() + static_cast<std::size_t>(y) * static_cast<std::size_t>(width) * 4;
+        for (std::size_t x = 0; x < static_cast<std::size_t>(width); ++x) {
+            row[x * 3 + 0] = src[x * 4 + 0];
+            row[x * 3 + 1] = src[x * 4 + 1];
+            row[x * 3 + 2] = src[x * 4 + 2];
+        }
+        std::fwrite(row.data(), 1, row.size(), file);
+    }
+
+    return std::fclose(file) == 0; // NOLINT (owning-memory)
+}
+
+} // namespace
+
+auto main(int argc, char** argv) -> int
+{
+    std::int32_t frames = 240;
+    std::int32_t width = 640;
+    std::int32_t height = 360;
+    const char* output = "headless.ppm";
+
+    for (auto const* arg : std::span { argv, static_cast<std::size_t>(argc) }.subspan(1)) {
+        std::string_view const option { arg };
+        auto const value = [&option](std::string_view prefix) { return option.substr(prefix.size()); };
+
+        if (option.starts_with("--frames=")) {
+            frames = std::max(std::atoi(value("--frames=").data()), 1);
+        } else if (option.starts_with("--width=")) {
+            width = std::max(std::atoi(value("--width=").data()), 1);
+        } else if (option.starts_with("--height=")) {
+            height = std::max(std::atoi(value("--height=").data()), 1);
+        } else if (option.starts_with("--out=")) {
+            output = value("--out=").data();
+        } else {
+            std::fprintf(stderr, "usage: headless [--frames=<n>] [--width=<w>] [--height=<h>] [--out=<file.ppm>]\n");
+            return 1;
+        }
+    }
+
+    staplegl::headless_context const context;
+    if (!context.is_valid()) {
+        std::fprintf(stderr, "could not create a headless OpenGL context\n");
+        return 1;
+    }
+
+    // the render target: a color texture and a depth-stencil renderbuffer.
+    staplegl::resolution const res { width, height };
+    staplegl::texture_2d const color_target {
+        std::span<const std::uint8_t> {},
+        res,
+        staplegl::texture_color {
+            .internal_format = GL_RGBA8, .format = GL_RGBA, .datatype = GL_UNSIGNED_BYTE },
+        staplegl::texture_filter {
+            .min_filter = GL_LINEAR, .mag_filter = GL_LINEAR, .clamping = GL_CLAMP_TO_EDGE }
+    };
+
+    staplegl::framebuffer fbo;
+    fbo.bind();
+    fbo.set_texture(color_target);
+    fbo.set_renderbuffer(res);
+    if (!fbo.assert_completeness()) [[unlikely]] {
+        std::fprintf(stderr, "framebuffer not complete\n");
+        return 1;
+    }
+    staplegl::framebuffer::set_viewport(res);
+
+    staplegl::shader_program const basic { "batched_shader", "./shaders/batched_shader.glsl" };
+    basic.bind();
+
+    const std::array<const float, 12> vertices {
+        0.004F, 0.004F, 0.0F,
+        0.004F, -0.004F, 0.0F,
+        -0.004F, -0.004F, 0.0F,
+        -0.004F, 0.004F, 0.0F,
+    };
+
+    const std::array<const unsigned int, 6> indices { 0, 1, 3, 1, 2, 3 };
+
+    using namespace staplegl::shader_data_type;
+
+    staplegl::vertex_buffer_layout const layout { { u_type::vec3, "aPos" } };
+    staplegl::vertex_buffer_layout const instance_layout { { u_type::vec3, "instancePos" } };
+
+    staplegl::vertex_buffer VBO { vertices, staplegl::driver_draw_hint::STATIC_DRAW };
+    staplegl::vertex_buffer_inst VBO_inst { {} };
+    VBO.set_layout(layout);
+    VBO_inst.set_layout(instance_layout);
+
+    staplegl::vertex_array VAO;
+    VAO.add_vertex_buffer(std::move(VBO));
+    VAO.set_instance_buffer(std::move(VBO_inst));
+    VAO.set_index_buffer(staplegl::index_buffer { indices });
+    VAO.bind();
+
+    staplegl::uniform_buffer UBO_block { staplegl::vertex_buffer_layout { { shader_array_type::float32_arr, "u_color", 4 } }, 1 };
+    UBO_block.bind();
+
+    constexpr std::int32_t NUM_INSTANCES = 16384;
+
+    std::mt19937 rng { 42 }; // NOLINT (cert-msc32-c), same picture on every run
+    std::uniform_real_distribution<float> xy { -0.95F, 0.95F };
+    std::uniform_real_distribution<float> z { 0.01F, 1.0F };
+    for (std::int32_t i = 0; i < NUM_INSTANCES; ++i) {
+        VAO.instanced_data()->add_instance(std::array { xy(rng), xy(rng), z(rng) });
+    }
+
+    auto const wall_begin = std::chrono::steady_clock::now();
+    auto const cpu_begin = std::clock();
+
+    std::array<float, 4> color {};
+    for (std::int32_t frame = 0; frame < frames; ++frame) {
+        glClearColor(0.2F, 0.3F, 0.3F, 1.0F);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+        auto const phase = std::sin(static_cast<float>(frame) / 30.0F) / 2.0F + 0.5F;
+        color = { phase, 0.5F, 1.0F - phase, 1.0F };
+        for (std::size_t i = 0; i < color.size(); ++i) {
+            UBO_block.set_attribute_data(std::span { &color[i], 1 }, "u_color", i);
+        }
+
+        glDrawElementsInstanced(GL_TRIANGLES, VAO.index_data().count(), GL_UNSIGNED_INT, nullptr,
+            VAO.instanced_data()->instance_count());
+    }
+    glFinish();
+
+    auto const wall_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - wall_begin).count();
+    auto const cpu_seconds = static_cast<double>(std::clock() - cpu_begin) / CLOCKS_PER_SEC;
+
+    std::printf("%d frames of %dx%d on %s (OpenGL %d.%d, %s)\n", frames, width, height, // NOLINT (vararg)
+        staplegl::headless_context::renderer(), context.version().first, context.version().second,
+        context.surface() == staplegl::headless_surface::none ? "surfaceless" : "pbuffer");
+    std::printf("%.1f fps, %.1f frames per CPU second\n", frames / wall_seconds, // NOLINT (vararg)
+        cpu_seconds > 0.0 ? frames / cpu_seconds : 0.0);
+
+    // read the last frame back.
+    std::vector<std::uint8_t> pixels(static_cast<std::size_t>(width) * static_cast<std::size_t>(height) * 4);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+
+    if (!write_ppm(output, pixels, width, height)) {
+        std::fprintf(stderr, "could not write %s\n", output);
+        return 1;
+    }
+    std::printf("wrote %s\n", output);
+
+    return 0;
+}
@@ -0,0 +1,212 @@
+/**
+ * @file render_jobs.cpp
+ * @author Dario Loi
+ * @brief Batch offline rendering example, on a pool of headless contexts.
+ * @date 2026-10-17
+ *
+ * @copyright MIT License
+ *
+ * @details Renders the same set of jobs (the instances of batches.cpp, colored after the job
+ * number) with 1, 2, 4, ... workers, up to the number of hardware threads, and reports the
+ * throughput of each run. Every worker keeps its program, vertex array and render target across
+ * jobs, and reads the results back asynchronously. <br>
+ *
+ * Usage: `render_jobs [--jobs=<n>] [--width=<w>] [--height=<h>] [--max_workers=<n>] [--png=<directory>]`
+ *
+ * With `--png`, the last run also writes every job to a PNG file, encoded by an image_writer on
+ * threads of its own, so that the workers go back to rendering right after copying the pixels.
+ *
+ * The checksum of the pixels of all the jobs is printed with every run, and should not depend
+ * on the number of workers. Running with `LP_NUM_THREADS=1` shows how llvmpipe scales with
+ * contexts alone, rather than with its own rasterizer threads.
+ *
+ * @example render_jobs.cpp
+ */
+
+#include "image_writer.hpp"
+#include "render_job_pool.hpp"
+#include "staplegl.hpp"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <numeric>
+#include <random>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace {
+
+std::int32_t width = 256;  // NOLINT (non-const-global)
+std::int32_t height = 256; // NOLINT (non-const-global)
+
+/**
+ * @brief What every worker keeps from one job to the next.
+ *
+ */
+struct scene {
+    staplegl::shader_program program { "batched_shader", "./shaders/batched_shader.glsl" };
+    staplegl::vertex_array vao;
+    staplegl::uniform_buffer colors { staplegl::vertex_buffer_layout {
+                                          { staplegl::shader_data_type::shader_array_type::float32_arr, "u_color", 4 } },
+        1 };
+    staplegl::texture_2d color_target {
+        std::span<const std::uint8_t> {},
+        staplegl::resolution { width, height },
+        staplegl::texture_color { .internal_format = GL_RGBA8, .format = GL_RGBA, .datatype = GL_UNSIGNED_BYTE },
+        staplegl::texture_filter { .min_filter = GL_LINEAR, .mag_filter = GL_LINEAR, .clamping = GL_CLAMP_TO_EDGE }
+    };
+    staplegl::framebuffer fbo;
+
+    scene()
+    {
+        using namespace staplegl::shader_data_type;
+
+        const std::array<const float, 12> vertices {
+            0.01F, 0.01F, 0.0F,
+            0.01F, -0.01F, 0.0F,
+            -0.01F, -0.01F, 0.0F,
+            -0.01F, 0.01F, 0.0F,
+        };
+        const std::array<const unsigned int, 6> indices { 0, 1, 3, 1, 2, 3 };
+
+        staplegl::vertex_buffer vbo { vertices, staplegl::driver_draw_hint::STATIC_DRAW };
+        vbo.set_layout(staplegl::vertex_buffer_layout { { u_type::vec3, "aPos" } });
+
+        staplegl::vertex_buffer_inst instances { {} };
+        instances.set_layout(staplegl::vertex_buffer_layout { { u_type::vec3, "instancePos" } });
+
+        vao.add_vertex_buffer(std::move(vbo));
+        vao.set_instance_buffer(std::move(instances));
+        vao.set_index_buffer(staplegl::index_buffer { indices });
+
+        std::mt19937 rng { 42 }; // NOLINT (cert-msc32-c), the same scene on every worker
+        std::uniform_real_distribution<float> xy { -0.95F, 0.95F };
+        std::uniform_real_distribution<float> z { 0.01F, 1.0F };
+        for (std::int32_t i = 0; i < 4096; ++i) {
+            vao.instanced_data()->add_instance(std::array { xy(rng), xy(rng), z(rng) });
+        }
+
+        fbo.bind();
+        fbo.set_texture(color_target);
+        fbo.set_renderbuffer({ width, height });
+    }
+
+    auto draw(std::uint64_t job) -> staplegl::readback_region
+    {
+        fbo.bind();
+        staplegl::framebuffer::set_viewport({ width, height });
+        program.bind();
+        vao.bind();
+        colors.bind();
+
+        auto const shade = static_cast<float>(job % 256) / 255.0F;
+        std::array<float, 4> color { shade, 1.0F - shade, 0.5F, 1.0F };
+        for (std::size_t i = 0; i < color.size(); ++i) {
+            colors.set_attribute_data(std::span { &color[i], 1 }, "u_color", i);
+        }
+
+        glClearColor(0.2F, 0.3F, 0.3F, 1.0F);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        glDrawElementsInstanced(GL_TRIANGLES, vao.index_data().count(), GL_UNSIGNED_INT, nullptr,
+            vao.instanced_data()->instance_count());
+
+        return { 0, 0, width, height };
+    }
+};
+
+} // namespace
+
+auto main(int argc, char** argv) -> int
+{
+    std::uint64_t jobs = 256;
+    std::size_t max_workers = std::max(std::thread::hardware_concurrency(), 1U);
+    std::string png_directory;
+
+    for (auto const* arg : std::span { argv, static_cast<std::size_t>(argc) }.subspan(1)) {
+        std::string_view const option { arg };
+        auto const value = [&option](std::string_view prefix) { return std::atoi(option.substr(prefix.size()).data()); };
+
+        if (option.starts_with("--jobs=")) {
+            jobs = static_cast<std::uint64_t>(std::max(value("--jobs="), 1));
+        } else if (option.starts_with("--width=")) {
+            width = std::max(value("--width="), 1);
+        } else if (option.starts_with("--height=")) {
+            height = std::max(value("--height="), 1);
+        } else if (option.starts_with("--max_workers=")) {
+            max_workers = static_cast<std::size_t>(std::max(value("--max_workers="), 1));
+        } else if (option.starts_with("--png=")) {
+            png_directory = option.substr(std::string_view { "--png=" }.size());
+        } else {
+            std::fprintf(stderr, "usage: render_jobs [--jobs=<n>] [--width=<w>] [--height=<h>] [--max_workers=<n>] [--png=<directory>]\n");
+            return 1;
+        }
+    }
+
+    // one slot per job, so that the workers never write to the same one.
+    std::vector<std::uint64_t> checksums(jobs);
+
+    std::printf("%llu jobs of %dx%d\n", static_cast<unsigned long long>(jobs), width, height); // NOLINT (vararg)
+    std::printf("%8s %12s %18s %18s\n", "workers", "jobs/s", "jobs/s per worker", "checksum"); // NOLINT (vararg)
+
+    staplegl::image_writer writer;
+
+    for (std::size_t workers = 1;; workers = std::min(workers * 2, max_workers)) {
+        std::fill(checksums.begin(), checksums.end(), 0);
+        auto const save = !png_directory.empty() && workers == max_workers;
+
+        staplegl::render_job_pool<scene> pool {
+            [] { return scene {}; },
+            [](scene& s, std::uint64_t job) { return s.draw(job); },
+            [&](std::uint64_t job, staplegl::readback_region const& region, std::span<const std::byte> pixels) {
+                std::uint64_t sum {};
+                for (auto const pixel : pixels) {
+                    sum = sum * 31 + static_cast<std::uint64_t>(pixel);
+                }
+                checksums[job] = sum;
+
+                if (save) {
+                    writer.write(png_directory + "/job_" + std::to_string(job) + ".png", staplegl::image_format::png,
+                        { region.width, region.height }, {}, pixels);
+                }
+            },
+            staplegl::render_job_options { .workers = workers }
+        };
+
+        if (!pool.is_valid()) {
+            std::fprintf(stderr, "could not create %zu headless OpenGL contexts\n", workers);
+            return 1;
+        }
+
+        // the contexts and their resources are ready, time the jobs alone.
+        auto const begin = std::chrono::steady_clock::now();
+        pool.submit(0, jobs);
+        pool.wait();
+        writer.wait();
+        auto const seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+        auto const checksum = std::accumulate(checksums.begin(), checksums.end(), std::uint64_t {},
+            [](std::uint64_t total, std::uint64_t sum) { return total ^ (sum + 0x9e3779b97f4a7c15ULL + (total << 6) + (total >> 2)); });
+        auto const rate = static_cast<double>(jobs) / seconds;
+        std::printf("%8zu %12.1f %18.1f %18llx\n", workers, rate, rate / static_cast<double>(workers), // NOLINT (vararg)
+            static_cast<unsigned long long>(checksum));
+
+        if (workers == max_workers) {
+            break;
+        }
+    }
+
+    if (!png_directory.empty()) {
+        std::printf("wrote %zu PNG files to %s, %zu failed\n", writer.written(), png_directory.c_str(), writer.failed()); // NOLINT (vararg)
+    }
+
+    return 0;
+}
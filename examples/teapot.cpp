@@ -15,6 +15,7 @@
 #include <algorithm>
 #include <array>
 #include <cstddef>
+#include <fstream>
 #include <iostream>
 #include <span>
 #include <utility>
@@ -29,6 +30,10 @@
 #include "gtc/matrix_transform.hpp"
 #include "gtc/type_ptr.hpp"
 
+#ifdef STAPLEGL_INSTRUMENT
+#include "gl_capture.hpp"
+#endif // STAPLEGL_INSTRUMENT
+
 // stb_image in order to load up textures.
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
@@ -55,10 +60,13 @@ constexpr auto MSAA_SAMPLES = 8;
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void processInput(GLFWwindow* window);
 
-// initial window size
+// initial window size, and the largest internal render resolution.
 const int32_t SCR_WIDTH = 1600;
 const int32_t SCR_HEIGHT = 900;
 
+// GPU time budget of a frame, the internal resolution is scaled down when frames take longer.
+constexpr double TARGET_GPU_MS = 1000.0 / 60.0;
+
 // global luminosity to be updated by keypresses
 float luminosity = 50.0F; // NOLINT
 
@@ -110,7 +118,8 @@ auto main() -> int
     std::string_view const hello_message {
         "Hello! This is a more complex example of staplegl usage, featuring the Utah Teapot model.\n"
         "Press the U and D keys to increase (U) and decrease (D) the luminosity of the light source.\n"
-        "Play around with them to observe how the bloom effect changes."
+        "Play around with them to observe how the bloom effect changes.\n"
+        "The scene is rendered at a lower resolution, and upscaled, when a frame takes the GPU longer than the budget."
     };
 
     std::cout << hello_message << std::endl;
@@ -149,6 +158,13 @@ auto main() -> int
         return -1;
     }
 
+#ifdef STAPLEGL_INSTRUMENT
+    // capture the setup and the first few frames, they can be replayed offline with the `replay` tool.
+    constexpr std::size_t capture_frames = 3;
+    staplegl::instrument::recorder capture;
+    staplegl::instrument::set_backend(&capture);
+#endif // STAPLEGL_INSTRUMENT
+
     // enabe OpenGL features: depth test, MSAA, debug output, face culling
     glEnable(GL_DEPTH_TEST);
     glEnable(GL_DEBUG_OUTPUT);
@@ -232,15 +248,31 @@ auto main() -> int
     staplegl::framebuffer msaa_fbo {};
     staplegl::framebuffer post_fbo {};
 
+    // the render targets are attached once, at full size: lowering the resolution only renders
+    // to a smaller part of them, nothing is reallocated.
+    msaa_fbo.bind();
+    msaa_fbo.set_texture(msaa_color);
+    msaa_fbo.set_renderbuffer(
+        { SCR_WIDTH,
+            SCR_HEIGHT }, // get a renderbuffer of the same size as the screen.
+        staplegl::fbo_attachment::ATTACH_DEPTH_STENCIL_BUFFER,
+        MSAA); // set the same samples as the color texture.
+
+    if (!msaa_fbo.assert_completeness()) [[unlikely]] {
+        std::cerr << "Framebuffer not complete, line: " << __LINE__ << std::endl;
+        return EXIT_FAILURE; // check for completeness
+    }
+    staplegl::framebuffer::bind_default();
+
     // set up vertex data (and buffer(s)) and configure vertex attributes
     // ------------------------------------------------------------------
 
     // Teapot model
-    staplegl::vertex_buffer_layout const layout_3P_3N { { u_type::vec3, "aPos" }, { u_type::vec3, "aNormal" } };
+    // the format is known at compile time, so the layout is a type and allocates nothing.
+    using layout_3P_3N = staplegl::static_layout<staplegl::attr<u_type::vec3, "aPos">, staplegl::attr<u_type::vec3, "aNormal">>;
 
     staplegl::vertex_buffer VBO { { teapot_vertices }, // std::span extracts the size from the C array, preventing decay.
         staplegl::driver_draw_hint::STATIC_DRAW };
-    VBO.set_layout(layout_3P_3N);
 
     staplegl::index_buffer EBO {
         { teapot_indices } // capture the array again.
@@ -248,7 +280,7 @@ auto main() -> int
 
     staplegl::vertex_array VAO;
 
-    VAO.add_vertex_buffer(std::move(VBO));
+    VAO.add_vertex_buffer(std::move(VBO), layout_3P_3N {});
     VAO.set_index_buffer(std::move(EBO));
     VAO.unbind(); // unbind to ensure that the VAO is not modified by accident.
 
@@ -385,11 +417,24 @@ auto main() -> int
 
     glClearColor(0.F, 0.F, 0.F, 1.0F);
 
+    // time every pass of the frame on the GPU, results are read back a few frames late
+    // so that the profiler never stalls the pipeline.
+    staplegl::gpu_profiler profiler;
+
+    // picks the internal resolution from the GPU frame times of the profiler.
+    staplegl::resolution_scaler scaler { { SCR_WIDTH, SCR_HEIGHT }, { .target_ms = TARGET_GPU_MS } };
+
+#ifdef STAPLEGL_INSTRUMENT
+    capture.mark_frame(); // end of the setup
+#endif // STAPLEGL_INSTRUMENT
+
     while (glfwWindowShouldClose(window) == 0) {
         // input
         // -----
         processInput(window);
 
+        profiler.begin_frame();
+
         light_block.bind();
         light_block.set_attribute_data(std::span { glm::value_ptr(glm::vec2(luminosity, 1.2F)), 2 }, "light_intensities");
 
@@ -417,19 +462,10 @@ auto main() -> int
         camera_block.set_attribute_data(std::span { glm::value_ptr(view), 16 }, "view");
         camera_block.set_attribute_data(std::span { glm::value_ptr(projection), 16 }, "projection");
 
-        // first off, we bind the framebuffer and start drawing to our HDR texture.
+        // first off, we bind the framebuffer and start drawing to our HDR texture,
+        // at the internal resolution.
         msaa_fbo.bind();
-        msaa_fbo.set_texture(msaa_color);
-        msaa_fbo.set_renderbuffer(
-            { SCR_WIDTH,
-                SCR_HEIGHT }, // get a renderbuffer of the same size as the screen.
-            staplegl::fbo_attachment::ATTACH_DEPTH_STENCIL_BUFFER,
-            MSAA); // set the same samples as the color texture.
-
-        if (!msaa_fbo.assert_completeness()) [[unlikely]] {
-            std::cerr << "Framebuffer not complete, line: " << __LINE__ << std::endl;
-            return EXIT_FAILURE; // check for completeness
-        }
+        staplegl::framebuffer::set_viewport(scaler.region());
 
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT); // clear the framebuffer
 
@@ -439,44 +475,48 @@ auto main() -> int
 
         */
 
-        // prep to render the skybox
-        skybox_VAO.bind();
-        skybox_shader.bind();
+        {
+            auto const timer = profiler.scope("scene");
 
-        // make the skybox huge and centered on the camera.
-        // in a more complex scene you would have it follow the camera.
-        glm::mat4 skybox_mat = glm::scale(glm::mat4(1.0F), glm::vec3(50.0F, 50.0F, 50.0F));
-        camera_block.set_attribute_data(std::span { glm::value_ptr(skybox_mat), 16 }, "model");
+            // prep to render the skybox
+            skybox_VAO.bind();
+            skybox_shader.bind();
 
-        // disable depth writing so that the skybox is always drawn behind everything else.
-        // we do not need to invert culling due to the skybox's indices being wound in the opposite direction.
-        glDepthMask(GL_FALSE);
-        glDrawElements(GL_TRIANGLES, skybox_VAO.index_data().count(), GL_UNSIGNED_INT, nullptr);
-        glDepthMask(GL_TRUE);
+            // make the skybox huge and centered on the camera.
+            // in a more complex scene you would have it follow the camera.
+            glm::mat4 skybox_mat = glm::scale(glm::mat4(1.0F), glm::vec3(50.0F, 50.0F, 50.0F));
+            camera_block.set_attribute_data(std::span { glm::value_ptr(skybox_mat), 16 }, "model");
 
-        // draw the blue light source
-        // we use the same VAO as the skybox, but we change the shader and the model matrix.
+            // disable depth writing so that the skybox is always drawn behind everything else.
+            // we do not need to invert culling due to the skybox's indices being wound in the opposite direction.
+            glDepthMask(GL_FALSE);
+            glDrawElements(GL_TRIANGLES, skybox_VAO.index_data().count(), GL_UNSIGNED_INT, nullptr);
+            glDepthMask(GL_TRUE);
 
-        glm::mat4 light_mat = glm::translate(glm::mat4(1.0F), glm::vec3(light_pos));
-        camera_block.set_attribute_data(std::span { glm::value_ptr(light_mat), 16 }, "model");
+            // draw the blue light source
+            // we use the same VAO as the skybox, but we change the shader and the model matrix.
 
-        light_shader.bind();
-        // since the skybox has an inverted winding order, we need to invert culling
-        // (we want to see the cube from outside now), so the effect is not cancelled out.
-        glFrontFace(GL_CW);
-        glDrawElements(GL_TRIANGLES, skybox_VAO.index_data().count(), GL_UNSIGNED_INT, nullptr);
-        glFrontFace(GL_CCW); // on a real program, use better models :)
+            glm::mat4 light_mat = glm::translate(glm::mat4(1.0F), glm::vec3(light_pos));
+            camera_block.set_attribute_data(std::span { glm::value_ptr(light_mat), 16 }, "model");
 
-        // draw the teapot
+            light_shader.bind();
+            // since the skybox has an inverted winding order, we need to invert culling
+            // (we want to see the cube from outside now), so the effect is not cancelled out.
+            glFrontFace(GL_CW);
+            glDrawElements(GL_TRIANGLES, skybox_VAO.index_data().count(), GL_UNSIGNED_INT, nullptr);
+            glFrontFace(GL_CCW); // on a real program, use better models :)
 
-        // The teapot model matrix flips it upside-down, so that it is rendered correctly.
-        glm::mat4 model_mat = glm::scale(model, glm::vec3(1.0F, -1.0F, 1.0F));
-        camera_block.set_attribute_data(std::span { glm::value_ptr(model_mat), 16 }, "model");
+            // draw the teapot
 
-        VAO.bind();
-        teapot_shader.bind();
+            // The teapot model matrix flips it upside-down, so that it is rendered correctly.
+            glm::mat4 model_mat = glm::scale(model, glm::vec3(1.0F, -1.0F, 1.0F));
+            camera_block.set_attribute_data(std::span { glm::value_ptr(model_mat), 16 }, "model");
 
-        glDrawElements(GL_TRIANGLES, VAO.index_data().count(), GL_UNSIGNED_INT, nullptr);
+            VAO.bind();
+            teapot_shader.bind();
+
+            glDrawElements(GL_TRIANGLES, VAO.index_data().count(), GL_UNSIGNED_INT, nullptr);
+        }
 
         /*
 
@@ -484,13 +524,16 @@ auto main() -> int
 
         */
 
-        post_fbo.bind();
-        post_fbo.set_texture(hdr_color);
+        {
+            auto const timer = profiler.scope("msaa_resolve");
+
+            post_fbo.bind();
+            post_fbo.set_texture(hdr_color);
 
-        staplegl::framebuffer::transfer_data(msaa_fbo, post_fbo, { SCR_WIDTH, SCR_HEIGHT });
+            staplegl::framebuffer::transfer_data(msaa_fbo, post_fbo, scaler.region());
 
-        post_fbo.bind();
-        post_fbo.set_renderbuffer({ 0, 0 }, staplegl::fbo_attachment::NONE);
+            post_fbo.bind();
+        }
 
         /*
 
@@ -501,83 +544,132 @@ auto main() -> int
         // bind screen-quad, every draw call will now simply
         // transfer content from one texture to another.
 
-        quad_VAO.bind();
+        {
+            auto const timer = profiler.scope("bloom_down");
 
-        // copy stuff to the bloom pyramid
-        passthrough_shader.bind();
-        hdr_color.set_unit(1);
-        post_fbo.set_texture(pyramid_textures[0], 0);
+            quad_VAO.bind();
 
-        glDrawArrays(GL_TRIANGLE_STRIP, 0, 4); // copy the scene to the lowest level of the pyramid
+            // copy stuff to the bloom pyramid
+            passthrough_shader.bind();
+            passthrough_shader.upload_uniform2f("uUVScale", scaler.uv_scale()[0], scaler.uv_scale()[1]);
+            hdr_color.set_unit(1);
+            post_fbo.set_texture(pyramid_textures[0], 0);
+            post_fbo.set_viewport(scaler.region());
 
-        downsample_shader.bind();
+            glDrawArrays(GL_TRIANGLE_STRIP, 0, 4); // copy the scene to the lowest level of the pyramid
 
-        // work our way down the levels of the pyramid, downsampling the texture each time.
-        for (size_t i = 0; i < pyramid_textures.size() - 1; i++) {
-            // downsample from texture i to texture i + 1
+            downsample_shader.bind();
 
-            auto& draw_source = pyramid_textures[i];
-            auto& draw_target = pyramid_textures[i + 1];
-            auto const& t_res = draw_target.get_resolution();
+            // work our way down the levels of the pyramid, downsampling the texture each time.
+            for (size_t i = 0; i < pyramid_textures.size() - 1; i++) {
+                // downsample from texture i to texture i + 1
 
-            draw_source.set_unit(1);
+                auto& draw_source = pyramid_textures[i];
+                auto& draw_target = pyramid_textures[i + 1];
+                auto const& t_res = draw_target.get_resolution();
+                auto const level = static_cast<std::uint32_t>(i);
+                auto const uv_scale = scaler.uv_scale(level);
 
-            post_fbo.set_texture(draw_target, 0);
-            post_fbo.set_viewport(
-                { t_res.width,
-                    t_res.height });
+                draw_source.set_unit(1);
 
-            downsample_shader.upload_uniform2f(
-                "uResolution", static_cast<float>(t_res.width),
-                static_cast<float>(t_res.height));
+                post_fbo.set_texture(draw_target, 0);
+                post_fbo.set_viewport(scaler.region(level + 1));
 
-            glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+                downsample_shader.upload_uniform2f(
+                    "uResolution", static_cast<float>(t_res.width),
+                    static_cast<float>(t_res.height));
+                downsample_shader.upload_uniform2f("uUVScale", uv_scale[0], uv_scale[1]);
+
+                glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+            }
         }
 
         // now every level of the pyramid is filled with a downsampled version of the scene.
         // we can now upsample the pyramid and add the results together to get the bloom effect.
 
-        // blending for Bloom
-        glEnable(GL_BLEND);
-        glBlendFunc(GL_ONE, GL_ONE);
-        glBlendEquation(GL_FUNC_ADD);
+        {
+            auto const timer = profiler.scope("bloom_up");
 
-        upsample_shader.bind();
+            // blending for Bloom
+            glEnable(GL_BLEND);
+            glBlendFunc(GL_ONE, GL_ONE);
+            glBlendEquation(GL_FUNC_ADD);
 
-        for (int i = pyramid_textures.size() - 1; i > 0; i--) {
-            // upsample from texture i to texture i - 1
+            upsample_shader.bind();
 
-            auto& draw_source = pyramid_textures[i];
-            auto& draw_target = pyramid_textures[i - 1];
+            for (int i = pyramid_textures.size() - 1; i > 0; i--) {
+                // upsample from texture i to texture i - 1
 
-            draw_source.set_unit(1);
+                auto& draw_source = pyramid_textures[i];
+                auto& draw_target = pyramid_textures[i - 1];
+                auto const level = static_cast<std::uint32_t>(i);
+                auto const uv_scale = scaler.uv_scale(level);
 
-            post_fbo.set_texture(draw_target, 0);
-            post_fbo.set_viewport(
-                { draw_target.get_resolution().width,
-                    draw_target.get_resolution().height });
-            glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+                draw_source.set_unit(1);
+
+                post_fbo.set_texture(draw_target, 0);
+                post_fbo.set_viewport(scaler.region(level - 1));
+                upsample_shader.upload_uniform2f("uUVScale", uv_scale[0], uv_scale[1]);
+                glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+            }
+            glDisable(GL_BLEND);
         }
-        glDisable(GL_BLEND);
 
         // After upscaling the pyramid, we have the bloom effect in the lowest level of the pyramid.
         // we can combine it with the original scene to get the final result.
 
-        // HDR post-processing
-        staplegl::framebuffer::bind_default();
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        {
+            auto const timer = profiler.scope("tonemap");
+
+            // HDR post-processing, upscaling from the internal resolution to the whole window.
+            staplegl::framebuffer::bind_default();
+            std::int32_t window_width {};
+            std::int32_t window_height {};
+            glfwGetFramebufferSize(window, &window_width, &window_height);
+            staplegl::framebuffer::set_viewport({ window_width, window_height });
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+            tonemap_shader.bind();
+            tonemap_shader.upload_uniform2f("uUVScale", scaler.uv_scale()[0], scaler.uv_scale()[1]);
+            // bind the pyramid texture and the original scene
+            hdr_color.set_unit(1);
+            pyramid_textures[0].set_unit(2);
+
+            glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+        }
 
-        tonemap_shader.bind();
-        // bind the pyramid texture and the original scene
-        hdr_color.set_unit(1);
-        pyramid_textures[0].set_unit(2);
+        profiler.end_frame();
 
-        glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+        // the timings arrive a few frames late, the scaler takes care of that.
+        scaler.update(profiler);
+
+#ifdef STAPLEGL_INSTRUMENT
+        if (staplegl::instrument::get_backend() == &capture) {
+            capture.mark_frame();
+            if (capture.log().frame_ends.size() == capture_frames + 1) {
+                staplegl::instrument::set_backend(nullptr);
+                std::ofstream capture_file { "teapot.sglc", std::ios::binary };
+                staplegl::instrument::write_capture(capture_file, capture.log());
+            }
+        }
+#endif // STAPLEGL_INSTRUMENT
 
         glfwSwapBuffers(window);
         glfwPollEvents();
     }
 
+    // report the GPU time spent in each pass, and dump a trace for chrome://tracing.
+    std::cout << "GPU pass timings (min / mean / p99):\n";
+    for (auto const& [name, min_ms, mean_ms, p99_ms, frames] : profiler.stats()) {
+        std::cout << "  " << name << ": " << min_ms << " / " << mean_ms << " / " << p99_ms
+                  << " ms over " << frames << " frames\n";
+    }
+    std::cout << "Internal resolution: " << scaler.region().width << "x" << scaler.region().height
+              << " (" << scaler.scale() * 100.0F << "%), " << scaler.frame_ms() << " ms per frame\n";
+
+    std::ofstream trace_file { "teapot_gpu_trace.json" };
+    profiler.write_chrome_trace(trace_file);
+
     // no need to de-allocate anything as staplegl handles all the OpenGL objects in a RAII fashion.
 
     // glfw: terminate, clearing all previously allocated GLFW resources.
@@ -0,0 +1,135 @@
+/**
+ * @file tiled.cpp
+ * @author Dario Loi
+ * @brief Tiled rendering example, for images larger than any framebuffer.
+ * @date 2026-10-17
+ *
+ * @copyright MIT License
+ *
+ * @details Renders a field of instanced quads at print resolution on a headless context, tile by
+ * tile, and streams the tiles to a binary PPM file as they are read back. Only the tiles in
+ * flight are ever held in memory. <br>
+ *
+ * Usage: `tiled [--width=<w>] [--height=<h>] [--tile=<side>] [--out=<file.ppm>]`
+ *
+ * Defaults to a 16384 x 16384 image in 2048 x 2048 tiles, the image takes 768 MiB on disk.
+ *
+ * @example tiled.cpp
+ */
+
+#include "headless_context.hpp"
+#include "staplegl.hpp"
+#include "tiled_renderer.hpp"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+
+auto main(int argc, char** argv) -> int
+{
+    std::int32_t width = 16384;
+    std::int32_t height = 16384;
+    std::int32_t tile_side = 2048;
+    std::string output = "tiled.ppm";
+
+    for (auto const* arg : std::span { argv, static_cast<std::size_t>(argc) }.subspan(1)) {
+        std::string_view const option { arg };
+        auto const value = [&option](std::string_view prefix) { return std::max(std::atoi(option.substr(prefix.size()).data()), 1); };
+
+        if (option.starts_with("--width=")) {
+            width = value("--width=");
+        } else if (option.starts_with("--height=")) {
+            height = value("--height=");
+        } else if (option.starts_with("--tile=")) {
+            tile_side = value("--tile=");
+        } else if (option.starts_with("--out=")) {
+            output = option.substr(std::string_view { "--out=" }.size());
+        } else {
+            std::fprintf(stderr, "usage: tiled [--width=<w>] [--height=<h>] [--tile=<side>] [--out=<file.ppm>]\n");
+            return 1;
+        }
+    }
+
+    staplegl::headless_context const context;
+    if (!context.is_valid()) {
+        std::fprintf(stderr, "could not create a headless OpenGL context\n");
+        return 1;
+    }
+
+    staplegl::shader_program program { "tiled_shader", "./shaders/tiled_shader.glsl" };
+
+    using namespace staplegl::shader_data_type;
+
+    const std::array<const float, 12> vertices {
+        0.002F, 0.002F, 0.0F,
+        0.002F, -0.002F, 0.0F,
+        -0.002F, -0.002F, 0.0F,
+        -0.002F, 0.002F, 0.0F,
+    };
+    const std::array<const unsigned int, 6> indices { 0, 1, 3, 1, 2, 3 };
+
+    staplegl::vertex_buffer vbo { vertices, staplegl::driver_draw_hint::STATIC_DRAW };
+    vbo.set_layout(staplegl::vertex_buffer_layout { { u_type::vec3, "aPos" } });
+
+    staplegl::vertex_buffer_inst instances { {} };
+    instances.set_layout(staplegl::vertex_buffer_layout { { u_type::vec3, "instancePos" } });
+
+    staplegl::vertex_array vao;
+    vao.add_vertex_buffer(std::move(vbo));
+    vao.set_instance_buffer(std::move(instances));
+    vao.set_index_buffer(staplegl::index_buffer { indices });
+
+    std::mt19937 rng { 42 }; // NOLINT (cert-msc32-c), the same picture on every run
+    std::uniform_real_distribution<float> xy { -0.99F, 0.99F };
+    for (std::int32_t i = 0; i < 65536; ++i) {
+        vao.instanced_data()->add_instance(std::array { xy(rng), xy(rng), 0.0F });
+    }
+
+    staplegl::tiled_renderer renderer { { width, height }, { tile_side, tile_side } };
+    staplegl::ppm_tile_writer file { output, { width, height } };
+    if (!file.is_open()) {
+        std::fprintf(stderr, "could not open %s\n", output.c_str());
+        return 1;
+    }
+
+    auto const& grid = renderer.grid();
+    std::printf("%dx%d in %zu tiles of %dx%d, on %s\n", width, height, grid.size(), // NOLINT (vararg)
+        grid.tile_size().width, grid.tile_size().height, staplegl::headless_context::renderer());
+
+    auto const begin = std::chrono::steady_clock::now();
+    bool written = true;
+
+    renderer.render(
+        [&](staplegl::tile const& /*tile*/, std::array<float, 16> const& tile_matrix) {
+            glClearColor(0.05F, 0.05F, 0.1F, 1.0F);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+            program.bind();
+            program.upload_uniform_mat4f("u_tile", tile_matrix.data());
+            vao.bind();
+            glDrawElementsInstanced(GL_TRIANGLES, vao.index_data().count(), GL_UNSIGNED_INT, nullptr,
+                vao.instanced_data()->instance_count());
+        },
+        [&](staplegl::tile const& tile, std::span<const std::byte> pixels) {
+            written = file.write(tile, pixels) && written;
+        });
+
+    auto const seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    auto const megapixels = static_cast<double>(width) * static_cast<double>(height) / 1e6;
+
+    if (!written) {
+        std::fprintf(stderr, "could not write %s\n", output.c_str());
+        return 1;
+    }
+
+    std::printf("%.2f s, %.1f megapixels/s, wrote %s\n", seconds, megapixels / seconds, output.c_str()); // NOLINT (vararg)
+    return 0;
+}
@@ -0,0 +1,351 @@
+/**
+ * @file async_readback.hpp
+ * @author Dario Loi
+ * @brief Asynchronous pixel readback through pixel buffer objects.
+ *
+ * @date 2026-10-17
+ *
+ * @copyright MIT License
+ *
+ * @details `glReadPixels` into client memory waits for the GPU to finish the frame and copies
+ * the pixels before returning. With a buffer bound to `GL_PIXEL_PACK_BUFFER` it only schedules
+ * the copy instead, and returns at once. <br>
+ *
+ * async_readback keeps a ring of such buffers, each followed by a fence. read() schedules the copy
+ * of a region of the current read framebuffer into the next buffer; poll() hands the pixels of
+ * every copy the GPU has finished to a sink, oldest first, without waiting. The CPU keeps
+ * rendering while up to `depth` readbacks are in flight, and only waits when the ring is full. <br>
+ *
+ * Every readback carries a tag (e.g. a frame or job number), given back to the sink with the
+ * pixels. The pixels are only valid during the call to the sink, rows bottom to top as
+ * `glReadPixels` returns them, tightly packed. Every read() reaches the sink exactly once: a
+ * readback that cannot be made, or whose copy fails, is handed over with no pixels.
+ *
+ * @code{.cpp}
+ * staplegl::async_readback readback;
+ *
+ * while (rendering) {
+ *     // ... draw into fbo ...
+ *     readback.read({ 0, 0, width, height }, frame++, write_frame);
+ *     readback.poll(write_frame);
+ * }
+ * readback.drain(write_frame);
+ * @endcode
+ *
+ * @note Fences are core since OpenGL 3.2. The buffers and fences belong to the context current
+ * when the readback is created, use one async_readback per context.
+ *
+ * @see https://www.khronos.org/opengl/wiki/Pixel_Buffer_Object
+ */
+
+#pragma once
+
+#include "deletion_queue.hpp"
+#include "gl_functions.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <utility>
+#include <vector>
+
+#ifdef STAPLEGL_DEBUG
+#include <cstdio>
+#endif // STAPLEGL_DEBUG
+
+namespace staplegl {
+
+/**
+ * @brief A rectangle of the read framebuffer, in pixels.
+ *
+ */
+struct readback_region {
+    std::int32_t x {};
+    std::int32_t y {};
+    std::int32_t width {};
+    std::int32_t height {};
+};
+
+/**
+ * @brief Format of the pixels read back, as given to glReadPixels.
+ *
+ */
+struct readback_format {
+    std::uint32_t format { GL_RGBA };
+    std::uint32_t datatype { GL_UNSIGNED_BYTE };
+
+    /**
+     * @brief The size of a pixel, in bytes, 0 if the format is not supported.
+     *
+     */
+    [[nodiscard]] constexpr auto pixel_size() const noexcept -> std::size_t;
+};
+
+/**
+ * @brief Ring of pixel buffers to read framebuffers back without stalling.
+ *
+ */
+class async_readback {
+public:
+    /**
+     * @brief Construct a new async readback object
+     *
+     * @param depth the number of readbacks in flight before read() waits for the oldest one.
+     */
+    explicit async_readback(std::size_t depth = 3) noexcept
+        : m_slots(std::max<std::size_t>(depth, 1))
+    {
+    }
+
+    ~async_readback();
+
+    async_readback(const async_readback&) = delete;
+    auto operator=(const async_readback&) -> async_readback& = delete;
+
+    async_readback(async_readback&& other) noexcept;
+    auto operator=(async_readback&& other) noexcept -> async_readback&;
+
+    /**
+     * @brief Schedule the copy of a region of the read framebuffer.
+     *
+     * @details If the ring is full, waits for the oldest readback and hands it to the sink first.
+     * An empty region or an unsupported format is handed to the sink at once, with no pixels.
+     *
+     * @param region the region to read.
+     * @param tag given back to the sink with the pixels.
+     * @param sink called as `sink(tag, region, std::span<const std::byte> pixels)`.
+     * @param format the format of the pixels.
+     * @return std::size_t the number of readbacks handed to the sink meanwhile.
+     */
+    template <typename Sink>
+    auto read(readback_region const& region, std::uint64_t tag, Sink&& sink, readback_format format = {}) -> std::size_t;
+
+    /**
+     * @brief Hand the finished readbacks to the sink, oldest first, without waiting.
+     *
+     * @return std::size_t the number of readbacks handed over.
+     */
+    template <typename Sink>
+    auto poll(Sink&& sink) -> std::size_t;
+
+    /**
+     * @brief Wait for every readback in flight, and hand them to the sink.
+     *
+     * @return std::size_t the number of readbacks handed over.
+     */
+    template <typename Sink>
+    auto drain(Sink&& sink) -> std::size_t;
+
+    /**
+     * @brief The number of readbacks in flight.
+     *
+     */
+    [[nodiscard]] auto pending() const noexcept -> std::size_t { return m_pending; }
+
+    [[nodiscard]] auto depth() const noexcept -> std::size_t { return m_slots.size(); }
+
+private:
+    struct slot {
+        std::uint32_t buffer {};
+        std::size_t capacity {};
+        GLsync fence {};
+        std::uint64_t tag {};
+        readback_region region {};
+        std::size_t bytes {};
+    };
+
+    /**
+     * @brief Hand the oldest readback to the sink, if it is done or `wait` is set.
+     *
+     * @details A readback whose fence or mapping failed is handed over with no pixels.
+     *
+     * @return true if it was handed over.
+     */
+    template <typename Sink>
+    auto retire(Sink& sink, bool wait) -> bool;
+
+    std::vector<slot> m_slots;
+    std::size_t m_oldest {};
+    std::size_t m_pending {};
+};
+
+/*
+
+        IMPLEMENTATIONS
+
+*/
+
+constexpr auto readback_format::pixel_size() const noexcept -> std::size_t
+{
+    std::size_t channels {};
+    switch (format) {
+    case GL_RED:
+    case GL_DEPTH_COMPONENT:
+    case GL_STENCIL_INDEX:
+        channels = 1;
+        break;
+    case GL_RG:
+        channels = 2;
+        break;
+    case GL_RGB:
+    case GL_BGR:
+        channels = 3;
+        break;
+    case GL_RGBA:
+    case GL_BGRA:
+        channels = 4;
+        break;
+    default:
+        return 0;
+    }
+
+    switch (datatype) {
+    case GL_UNSIGNED_BYTE:
+    case GL_BYTE:
+        return channels;
+    case GL_UNSIGNED_SHORT:
+    case GL_SHORT:
+    case GL_HALF_FLOAT:
+        return channels * 2;
+    case GL_UNSIGNED_INT:
+    case GL_INT:
+    case GL_FLOAT:
+        return channels * 4;
+    default:
+        return 0;
+    }
+}
+
+inline async_readback::~async_readback()
+{
+    for (auto& entry : m_slots) {
+        if (entry.fence != nullptr) {
+            glDeleteSync(entry.fence);
+        }
+        release_object(gl_object::buffer, entry.buffer);
+    }
+}
+
+inline async_readback::async_readback(async_readback&& other) noexcept
+    : m_slots { std::move(other.m_slots) }
+    , m_oldest { std::exchange(other.m_oldest, 0) }
+    , m_pending { std::exchange(other.m_pending, 0) }
+{
+}
+
+inline auto async_readback::operator=(async_readback&& other) noexcept -> async_readback&
+{
+    // the buffers and fences of this readback go to other, and are released with it.
+    std::swap(m_slots, other.m_slots);
+    std::swap(m_oldest, other.m_oldest);
+    std::swap(m_pending, other.m_pending);
+    return *this;
+}
+
+template <typename Sink>
+inline auto async_readback::read(readback_region const& region, std::uint64_t tag, Sink&& sink, readback_format format) -> std::size_t
+{
+    auto const pixel_size = format.pixel_size();
+    if (pixel_size == 0 || region.width <= 0 || region.height <= 0) [[unlikely]] {
+#ifdef STAPLEGL_DEBUG
+        std::fprintf(stderr, STAPLEGL_LINEINFO ", cannot read back a %dx%d region with format 0x%x and type 0x%x\n",
+            region.width, region.height, format.format, format.datatype);
+#endif // STAPLEGL_DEBUG
+        sink(tag, region, std::span<const std::byte> {});
+        return 1;
+    }
+
+    std::size_t retired {};
+    if (m_pending == m_slots.size()) {
+        retired += retire(sink, true) ? 1 : 0;
+    }
+
+    auto& entry = m_slots[(m_oldest + m_pending) % m_slots.size()];
+    entry.tag = tag;
+    entry.region = region;
+    entry.bytes = static_cast<std::size_t>(region.width) * static_cast<std::size_t>(region.height) * pixel_size;
+
+    if (entry.buffer == 0) {
+        entry.buffer = acquire_name(gl_object::buffer);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, entry.buffer);
+    if (entry.capacity < entry.bytes) {
+        glBufferData(GL_PIXEL_PACK_BUFFER, static_cast<std::ptrdiff_t>(entry.bytes), nullptr, GL_STREAM_READ);
+        entry.capacity = entry.bytes;
+    }
+
+    // rows are tightly packed, whatever their width.
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(region.x, region.y, region.width, region.height, format.format, format.datatype, nullptr);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    entry.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    ++m_pending;
+
+    // without a flush, the fence may never be reached by a driver waiting for more commands.
+    glFlush();
+
+    return retired;
+}
+
+template <typename Sink>
+inline auto async_readback::poll(Sink&& sink) -> std::size_t
+{
+    std::size_t count {};
+    while (m_pending != 0 && retire(sink, false)) {
+        ++count;
+    }
+    return count;
+}
+
+template <typename Sink>
+inline auto async_readback::drain(Sink&& sink) -> std::size_t
+{
+    std::size_t count {};
+    while (m_pending != 0 && retire(sink, true)) {
+        ++count;
+    }
+    return count;
+}
+
+template <typename Sink>
+inline auto async_readback::retire(Sink& sink, bool wait) -> bool
+{
+    auto& entry = m_slots[m_oldest];
+
+    constexpr std::uint64_t forever = ~std::uint64_t { 0 };
+    auto const status = glClientWaitSync(entry.fence, wait ? GL_SYNC_FLUSH_COMMANDS_BIT : 0, wait ? forever : 0);
+    if (status == GL_TIMEOUT_EXPIRED) {
+        return false;
+    }
+
+    glDeleteSync(entry.fence);
+    entry.fence = nullptr;
+    m_oldest = (m_oldest + 1) % m_slots.size();
+    --m_pending;
+
+    if (status == GL_WAIT_FAILED) [[unlikely]] {
+#ifdef STAPLEGL_DEBUG
+        std::fprintf(stderr, STAPLEGL_LINEINFO ", waiting for readback %llu failed\n",
+            static_cast<unsigned long long>(entry.tag));
+#endif // STAPLEGL_DEBUG
+        sink(entry.tag, std::as_const(entry.region), std::span<const std::byte> {});
+        return true;
+    }
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, entry.buffer);
+    auto const* pixels = static_cast<const std::byte*>(
+        glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, static_cast<std::ptrdiff_t>(entry.bytes), GL_MAP_READ_BIT));
+    if (pixels != nullptr) [[likely]] {
+        sink(entry.tag, std::as_const(entry.region), std::span<const std::byte> { pixels, entry.bytes });
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    } else {
+        sink(entry.tag, std::as_const(entry.region), std::span<const std::byte> {});
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    return true;
+}
+
+} // namespace staplegl
@@ -0,0 +1,483 @@
+/**
+ * @file command_buffer.hpp
+ * @author Dario Loi
+ * @brief Deferred recording of draws and uploads, for multithreaded frame preparation.
+ *
+ * @date 2026-10-17
+ *
+ * @copyright MIT License
+ *
+ * @details OpenGL calls must come from the thread that owns the context. A command_buffer makes
+ * no GL call: it only records draws, uniform values and buffer sub-uploads (e.g. uniform buffer
+ * updates) into an arena of its own. Worker threads can thus traverse the scene and pack
+ * uniforms in parallel, each into its own buffer, and the render thread executes all the
+ * buffers afterwards. <br>
+ *
+ * A buffer is written by one thread at a time and needs no synchronization: hand it to the
+ * render thread only once recording is done (e.g. after joining the workers). The arena is a
+ * list of chunks that is kept across reset(), so that recording stops allocating after the first
+ * few frames. <br>
+ *
+ * Every draw sees the uniform values and uploads recorded before it, and none recorded after it.
+ * A buffer is split in phases: a uniform value or an upload recorded after a draw starts a new
+ * one. Execution goes phase by phase: the updates of every buffer are applied, in buffer and
+ * recording order, then the draws of all the buffers are sorted together through a
+ * command_queue. Draws only sort within their phase, so per-draw data should go with the draw
+ * (see draw(draw_packet const&, std::span<const std::byte>)), into the uniform range of its
+ * packet, rather than through uniform values in between draws.
+ *
+ * @code{.cpp}
+ * std::vector<staplegl::command_buffer> buffers(workers);
+ *
+ * parallel_for(workers, [&](std::size_t worker) {
+ *     for (auto const& object : slice(scene, worker)) {
+ *         buffers[worker].draw(object.packet, std::span { &object.transform, 1 }); // into packet.uniforms
+ *     }
+ * });
+ *
+ * staplegl::execute_command_buffers(buffers, queue, cache);
+ * for (auto& buffer : buffers) {
+ *     buffer.reset();
+ * }
+ * @endcode
+ *
+ * @see command_queue.hpp
+ */
+
+#pragma once
+
+#include "command_queue.hpp"
+#include "gl_functions.hpp"
+#include "shader_data_type.hpp"
+#include "state_cache.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+#ifdef STAPLEGL_DEBUG
+#include <cstdio>
+#endif // STAPLEGL_DEBUG
+
+namespace staplegl {
+
+/**
+ * @brief Records draws, uniform values and buffer uploads, to be executed later on the GL thread.
+ *
+ */
+class command_buffer {
+public:
+    static constexpr std::size_t chunk_size = 64 * 1024;
+
+    command_buffer() = default;
+    ~command_buffer() = default;
+
+    command_buffer(const command_buffer&) = delete;
+    auto operator=(const command_buffer&) -> command_buffer& = delete;
+
+    command_buffer(command_buffer&&) noexcept = default;
+    auto operator=(command_buffer&&) noexcept -> command_buffer& = default;
+
+    /**
+     * @brief Record a draw.
+     *
+     * @param packet the draw, copied.
+     */
+    void draw(draw_packet const& packet);
+
+    /**
+     * @brief Record a draw along with the contents of its uniform buffer range.
+     *
+     * @details The data is uploaded to `packet.uniforms` with the updates of the current phase,
+     * without starting a new one: the range belongs to this draw, and is not read by the others.
+     *
+     * @param packet the draw, copied, its uniform range must hold the data.
+     * @param uniforms the contents of the range, copied.
+     */
+    void draw(draw_packet const& packet, std::span<const std::byte> uniforms);
+
+    template <typename T, std::size_t Extent>
+        requires std::is_trivially_copyable_v<T>
+    void draw(draw_packet const& packet, std::span<T, Extent> uniforms)
+    {
+        draw(packet, std::span<const std::byte> { std::as_bytes(uniforms) });
+    }
+
+    /**
+     * @brief Record a uniform value, set on a program before the draws recorded after it.
+     *
+     * @param program the program name.
+     * @param location the uniform location, looked up beforehand (e.g. shader_program::uniform_location).
+     * @param type the type of the uniform, one of float32, vec2, vec3, vec4, mat3 and mat4.
+     * @param value the components of the value, copied, missing ones are zero.
+     */
+    void set_uniform(std::uint32_t program, std::int32_t location, shader_data_type::u_type type, std::span<const float> value);
+
+    /**
+     * @brief Record an integer uniform value (e.g. a sampler unit).
+     *
+     * @param program the program name.
+     * @param location the uniform location.
+     * @param value the value.
+     */
+    void set_uniform(std::uint32_t program, std::int32_t location, std::int32_t value);
+
+    /**
+     * @brief Record an update of a range of a buffer (glBufferSubData).
+     *
+     * @param buffer the buffer name, e.g. the id of a uniform_buffer.
+     * @param offset the offset of the range in the buffer, in bytes.
+     * @param data the new contents of the range, copied.
+     */
+    void upload(std::uint32_t buffer, std::size_t offset, std::span<const std::byte> data);
+
+    template <typename T, std::size_t Extent>
+        requires std::is_trivially_copyable_v<T>
+    void upload(std::uint32_t buffer, std::size_t offset, std::span<T, Extent> data)
+    {
+        upload(buffer, offset, std::span<const std::byte> { std::as_bytes(data) });
+    }
+
+    /**
+     * @brief Forget the recorded commands, keeping the allocated memory.
+     *
+     */
+    void reset() noexcept;
+
+    [[nodiscard]] constexpr auto draw_count() const noexcept -> std::size_t { return m_draws; }
+    [[nodiscard]] constexpr auto empty() const noexcept -> bool { return m_commands == 0; }
+
+    /**
+     * @brief Get the number of phases, each is a run of updates followed by a run of draws.
+     *
+     */
+    [[nodiscard]] auto phase_count() const noexcept -> std::size_t { return empty() ? 0 : m_phase_starts.size() + 1; }
+
+    /**
+     * @brief Apply the uniform values and uploads of a phase, in recording order.
+     *
+     * @param cache the state cache programs are bound through.
+     * @param phase the phase, less than phase_count().
+     */
+    void apply_updates(state_cache& cache, std::size_t phase) const noexcept;
+
+    /**
+     * @brief Add the draws of a phase to a queue.
+     *
+     * @param queue the queue.
+     * @param phase the phase, less than phase_count().
+     */
+    void enqueue_draws(command_queue& queue, std::size_t phase) const;
+
+private:
+    enum class command_type : std::uint32_t {
+        draw,
+        uniform,
+        upload,
+        draw_upload, ///< an upload that goes with the next draw, it does not start a phase.
+    };
+
+    // every command is a header followed by its payload, both aligned to `alignment`.
+    struct command_header {
+        command_type type;
+        std::uint32_t size; ///< size of the payload, in bytes.
+    };
+
+    struct uniform_command {
+        std::uint32_t program;
+        std::int32_t location;
+        shader_data_type::u_type type;
+        std::uint32_t components; ///< number of float components that follow.
+        std::int32_t int_value;
+        // followed by the float components, if any.
+    };
+
+    struct upload_command {
+        std::uint32_t buffer;
+        std::size_t offset;
+        std::size_t size;
+        // followed by the data.
+    };
+
+    struct chunk {
+        std::unique_ptr<std::byte[]> data; // NOLINT (c-arrays)
+        std::size_t capacity {};
+        std::size_t used {};
+    };
+
+    struct position {
+        std::size_t chunk;
+        std::size_t offset;
+    };
+
+    static constexpr std::size_t alignment = alignof(std::max_align_t);
+
+    [[nodiscard]] static constexpr auto align_up(std::size_t size) noexcept -> std::size_t
+    {
+        return (size + alignment - 1) & ~(alignment - 1);
+    }
+
+    /**
+     * @brief Reserve space for a command and write its header.
+     *
+     * @return std::byte* where the payload goes.
+     */
+    auto allocate(command_type type, std::size_t payload_size) -> std::byte*;
+
+    template <typename Visitor>
+    void for_each(std::size_t phase, Visitor&& visitor) const;
+
+    std::vector<chunk> m_chunks;
+    std::vector<position> m_phase_starts; // where every phase but the first begins.
+    std::size_t m_current {};
+    std::size_t m_commands {};
+    std::size_t m_draws {};
+    bool m_phase_drawn {}; // whether the current phase has draws, the next update starts a new one.
+};
+
+/**
+ * @brief Execute command buffers recorded by several threads, on the GL thread.
+ *
+ * @details Phase by phase: the updates of every buffer are applied, in order, then the draws
+ * of all the buffers are sorted and submitted together. The queue is cleared afterwards.
+ *
+ * @param buffers the recorded buffers, left untouched.
+ * @param queue the queue the draws are sorted in.
+ * @param cache the state cache binds go through.
+ * @return queue_stats the statistics of the submissions, summed over the phases.
+ */
+auto execute_command_buffers(std::span<const command_buffer> buffers, command_queue& queue, state_cache& cache) -> queue_stats;
+
+/*
+
+        IMPLEMENTATIONS
+
+*/
+
+inline auto command_buffer::allocate(command_type type, std::size_t payload_size) -> std::byte*
+{
+    auto const total = align_up(sizeof(command_header)) + align_up(payload_size);
+
+    // move on to the next chunk that fits, reusing the ones kept from previous frames.
+    while (m_current < m_chunks.size() && m_chunks[m_current].used + total > m_chunks[m_current].capacity) {
+        ++m_current;
+    }
+    if (m_current == m_chunks.size()) {
+        auto const capacity = std::max(chunk_size, total);
+        m_chunks.push_back({ std::make_unique_for_overwrite<std::byte[]>(capacity), capacity, 0 }); // NOLINT (c-arrays)
+    }
+
+    auto& current = m_chunks[m_current];
+    if (type == command_type::draw) {
+        m_phase_drawn = true;
+    } else if (type != command_type::draw_upload && m_phase_drawn) {
+        // the draws recorded so far must not see this update.
+        m_phase_starts.push_back({ m_current, current.used });
+        m_phase_drawn = false;
+    }
+
+    auto* header = current.data.get() + current.used;
+    current.used += total;
+    ++m_commands;
+
+    command_header const value { type, static_cast<std::uint32_t>(payload_size) };
+    std::memcpy(header, &value, sizeof(value));
+    return header + align_up(sizeof(command_header));
+}
+
+inline void command_buffer::draw(draw_packet const& packet)
+{
+    static_assert(std::is_trivially_copyable_v<draw_packet>);
+
+    std::memcpy(allocate(command_type::draw, sizeof(packet)), &packet, sizeof(packet));
+    ++m_draws;
+}
+
+inline void command_buffer::draw(draw_packet const& packet, std::span<const std::byte> uniforms)
+{
+    assert(packet.uniforms.buffer != 0 && uniforms.size() <= packet.uniforms.size);
+
+    auto* payload = allocate(command_type::draw_upload, sizeof(upload_command) + uniforms.size());
+
+    upload_command const command { packet.uniforms.buffer, packet.uniforms.offset, uniforms.size() };
+    std::memcpy(payload, &command, sizeof(command));
+    std::memcpy(payload + sizeof(command), uniforms.data(), uniforms.size());
+
+    draw(packet);
+}
+
+inline void command_buffer::set_uniform(std::uint32_t program, std::int32_t location, shader_data_type::u_type type, std::span<const float> value)
+{
+    using shader_data_type::u_type;
+
+    if (type != u_type::float32 && type != u_type::vec2 && type != u_type::vec3
+        && type != u_type::vec4 && type != u_type::mat3 && type != u_type::mat4) [[unlikely]] {
+#ifdef STAPLEGL_DEBUG
+        std::fprintf(stderr, STAPLEGL_LINEINFO ", unsupported uniform type in command_buffer\n");
+#endif // STAPLEGL_DEBUG
+        std::terminate();
+    }
+
+    auto const components = std::min(value.size(), static_cast<std::size_t>(shader_data_type::component_count(type)));
+    auto* payload = allocate(command_type::uniform, sizeof(uniform_command) + components * sizeof(float));
+
+    uniform_command const command { program, location, type, static_cast<std::uint32_t>(components), 0 };
+    std::memcpy(payload, &command, sizeof(command));
+    std::memcpy(payload + sizeof(command), value.data(), components * sizeof(float));
+}
+
+inline void command_buffer::set_uniform(std::uint32_t program, std::int32_t location, std::int32_t value)
+{
+    uniform_command const command { program, location, shader_data_type::u_type::int32, 0, value };
+    std::memcpy(allocate(command_type::uniform, sizeof(command)), &command, sizeof(command));
+}
+
+inline void command_buffer::upload(std::uint32_t buffer, std::size_t offset, std::span<const std::byte> data)
+{
+    auto* payload = allocate(command_type::upload, sizeof(upload_command) + data.size());
+
+    upload_command const command { buffer, offset, data.size() };
+    std::memcpy(payload, &command, sizeof(command));
+    std::memcpy(payload + sizeof(command), data.data(), data.size());
+}
+
+inline void command_buffer::reset() noexcept
+{
+    for (auto& current : m_chunks) {
+        current.used = 0;
+    }
+    m_phase_starts.clear();
+    m_current = 0;
+    m_commands = 0;
+    m_draws = 0;
+    m_phase_drawn = false;
+}
+
+template <typename Visitor>
+inline void command_buffer::for_each(std::size_t phase, Visitor&& visitor) const
+{
+    auto const begin = phase == 0 ? position {} : m_phase_starts[phase - 1];
+    auto const end = phase < m_phase_starts.size() ? m_phase_starts[phase] : position { m_chunks.size(), 0 };
+
+    for (auto index = begin.chunk; index <= end.chunk && index < m_chunks.size(); ++index) {
+        auto const& current = m_chunks[index];
+        auto offset = index == begin.chunk ? begin.offset : 0;
+        auto const last = index == end.chunk ? end.offset : current.used;
+
+        while (offset < last) {
+            command_header header {};
+            std::memcpy(&header, current.data.get() + offset, sizeof(header));
+
+            auto const* payload = current.data.get() + offset + align_up(sizeof(command_header));
+            visitor(header.type, payload);
+
+            offset += align_up(sizeof(command_header)) + align_up(header.size);
+        }
+    }
+}
+
+inline void command_buffer::apply_updates(state_cache& cache, std::size_t phase) const noexcept
+{
+    using shader_data_type::u_type;
+
+    for_each(phase, [&cache](command_type type, const std::byte* payload) {
+        if (type == command_type::uniform) {
+            uniform_command command {};
+            std::memcpy(&command, payload, sizeof(command));
+
+            // only the components that were recorded, the others stay zero.
+            std::array<float, 16> value {};
+            std::memcpy(value.data(), payload + sizeof(command), command.components * sizeof(float));
+
+            cache.use_program(command.program);
+            switch (command.type) {
+            case u_type::int32:
+                glUniform1i(command.location, command.int_value);
+                break;
+            case u_type::float32:
+                glUniform1f(command.location, value[0]);
+                break;
+            case u_type::vec2:
+                glUniform2f(command.location, value[0], value[1]);
+                break;
+            case u_type::vec3:
+                glUniform3f(command.location, value[0], value[1], value[2]);
+                break;
+            case u_type::vec4:
+                glUniform4f(command.location, value[0], value[1], value[2], value[3]);
+                break;
+            case u_type::mat3:
+                glUniformMatrix3fv(command.location, 1, GL_FALSE, value.data());
+                break;
+            case u_type::mat4:
+                glUniformMatrix4fv(command.location, 1, GL_FALSE, value.data());
+                break;
+            default:
+                break;
+            }
+        } else if (type == command_type::upload || type == command_type::draw_upload) {
+            upload_command command {};
+            std::memcpy(&command, payload, sizeof(command));
+
+            // GL_COPY_WRITE_BUFFER is not part of any vertex array or program state.
+            glBindBuffer(GL_COPY_WRITE_BUFFER, command.buffer);
+            glBufferSubData(GL_COPY_WRITE_BUFFER, static_cast<GLintptr>(command.offset),
+                static_cast<GLsizeiptr>(command.size), payload + sizeof(command));
+        }
+    });
+}
+
+inline void command_buffer::enqueue_draws(command_queue& queue, std::size_t phase) const
+{
+    for_each(phase, [&queue](command_type type, const std::byte* payload) {
+        if (type == command_type::draw) {
+            draw_packet packet {};
+            std::memcpy(&packet, payload, sizeof(packet));
+            queue.push(packet);
+        }
+    });
+}
+
+inline auto execute_command_buffers(std::span<const command_buffer> buffers, command_queue& queue, state_cache& cache) -> queue_stats
+{
+    std::size_t draws {};
+    std::size_t phases {};
+    for (auto const& buffer : buffers) {
+        draws += buffer.draw_count();
+        phases = std::max(phases, buffer.phase_count());
+    }
+    queue.reserve(queue.size() + draws);
+
+    queue_stats total {};
+    for (std::size_t phase = 0; phase < phases; ++phase) {
+        for (auto const& buffer : buffers) {
+            if (phase < buffer.phase_count()) {
+                buffer.apply_updates(cache, phase);
+            }
+        }
+        for (auto const& buffer : buffers) {
+            if (phase < buffer.phase_count()) {
+                buffer.enqueue_draws(queue, phase);
+            }
+        }
+
+        queue.submit(cache);
+        queue.clear();
+
+        total.packets += queue.stats().packets;
+        total.binds_unsorted += queue.stats().binds_unsorted;
+        total.binds_sorted += queue.stats().binds_sorted;
+    }
+
+    return total;
+}
+
+} // namespace staplegl
@@ -16,7 +16,9 @@
 
 #pragma once
 
+#include "deletion_queue.hpp"
 #include "gl_functions.hpp"
+#include "name_pool.hpp"
 #include "texture.hpp"
 #include "utility.hpp"
 
@@ -55,7 +57,7 @@ public:
     ~cubemap() noexcept
     {
         if (m_id != 0) {
-            glDeleteTextures(1, &m_id);
+            release_object(gl_object::texture, m_id);
         }
     }
 
@@ -148,7 +150,7 @@ inline cubemap::cubemap(std::span<std::span<std::byte>, 6> data, resolution res,
     , m_color(color)
     , m_filter(filter)
 {
-    glGenTextures(1, &m_id);
+    m_id = acquire_name(gl_object::texture);
     glBindTexture(GL_TEXTURE_CUBE_MAP, m_id);
 
     glTextureParameteri(m_id, GL_TEXTURE_WRAP_S, filter.clamping);
@@ -0,0 +1,225 @@
+/**
+ * @file deletion_queue.hpp
+ * @author Dario Loi
+ * @brief Deferred, batched deletion of OpenGL objects.
+ *
+ * @date 2026-10-17
+ *
+ * @copyright MIT License
+ *
+ * @details The wrappers delete their OpenGL object as soon as they are destroyed, which only
+ * works on the thread that owns the context, and may stall the driver mid-frame. Once a
+ * deletion_queue is installed through set_deletion_queue, destructors hand their names to the
+ * queue instead, from any thread, and the render thread deletes them all at once with flush(),
+ * e.g. at the end of the frame. <br>
+ *
+ * Any number of threads can release objects concurrently, while flush() must only be called on
+ * the thread owning the context. Releasing only holds a lock for as long as it takes to append
+ * to a vector, which flush() swaps out with one it keeps from the previous frame: once the
+ * vectors have grown to the number of objects released in a frame, nothing is allocated. Names
+ * of the same kind are deleted together with a single `glDelete*` call, or retired to the
+ * installed name_pools, which are then flushed as well.
+ *
+ * @code{.cpp}
+ * staplegl::deletion_queue deletions;
+ * staplegl::set_deletion_queue(&deletions);
+ *
+ * while (running) {
+ *     render_frame();           // workers may destroy meshes and textures meanwhile
+ *     deletions.flush();
+ * }
+ *
+ * staplegl::set_deletion_queue(nullptr); // the queue flushes what is left when destroyed
+ * @endcode
+ */
+
+#pragma once
+
+#include "gl_functions.hpp"
+#include "name_pool.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <span>
+#include <vector>
+
+namespace staplegl {
+
+/**
+ * @brief Multi-producer queue of OpenGL names to delete on the render thread.
+ *
+ */
+class deletion_queue {
+public:
+    deletion_queue() = default;
+    ~deletion_queue();
+
+    deletion_queue(const deletion_queue&) = delete;
+    auto operator=(const deletion_queue&) -> deletion_queue& = delete;
+    deletion_queue(deletion_queue&&) = delete;
+    auto operator=(deletion_queue&&) -> deletion_queue& = delete;
+
+    /**
+     * @brief Schedule an object for deletion, callable from any thread.
+     *
+     * @param kind the kind of the object.
+     * @param name the object name, 0 is ignored.
+     */
+    void push(gl_object kind, std::uint32_t name) { push(kind, std::span { &name, 1 }); }
+
+    /**
+     * @brief Schedule objects of the same kind for deletion, callable from any thread.
+     *
+     * @param kind the kind of the objects.
+     * @param names the object names, 0 is ignored.
+     */
+    void push(gl_object kind, std::span<const std::uint32_t> names);
+
+    /**
+     * @brief Delete every scheduled object, on the thread owning the context.
+     *
+     * @return std::size_t the number of objects deleted.
+     */
+    auto flush() -> std::size_t;
+
+    /**
+     * @brief Whether no object is waiting to be deleted.
+     *
+     */
+    [[nodiscard]] auto empty() const -> bool
+    {
+        std::scoped_lock const lock { m_mutex };
+        return m_pending.empty();
+    }
+
+private:
+    static constexpr std::size_t kind_count = static_cast<std::size_t>(gl_object::program) + 1;
+
+    struct entry {
+        gl_object kind;
+        std::uint32_t name;
+    };
+
+    mutable std::mutex m_mutex;
+    std::vector<entry> m_pending;  ///< guarded by m_mutex.
+    std::vector<entry> m_flushing; ///< swapped with m_pending by flush, reused.
+    std::array<std::vector<std::uint32_t>, kind_count> m_names {}; ///< flush scratch, reused.
+};
+
+namespace detail {
+
+    inline auto installed_deletion_queue() noexcept -> std::atomic<deletion_queue*>&
+    {
+        static std::atomic<deletion_queue*> queue {};
+        return queue;
+    }
+
+} // namespace detail
+
+/**
+ * @brief Install the queue the wrappers release their objects to.
+ *
+ * @param queue the queue, or nullptr to delete objects immediately again (the default).
+ */
+inline void set_deletion_queue(deletion_queue* queue) noexcept
+{
+    detail::installed_deletion_queue().store(queue, std::memory_order_release);
+}
+
+/**
+ * @brief Delete an OpenGL object, or schedule its deletion if a deletion_queue is installed.
+ *
+ * @details This is what the destructors of the wrappers call. If name_pools are installed,
+ * the name is retired to its pool, which deletes it with the others when flushed.
+ *
+ * @param kind the kind of the object.
+ * @param name the object name, 0 is ignored.
+ */
+void release_object(gl_object kind, std::uint32_t name);
+
+/**
+ * @brief Delete OpenGL objects of the same kind at once, or schedule their deletion.
+ *
+ * @details The batched form of release_object, e.g. for wrappers owning many objects.
+ *
+ * @param kind the kind of the objects.
+ * @param names the object names, 0 is ignored.
+ */
+void release_objects(gl_object kind, std::span<const std::uint32_t> names);
+
+/*
+
+        IMPLEMENTATIONS
+
+*/
+
+inline deletion_queue::~deletion_queue()
+{
+    flush();
+}
+
+inline void deletion_queue::push(gl_object kind, std::span<const std::uint32_t> names)
+{
+    std::scoped_lock const lock { m_mutex };
+    for (auto const name : names) {
+        if (name != 0) {
+            m_pending.push_back({ kind, name });
+        }
+    }
+}
+
+inline auto deletion_queue::flush() -> std::size_t
+{
+    {
+        // take the whole batch at once, producers keep appending to the emptied vector.
+        std::scoped_lock const lock { m_mutex };
+        m_pending.swap(m_flushing);
+    }
+
+    for (auto const& [kind, name] : m_flushing) {
+        m_names[static_cast<std::size_t>(kind)].push_back(name);
+    }
+    auto const deleted = m_flushing.size();
+    m_flushing.clear();
+
+    for (std::size_t kind = 0; kind < kind_count; ++kind) {
+        if (!m_names[kind].empty()) {
+            detail::return_objects(static_cast<gl_object>(kind), m_names[kind]);
+            m_names[kind].clear();
+        }
+    }
+
+    if (auto* pools = detail::installed_name_pools(); pools != nullptr) {
+        pools->flush();
+    }
+
+    return deleted;
+}
+
+inline void release_object(gl_object kind, std::uint32_t name)
+{
+    if (name == 0) {
+        return;
+    }
+
+    release_objects(kind, std::span { &name, 1 });
+}
+
+inline void release_objects(gl_object kind, std::span<const std::uint32_t> names)
+{
+    if (names.empty()) {
+        return;
+    }
+
+    if (auto* queue = detail::installed_deletion_queue().load(std::memory_order_acquire); queue != nullptr) {
+        queue->push(kind, names);
+        return;
+    }
+
+    detail::return_objects(kind, names);
+}
+
+} // namespace staplegl
@@ -15,7 +15,9 @@
 
 #pragma once
 
+#include "deletion_queue.hpp"
 #include "gl_functions.hpp"
+#include "name_pool.hpp"
 #include "renderbuffer.hpp"
 #include "texture.hpp"
 #include "utility.hpp"
@@ -181,13 +183,13 @@ private:
  */
 inline framebuffer::framebuffer() noexcept
 {
-    glGenFramebuffers(1, &m_id);
+    m_id = acquire_name(gl_object::framebuffer);
 }
 
 inline framebuffer::~framebuffer()
 {
     if (m_id != 0) {
-        glDeleteFramebuffers(1, &m_id);
+        release_object(gl_object::framebuffer, m_id);
     }
 }
 
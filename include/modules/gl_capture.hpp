@@ -0,0 +1,280 @@
+/**
+ * @file gl_capture.hpp
+ * @author Dario Loi
+ * @brief Compact binary serialization of recorded command streams.
+ *
+ * @date 2026-10-17
+ *
+ * @copyright MIT License
+ *
+ * @details Saves a staplegl::instrument::capture (calls, payloads and frame boundaries) to a
+ * stream and loads it back, so that a frame can be captured in production and replayed offline
+ * with the `replay` tool. <br>
+ *
+ * The format is little-endian, integers are LEB128 varints, argument and result bits are
+ * zigzag-encoded first so that small negative values (e.g. `-1` uniform locations) stay small:
+ *
+ * @code
+ * "SGLC" | version (u32)
+ * name count | { length | gl function name }*      the writer's gl_call table
+ * frame count | { frame end }*
+ * call count | { call index | arg count (u8) | { arg }* | result | payload size | payload bytes }*
+ * @endcode
+ *
+ * Calls are stored by index into the writer's own table of function names, which the reader
+ * maps back to its gl_call values, so captures survive changes to the instrumented call list.
+ * Client pointers (see is_client_pointer) and returned pointers are stored as 0/1 flags, their
+ * addresses are meaningless outside the recording process and would make captures of the same
+ * frame differ from run to run. Fences are kept as returned by the driver, the replayer only
+ * uses them to pair the waits with their fence.
+ *
+ * @see gl_recorder.hpp
+ */
+
+#pragma once
+
+#include "gl_recorder.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <istream>
+#include <limits>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace staplegl::instrument {
+
+/**
+ * @brief Write a recording in the binary capture format.
+ *
+ * @param out the output stream, must be opened in binary mode.
+ * @param log the recording.
+ */
+inline void write_capture(std::ostream& out, capture const& log);
+
+/**
+ * @brief Read a recording written by write_capture.
+ *
+ * @param in the input stream, must be opened in binary mode.
+ * @return std::optional<capture> the recording, empty if the stream is not a valid capture or
+ * refers to functions unknown to this build.
+ */
+[[nodiscard]] inline auto read_capture(std::istream& in) -> std::optional<capture>;
+
+/*
+
+        IMPLEMENTATIONS
+
+*/
+
+namespace detail {
+
+    inline constexpr std::array<char, 4> capture_magic { 'S', 'G', 'L', 'C' };
+    inline constexpr std::uint32_t capture_version = 1;
+
+    constexpr auto zigzag(std::uint64_t bits) noexcept -> std::uint64_t
+    {
+        auto const value = static_cast<std::int64_t>(bits);
+        return (bits << 1U) ^ static_cast<std::uint64_t>(value >> 63); // NOLINT (hicpp-signed-bitwise)
+    }
+
+    constexpr auto unzigzag(std::uint64_t bits) noexcept -> std::uint64_t
+    {
+        return (bits >> 1U) ^ (~(bits & 1U) + 1U);
+    }
+
+    inline void write_varint(std::ostream& out, std::uint64_t value)
+    {
+        while (value >= 0x80U) {
+            out.put(static_cast<char>((value & 0x7FU) | 0x80U));
+            value >>= 7U;
+        }
+        out.put(static_cast<char>(value));
+    }
+
+    inline auto read_varint(std::istream& in, std::uint64_t& value) -> bool
+    {
+        value = 0;
+        for (std::uint32_t shift = 0; shift < 64; shift += 7) {
+            auto const byte = in.get();
+            if (byte == std::istream::traits_type::eof()) {
+                return false;
+            }
+
+            value |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+} // namespace detail
+
+inline void write_capture(std::ostream& out, capture const& log)
+{
+    using detail::write_varint;
+
+    out.write(detail::capture_magic.data(), detail::capture_magic.size());
+    for (std::uint32_t shift = 0; shift < 32; shift += 8) {
+        out.put(static_cast<char>((detail::capture_version >> shift) & 0xFFU));
+    }
+
+    write_varint(out, gl_call_count);
+    for (std::size_t i = 0; i < gl_call_count; ++i) {
+        auto const function = name(static_cast<gl_call>(i));
+        write_varint(out, function.size());
+        out.write(function.data(), static_cast<std::streamsize>(function.size()));
+    }
+
+    write_varint(out, log.frame_ends.size());
+    for (auto const frame_end : log.frame_ends) {
+        write_varint(out, frame_end);
+    }
+
+    write_varint(out, log.calls.size());
+    for (auto const& call : log.calls) {
+        write_varint(out, static_cast<std::uint64_t>(call.call));
+        out.put(static_cast<char>(call.arg_count));
+        for (std::size_t i = 0; i < call.arg_count; ++i) {
+            bool const client_pointer = is_client_pointer(call.call, i);
+            write_varint(out, client_pointer ? std::uint64_t { call.args[i] != 0 } : detail::zigzag(call.args[i]));
+        }
+
+        bool const pointer = returns_pointer(call.call);
+        write_varint(out, pointer ? std::uint64_t { call.result != 0 } : detail::zigzag(call.result));
+
+        auto const payload = log.payload(call);
+        write_varint(out, payload.size());
+        out.write(reinterpret_cast<const char*>(payload.data()), static_cast<std::streamsize>(payload.size())); // NOLINT (reinterpret-cast)
+    }
+}
+
+inline auto read_capture(std::istream& in) -> std::optional<capture>
+{
+    using detail::read_varint;
+
+    std::array<char, 4> magic {};
+    std::array<unsigned char, 4> version_bytes {};
+    in.read(magic.data(), magic.size());
+    in.read(reinterpret_cast<char*>(version_bytes.data()), version_bytes.size()); // NOLINT (reinterpret-cast)
+
+    std::uint32_t version {};
+    for (std::uint32_t i = 0; i < 4; ++i) {
+        version |= static_cast<std::uint32_t>(version_bytes[i]) << (8U * i);
+    }
+
+    if (!in || magic != detail::capture_magic || version != detail::capture_version) [[unlikely]] {
+#ifdef STAPLEGL_DEBUG
+        std::fprintf(stderr, STAPLEGL_LINEINFO ", not a staplegl capture (or an unsupported version)\n");
+#endif // STAPLEGL_DEBUG
+        return std::nullopt;
+    }
+
+    // map the writer's call table onto ours.
+    std::uint64_t name_count {};
+    if (!read_varint(in, name_count) || name_count > std::numeric_limits<std::uint16_t>::max()) {
+        return std::nullopt;
+    }
+
+    std::vector<gl_call> calls_by_index;
+    calls_by_index.reserve(name_count);
+    for (std::uint64_t i = 0; i < name_count; ++i) {
+        std::uint64_t length {};
+        if (!read_varint(in, length) || length > 256) {
+            return std::nullopt;
+        }
+
+        std::string function(length, '\0');
+        in.read(function.data(), static_cast<std::streamsize>(length));
+
+        std::size_t found = gl_call_count;
+        for (std::size_t j = 0; j < gl_call_count; ++j) {
+            if (name(static_cast<gl_call>(j)) == function) {
+                found = j;
+                break;
+            }
+        }
+
+        // an unknown function is only an error if a call to it is actually stored, checked below.
+        calls_by_index.push_back(static_cast<gl_call>(found));
+    }
+
+    capture log;
+
+    std::uint64_t frame_count {};
+    if (!read_varint(in, frame_count)) {
+        return std::nullopt;
+    }
+    log.frame_ends.resize(frame_count);
+    for (auto& frame_end : log.frame_ends) {
+        std::uint64_t value {};
+        if (!read_varint(in, value)) {
+            return std::nullopt;
+        }
+        frame_end = value;
+    }
+
+    std::uint64_t call_count {};
+    if (!read_varint(in, call_count)) {
+        return std::nullopt;
+    }
+    log.calls.reserve(std::min<std::uint64_t>(call_count, 1U << 20U)); // do not trust the count blindly
+
+    for (std::uint64_t i = 0; i < call_count; ++i) {
+        call_record call {};
+
+        std::uint64_t index {};
+        if (!read_varint(in, index) || index >= calls_by_index.size()
+            || static_cast<std::size_t>(calls_by_index[index]) >= gl_call_count) [[unlikely]] {
+#ifdef STAPLEGL_DEBUG
+            std::fprintf(stderr, STAPLEGL_LINEINFO ", capture refers to a function this build does not instrument\n");
+#endif // STAPLEGL_DEBUG
+            return std::nullopt;
+        }
+        call.call = calls_by_index[index];
+
+        auto const arg_count = in.get();
+        if (arg_count < 0 || static_cast<std::size_t>(arg_count) > max_call_args) {
+            return std::nullopt;
+        }
+        call.arg_count = static_cast<std::uint8_t>(arg_count);
+
+        for (std::size_t arg = 0; arg < call.arg_count; ++arg) {
+            if (!read_varint(in, call.args[arg])) {
+                return std::nullopt;
+            }
+            if (!is_client_pointer(call.call, arg)) {
+                call.args[arg] = detail::unzigzag(call.args[arg]);
+            }
+        }
+
+        std::uint64_t payload_size {};
+        if (!read_varint(in, call.result) || !read_varint(in, payload_size)) {
+            return std::nullopt;
+        }
+        if (!returns_pointer(call.call)) {
+            call.result = detail::unzigzag(call.result);
+        }
+
+        call.payload_offset = log.payloads.size();
+        call.payload_size = payload_size;
+        log.payloads.resize(log.payloads.size() + payload_size);
+        in.read(reinterpret_cast<char*>(log.payloads.data() + call.payload_offset), static_cast<std::streamsize>(payload_size)); // NOLINT (reinterpret-cast)
+
+        if (!in) [[unlikely]] {
+            return std::nullopt;
+        }
+
+        log.calls.push_back(call);
+    }
+
+    return log;
+}
+
+} // namespace staplegl::instrument
@@ -16,6 +16,10 @@
  *
  * For the examples, we are using glad.h, if you want to see the examples with a different
  * loader, you'll have to modify their loading code accordingly.
+ * <br>
+ *
+ * Defining `STAPLEGL_INSTRUMENT` before including any staplegl header redirects the OpenGL
+ * entry points through counting wrappers, see gl_instrumentation.hpp.
  *
  * @copyright MIT License
  *
@@ -32,4 +36,8 @@
 
 /* REPLACE THIS INCLUDE DIRECTIVE WITH THE OPENGL FUNCTION LOADER YOU ARE CURRENTLY USING */
 #include "glad.h"
-/*----------------------------------------------------------------------------------------*/
\ No newline at end of file
+/*----------------------------------------------------------------------------------------*/
+
+#ifdef STAPLEGL_INSTRUMENT
+#include "gl_instrumentation.hpp"
+#endif // STAPLEGL_INSTRUMENT
@@ -0,0 +1,933 @@
+/**
+ * @file gl_instrumentation.hpp
+ * @author Dario Loi
+ * @brief Opt-in call counting and byte-transfer instrumentation of OpenGL entry points.
+ *
+ * @date 2026-10-17
+ *
+ * @copyright MIT License
+ *
+ * @details When `STAPLEGL_INSTRUMENT` is defined, every OpenGL entry point used by the
+ * staplegl modules (and the common draw calls issued by users) is redirected through a thin
+ * counting wrapper before reaching the loader. The wrappers keep per-frame counters of:
+ *
+ * - calls per function,
+ * - draw calls and state changes (binds, uniform uploads, capability toggles, ...),
+ * - bytes uploaded through `glBufferData`, `glBufferSubData` and `glTexImage2D`.
+ *
+ * Counters can be queried from code, and dumped once per frame as a JSON line so that they
+ * can be ingested by external dashboards. <br>
+ *
+ * Without `STAPLEGL_INSTRUMENT` no call is redirected and every counter stays at zero, so
+ * the query API can be left in place in release builds. <br>
+ *
+ * The wrappers also act as a dispatch table: a gl_backend installed through set_backend
+ * receives every call, with its arguments, and decides whether it reaches the driver. This is
+ * the extension point used by gl_recorder.hpp to record, mock and replay command streams.
+ *
+ * @warning The counters are global and not synchronized, issue instrumented calls from
+ * a single thread (as OpenGL already requires).
+ *
+ * @note The wrappers are installed by redefining the entry points as macros after the loader
+ * has been included, hence the loader must be included through gl_functions.hpp first.
+ *
+ * @see gl_functions.hpp
+ */
+
+#pragma once
+
+#include "gl_functions.hpp"
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+/**
+ * @brief X-macro listing the instrumented entry points.
+ *
+ * @details Each entry is `X(id, function, category)`, where `id` is the enumerator in
+ * staplegl::instrument::gl_call and `category` a staplegl::instrument::call_category.
+ */
+#define STAPLEGL_INSTRUMENTED_CALLS(X)                                  \
+    X(active_texture, glActiveTexture, state)                           \
+    X(bind_buffer, glBindBuffer, state)                                 \
+    X(bind_buffer_base, glBindBufferBase, state)                        \
+    X(bind_buffer_range, glBindBufferRange, state)                      \
+    X(bind_framebuffer, glBindFramebuffer, state)                       \
+    X(bind_renderbuffer, glBindRenderbuffer, state)                     \
+    X(bind_texture, glBindTexture, state)                               \
+    X(bind_vertex_array, glBindVertexArray, state)                      \
+    X(use_program, glUseProgram, state)                                 \
+    X(viewport, glViewport, state)                                      \
+    X(enable, glEnable, state)                                          \
+    X(disable, glDisable, state)                                        \
+    X(depth_mask, glDepthMask, state)                                   \
+    X(blend_func, glBlendFunc, state)                                   \
+    X(blend_equation, glBlendEquation, state)                           \
+    X(front_face, glFrontFace, state)                                   \
+    X(clear_color, glClearColor, state)                                 \
+    X(polygon_mode, glPolygonMode, state)                               \
+    X(pixel_storei, glPixelStorei, state)                               \
+    X(enable_vertex_attrib_array, glEnableVertexAttribArray, state)     \
+    X(vertex_attrib_pointer, glVertexAttribPointer, state)              \
+    X(vertex_attrib_i_pointer, glVertexAttribIPointer, state)           \
+    X(vertex_attrib_divisor, glVertexAttribDivisor, state)              \
+    X(vertex_attrib_format, glVertexAttribFormat, state)                \
+    X(vertex_attrib_i_format, glVertexAttribIFormat, state)             \
+    X(vertex_attrib_binding, glVertexAttribBinding, state)              \
+    X(vertex_binding_divisor, glVertexBindingDivisor, state)            \
+    X(bind_vertex_buffer, glBindVertexBuffer, state)                    \
+    X(framebuffer_renderbuffer, glFramebufferRenderbuffer, state)       \
+    X(framebuffer_texture_2d, glFramebufferTexture2D, state)            \
+    X(tex_parameteri, glTexParameteri, state)                           \
+    X(texture_parameteri, glTextureParameteri, state)                   \
+    X(uniform_1i, glUniform1i, state)                                   \
+    X(uniform_1f, glUniform1f, state)                                   \
+    X(uniform_2f, glUniform2f, state)                                   \
+    X(uniform_3f, glUniform3f, state)                                   \
+    X(uniform_4f, glUniform4f, state)                                   \
+    X(uniform_matrix_3fv, glUniformMatrix3fv, state)                    \
+    X(uniform_matrix_4fv, glUniformMatrix4fv, state)                    \
+    X(draw_arrays, glDrawArrays, draw)                                  \
+    X(draw_elements, glDrawElements, draw)                              \
+    X(draw_arrays_instanced, glDrawArraysInstanced, draw)               \
+    X(draw_elements_instanced, glDrawElementsInstanced, draw)           \
+    X(draw_elements_instanced_base_instance, glDrawElementsInstancedBaseInstance, draw) \
+    X(clear, glClear, draw)                                             \
+    X(blit_framebuffer, glBlitFramebuffer, draw)                        \
+    X(buffer_data, glBufferData, transfer)                              \
+    X(buffer_sub_data, glBufferSubData, transfer)                       \
+    X(copy_buffer_sub_data, glCopyBufferSubData, transfer)              \
+    X(map_buffer, glMapBuffer, transfer)                                \
+    X(map_buffer_range, glMapBufferRange, transfer)                     \
+    X(unmap_buffer, glUnmapBuffer, transfer)                            \
+    X(tex_image_2d, glTexImage2D, transfer)                             \
+    X(read_pixels, glReadPixels, transfer)                              \
+    X(tex_image_2d_multisample, glTexImage2DMultisample, transfer)      \
+    X(renderbuffer_storage, glRenderbufferStorage, transfer)            \
+    X(renderbuffer_storage_multisample, glRenderbufferStorageMultisample, transfer) \
+    X(generate_mipmap, glGenerateMipmap, transfer)                      \
+    X(generate_texture_mipmap, glGenerateTextureMipmap, transfer)       \
+    X(gen_buffers, glGenBuffers, object)                                \
+    X(delete_buffers, glDeleteBuffers, object)                          \
+    X(gen_textures, glGenTextures, object)                              \
+    X(delete_textures, glDeleteTextures, object)                        \
+    X(gen_framebuffers, glGenFramebuffers, object)                      \
+    X(delete_framebuffers, glDeleteFramebuffers, object)                \
+    X(gen_renderbuffers, glGenRenderbuffers, object)                    \
+    X(delete_renderbuffers, glDeleteRenderbuffers, object)              \
+    X(gen_vertex_arrays, glGenVertexArrays, object)                     \
+    X(delete_vertex_arrays, glDeleteVertexArrays, object)               \
+    X(gen_queries, glGenQueries, object)                                \
+    X(delete_queries, glDeleteQueries, object)                          \
+    X(create_program, glCreateProgram, object)                          \
+    X(delete_program, glDeleteProgram, object)                          \
+    X(create_shader, glCreateShader, object)                            \
+    X(delete_shader, glDeleteShader, object)                            \
+    X(attach_shader, glAttachShader, object)                            \
+    X(detach_shader, glDetachShader, object)                            \
+    X(shader_source, glShaderSource, object)                            \
+    X(compile_shader, glCompileShader, object)                          \
+    X(link_program, glLinkProgram, object)                              \
+    X(validate_program, glValidateProgram, object)                      \
+    X(get_programiv, glGetProgramiv, query)                             \
+    X(get_program_info_log, glGetProgramInfoLog, query)                 \
+    X(get_shaderiv, glGetShaderiv, query)                               \
+    X(get_shader_info_log, glGetShaderInfoLog, query)                   \
+    X(get_uniform_location, glGetUniformLocation, query)                \
+    X(check_framebuffer_status, glCheckFramebufferStatus, query)        \
+    X(get_integerv, glGetIntegerv, query)                               \
+    X(get_string, glGetString, query)                                   \
+    X(query_counter, glQueryCounter, query)                             \
+    X(get_query_objectiv, glGetQueryObjectiv, query)                    \
+    X(get_query_objectui64v, glGetQueryObjectui64v, query)              \
+    X(fence_sync, glFenceSync, sync)                                    \
+    X(client_wait_sync, glClientWaitSync, sync)                         \
+    X(delete_sync, glDeleteSync, sync)                                  \
+    X(flush, glFlush, sync)
+
+namespace staplegl::instrument {
+
+/**
+ * @brief Broad classification of the instrumented calls.
+ *
+ */
+enum class call_category : std::uint8_t {
+    state, ///< binds, uniform uploads, capability toggles, attribute setup.
+    draw, ///< draws, clears and blits.
+    transfer, ///< data uploads, copies, mappings and storage allocations.
+    object, ///< creation and destruction of OpenGL objects.
+    query, ///< reads of OpenGL state, which may synchronize with the GPU.
+    sync, ///< fences, waits on them, and flushes of the command stream.
+};
+
+/**
+ * @brief Identifier of an instrumented OpenGL entry point.
+ *
+ */
+enum class gl_call : std::uint16_t {
+#define STAPLEGL_X(id, fn, category) id,
+    STAPLEGL_INSTRUMENTED_CALLS(STAPLEGL_X)
+#undef STAPLEGL_X
+};
+
+/**
+ * @brief Number of instrumented entry points.
+ *
+ */
+inline constexpr std::size_t gl_call_count = 0
+#define STAPLEGL_X(id, fn, category) +1
+    STAPLEGL_INSTRUMENTED_CALLS(STAPLEGL_X)
+#undef STAPLEGL_X
+    ;
+
+/**
+ * @brief Whether the entry points are being redirected through the counting wrappers.
+ *
+ */
+#ifdef STAPLEGL_INSTRUMENT
+inline constexpr bool enabled = true;
+#else
+inline constexpr bool enabled = false;
+#endif // STAPLEGL_INSTRUMENT
+
+/**
+ * @brief Get the OpenGL name of an instrumented entry point.
+ *
+ * @param call the entry point.
+ * @return std::string_view the name of the function, e.g. `"glBufferData"`.
+ */
+constexpr auto name(gl_call call) noexcept -> std::string_view
+{
+    constexpr std::array<std::string_view, gl_call_count> names {
+#define STAPLEGL_X(id, fn, category) #fn,
+        STAPLEGL_INSTRUMENTED_CALLS(STAPLEGL_X)
+#undef STAPLEGL_X
+    };
+
+    return names[static_cast<std::size_t>(call)];
+}
+
+/**
+ * @brief Get the category of an instrumented entry point.
+ *
+ * @param call the entry point.
+ * @return call_category the category of the call.
+ */
+constexpr auto category(gl_call call) noexcept -> call_category
+{
+    constexpr std::array<call_category, gl_call_count> categories {
+#define STAPLEGL_X(id, fn, category) call_category::category,
+        STAPLEGL_INSTRUMENTED_CALLS(STAPLEGL_X)
+#undef STAPLEGL_X
+    };
+
+    return categories[static_cast<std::size_t>(call)];
+}
+
+/**
+ * @brief A set of counters, either for a single frame or accumulated over the whole run.
+ *
+ */
+struct gl_counters {
+    std::array<std::uint64_t, gl_call_count> calls {};
+    std::uint64_t draw_calls {};
+    std::uint64_t state_changes {};
+    std::uint64_t buffer_data_bytes {}; ///< bytes uploaded through glBufferData.
+    std::uint64_t buffer_sub_data_bytes {}; ///< bytes uploaded through glBufferSubData.
+    std::uint64_t tex_image_bytes {}; ///< bytes uploaded through glTexImage2D.
+    std::uint64_t copied_bytes {}; ///< bytes copied GPU-side through glCopyBufferSubData.
+    std::uint64_t read_pixels_bytes {}; ///< bytes read back through glReadPixels.
+
+    /**
+     * @brief Get the number of calls made to an entry point.
+     *
+     * @param call the entry point.
+     * @return std::uint64_t the number of calls.
+     */
+    [[nodiscard]] constexpr auto count(gl_call call) const noexcept -> std::uint64_t
+    {
+        return calls[static_cast<std::size_t>(call)];
+    }
+
+    /**
+     * @brief Get the total number of bytes uploaded from the CPU to the GPU.
+     *
+     * @return std::uint64_t the total number of uploaded bytes.
+     */
+    [[nodiscard]] constexpr auto bytes_uploaded() const noexcept -> std::uint64_t
+    {
+        return buffer_data_bytes + buffer_sub_data_bytes + tex_image_bytes;
+    }
+
+    /**
+     * @brief Get the total number of instrumented calls.
+     *
+     * @return std::uint64_t the total number of calls.
+     */
+    [[nodiscard]] constexpr auto total_calls() const noexcept -> std::uint64_t
+    {
+        std::uint64_t total {};
+        for (auto const count : calls) {
+            total += count;
+        }
+        return total;
+    }
+
+    constexpr auto operator+=(gl_counters const& other) noexcept -> gl_counters&
+    {
+        for (std::size_t i = 0; i < gl_call_count; ++i) {
+            calls[i] += other.calls[i];
+        }
+        draw_calls += other.draw_calls;
+        state_changes += other.state_changes;
+        buffer_data_bytes += other.buffer_data_bytes;
+        buffer_sub_data_bytes += other.buffer_sub_data_bytes;
+        tex_image_bytes += other.tex_image_bytes;
+        copied_bytes += other.copied_bytes;
+        read_pixels_bytes += other.read_pixels_bytes;
+        return *this;
+    }
+};
+
+/**
+ * @brief Maximum number of arguments taken by an instrumented entry point (glBlitFramebuffer).
+ *
+ */
+inline constexpr std::size_t max_call_args = 10;
+
+/**
+ * @brief Encode an argument or return value of an OpenGL call into 64 bits.
+ *
+ * @details Pointers keep their address, floats their bit pattern and integers their value,
+ * so that from_bits can recover the original value given its type.
+ */
+template <typename T>
+constexpr auto to_bits(T value) noexcept -> std::uint64_t
+{
+    if constexpr (std::is_pointer_v<T>) {
+        return reinterpret_cast<std::uintptr_t>(value); // NOLINT (reinterpret-cast)
+    } else if constexpr (std::is_floating_point_v<T>) {
+        return std::bit_cast<std::uint32_t>(static_cast<float>(value));
+    } else {
+        return static_cast<std::uint64_t>(value);
+    }
+}
+
+/**
+ * @brief Decode a value encoded by to_bits.
+ *
+ */
+template <typename T>
+constexpr auto from_bits(std::uint64_t bits) noexcept -> T
+{
+    if constexpr (std::is_pointer_v<T>) {
+        return reinterpret_cast<T>(static_cast<std::uintptr_t>(bits)); // NOLINT (reinterpret-cast, performance-no-int-to-ptr)
+    } else if constexpr (std::is_floating_point_v<T>) {
+        return static_cast<T>(std::bit_cast<float>(static_cast<std::uint32_t>(bits)));
+    } else {
+        return static_cast<T>(bits);
+    }
+}
+
+/**
+ * @brief A single OpenGL call, as seen by a gl_backend.
+ *
+ * @details Arguments are stored as given by the caller, pointer arguments therefore refer to
+ * the caller's memory and are only valid for the duration of the call. Backends that keep
+ * records around (see staplegl::instrument::recorder) copy the pointed-to data aside and fill
+ * in the payload fields.
+ */
+struct call_record {
+    gl_call call {};
+    std::uint8_t arg_count {};
+    std::array<std::uint64_t, max_call_args> args {};
+    std::uint64_t result {}; ///< the return value, as encoded by to_bits.
+    std::size_t payload_offset {}; ///< offset of the copied data in the backend's payload storage.
+    std::size_t payload_size {}; ///< size in bytes of the copied data, 0 if none.
+
+    template <typename T>
+    [[nodiscard]] constexpr auto arg(std::size_t index) const noexcept -> T
+    {
+        return from_bits<T>(args[index]);
+    }
+};
+
+/**
+ * @brief Type-erased handle that issues the call being dispatched to the driver.
+ *
+ */
+class call_forwarder {
+public:
+    using function_type = auto (*)(void*) -> std::uint64_t;
+
+    constexpr call_forwarder(void* context, function_type function) noexcept
+        : m_context { context }
+        , m_function { function }
+    {
+    }
+
+    /**
+     * @brief Issue the call to the driver.
+     *
+     * @return std::uint64_t the return value of the call, encoded by to_bits.
+     */
+    auto operator()() const -> std::uint64_t { return m_function(m_context); }
+
+private:
+    void* m_context;
+    function_type m_function;
+};
+
+/**
+ * @brief Pluggable backend receiving every instrumented call.
+ *
+ * @see set_backend
+ */
+class gl_backend {
+public:
+    gl_backend() = default;
+    virtual ~gl_backend() = default;
+
+    gl_backend(const gl_backend&) = delete;
+    auto operator=(const gl_backend&) -> gl_backend& = delete;
+    gl_backend(gl_backend&&) = delete;
+    auto operator=(gl_backend&&) -> gl_backend& = delete;
+
+    /**
+     * @brief Handle a call.
+     *
+     * @param call the call, its `result` field is filled by the caller with the returned value.
+     * @param forward issues the call to the driver, a backend may skip it entirely.
+     * @return std::uint64_t the value returned to the caller, encoded by to_bits.
+     */
+    virtual auto dispatch(call_record& call, call_forwarder forward) -> std::uint64_t = 0;
+};
+
+namespace detail {
+
+    struct registry {
+        gl_counters frame;
+        gl_counters total;
+        std::uint64_t frame_index {};
+        std::ostream* sink {};
+        gl_backend* backend {};
+    };
+
+    inline auto get_registry() noexcept -> registry&
+    {
+        static registry instance;
+        return instance;
+    }
+
+    /**
+     * @brief Size in bytes of a texel with the given client-side format and type.
+     *
+     * @note Unknown combinations report 0 bytes rather than guessing.
+     */
+    constexpr auto texel_size(std::uint32_t format, std::uint32_t type) noexcept -> std::uint64_t
+    {
+        std::uint64_t components {};
+        switch (format) {
+        case GL_RED:
+        case GL_RED_INTEGER:
+        case GL_DEPTH_COMPONENT:
+        case GL_STENCIL_INDEX:
+            components = 1;
+            break;
+        case GL_RG:
+        case GL_RG_INTEGER:
+            components = 2;
+            break;
+        case GL_RGB:
+        case GL_BGR:
+        case GL_RGB_INTEGER:
+            components = 3;
+            break;
+        case GL_RGBA:
+        case GL_BGRA:
+        case GL_RGBA_INTEGER:
+            components = 4;
+            break;
+        case GL_DEPTH_STENCIL:
+            return 4; // packed 24/8 or 32F/8, the latter is not accounted for.
+        default:
+            return 0;
+        }
+
+        switch (type) {
+        case GL_UNSIGNED_BYTE:
+        case GL_BYTE:
+            return components;
+        case GL_UNSIGNED_SHORT:
+        case GL_SHORT:
+        case GL_HALF_FLOAT:
+            return components * 2;
+        case GL_UNSIGNED_INT:
+        case GL_INT:
+        case GL_FLOAT:
+            return components * 4;
+        default:
+            return 0;
+        }
+    }
+
+    template <gl_call Call, typename... Args>
+    inline void account(Args const&... args) noexcept
+    {
+        auto& counters = get_registry().frame;
+        ++counters.calls[static_cast<std::size_t>(Call)];
+
+        if constexpr (category(Call) == call_category::draw) {
+            if constexpr (Call != gl_call::clear && Call != gl_call::blit_framebuffer) {
+                ++counters.draw_calls;
+            }
+        } else if constexpr (category(Call) == call_category::state) {
+            ++counters.state_changes;
+        }
+
+        if constexpr (Call == gl_call::buffer_data) {
+            auto const& [target, size, data, usage] = std::tie(args...);
+            if (data != nullptr) {
+                counters.buffer_data_bytes += static_cast<std::uint64_t>(size);
+            }
+        } else if constexpr (Call == gl_call::buffer_sub_data) {
+            auto const& [target, offset, size, data] = std::tie(args...);
+            counters.buffer_sub_data_bytes += static_cast<std::uint64_t>(size);
+        } else if constexpr (Call == gl_call::copy_buffer_sub_data) {
+            auto const& [read_target, write_target, read_offset, write_offset, size] = std::tie(args...);
+            counters.copied_bytes += static_cast<std::uint64_t>(size);
+        } else if constexpr (Call == gl_call::tex_image_2d) {
+            auto const& [target, level, internal_format, width, height, border, format, type, pixels] = std::tie(args...);
+            if (pixels != nullptr) {
+                counters.tex_image_bytes += static_cast<std::uint64_t>(width) * static_cast<std::uint64_t>(height)
+                    * texel_size(static_cast<std::uint32_t>(format), static_cast<std::uint32_t>(type));
+            }
+        } else if constexpr (Call == gl_call::read_pixels) {
+            auto const& [x, y, width, height, format, type, pixels] = std::tie(args...);
+            counters.read_pixels_bytes += static_cast<std::uint64_t>(width) * static_cast<std::uint64_t>(height)
+                * texel_size(static_cast<std::uint32_t>(format), static_cast<std::uint32_t>(type));
+        }
+    }
+
+    template <gl_call Call, typename R, typename... Params>
+    inline auto dispatch(gl_backend& backend, R(APIENTRYP function)(Params...), Params... params) -> R
+    {
+        call_record record { .call = Call,
+            .arg_count = sizeof...(Params),
+            .args = { to_bits(params)... } };
+
+        struct context {
+            R(APIENTRYP function)(Params...);
+            std::tuple<Params...> params;
+        } ctx { function, { params... } };
+
+        call_forwarder const forward { &ctx, [](void* erased) -> std::uint64_t {
+                                          auto& [fn, args] = *static_cast<context*>(erased);
+                                          if constexpr (std::is_void_v<R>) {
+                                              std::apply(fn, args);
+                                              return 0;
+                                          } else {
+                                              return to_bits(std::apply(fn, args));
+                                          }
+                                      } };
+
+        std::uint64_t const result = backend.dispatch(record, forward);
+        if constexpr (!std::is_void_v<R>) {
+            return from_bits<R>(result);
+        }
+    }
+
+    template <gl_call Call, typename R, typename... Params, typename... Args>
+    inline auto invoke(R(APIENTRYP function)(Params...), Args... args) -> R
+    {
+        account<Call>(args...);
+
+        gl_backend* const backend = get_registry().backend;
+        if (backend == nullptr) [[likely]] {
+            return function(args...);
+        }
+
+        // the arguments are converted to the parameter types here, as they would be by a direct call.
+        return [&](Params... params) { return dispatch<Call>(*backend, function, params...); }(args...);
+    }
+
+    // capture the loader's entry points before they are redefined below.
+#define STAPLEGL_X(id, fn, category) \
+    inline auto real_##id() noexcept { return fn; }
+    STAPLEGL_INSTRUMENTED_CALLS(STAPLEGL_X)
+#undef STAPLEGL_X
+
+} // namespace detail
+
+/**
+ * @brief Get the counters accumulated since the last call to end_frame.
+ *
+ * @return gl_counters const& the counters of the current frame.
+ */
+inline auto frame_counters() noexcept -> gl_counters const&
+{
+    return detail::get_registry().frame;
+}
+
+/**
+ * @brief Get the counters accumulated over every completed frame.
+ *
+ * @return gl_counters const& the counters of the whole run.
+ */
+inline auto total_counters() noexcept -> gl_counters const&
+{
+    return detail::get_registry().total;
+}
+
+/**
+ * @brief Set the stream that receives one JSON line per frame on end_frame.
+ *
+ * @param sink the output stream, pass `nullptr` to stop dumping frames.
+ */
+inline void set_frame_sink(std::ostream* sink) noexcept
+{
+    detail::get_registry().sink = sink;
+}
+
+/**
+ * @brief Write a set of counters as a single-line JSON object.
+ *
+ * @details Only entry points that were called at least once appear in the `calls` object, e.g.:
+ *
+ * @code{.json}
+ * {"frame":12,"draw_calls":9,"state_changes":61,"bytes_uploaded":1664,"buffer_data_bytes":0,
+ *  "buffer_sub_data_bytes":1664,"tex_image_bytes":0,"copied_bytes":0,"read_pixels_bytes":0,
+ *  "calls":{"glBindBuffer":4,...}}
+ * @endcode
+ *
+ * @param out the output stream.
+ * @param counters the counters to write.
+ * @param frame the index of the frame the counters belong to.
+ */
+inline void write_json(std::ostream& out, gl_counters const& counters, std::uint64_t frame)
+{
+    out << R"({"frame":)" << frame
+        << R"(,"draw_calls":)" << counters.draw_calls
+        << R"(,"state_changes":)" << counters.state_changes
+        << R"(,"bytes_uploaded":)" << counters.bytes_uploaded()
+        << R"(,"buffer_data_bytes":)" << counters.buffer_data_bytes
+        << R"(,"buffer_sub_data_bytes":)" << counters.buffer_sub_data_bytes
+        << R"(,"tex_image_bytes":)" << counters.tex_image_bytes
+        << R"(,"copied_bytes":)" << counters.copied_bytes
+        << R"(,"read_pixels_bytes":)" << counters.read_pixels_bytes
+        << R"(,"calls":{)";
+
+    bool first = true;
+    for (std::size_t i = 0; i < gl_call_count; ++i) {
+        if (counters.calls[i] == 0) {
+            continue;
+        }
+        if (!first) {
+            out << ',';
+        }
+        first = false;
+        out << '"' << name(static_cast<gl_call>(i)) << R"(":)" << counters.calls[i];
+    }
+
+    out << "}}\n";
+}
+
+/**
+ * @brief Close the current frame.
+ *
+ * @details Dumps the frame's counters to the sink (if any), folds them into the totals and
+ * resets them for the next frame.
+ */
+inline void end_frame()
+{
+    auto& registry = detail::get_registry();
+
+    if (registry.sink != nullptr) {
+        write_json(*registry.sink, registry.frame, registry.frame_index);
+    }
+
+    registry.total += registry.frame;
+    registry.frame = {};
+    ++registry.frame_index;
+}
+
+/**
+ * @brief Install a backend that receives every instrumented call.
+ *
+ * @details Has no effect on the calls unless `STAPLEGL_INSTRUMENT` is defined.
+ *
+ * @param backend the backend, `nullptr` sends the calls straight to the driver again.
+ * @return gl_backend* the previously installed backend.
+ */
+inline auto set_backend(gl_backend* backend) noexcept -> gl_backend*
+{
+    return std::exchange(detail::get_registry().backend, backend);
+}
+
+/**
+ * @brief Get the backend currently receiving the instrumented calls.
+ *
+ * @return gl_backend* the backend, `nullptr` if the calls go straight to the driver.
+ */
+inline auto get_backend() noexcept -> gl_backend*
+{
+    return detail::get_registry().backend;
+}
+
+/**
+ * @brief RAII guard installing a backend for its lifetime and restoring the previous one.
+ *
+ */
+class scoped_backend {
+public:
+    explicit scoped_backend(gl_backend& backend) noexcept
+        : m_previous { set_backend(&backend) }
+    {
+    }
+
+    ~scoped_backend() { set_backend(m_previous); }
+
+    scoped_backend(const scoped_backend&) = delete;
+    auto operator=(const scoped_backend&) -> scoped_backend& = delete;
+    scoped_backend(scoped_backend&&) = delete;
+    auto operator=(scoped_backend&&) -> scoped_backend& = delete;
+
+private:
+    gl_backend* m_previous;
+};
+
+/**
+ * @brief Reset every counter, including the totals and the frame index.
+ *
+ */
+inline void reset() noexcept
+{
+    auto& registry = detail::get_registry();
+    registry.frame = {};
+    registry.total = {};
+    registry.frame_index = 0;
+}
+
+} // namespace staplegl::instrument
+
+#ifdef STAPLEGL_INSTRUMENT
+
+#define STAPLEGL_INSTRUMENTED(id, ...)                                        \
+    ::staplegl::instrument::detail::invoke<::staplegl::instrument::gl_call::id>( \
+        ::staplegl::instrument::detail::real_##id() __VA_OPT__(, ) __VA_ARGS__)
+
+// the preprocessor cannot emit directives, so every entry point is redirected by hand.
+
+#undef glActiveTexture
+#define glActiveTexture(...) STAPLEGL_INSTRUMENTED(active_texture, __VA_ARGS__)
+#undef glBindBuffer
+#define glBindBuffer(...) STAPLEGL_INSTRUMENTED(bind_buffer, __VA_ARGS__)
+#undef glBindBufferBase
+#define glBindBufferBase(...) STAPLEGL_INSTRUMENTED(bind_buffer_base, __VA_ARGS__)
+#undef glBindBufferRange
+#define glBindBufferRange(...) STAPLEGL_INSTRUMENTED(bind_buffer_range, __VA_ARGS__)
+#undef glBindFramebuffer
+#define glBindFramebuffer(...) STAPLEGL_INSTRUMENTED(bind_framebuffer, __VA_ARGS__)
+#undef glBindRenderbuffer
+#define glBindRenderbuffer(...) STAPLEGL_INSTRUMENTED(bind_renderbuffer, __VA_ARGS__)
+#undef glBindTexture
+#define glBindTexture(...) STAPLEGL_INSTRUMENTED(bind_texture, __VA_ARGS__)
+#undef glBindVertexArray
+#define glBindVertexArray(...) STAPLEGL_INSTRUMENTED(bind_vertex_array, __VA_ARGS__)
+#undef glUseProgram
+#define glUseProgram(...) STAPLEGL_INSTRUMENTED(use_program, __VA_ARGS__)
+#undef glViewport
+#define glViewport(...) STAPLEGL_INSTRUMENTED(viewport, __VA_ARGS__)
+#undef glEnable
+#define glEnable(...) STAPLEGL_INSTRUMENTED(enable, __VA_ARGS__)
+#undef glDisable
+#define glDisable(...) STAPLEGL_INSTRUMENTED(disable, __VA_ARGS__)
+#undef glDepthMask
+#define glDepthMask(...) STAPLEGL_INSTRUMENTED(depth_mask, __VA_ARGS__)
+#undef glBlendFunc
+#define glBlendFunc(...) STAPLEGL_INSTRUMENTED(blend_func, __VA_ARGS__)
+#undef glBlendEquation
+#define glBlendEquation(...) STAPLEGL_INSTRUMENTED(blend_equation, __VA_ARGS__)
+#undef glFrontFace
+#define glFrontFace(...) STAPLEGL_INSTRUMENTED(front_face, __VA_ARGS__)
+#undef glClearColor
+#define glClearColor(...) STAPLEGL_INSTRUMENTED(clear_color, __VA_ARGS__)
+#undef glPolygonMode
+#define glPolygonMode(...) STAPLEGL_INSTRUMENTED(polygon_mode, __VA_ARGS__)
+#undef glPixelStorei
+#define glPixelStorei(...) STAPLEGL_INSTRUMENTED(pixel_storei, __VA_ARGS__)
+#undef glEnableVertexAttribArray
+#define glEnableVertexAttribArray(...) STAPLEGL_INSTRUMENTED(enable_vertex_attrib_array, __VA_ARGS__)
+#undef glVertexAttribPointer
+#define glVertexAttribPointer(...) STAPLEGL_INSTRUMENTED(vertex_attrib_pointer, __VA_ARGS__)
+#undef glVertexAttribIPointer
+#define glVertexAttribIPointer(...) STAPLEGL_INSTRUMENTED(vertex_attrib_i_pointer, __VA_ARGS__)
+#undef glVertexAttribDivisor
+#define glVertexAttribDivisor(...) STAPLEGL_INSTRUMENTED(vertex_attrib_divisor, __VA_ARGS__)
+#undef glVertexAttribFormat
+#define glVertexAttribFormat(...) STAPLEGL_INSTRUMENTED(vertex_attrib_format, __VA_ARGS__)
+#undef glVertexAttribIFormat
+#define glVertexAttribIFormat(...) STAPLEGL_INSTRUMENTED(vertex_attrib_i_format, __VA_ARGS__)
+#undef glVertexAttribBinding
+#define glVertexAttribBinding(...) STAPLEGL_INSTRUMENTED(vertex_attrib_binding, __VA_ARGS__)
+#undef glVertexBindingDivisor
+#define glVertexBindingDivisor(...) STAPLEGL_INSTRUMENTED(vertex_binding_divisor, __VA_ARGS__)
+#undef glBindVertexBuffer
+#define glBindVertexBuffer(...) STAPLEGL_INSTRUMENTED(bind_vertex_buffer, __VA_ARGS__)
+#undef glFramebufferRenderbuffer
+#define glFramebufferRenderbuffer(...) STAPLEGL_INSTRUMENTED(framebuffer_renderbuffer, __VA_ARGS__)
+#undef glFramebufferTexture2D
+#define glFramebufferTexture2D(...) STAPLEGL_INSTRUMENTED(framebuffer_texture_2d, __VA_ARGS__)
+#undef glTexParameteri
+#define glTexParameteri(...) STAPLEGL_INSTRUMENTED(tex_parameteri, __VA_ARGS__)
+#undef glTextureParameteri
+#define glTextureParameteri(...) STAPLEGL_INSTRUMENTED(texture_parameteri, __VA_ARGS__)
+#undef glUniform1i
+#define glUniform1i(...) STAPLEGL_INSTRUMENTED(uniform_1i, __VA_ARGS__)
+#undef glUniform1f
+#define glUniform1f(...) STAPLEGL_INSTRUMENTED(uniform_1f, __VA_ARGS__)
+#undef glUniform2f
+#define glUniform2f(...) STAPLEGL_INSTRUMENTED(uniform_2f, __VA_ARGS__)
+#undef glUniform3f
+#define glUniform3f(...) STAPLEGL_INSTRUMENTED(uniform_3f, __VA_ARGS__)
+#undef glUniform4f
+#define glUniform4f(...) STAPLEGL_INSTRUMENTED(uniform_4f, __VA_ARGS__)
+#undef glUniformMatrix3fv
+#define glUniformMatrix3fv(...) STAPLEGL_INSTRUMENTED(uniform_matrix_3fv, __VA_ARGS__)
+#undef glUniformMatrix4fv
+#define glUniformMatrix4fv(...) STAPLEGL_INSTRUMENTED(uniform_matrix_4fv, __VA_ARGS__)
+#undef glDrawArrays
+#define glDrawArrays(...) STAPLEGL_INSTRUMENTED(draw_arrays, __VA_ARGS__)
+#undef glDrawElements
+#define glDrawElements(...) STAPLEGL_INSTRUMENTED(draw_elements, __VA_ARGS__)
+#undef glDrawArraysInstanced
+#define glDrawArraysInstanced(...) STAPLEGL_INSTRUMENTED(draw_arrays_instanced, __VA_ARGS__)
+#undef glDrawElementsInstanced
+#define glDrawElementsInstanced(...) STAPLEGL_INSTRUMENTED(draw_elements_instanced, __VA_ARGS__)
+#undef glDrawElementsInstancedBaseInstance
+#define glDrawElementsInstancedBaseInstance(...) STAPLEGL_INSTRUMENTED(draw_elements_instanced_base_instance, __VA_ARGS__)
+#undef glClear
+#define glClear(...) STAPLEGL_INSTRUMENTED(clear, __VA_ARGS__)
+#undef glBlitFramebuffer
+#define glBlitFramebuffer(...) STAPLEGL_INSTRUMENTED(blit_framebuffer, __VA_ARGS__)
+#undef glBufferData
+#define glBufferData(...) STAPLEGL_INSTRUMENTED(buffer_data, __VA_ARGS__)
+#undef glBufferSubData
+#define glBufferSubData(...) STAPLEGL_INSTRUMENTED(buffer_sub_data, __VA_ARGS__)
+#undef glCopyBufferSubData
+#define glCopyBufferSubData(...) STAPLEGL_INSTRUMENTED(copy_buffer_sub_data, __VA_ARGS__)
+#undef glMapBuffer
+#define glMapBuffer(...) STAPLEGL_INSTRUMENTED(map_buffer, __VA_ARGS__)
+#undef glMapBufferRange
+#define glMapBufferRange(...) STAPLEGL_INSTRUMENTED(map_buffer_range, __VA_ARGS__)
+#undef glUnmapBuffer
+#define glUnmapBuffer(...) STAPLEGL_INSTRUMENTED(unmap_buffer, __VA_ARGS__)
+#undef glTexImage2D
+#define glTexImage2D(...) STAPLEGL_INSTRUMENTED(tex_image_2d, __VA_ARGS__)
+#undef glReadPixels
+#define glReadPixels(...) STAPLEGL_INSTRUMENTED(read_pixels, __VA_ARGS__)
+#undef glTexImage2DMultisample
+#define glTexImage2DMultisample(...) STAPLEGL_INSTRUMENTED(tex_image_2d_multisample, __VA_ARGS__)
+#undef glRenderbufferStorage
+#define glRenderbufferStorage(...) STAPLEGL_INSTRUMENTED(renderbuffer_storage, __VA_ARGS__)
+#undef glRenderbufferStorageMultisample
+#define glRenderbufferStorageMultisample(...) STAPLEGL_INSTRUMENTED(renderbuffer_storage_multisample, __VA_ARGS__)
+#undef glGenerateMipmap
+#define glGenerateMipmap(...) STAPLEGL_INSTRUMENTED(generate_mipmap, __VA_ARGS__)
+#undef glGenerateTextureMipmap
+#define glGenerateTextureMipmap(...) STAPLEGL_INSTRUMENTED(generate_texture_mipmap, __VA_ARGS__)
+#undef glGenBuffers
+#define glGenBuffers(...) STAPLEGL_INSTRUMENTED(gen_buffers, __VA_ARGS__)
+#undef glDeleteBuffers
+#define glDeleteBuffers(...) STAPLEGL_INSTRUMENTED(delete_buffers, __VA_ARGS__)
+#undef glGenTextures
+#define glGenTextures(...) STAPLEGL_INSTRUMENTED(gen_textures, __VA_ARGS__)
+#undef glDeleteTextures
+#define glDeleteTextures(...) STAPLEGL_INSTRUMENTED(delete_textures, __VA_ARGS__)
+#undef glGenFramebuffers
+#define glGenFramebuffers(...) STAPLEGL_INSTRUMENTED(gen_framebuffers, __VA_ARGS__)
+#undef glDeleteFramebuffers
+#define glDeleteFramebuffers(...) STAPLEGL_INSTRUMENTED(delete_framebuffers, __VA_ARGS__)
+#undef glGenRenderbuffers
+#define glGenRenderbuffers(...) STAPLEGL_INSTRUMENTED(gen_renderbuffers, __VA_ARGS__)
+#undef glDeleteRenderbuffers
+#define glDeleteRenderbuffers(...) STAPLEGL_INSTRUMENTED(delete_renderbuffers, __VA_ARGS__)
+#undef glGenVertexArrays
+#define glGenVertexArrays(...) STAPLEGL_INSTRUMENTED(gen_vertex_arrays, __VA_ARGS__)
+#undef glDeleteVertexArrays
+#define glDeleteVertexArrays(...) STAPLEGL_INSTRUMENTED(delete_vertex_arrays, __VA_ARGS__)
+#undef glGenQueries
+#define glGenQueries(...) STAPLEGL_INSTRUMENTED(gen_queries, __VA_ARGS__)
+#undef glDeleteQueries
+#define glDeleteQueries(...) STAPLEGL_INSTRUMENTED(delete_queries, __VA_ARGS__)
+#undef glCreateProgram
+#define glCreateProgram(...) STAPLEGL_INSTRUMENTED(create_program, __VA_ARGS__)
+#undef glDeleteProgram
+#define glDeleteProgram(...) STAPLEGL_INSTRUMENTED(delete_program, __VA_ARGS__)
+#undef glCreateShader
+#define glCreateShader(...) STAPLEGL_INSTRUMENTED(create_shader, __VA_ARGS__)
+#undef glDeleteShader
+#define glDeleteShader(...) STAPLEGL_INSTRUMENTED(delete_shader, __VA_ARGS__)
+#undef glAttachShader
+#define glAttachShader(...) STAPLEGL_INSTRUMENTED(attach_shader, __VA_ARGS__)
+#undef glDetachShader
+#define glDetachShader(...) STAPLEGL_INSTRUMENTED(detach_shader, __VA_ARGS__)
+#undef glShaderSource
+#define glShaderSource(...) STAPLEGL_INSTRUMENTED(shader_source, __VA_ARGS__)
+#undef glCompileShader
+#define glCompileShader(...) STAPLEGL_INSTRUMENTED(compile_shader, __VA_ARGS__)
+#undef glLinkProgram
+#define glLinkProgram(...) STAPLEGL_INSTRUMENTED(link_program, __VA_ARGS__)
+#undef glValidateProgram
+#define glValidateProgram(...) STAPLEGL_INSTRUMENTED(validate_program, __VA_ARGS__)
+#undef glGetProgramiv
+#define glGetProgramiv(...) STAPLEGL_INSTRUMENTED(get_programiv, __VA_ARGS__)
+#undef glGetProgramInfoLog
+#define glGetProgramInfoLog(...) STAPLEGL_INSTRUMENTED(get_program_info_log, __VA_ARGS__)
+#undef glGetShaderiv
+#define glGetShaderiv(...) STAPLEGL_INSTRUMENTED(get_shaderiv, __VA_ARGS__)
+#undef glGetShaderInfoLog
+#define glGetShaderInfoLog(...) STAPLEGL_INSTRUMENTED(get_shader_info_log, __VA_ARGS__)
+#undef glGetUniformLocation
+#define glGetUniformLocation(...) STAPLEGL_INSTRUMENTED(get_uniform_location, __VA_ARGS__)
+#undef glCheckFramebufferStatus
+#define glCheckFramebufferStatus(...) STAPLEGL_INSTRUMENTED(check_framebuffer_status, __VA_ARGS__)
+#undef glGetIntegerv
+#define glGetIntegerv(...) STAPLEGL_INSTRUMENTED(get_integerv, __VA_ARGS__)
+#undef glGetString
+#define glGetString(...) STAPLEGL_INSTRUMENTED(get_string, __VA_ARGS__)
+#undef glQueryCounter
+#define glQueryCounter(...) STAPLEGL_INSTRUMENTED(query_counter, __VA_ARGS__)
+#undef glGetQueryObjectiv
+#define glGetQueryObjectiv(...) STAPLEGL_INSTRUMENTED(get_query_objectiv, __VA_ARGS__)
+#undef glGetQueryObjectui64v
+#define glGetQueryObjectui64v(...) STAPLEGL_INSTRUMENTED(get_query_objectui64v, __VA_ARGS__)
+#undef glFenceSync
+#define glFenceSync(...) STAPLEGL_INSTRUMENTED(fence_sync, __VA_ARGS__)
+#undef glClientWaitSync
+#define glClientWaitSync(...) STAPLEGL_INSTRUMENTED(client_wait_sync, __VA_ARGS__)
+#undef glDeleteSync
+#define glDeleteSync(...) STAPLEGL_INSTRUMENTED(delete_sync, __VA_ARGS__)
+#undef glFlush
+#define glFlush(...) STAPLEGL_INSTRUMENTED(flush, __VA_ARGS__)
+
+// an entry of the list without its redirect is never counted, and reaches the loader even when a
+// backend is installed (with mock_gl, an unloaded entry point): check that each one is redirected.
+#define STAPLEGL_STRINGIFY_IMPL(...) #__VA_ARGS__
+#define STAPLEGL_STRINGIFY(...) STAPLEGL_STRINGIFY_IMPL(__VA_ARGS__)
+#define STAPLEGL_X(id, fn, category)                                                                 \
+    static_assert(std::string_view { STAPLEGL_STRINGIFY(fn()) }.starts_with("::staplegl::instrument"), \
+        "missing redirect for " #fn);
+STAPLEGL_INSTRUMENTED_CALLS(STAPLEGL_X)
+#undef STAPLEGL_X
+#undef STAPLEGL_STRINGIFY
+#undef STAPLEGL_STRINGIFY_IMPL
+
+#endif // STAPLEGL_INSTRUMENT
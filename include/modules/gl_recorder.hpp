@@ -0,0 +1,1105 @@
+/**
+ * @file gl_recorder.hpp
+ * @author Dario Loi
+ * @brief Recording, mock and replay backends for the instrumented OpenGL entry points.
+ *
+ * @date 2026-10-17
+ *
+ * @copyright MIT License
+ *
+ * @details Builds on the dispatch table of gl_instrumentation.hpp to run staplegl without
+ * (or alongside) a live OpenGL context:
+ *
+ * - staplegl::instrument::recorder logs every call with its arguments and copies the data
+ *   referenced by pointer arguments (buffer uploads, texels, shader sources, ...), while still
+ *   forwarding the calls to the driver.
+ * - staplegl::instrument::mock_gl records the calls without forwarding them, emulating just
+ *   enough of OpenGL (object names, buffer storage, successful compilation and linking) for the
+ *   staplegl objects to work without a context. This makes call counts fully deterministic and
+ *   isolates the CPU-side cost of the wrappers.
+ * - staplegl::instrument::replayer re-issues a recorded command stream, remapping object names.
+ * - staplegl::instrument::analyze computes redundant-state metrics on a command stream, e.g.:
+ *
+ * @code{.cpp}
+ * staplegl::instrument::mock_gl mock;
+ * staplegl::instrument::scoped_backend const guard { mock };
+ *
+ * render_frame();
+ *
+ * auto const report = staplegl::instrument::analyze(mock.calls());
+ * assert(report.binds <= 40 && report.redundant_binds == 0);
+ * @endcode
+ *
+ * @note Requires `STAPLEGL_INSTRUMENT`, otherwise the calls never reach the backends.
+ *
+ * @see gl_instrumentation.hpp
+ */
+
+#pragma once
+
+#include "gl_instrumentation.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace staplegl::instrument {
+
+/**
+ * @brief The namespace an OpenGL object name belongs to.
+ *
+ */
+enum class object_kind : std::uint8_t {
+    none,
+    buffer,
+    texture,
+    framebuffer,
+    renderbuffer,
+    vertex_array,
+    query,
+    program,
+    shader,
+};
+
+inline constexpr std::size_t object_kind_count = 9;
+
+/**
+ * @brief Get the kind of objects generated by a `glGen*` call or deleted by a `glDelete*` call
+ * taking an array of names.
+ *
+ * @return object_kind the kind, object_kind::none for any other call.
+ */
+constexpr auto name_array_kind(gl_call call) noexcept -> object_kind
+{
+    switch (call) {
+    case gl_call::gen_buffers:
+    case gl_call::delete_buffers:
+        return object_kind::buffer;
+    case gl_call::gen_textures:
+    case gl_call::delete_textures:
+        return object_kind::texture;
+    case gl_call::gen_framebuffers:
+    case gl_call::delete_framebuffers:
+        return object_kind::framebuffer;
+    case gl_call::gen_renderbuffers:
+    case gl_call::delete_renderbuffers:
+        return object_kind::renderbuffer;
+    case gl_call::gen_vertex_arrays:
+    case gl_call::delete_vertex_arrays:
+        return object_kind::vertex_array;
+    case gl_call::gen_queries:
+    case gl_call::delete_queries:
+        return object_kind::query;
+    default:
+        return object_kind::none;
+    }
+}
+
+/**
+ * @brief Whether a call generates names (as opposed to deleting them).
+ *
+ */
+constexpr auto generates_names(gl_call call) noexcept -> bool
+{
+    switch (call) {
+    case gl_call::gen_buffers:
+    case gl_call::gen_textures:
+    case gl_call::gen_framebuffers:
+    case gl_call::gen_renderbuffers:
+    case gl_call::gen_vertex_arrays:
+    case gl_call::gen_queries:
+        return true;
+    default:
+        return false;
+    }
+}
+
+/**
+ * @brief Get the kind of object whose name is returned by a call (`glCreateProgram`, `glCreateShader`).
+ *
+ */
+constexpr auto returned_kind(gl_call call) noexcept -> object_kind
+{
+    switch (call) {
+    case gl_call::create_program:
+        return object_kind::program;
+    case gl_call::create_shader:
+        return object_kind::shader;
+    default:
+        return object_kind::none;
+    }
+}
+
+/**
+ * @brief An argument of a call that holds the name of an object.
+ *
+ */
+struct name_argument {
+    std::int8_t index { -1 };
+    object_kind kind {};
+};
+
+/**
+ * @brief Get the arguments of a call that hold object names, at most two per call.
+ *
+ */
+constexpr auto name_arguments(gl_call call) noexcept -> std::array<name_argument, 2>
+{
+    using enum object_kind;
+
+    switch (call) {
+    case gl_call::bind_buffer:
+        return { { { 1, buffer } } };
+    case gl_call::bind_buffer_base:
+    case gl_call::bind_buffer_range:
+        return { { { 2, buffer } } };
+    case gl_call::bind_vertex_buffer:
+        return { { { 1, buffer } } };
+    case gl_call::bind_framebuffer:
+        return { { { 1, framebuffer } } };
+    case gl_call::bind_renderbuffer:
+    case gl_call::bind_texture:
+        return { { { 1, call == gl_call::bind_texture ? texture : renderbuffer } } };
+    case gl_call::bind_vertex_array:
+        return { { { 0, vertex_array } } };
+    case gl_call::framebuffer_renderbuffer:
+        return { { { 3, renderbuffer } } };
+    case gl_call::framebuffer_texture_2d:
+        return { { { 3, texture } } };
+    case gl_call::texture_parameteri:
+    case gl_call::generate_texture_mipmap:
+        return { { { 0, texture } } };
+    case gl_call::use_program:
+    case gl_call::delete_program:
+    case gl_call::link_program:
+    case gl_call::validate_program:
+    case gl_call::get_programiv:
+    case gl_call::get_program_info_log:
+    case gl_call::get_uniform_location:
+        return { { { 0, program } } };
+    case gl_call::attach_shader:
+    case gl_call::detach_shader:
+        return { { { 0, program }, { 1, shader } } };
+    case gl_call::delete_shader:
+    case gl_call::shader_source:
+    case gl_call::compile_shader:
+    case gl_call::get_shaderiv:
+    case gl_call::get_shader_info_log:
+        return { { { 0, shader } } };
+    case gl_call::query_counter:
+    case gl_call::get_query_objectiv:
+    case gl_call::get_query_objectui64v:
+        return { { { 0, query } } };
+    default:
+        return {};
+    }
+}
+
+/**
+ * @brief Get the index of the pointer argument whose data is captured as the call's payload.
+ *
+ * @return int the argument index, -1 if the call has no payload.
+ */
+constexpr auto payload_argument(gl_call call) noexcept -> int
+{
+    switch (call) {
+    case gl_call::buffer_data:
+    case gl_call::shader_source:
+        return 2;
+    case gl_call::buffer_sub_data:
+    case gl_call::uniform_matrix_3fv:
+    case gl_call::uniform_matrix_4fv:
+        return 3;
+    case gl_call::tex_image_2d:
+        return 8;
+    case gl_call::get_uniform_location:
+        return 1;
+    default:
+        return name_array_kind(call) != object_kind::none ? 1 : -1;
+    }
+}
+
+/**
+ * @brief Whether an argument of a call points to client memory, only meaningful during the call.
+ *
+ * @details These are the payload arguments and the output parameters, which the replayer
+ * redirects to captured data and scratch memory respectively. Buffer offsets passed as
+ * pointers (e.g. to `glVertexAttribPointer`) are not client pointers.
+ */
+constexpr auto is_client_pointer(gl_call call, std::size_t index) noexcept -> bool
+{
+    if (static_cast<int>(index) == payload_argument(call)) {
+        return true;
+    }
+
+    switch (call) {
+    case gl_call::shader_source:
+        return index == 3;
+    case gl_call::get_programiv:
+    case gl_call::get_shaderiv:
+    case gl_call::get_query_objectiv:
+    case gl_call::get_query_objectui64v:
+        return index == 2;
+    case gl_call::get_integerv:
+        return index == 1;
+    case gl_call::get_program_info_log:
+    case gl_call::get_shader_info_log:
+        return index >= 2;
+    default:
+        return false;
+    }
+}
+
+/**
+ * @brief Whether a call returns a pointer to memory only meaningful in the recording process.
+ *
+ */
+constexpr auto returns_pointer(gl_call call) noexcept -> bool
+{
+    return call == gl_call::map_buffer || call == gl_call::map_buffer_range || call == gl_call::get_string;
+}
+
+/**
+ * @brief A recorded command stream: the calls, their payloads and the frame boundaries.
+ *
+ * @see gl_capture.hpp for its serialized form.
+ */
+struct capture {
+    std::vector<call_record> calls;
+    std::vector<std::byte> payloads;
+    std::vector<std::size_t> frame_ends; ///< index one past the last call of every frame.
+
+    /**
+     * @brief Get the data captured for a call.
+     *
+     * @return std::span<const std::byte> the payload, empty if none was captured.
+     */
+    [[nodiscard]] auto payload(call_record const& call) const noexcept -> std::span<const std::byte>
+    {
+        return { payloads.data() + call.payload_offset, call.payload_size };
+    }
+};
+
+/**
+ * @brief Records every instrumented call, along with the data its pointer arguments refer to.
+ *
+ * @details Payloads are copied when the call is made, so that the log stays valid after the
+ * caller's memory is gone:
+ *
+ * - uploads (`glBufferData`, `glBufferSubData`, `glTexImage2D`), uniform matrices, shader
+ *   sources (concatenated) and uniform names;
+ * - the names passed to `glDelete*` and those returned by `glGen*`;
+ * - for write mappings, the contents of the mapped range when `glUnmapBuffer` is called, since
+ *   writes through the mapped pointer are otherwise invisible.
+ */
+class recorder : public gl_backend {
+public:
+    /**
+     * @brief Construct a new recorder object
+     *
+     * @param forward whether the calls also reach the driver.
+     * @param keep_log whether the calls are kept, disable to only track state (e.g. in benchmarks).
+     */
+    explicit recorder(bool forward = true, bool keep_log = true) noexcept
+        : m_forward { forward }
+        , m_keep_log { keep_log }
+    {
+    }
+
+    auto dispatch(call_record& call, call_forwarder forward) -> std::uint64_t override;
+
+    /**
+     * @brief Get the recorded calls, in issue order.
+     *
+     */
+    [[nodiscard]] auto calls() const noexcept -> std::span<const call_record> { return m_log.calls; }
+
+    /**
+     * @brief Get the whole recording, e.g. to replay or serialize it.
+     *
+     */
+    [[nodiscard]] auto log() const noexcept -> capture const& { return m_log; }
+
+    /**
+     * @brief Get the data captured for a recorded call.
+     *
+     * @return std::span<const std::byte> the payload, empty if none was captured.
+     */
+    [[nodiscard]] auto payload(call_record const& call) const noexcept -> std::span<const std::byte>
+    {
+        return m_log.payload(call);
+    }
+
+    /**
+     * @brief Get the number of recorded calls to an entry point.
+     *
+     */
+    [[nodiscard]] auto count(gl_call call) const noexcept -> std::size_t
+    {
+        return static_cast<std::size_t>(std::count_if(m_log.calls.begin(), m_log.calls.end(),
+            [call](call_record const& record) { return record.call == call; }));
+    }
+
+    /**
+     * @brief Write the log as text, one call per line, e.g. `glBindBuffer(34962, 3)`.
+     *
+     */
+    void write_text(std::ostream& out) const;
+
+    /**
+     * @brief Mark the end of a frame, so that the log can be replayed and timed frame by frame.
+     *
+     */
+    void mark_frame() { m_log.frame_ends.push_back(m_log.calls.size()); }
+
+    /**
+     * @brief Discard the recorded calls, payloads and frame marks.
+     *
+     */
+    void clear() noexcept
+    {
+        m_log.calls.clear();
+        m_log.payloads.clear();
+        m_log.frame_ends.clear();
+    }
+
+protected:
+    /**
+     * @brief Produce the result of a call that is not forwarded to the driver.
+     *
+     * @details Output parameters must be written here, before they are captured.
+     */
+    virtual auto emulate(call_record const& /*call*/) -> std::uint64_t { return 0; }
+
+    /**
+     * @brief Get the buffer bound to a target, as tracked by the recorder.
+     *
+     */
+    [[nodiscard]] auto bound_buffer(std::uint32_t target) const noexcept -> std::uint32_t
+    {
+        auto const found = m_bound_buffers.find(target);
+        return found == m_bound_buffers.end() ? 0 : found->second;
+    }
+
+private:
+    struct mapping {
+        std::uint32_t target {};
+        std::uint64_t pointer {};
+        std::size_t size {};
+        bool write {};
+    };
+
+    void capture_inputs(call_record& call);
+    void capture_outputs(call_record& call);
+    void append_payload(call_record& call, const void* data, std::size_t size);
+
+    capture m_log;
+    std::vector<mapping> m_mappings;
+    std::unordered_map<std::uint32_t, std::uint32_t> m_bound_buffers; // target -> name
+    std::unordered_map<std::uint32_t, std::size_t> m_buffer_sizes; // name -> size in bytes
+    bool m_forward {};
+    bool m_keep_log {};
+};
+
+/**
+ * @brief Context-free stand-in for OpenGL, records the calls without issuing them.
+ *
+ * @details Emulates object name generation, buffer storage (so that mapping, `apply` and
+ * `delete_instance` work), and reports shader compilation, program linking and framebuffer
+ * completeness as successful. Fences are signaled as soon as they are created, and pixels
+ * read back are all zero. Limits queried through `glGetIntegerv` are those of a typical
+ * desktop driver (see mock_gl::max_size), any other value reads as 0. Every other call is a no-op.
+ */
+class mock_gl : public recorder {
+public:
+    /**
+     * @brief The size limit reported for textures, renderbuffers and viewports.
+     *
+     */
+    static constexpr std::int32_t max_size = 16384;
+
+    explicit mock_gl(bool keep_log = true) noexcept
+        : recorder { false, keep_log }
+    {
+    }
+
+    /**
+     * @brief Get the current contents of a buffer object.
+     *
+     */
+    [[nodiscard]] auto buffer_contents(std::uint32_t name) const noexcept -> std::span<const std::byte>
+    {
+        auto const found = m_storage.find(name);
+        return found == m_storage.end() ? std::span<const std::byte> {} : std::span<const std::byte> { found->second };
+    }
+
+protected:
+    auto emulate(call_record const& call) -> std::uint64_t override;
+
+private:
+    auto storage(std::uint32_t target) -> std::vector<std::byte>& { return m_storage[bound_buffer(target)]; }
+
+    std::array<std::uint32_t, object_kind_count> m_next_name {};
+    std::unordered_map<std::uint32_t, std::vector<std::byte>> m_storage;
+    std::unordered_map<std::uint32_t, std::unordered_map<std::string, std::int32_t>> m_uniforms;
+    std::uint64_t m_clock {};
+    std::uint64_t m_next_sync {};
+};
+
+/**
+ * @brief Re-issues recorded calls through the instrumented entry points.
+ *
+ * @details Object names are remapped, names generated during replay replace the recorded ones
+ * wherever they appear. Pointer arguments refer to the captured payloads, output parameters
+ * to scratch memory, and buffer offsets passed as pointers (attribute and index offsets) are
+ * passed through untouched. <br>
+ *
+ * Fences are remapped like object names. Pixels read into client memory go to scratch memory.
+ * Uniform locations are not remapped, they are stable for the same shader on the same driver.
+ * The replayer keeps its name tables, so a log can be replayed in chunks (e.g. frame by frame).
+ */
+class replayer {
+public:
+    /**
+     * @brief Replay every call of a recording.
+     *
+     */
+    void replay(capture const& log);
+
+    /**
+     * @brief Replay a range of calls of a recording, e.g. a single frame.
+     *
+     * @param log the recording.
+     * @param first the index of the first call to replay.
+     * @param last the index one past the last call to replay.
+     */
+    void replay(capture const& log, std::size_t first, std::size_t last);
+
+    /**
+     * @brief Redirect the draws made to the default framebuffer to another framebuffer.
+     *
+     * @details Useful when replaying on a surfaceless context, that has no default framebuffer.
+     *
+     * @param name the framebuffer object that replaces the default framebuffer.
+     */
+    void set_default_framebuffer(std::uint32_t name) { m_names[static_cast<std::size_t>(object_kind::framebuffer)][0] = name; }
+
+    /**
+     * @brief Replay a single call.
+     *
+     * @param call the recorded call.
+     * @param payload the data captured for the call.
+     */
+    void replay(call_record const& call, std::span<const std::byte> payload);
+
+    /**
+     * @brief Translate a recorded object name into the one generated during replay.
+     *
+     */
+    [[nodiscard]] auto remap(object_kind kind, std::uint32_t name) const noexcept -> std::uint32_t;
+
+private:
+    template <gl_call Call, typename R, typename... Params>
+    void replay_as(R(APIENTRYP function)(Params...), call_record const& call, std::span<const std::byte> payload);
+
+    void prepare(call_record const& call, std::span<const std::byte> payload, std::array<std::uint64_t, max_call_args>& args);
+    void finish(call_record const& call, std::span<const std::byte> payload, std::uint64_t result);
+
+    std::array<std::unordered_map<std::uint32_t, std::uint32_t>, object_kind_count> m_names;
+    std::unordered_map<std::uint32_t, std::uint64_t> m_mapped; // target -> replayed mapping
+    std::unordered_map<std::uint64_t, std::uint64_t> m_syncs; // recorded fence -> replayed fence
+    std::uint32_t m_pack_buffer {}; // replayed name bound to GL_PIXEL_PACK_BUFFER
+    std::vector<std::byte> m_pixels; // destination of glReadPixels into client memory
+    std::vector<std::uint32_t> m_name_scratch;
+    std::vector<std::uint64_t> m_scratch = std::vector<std::uint64_t>(512);
+    std::string m_source;
+    const char* m_source_pointer {};
+};
+
+/**
+ * @brief Redundant-state metrics of a command stream.
+ *
+ * @details A state change is redundant when it sets the value the state already has, e.g.
+ * binding the buffer that is already bound, or re-uploading the same scalar uniform value.
+ * Vertex attribute setup, attachments, texture parameters and matrix uniforms are counted as
+ * state changes but never flagged as redundant.
+ */
+struct state_report {
+    std::size_t calls {};
+    std::size_t draw_calls {};
+    std::size_t binds {}; ///< `glBind*` and `glUseProgram` calls.
+    std::size_t redundant_binds {};
+    std::size_t state_changes {};
+    std::size_t redundant_state_changes {}; ///< includes the redundant binds.
+};
+
+/**
+ * @brief Compute the redundant-state metrics of a command stream.
+ *
+ * @param calls the calls, e.g. recorder::calls().
+ * @return state_report the metrics.
+ */
+[[nodiscard]] inline auto analyze(std::span<const call_record> calls) -> state_report;
+
+/*
+
+        IMPLEMENTATIONS
+
+*/
+
+inline auto recorder::dispatch(call_record& call, call_forwarder forward) -> std::uint64_t
+{
+    capture_inputs(call);
+    call.result = m_forward ? forward() : emulate(call);
+    capture_outputs(call);
+
+    if (m_keep_log) {
+        m_log.calls.push_back(call);
+    }
+
+    return call.result;
+}
+
+inline void recorder::append_payload(call_record& call, const void* data, std::size_t size)
+{
+    if (!m_keep_log || data == nullptr || size == 0) {
+        return;
+    }
+
+    call.payload_offset = m_log.payloads.size();
+    call.payload_size = size;
+
+    auto const* bytes = static_cast<const std::byte*>(data);
+    m_log.payloads.insert(m_log.payloads.end(), bytes, bytes + size);
+}
+
+inline void recorder::capture_inputs(call_record& call)
+{
+    switch (call.call) {
+    case gl_call::bind_buffer:
+        m_bound_buffers[call.arg<std::uint32_t>(0)] = call.arg<std::uint32_t>(1);
+        break;
+    case gl_call::bind_buffer_base:
+        m_bound_buffers[call.arg<std::uint32_t>(0)] = call.arg<std::uint32_t>(2);
+        break;
+    case gl_call::buffer_data:
+        m_buffer_sizes[bound_buffer(call.arg<std::uint32_t>(0))] = call.arg<std::size_t>(1);
+        append_payload(call, call.arg<const void*>(2), call.arg<std::size_t>(1));
+        break;
+    case gl_call::buffer_sub_data:
+        append_payload(call, call.arg<const void*>(3), call.arg<std::size_t>(2));
+        break;
+    case gl_call::tex_image_2d:
+        append_payload(call, call.arg<const void*>(8),
+            call.arg<std::size_t>(3) * call.arg<std::size_t>(4)
+                * detail::texel_size(call.arg<std::uint32_t>(6), call.arg<std::uint32_t>(7)));
+        break;
+    case gl_call::uniform_matrix_3fv:
+        append_payload(call, call.arg<const void*>(3), call.arg<std::size_t>(1) * 9 * sizeof(float));
+        break;
+    case gl_call::uniform_matrix_4fv:
+        append_payload(call, call.arg<const void*>(3), call.arg<std::size_t>(1) * 16 * sizeof(float));
+        break;
+    case gl_call::get_uniform_location: {
+        const auto* name = call.arg<const char*>(1);
+        append_payload(call, name, std::strlen(name) + 1);
+        break;
+    }
+    case gl_call::shader_source: {
+        // concatenate the strings, so that they can be replayed as a single one.
+        auto const count = call.arg<std::size_t>(1);
+        const auto* strings = call.arg<const char* const*>(2);
+        const auto* lengths = call.arg<const std::int32_t*>(3);
+
+        std::string source;
+        for (std::size_t i = 0; i < count; ++i) {
+            bool const terminated = lengths == nullptr || lengths[i] < 0; // NOLINT (pointer-arithmetic)
+            source.append(strings[i], terminated ? std::strlen(strings[i]) : static_cast<std::size_t>(lengths[i])); // NOLINT
+        }
+        append_payload(call, source.c_str(), source.size() + 1);
+        break;
+    }
+    case gl_call::unmap_buffer: {
+        auto const target = call.arg<std::uint32_t>(0);
+        auto const found = std::find_if(m_mappings.begin(), m_mappings.end(),
+            [target](mapping const& map) { return map.target == target; });
+
+        if (found != m_mappings.end()) {
+            if (found->write) {
+                append_payload(call, from_bits<const void*>(found->pointer), found->size);
+            }
+            m_mappings.erase(found);
+        }
+        break;
+    }
+    default:
+        if (name_array_kind(call.call) != object_kind::none && !generates_names(call.call)) {
+            auto const count = call.arg<std::size_t>(0);
+            const auto* names = call.arg<const std::uint32_t*>(1);
+            append_payload(call, names, count * sizeof(std::uint32_t));
+
+            if (call.call == gl_call::delete_buffers) {
+                for (std::size_t i = 0; i < count; ++i) {
+                    m_buffer_sizes.erase(names[i]); // NOLINT (pointer-arithmetic)
+                }
+            }
+        }
+        break;
+    }
+}
+
+inline void recorder::capture_outputs(call_record& call)
+{
+    if (generates_names(call.call)) {
+        append_payload(call, call.arg<const void*>(1), call.arg<std::size_t>(0) * sizeof(std::uint32_t));
+        return;
+    }
+
+    if (call.result == 0) {
+        return;
+    }
+
+    if (call.call == gl_call::map_buffer) {
+        auto const target = call.arg<std::uint32_t>(0);
+        auto const size = m_buffer_sizes[bound_buffer(target)];
+        m_mappings.push_back({ target, call.result, size, call.arg<std::uint32_t>(1) != GL_READ_ONLY });
+    } else if (call.call == gl_call::map_buffer_range) {
+        auto const access = call.arg<std::uint32_t>(3);
+        m_mappings.push_back({ call.arg<std::uint32_t>(0), call.result, call.arg<std::size_t>(2), (access & GL_MAP_WRITE_BIT) != 0 });
+    }
+}
+
+inline void recorder::write_text(std::ostream& out) const
+{
+    for (auto const& call : m_log.calls) {
+        out << name(call.call) << '(';
+        for (std::size_t i = 0; i < call.arg_count; ++i) {
+            out << (i == 0 ? "" : ", ") << static_cast<std::int64_t>(call.args[i]);
+        }
+        out << ')';
+
+        if (call.result != 0) {
+            out << " -> " << call.result;
+        }
+        if (call.payload_size != 0) {
+            out << " [" << call.payload_size << " bytes]";
+        }
+        out << '\n';
+    }
+}
+
+inline auto mock_gl::emulate(call_record const& call) -> std::uint64_t
+{
+    auto const kind = name_array_kind(call.call);
+    if (kind != object_kind::none) {
+        if (generates_names(call.call)) {
+            auto* names = call.arg<std::uint32_t*>(1);
+            for (std::size_t i = 0; i < call.arg<std::size_t>(0); ++i) {
+                names[i] = ++m_next_name[static_cast<std::size_t>(kind)]; // NOLINT (pointer-arithmetic)
+            }
+        } else if (call.call == gl_call::delete_buffers) {
+            const auto* names = call.arg<const std::uint32_t*>(1);
+            for (std::size_t i = 0; i < call.arg<std::size_t>(0); ++i) {
+                m_storage.erase(names[i]); // NOLINT (pointer-arithmetic)
+            }
+        }
+        return 0;
+    }
+
+    switch (call.call) {
+    case gl_call::create_program:
+    case gl_call::create_shader:
+        return ++m_next_name[static_cast<std::size_t>(returned_kind(call.call))];
+
+    case gl_call::buffer_data: {
+        auto& data = storage(call.arg<std::uint32_t>(0));
+        data.assign(call.arg<std::size_t>(1), std::byte {});
+        if (const auto* source = call.arg<const std::byte*>(2); source != nullptr) {
+            std::memcpy(data.data(), source, data.size());
+        }
+        return 0;
+    }
+    case gl_call::buffer_sub_data: {
+        auto& data = storage(call.arg<std::uint32_t>(0));
+        auto const offset = std::min(call.arg<std::size_t>(1), data.size());
+        auto const size = std::min(call.arg<std::size_t>(2), data.size() - offset);
+        std::memcpy(data.data() + offset, call.arg<const void*>(3), size);
+        return 0;
+    }
+    case gl_call::copy_buffer_sub_data: {
+        auto& source = storage(call.arg<std::uint32_t>(0));
+        auto& destination = storage(call.arg<std::uint32_t>(1));
+        auto const read_offset = call.arg<std::size_t>(2);
+        auto const write_offset = call.arg<std::size_t>(3);
+        auto const size = call.arg<std::size_t>(4);
+        if (read_offset + size <= source.size() && write_offset + size <= destination.size()) {
+            std::memmove(destination.data() + write_offset, source.data() + read_offset, size);
+        }
+        return 0;
+    }
+    case gl_call::map_buffer:
+        return to_bits(storage(call.arg<std::uint32_t>(0)).data());
+    case gl_call::map_buffer_range:
+        return to_bits(storage(call.arg<std::uint32_t>(0)).data() + call.arg<std::size_t>(1));
+    case gl_call::unmap_buffer:
+        return GL_TRUE;
+
+    case gl_call::get_programiv:
+    case gl_call::get_shaderiv: {
+        auto const pname = call.arg<std::uint32_t>(1);
+        bool const status = pname == GL_LINK_STATUS || pname == GL_COMPILE_STATUS || pname == GL_VALIDATE_STATUS;
+        *call.arg<std::int32_t*>(2) = status ? GL_TRUE : 0;
+        return 0;
+    }
+    case gl_call::get_program_info_log:
+    case gl_call::get_shader_info_log:
+        if (auto* length = call.arg<std::int32_t*>(2); length != nullptr) {
+            *length = 0;
+        }
+        if (call.arg<std::int32_t>(1) > 0) {
+            *call.arg<char*>(3) = '\0';
+        }
+        return 0;
+    case gl_call::get_uniform_location: {
+        // hand out locations in order of first lookup, per program.
+        auto& locations = m_uniforms[call.arg<std::uint32_t>(0)];
+        auto const [it, inserted] = locations.try_emplace(call.arg<const char*>(1), static_cast<std::int32_t>(locations.size()));
+        return to_bits(it->second);
+    }
+    case gl_call::check_framebuffer_status:
+        return GL_FRAMEBUFFER_COMPLETE;
+    case gl_call::get_integerv: {
+        auto* values = call.arg<std::int32_t*>(1);
+        switch (call.arg<std::uint32_t>(0)) {
+        case GL_MAX_VIEWPORT_DIMS:
+            values[1] = max_size; // NOLINT (pointer-arithmetic)
+            [[fallthrough]];
+        case GL_MAX_TEXTURE_SIZE:
+        case GL_MAX_RENDERBUFFER_SIZE:
+            values[0] = max_size;
+            break;
+        default:
+            values[0] = 0;
+            break;
+        }
+        return 0;
+    }
+    case gl_call::get_string:
+        return to_bits("staplegl mock");
+
+    case gl_call::get_query_objectiv:
+        *call.arg<std::int32_t*>(2) = 1; // always available
+        return 0;
+    case gl_call::get_query_objectui64v:
+        m_clock += 1000; // 1us between timestamps
+        *call.arg<std::uint64_t*>(2) = m_clock;
+        return 0;
+
+    case gl_call::read_pixels: {
+        // into the pixel pack buffer if one is bound, at the offset passed as pointer.
+        auto const size = call.arg<std::size_t>(2) * call.arg<std::size_t>(3)
+            * detail::texel_size(call.arg<std::uint32_t>(4), call.arg<std::uint32_t>(5));
+        if (bound_buffer(GL_PIXEL_PACK_BUFFER) == 0) {
+            if (auto* pixels = call.arg<void*>(6); pixels != nullptr) {
+                std::memset(pixels, 0, size);
+            }
+            return 0;
+        }
+        auto& data = storage(GL_PIXEL_PACK_BUFFER);
+        auto const offset = std::min(call.arg<std::size_t>(6), data.size());
+        std::memset(data.data() + offset, 0, std::min(size, data.size() - offset));
+        return 0;
+    }
+    case gl_call::fence_sync:
+        return ++m_next_sync; // a non-null handle
+    case gl_call::client_wait_sync:
+        return GL_ALREADY_SIGNALED;
+
+    default:
+        return 0;
+    }
+}
+
+inline auto replayer::remap(object_kind kind, std::uint32_t name) const noexcept -> std::uint32_t
+{
+    auto const& names = m_names[static_cast<std::size_t>(kind)];
+    auto const found = names.find(name);
+    return found == names.end() ? name : found->second;
+}
+
+inline void replayer::replay(capture const& log)
+{
+    replay(log, 0, log.calls.size());
+}
+
+inline void replayer::replay(capture const& log, std::size_t first, std::size_t last)
+{
+    last = std::min(last, log.calls.size());
+    for (std::size_t i = first; i < last; ++i) {
+        replay(log.calls[i], log.payload(log.calls[i]));
+    }
+}
+
+inline void replayer::replay(call_record const& call, std::span<const std::byte> payload)
+{
+    switch (call.call) {
+#define STAPLEGL_X(id, fn, category)                                   \
+    case gl_call::id:                                                  \
+        replay_as<gl_call::id>(detail::real_##id(), call, payload);    \
+        break;
+        STAPLEGL_INSTRUMENTED_CALLS(STAPLEGL_X)
+#undef STAPLEGL_X
+    }
+}
+
+template <gl_call Call, typename R, typename... Params>
+inline void replayer::replay_as(R(APIENTRYP function)(Params...), call_record const& call, std::span<const std::byte> payload)
+{
+    std::array<std::uint64_t, max_call_args> args = call.args;
+    prepare(call, payload, args);
+
+    // routed through the dispatch layer, so that counters and backends see the replayed calls.
+    auto const result = [&]<std::size_t... I>(std::index_sequence<I...>) {
+        if constexpr (std::is_void_v<R>) {
+            detail::invoke<Call>(function, from_bits<Params>(args[I])...);
+            return std::uint64_t {};
+        } else {
+            return to_bits(detail::invoke<Call>(function, from_bits<Params>(args[I])...));
+        }
+    }(std::index_sequence_for<Params...> {});
+
+    finish(call, payload, result);
+}
+
+inline void replayer::prepare(call_record const& call, std::span<const std::byte> payload, std::array<std::uint64_t, max_call_args>& args)
+{
+    for (auto const& [index, kind] : name_arguments(call.call)) {
+        if (index >= 0) {
+            args[static_cast<std::size_t>(index)] = remap(kind, static_cast<std::uint32_t>(args[static_cast<std::size_t>(index)]));
+        }
+    }
+
+    auto const kind = name_array_kind(call.call);
+    if (kind != object_kind::none) {
+        // generated names go to scratch memory, deleted ones are remapped.
+        m_name_scratch.assign(call.arg<std::size_t>(0), 0);
+        if (!generates_names(call.call)) {
+            for (std::size_t i = 0; i < m_name_scratch.size() && (i + 1) * sizeof(std::uint32_t) <= payload.size(); ++i) {
+                std::uint32_t name {};
+                std::memcpy(&name, payload.data() + i * sizeof(std::uint32_t), sizeof(name));
+                m_name_scratch[i] = remap(kind, name);
+            }
+        }
+        args[1] = to_bits(m_name_scratch.data());
+        return;
+    }
+
+    switch (call.call) {
+    case gl_call::unmap_buffer:
+        // write back what was written through the mapped pointer during recording.
+        if (auto const found = m_mapped.find(call.arg<std::uint32_t>(0)); found != m_mapped.end() && found->second != 0 && !payload.empty()) {
+            std::memcpy(from_bits<void*>(found->second), payload.data(), payload.size());
+        }
+        return;
+    case gl_call::bind_buffer:
+        if (args[0] == GL_PIXEL_PACK_BUFFER) {
+            m_pack_buffer = static_cast<std::uint32_t>(args[1]);
+        }
+        return;
+    case gl_call::read_pixels:
+        if (m_pack_buffer == 0) {
+            m_pixels.resize(call.arg<std::size_t>(2) * call.arg<std::size_t>(3)
+                * detail::texel_size(call.arg<std::uint32_t>(4), call.arg<std::uint32_t>(5)));
+            args[6] = to_bits(m_pixels.data());
+        }
+        return;
+    case gl_call::client_wait_sync:
+    case gl_call::delete_sync:
+        if (auto const found = m_syncs.find(args[0]); found != m_syncs.end()) {
+            args[0] = found->second;
+        }
+        return;
+    case gl_call::shader_source:
+        m_source.assign(reinterpret_cast<const char*>(payload.data()), payload.empty() ? 0 : payload.size() - 1); // NOLINT (reinterpret-cast)
+        m_source_pointer = m_source.c_str();
+        args[1] = 1;
+        args[2] = to_bits(&m_source_pointer);
+        args[3] = 0;
+        return;
+    case gl_call::get_programiv:
+    case gl_call::get_shaderiv:
+    case gl_call::get_query_objectiv:
+    case gl_call::get_query_objectui64v:
+        args[2] = to_bits(m_scratch.data());
+        return;
+    case gl_call::get_integerv:
+        args[1] = to_bits(m_scratch.data());
+        return;
+    case gl_call::get_program_info_log:
+    case gl_call::get_shader_info_log:
+        args[1] = std::min<std::uint64_t>(args[1], m_scratch.size() * sizeof(std::uint64_t));
+        args[2] = 0;
+        args[3] = to_bits(m_scratch.data());
+        return;
+    default:
+        break;
+    }
+
+    if (auto const index = payload_argument(call.call); index >= 0 && args[static_cast<std::size_t>(index)] != 0) {
+        args[static_cast<std::size_t>(index)] = to_bits(payload.data());
+    }
+}
+
+inline void replayer::finish(call_record const& call, std::span<const std::byte> payload, std::uint64_t result)
+{
+    auto const kind = name_array_kind(call.call);
+    if (generates_names(call.call)) {
+        for (std::size_t i = 0; i < m_name_scratch.size() && (i + 1) * sizeof(std::uint32_t) <= payload.size(); ++i) {
+            std::uint32_t recorded {};
+            std::memcpy(&recorded, payload.data() + i * sizeof(std::uint32_t), sizeof(recorded));
+            m_names[static_cast<std::size_t>(kind)][recorded] = m_name_scratch[i];
+        }
+        return;
+    }
+
+    switch (call.call) {
+    case gl_call::create_program:
+    case gl_call::create_shader:
+        m_names[static_cast<std::size_t>(returned_kind(call.call))][static_cast<std::uint32_t>(call.result)] = static_cast<std::uint32_t>(result);
+        break;
+    case gl_call::map_buffer:
+    case gl_call::map_buffer_range:
+        m_mapped[call.arg<std::uint32_t>(0)] = result;
+        break;
+    case gl_call::fence_sync:
+        m_syncs[call.result] = result;
+        break;
+    case gl_call::delete_sync:
+        m_syncs.erase(call.args[0]);
+        break;
+    default:
+        break;
+    }
+}
+
+inline auto analyze(std::span<const call_record> calls) -> state_report
+{
+    state_report report { .calls = calls.size() };
+
+    // (call, discriminator) -> last value set, the discriminator tells apart targets, units, capabilities, ...
+    std::unordered_map<std::uint64_t, std::array<std::uint64_t, 4>> state;
+    std::uint64_t active_unit { GL_TEXTURE0 };
+    std::uint64_t program {};
+
+    auto const set = [&](gl_call group, std::uint64_t discriminator, std::array<std::uint64_t, 4> const& value) -> bool {
+        auto const key = (static_cast<std::uint64_t>(group) << 48U) ^ discriminator;
+        auto const [it, inserted] = state.try_emplace(key, value);
+        if (!inserted && it->second == value) {
+            return true;
+        }
+        it->second = value;
+        return false;
+    };
+
+    for (auto const& call : calls) {
+        auto const category = instrument::category(call.call);
+        if (category == call_category::draw && call.call != gl_call::clear && call.call != gl_call::blit_framebuffer) {
+            ++report.draw_calls;
+        }
+        if (category != call_category::state) {
+            continue;
+        }
+
+        ++report.state_changes;
+
+        auto const& a = call.args;
+        bool redundant = false;
+        bool bind = true;
+
+        switch (call.call) {
+        case gl_call::bind_buffer:
+            redundant = set(gl_call::bind_buffer, a[0], { a[1] });
+            break;
+        case gl_call::bind_buffer_base:
+            redundant = set(gl_call::bind_buffer_base, (a[0] << 16U) ^ a[1], { a[2] });
+            set(gl_call::bind_buffer, a[0], { a[2] });
+            break;
+        case gl_call::bind_framebuffer:
+            if (a[0] == GL_FRAMEBUFFER) {
+                redundant = set(gl_call::bind_framebuffer, GL_READ_FRAMEBUFFER, { a[1] });
+                redundant = set(gl_call::bind_framebuffer, GL_DRAW_FRAMEBUFFER, { a[1] }) && redundant;
+            } else {
+                redundant = set(gl_call::bind_framebuffer, a[0], { a[1] });
+            }
+            break;
+        case gl_call::bind_renderbuffer:
+            redundant = set(gl_call::bind_renderbuffer, a[0], { a[1] });
+            break;
+        case gl_call::bind_texture:
+            redundant = set(gl_call::bind_texture, (active_unit << 16U) ^ a[0], { a[1] });
+            break;
+        case gl_call::bind_vertex_array:
+            redundant = set(gl_call::bind_vertex_array, 0, { a[0] });
+            break;
+        case gl_call::use_program:
+            redundant = set(gl_call::use_program, 0, { a[0] });
+            program = a[0];
+            break;
+        default:
+            bind = false;
+            break;
+        }
+
+        if (!bind) {
+            switch (call.call) {
+            case gl_call::active_texture:
+                redundant = set(gl_call::active_texture, 0, { a[0] });
+                active_unit = a[0];
+                break;
+            case gl_call::enable:
+            case gl_call::disable:
+                redundant = set(gl_call::enable, a[0], { call.call == gl_call::enable ? 1U : 0U });
+                break;
+            case gl_call::polygon_mode:
+                redundant = set(gl_call::polygon_mode, a[0], { a[1] });
+                break;
+            case gl_call::depth_mask:
+            case gl_call::blend_func:
+            case gl_call::blend_equation:
+            case gl_call::front_face:
+            case gl_call::viewport:
+            case gl_call::clear_color:
+                redundant = set(call.call, 0, { a[0], a[1], a[2], a[3] });
+                break;
+            case gl_call::uniform_1i:
+            case gl_call::uniform_1f:
+            case gl_call::uniform_2f:
+            case gl_call::uniform_3f:
+            case gl_call::uniform_4f:
+                // uniforms are program state, keyed by the program in use and the location.
+                redundant = set(gl_call::uniform_1i, (program << 32U) ^ (a[0] & 0xFFFFFFFFU),
+                    { static_cast<std::uint64_t>(call.call), a[1], a[2], (a[3] << 32U) ^ a[4] });
+                break;
+            default:
+                break;
+            }
+        }
+
+        report.binds += bind ? 1 : 0;
+        report.redundant_binds += (bind && redundant) ? 1 : 0;
+        report.redundant_state_changes += redundant ? 1 : 0;
+    }
+
+    return report;
+}
+
+} // namespace staplegl::instrument
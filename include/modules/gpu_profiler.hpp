@@ -0,0 +1,451 @@
+/**
+ * @file gpu_profiler.hpp
+ * @author Dario Loi
+ * @brief GPU timer query profiler.
+ *
+ * @date 2026-10-17
+ *
+ * @copyright MIT License
+ *
+ * @details Measures how long each part of a frame takes on the GPU. <br>
+ *
+ * The profiler issues a pair of `GL_TIMESTAMP` queries through `glQueryCounter` around
+ * every named scope. Queries are kept in a ring of per-frame slots, results for a slot are
+ * only read back once the ring wraps around to it again, so that the CPU never waits on the
+ * GPU. If the GPU is still behind when a slot is reused, that frame's results are dropped
+ * instead of stalling. <br>
+ *
+ * Timestamps are used instead of `GL_TIME_ELAPSED` queries, since the latter cannot be nested.
+ *
+ * @see https://www.khronos.org/opengl/wiki/Query_Object#Timer_queries
+ */
+
+#pragma once
+
+#include "deletion_queue.hpp"
+#include "gl_functions.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <ostream>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace staplegl {
+
+/**
+ * @brief Aggregated GPU timings for a single named scope.
+ *
+ * @details All the timings are expressed in milliseconds and computed over the per-frame
+ * totals of the scope, a scope that is entered multiple times in a frame contributes the sum
+ * of its durations.
+ */
+struct gpu_scope_stats {
+    std::string_view name;
+    double min_ms {};
+    double mean_ms {};
+    double p99_ms {};
+    std::size_t frames {};
+};
+
+/**
+ * @brief GPU time of a whole frame, from the start of its first scope to the end of its last.
+ *
+ */
+struct gpu_frame_time {
+    std::uint64_t frame {}; ///< the index of the frame, counted by gpu_profiler::end_frame.
+    double ms {};
+};
+
+/**
+ * @brief GPU profiler based on timer queries.
+ *
+ * @details Usage is as follows:
+ *
+ * @code{.cpp}
+ * staplegl::gpu_profiler profiler;
+ *
+ * while (running) {
+ *     profiler.begin_frame();
+ *     {
+ *         auto s = profiler.scope("bloom_down");
+ *         // ... draw calls ...
+ *     }
+ *     profiler.end_frame();
+ * }
+ *
+ * for (auto const& s : profiler.stats()) { ... }
+ * @endcode
+ *
+ * @note Timer queries are core since OpenGL 3.3.
+ */
+class gpu_profiler {
+
+public:
+    /**
+     * @brief RAII guard that times the GPU work issued during its lifetime.
+     *
+     * @see gpu_profiler::scope
+     */
+    class scope_guard {
+    public:
+        scope_guard(const scope_guard&) = delete;
+        auto operator=(const scope_guard&) -> scope_guard& = delete;
+        scope_guard(scope_guard&&) = delete;
+        auto operator=(scope_guard&&) -> scope_guard& = delete;
+
+        ~scope_guard() { m_profiler.end_scope(m_record); }
+
+    private:
+        friend class gpu_profiler;
+
+        scope_guard(gpu_profiler& profiler, std::size_t record) noexcept
+            : m_profiler { profiler }
+            , m_record { record }
+        {
+        }
+
+        gpu_profiler& m_profiler;
+        std::size_t m_record;
+    };
+
+    /**
+     * @brief Construct a new gpu profiler object
+     *
+     * @param frames_in_flight the number of frames a result can lag behind before being read,
+     * higher values reduce the chance of dropping results at the cost of latency.
+     * @param history the number of frames over which the statistics are computed.
+     */
+    explicit gpu_profiler(std::size_t frames_in_flight = 4, std::size_t history = 256) noexcept
+        : m_slots(std::max<std::size_t>(frames_in_flight, 1))
+        , m_history { std::max<std::size_t>(history, 1) }
+    {
+    }
+
+    ~gpu_profiler()
+    {
+        for (auto const& slot : m_slots) {
+            release_objects(gl_object::query, slot.queries);
+        }
+    }
+
+    gpu_profiler(const gpu_profiler&) = delete;
+    auto operator=(const gpu_profiler&) -> gpu_profiler& = delete;
+
+    gpu_profiler(gpu_profiler&&) noexcept = default;
+    auto operator=(gpu_profiler&&) noexcept -> gpu_profiler& = default;
+
+    /**
+     * @brief Start a new frame.
+     *
+     * @details Collects the results of the frame that previously occupied the ring slot being
+     * reused, if they are available, and prepares the slot for recording.
+     */
+    void begin_frame();
+
+    /**
+     * @brief End the current frame, every scope must be closed.
+     *
+     */
+    void end_frame() noexcept
+    {
+        assert(m_open_scopes == 0 && "gpu_profiler: frame ended with scopes still open");
+        ++m_frame;
+    }
+
+    /**
+     * @brief Open a named timing scope, which is closed when the returned guard is destroyed.
+     *
+     * @param name the name of the scope, scopes with the same name are aggregated together.
+     * @return scope_guard the guard that closes the scope.
+     */
+    [[nodiscard]] auto scope(std::string_view name) -> scope_guard;
+
+    /**
+     * @brief Compute min, mean and 99th percentile GPU time for every scope seen so far.
+     *
+     * @return std::vector<gpu_scope_stats> the statistics, in order of first appearance.
+     */
+    [[nodiscard]] auto stats() const -> std::vector<gpu_scope_stats>;
+
+    /**
+     * @brief Write the collected scopes in the Chrome trace event format.
+     *
+     * @details The output can be loaded in `chrome://tracing` or https://ui.perfetto.dev.
+     *
+     * @param out the stream to write the JSON document to.
+     */
+    void write_chrome_trace(std::ostream& out) const;
+
+    /**
+     * @brief Discard the events collected for the Chrome trace.
+     *
+     */
+    void clear_trace() noexcept { m_trace.clear(); }
+
+    /**
+     * @brief Get the number of frames whose results were not ready in time and were dropped.
+     *
+     * @return std::size_t the number of dropped frames.
+     */
+    [[nodiscard]] constexpr auto dropped_frames() const noexcept -> std::size_t { return m_dropped; }
+
+    /**
+     * @brief Get the GPU time of the most recent frame whose results were collected.
+     *
+     * @details The results lag `frames_in_flight` frames behind, compare gpu_frame_time::frame
+     * with current_frame() to tell which frame they belong to.
+     *
+     * @return std::optional<gpu_frame_time> the frame time, empty until a frame has been collected.
+     */
+    [[nodiscard]] constexpr auto latest_frame() const noexcept -> std::optional<gpu_frame_time> { return m_latest; }
+
+    /**
+     * @brief Get the index of the frame being recorded, or of the next one after end_frame().
+     *
+     */
+    [[nodiscard]] constexpr auto current_frame() const noexcept -> std::uint64_t { return m_frame; }
+
+    /**
+     * @brief Maximum number of events retained for the Chrome trace, older events are not overwritten.
+     *
+     */
+    static constexpr std::size_t max_trace_events = 1U << 16U;
+
+private:
+    struct record {
+        std::size_t name {};
+        std::uint32_t begin_query {};
+        std::uint32_t end_query {};
+    };
+
+    struct frame_slot {
+        std::vector<std::uint32_t> queries;
+        std::vector<record> records;
+        std::size_t used_queries {};
+        std::uint64_t frame {};
+    };
+
+    struct trace_event {
+        std::size_t name {};
+        std::uint64_t frame {};
+        std::uint64_t begin_ns {};
+        std::uint64_t end_ns {};
+    };
+
+    void end_scope(std::size_t record_index);
+    auto next_query(frame_slot& slot) -> std::uint32_t;
+    auto intern(std::string_view name) -> std::size_t;
+    void collect(frame_slot& slot);
+
+    [[nodiscard]] auto current_slot() noexcept -> frame_slot& { return m_slots[m_frame % m_slots.size()]; }
+
+    std::vector<frame_slot> m_slots;
+    std::vector<std::string> m_names;
+    std::vector<std::deque<double>> m_samples; // per-frame totals, in ms, indexed by name
+    std::vector<trace_event> m_trace;
+    std::optional<gpu_frame_time> m_latest;
+    std::size_t m_history {};
+    std::size_t m_dropped {};
+    std::size_t m_open_scopes {};
+    std::uint64_t m_frame {};
+};
+
+/*
+
+        IMPLEMENTATIONS
+
+*/
+
+inline void gpu_profiler::begin_frame()
+{
+    frame_slot& slot = current_slot();
+
+    if (!slot.records.empty()) {
+        // the last query of the slot is the last one to complete, if it is available then all the others are too.
+        std::int32_t available {};
+        glGetQueryObjectiv(slot.queries[slot.used_queries - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+
+        if (available != 0) [[likely]] {
+            collect(slot);
+        } else {
+            ++m_dropped;
+        }
+    }
+
+    slot.records.clear();
+    slot.used_queries = 0;
+    slot.frame = m_frame;
+}
+
+inline auto gpu_profiler::scope(std::string_view name) -> scope_guard
+{
+    frame_slot& slot = current_slot();
+    std::uint32_t const begin_query = next_query(slot);
+
+    glQueryCounter(begin_query, GL_TIMESTAMP);
+    slot.records.push_back({ intern(name), begin_query, 0 });
+    ++m_open_scopes;
+
+    return scope_guard { *this, slot.records.size() - 1 };
+}
+
+inline void gpu_profiler::end_scope(std::size_t record_index)
+{
+    frame_slot& slot = current_slot();
+    std::uint32_t const end_query = next_query(slot);
+
+    glQueryCounter(end_query, GL_TIMESTAMP);
+    slot.records[record_index].end_query = end_query;
+    --m_open_scopes;
+}
+
+inline auto gpu_profiler::next_query(frame_slot& slot) -> std::uint32_t
+{
+    if (slot.used_queries == slot.queries.size()) [[unlikely]] {
+        // grow the pool in blocks, query names are only generated during the first few frames.
+        constexpr std::size_t block_size = 16;
+        slot.queries.resize(slot.queries.size() + block_size);
+        acquire_names(gl_object::query, std::span { slot.queries }.subspan(slot.used_queries));
+    }
+
+    return slot.queries[slot.used_queries++];
+}
+
+inline auto gpu_profiler::intern(std::string_view name) -> std::size_t
+{
+    // a handful of scopes per frame, a linear scan beats hashing here.
+    auto const found = std::find(m_names.begin(), m_names.end(), name);
+    if (found != m_names.end()) [[likely]] {
+        return static_cast<std::size_t>(std::distance(m_names.begin(), found));
+    }
+
+    m_names.emplace_back(name);
+    m_samples.emplace_back();
+    return m_names.size() - 1;
+}
+
+inline void gpu_profiler::collect(frame_slot& slot)
+{
+    constexpr double ns_per_ms = 1.0e6;
+
+    std::vector<double> totals(m_names.size(), 0.0);
+    std::vector<bool> seen(m_names.size(), false);
+    std::uint64_t frame_begin_ns = ~std::uint64_t { 0 };
+    std::uint64_t frame_end_ns {};
+
+    for (auto const& [name, begin_query, end_query] : slot.records) {
+        if (end_query == 0) [[unlikely]] {
+            continue; // scope was never closed
+        }
+
+        std::uint64_t begin_ns {};
+        std::uint64_t end_ns {};
+        glGetQueryObjectui64v(begin_query, GL_QUERY_RESULT, &begin_ns);
+        glGetQueryObjectui64v(end_query, GL_QUERY_RESULT, &end_ns);
+
+        end_ns = std::max(end_ns, begin_ns);
+        totals[name] += static_cast<double>(end_ns - begin_ns) / ns_per_ms;
+        seen[name] = true;
+        frame_begin_ns = std::min(frame_begin_ns, begin_ns);
+        frame_end_ns = std::max(frame_end_ns, end_ns);
+
+        if (m_trace.size() < max_trace_events) {
+            m_trace.push_back({ name, slot.frame, begin_ns, end_ns });
+        }
+    }
+
+    if (frame_end_ns >= frame_begin_ns) {
+        m_latest = gpu_frame_time { .frame = slot.frame, .ms = static_cast<double>(frame_end_ns - frame_begin_ns) / ns_per_ms };
+    }
+
+    for (std::size_t i = 0; i < totals.size(); ++i) {
+        if (!seen[i]) {
+            continue;
+        }
+
+        auto& samples = m_samples[i];
+        samples.push_back(totals[i]);
+        if (samples.size() > m_history) {
+            samples.pop_front();
+        }
+    }
+}
+
+inline auto gpu_profiler::stats() const -> std::vector<gpu_scope_stats>
+{
+    std::vector<gpu_scope_stats> result;
+    result.reserve(m_names.size());
+
+    std::vector<double> sorted;
+    for (std::size_t i = 0; i < m_names.size(); ++i) {
+        auto const& samples = m_samples[i];
+        if (samples.empty()) {
+            continue;
+        }
+
+        sorted.assign(samples.begin(), samples.end());
+        std::sort(sorted.begin(), sorted.end());
+
+        double sum {};
+        for (double const sample : sorted) {
+            sum += sample;
+        }
+
+        // nearest-rank percentile
+        auto const p99_rank = static_cast<std::size_t>(0.99 * static_cast<double>(sorted.size() - 1) + 0.5);
+
+        result.push_back({ .name = m_names[i],
+            .min_ms = sorted.front(),
+            .mean_ms = sum / static_cast<double>(sorted.size()),
+            .p99_ms = sorted[p99_rank],
+            .frames = sorted.size() });
+    }
+
+    return result;
+}
+
+inline void gpu_profiler::write_chrome_trace(std::ostream& out) const
+{
+    constexpr double ns_per_us = 1.0e3;
+
+    // timestamps are relative to the first event, so that the trace starts at zero.
+    std::uint64_t origin = m_trace.empty() ? 0 : m_trace.front().begin_ns;
+    for (auto const& event : m_trace) {
+        origin = std::min(origin, event.begin_ns);
+    }
+
+    out << R"({"displayTimeUnit":"ms","traceEvents":[)";
+
+    for (bool first = true; auto const& [name, frame, begin_ns, end_ns] : m_trace) {
+        if (!first) {
+            out << ',';
+        }
+        first = false;
+
+        // scope names are chosen by the user, escape the characters that would break the document.
+        out << R"({"name":")";
+        for (char const c : m_names[name]) {
+            if (c == '"' || c == '\\') {
+                out << '\\';
+            }
+            out << c;
+        }
+
+        out << R"(","cat":"gpu","ph":"X","pid":0,"tid":0,"ts":)"
+            << static_cast<double>(begin_ns - origin) / ns_per_us
+            << R"(,"dur":)" << static_cast<double>(end_ns - begin_ns) / ns_per_us
+            << R"(,"args":{"frame":)" << frame << "}}";
+    }
+
+    out << "]}\n";
+}
+
+} // namespace staplegl
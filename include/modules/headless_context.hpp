@@ -0,0 +1,379 @@
+/**
+ * @file headless_context.hpp
+ * @author Dario Loi
+ * @brief Windowless OpenGL contexts, for offscreen rendering.
+ *
+ * @date 2026-10-17
+ *
+ * @copyright MIT License
+ *
+ * @details Creates an OpenGL core context through EGL, without a window system, so that frames
+ * can be rendered into a staplegl::framebuffer on servers and CI machines. Mesa's software
+ * rasterizer (llvmpipe) is enough, select it with `LIBGL_ALWAYS_SOFTWARE=1` or
+ * `EGL_PLATFORM=surfaceless` if the machine also has a GPU driver. <br>
+ *
+ * The context is created on the surfaceless platform (EGL_MESA_platform_surfaceless) when
+ * available, the default display otherwise, and without a surface at all if the driver supports
+ * EGL_KHR_no_config_context and EGL_KHR_surfaceless_context. Otherwise, it is bound to a 1x1
+ * pbuffer, which is never drawn to: everything is rendered into framebuffer objects. <br>
+ *
+ * All the contexts share the same EGL display, terminated with the last of them. Contexts may
+ * share their objects with another one (see headless_context_options::share), and be made current
+ * on a different thread than the one that created them, e.g. one per worker of a thread_pool.
+ * <br>
+ *
+ * The OpenGL functions are loaded with glad, the loader of the examples, the first time a
+ * context is made current. This header needs to link against EGL, so it is not included by
+ * staplegl.hpp.
+ *
+ * @code{.cpp}
+ * staplegl::headless_context const context;
+ * if (!context.is_valid()) {
+ *     return 1;
+ * }
+ *
+ * staplegl::framebuffer fbo;
+ * // ... render, then read back with glReadPixels.
+ * @endcode
+ */
+
+#pragma once
+
+#include "gl_functions.hpp"
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string_view>
+#include <utility>
+
+#ifdef STAPLEGL_DEBUG
+#include <cstdio>
+#endif // STAPLEGL_DEBUG
+
+namespace staplegl {
+
+/**
+ * @brief What a headless context is bound to.
+ *
+ */
+enum class headless_surface : std::uint8_t {
+    none,    ///< surfaceless context, no framebuffer config.
+    pbuffer, ///< 1x1 pbuffer, for drivers without surfaceless contexts.
+};
+
+class headless_context;
+
+/**
+ * @brief Options of a headless context.
+ *
+ */
+struct headless_context_options {
+    std::int32_t major { 4 };         ///< newest OpenGL version tried, older ones down to 3.3 follow.
+    std::int32_t minor { 6 };
+    bool debug {};                    ///< request a debug context.
+    headless_context const* share {}; ///< context to share objects with, if any.
+};
+
+class headless_context {
+public:
+    /**
+     * @brief Create a context and make it current on the calling thread.
+     *
+     * @see is_valid()
+     */
+    explicit headless_context(headless_context_options const& options = {}) noexcept;
+    ~headless_context();
+
+    headless_context(const headless_context&) = delete;
+    auto operator=(const headless_context&) -> headless_context& = delete;
+    headless_context(headless_context&&) = delete;
+    auto operator=(headless_context&&) -> headless_context& = delete;
+
+    /**
+     * @brief Whether the context was created, and the OpenGL functions loaded.
+     *
+     */
+    [[nodiscard]] auto is_valid() const noexcept -> bool { return m_valid; }
+
+    [[nodiscard]] auto surface() const noexcept -> headless_surface { return m_surface_kind; }
+
+    /**
+     * @brief The OpenGL version of the context, as {major, minor}.
+     *
+     */
+    [[nodiscard]] auto version() const noexcept -> std::pair<std::int32_t, std::int32_t> { return m_version; }
+
+    /**
+     * @brief Make the context current on the calling thread.
+     *
+     * @details A context is current on at most one thread at a time, release() it first on the
+     * thread it was current on.
+     *
+     * @return true on success.
+     */
+    auto make_current() const noexcept -> bool;
+
+    /**
+     * @brief Detach the context current on the calling thread, if any.
+     *
+     */
+    static void release() noexcept;
+
+    /**
+     * @brief The GL_RENDERER string of the current context.
+     *
+     */
+    [[nodiscard]] static auto renderer() noexcept -> const char*
+    {
+        return reinterpret_cast<const char*>(glGetString(GL_RENDERER)); // NOLINT (reinterpret-cast)
+    }
+
+private:
+    EGLDisplay m_display { EGL_NO_DISPLAY };
+    EGLConfig m_config { EGL_NO_CONFIG_KHR };
+    EGLContext m_context { EGL_NO_CONTEXT };
+    EGLSurface m_surface { EGL_NO_SURFACE };
+    headless_surface m_surface_kind { headless_surface::none };
+    std::pair<std::int32_t, std::int32_t> m_version {};
+    bool m_valid {};
+};
+
+/*
+
+        IMPLEMENTATIONS
+
+*/
+
+namespace detail {
+
+    /**
+     * @brief The EGL display shared by the headless contexts, reference counted.
+     *
+     * @details EGL returns the same handle for the same native display, and eglTerminate is not
+     * reference counted: terminating it with the first context destroyed would invalidate the
+     * others.
+     */
+    struct headless_display {
+        std::mutex mutex;
+        EGLDisplay display { EGL_NO_DISPLAY };
+        std::size_t references {};
+        bool gl_loaded {};
+
+        static auto instance() noexcept -> headless_display&
+        {
+            static headless_display display;
+            return display;
+        }
+
+        auto acquire() noexcept -> EGLDisplay
+        {
+            std::scoped_lock const lock { mutex };
+            if (references != 0) {
+                ++references;
+                return display;
+            }
+
+            // prefer a surfaceless display, fall back to the default one.
+            auto const get_platform_display = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>( // NOLINT (reinterpret-cast)
+                eglGetProcAddress("eglGetPlatformDisplayEXT"));
+            if (get_platform_display != nullptr) {
+                display = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+            }
+            if (display != EGL_NO_DISPLAY && eglInitialize(display, nullptr, nullptr) == EGL_FALSE) {
+                display = EGL_NO_DISPLAY;
+            }
+            if (display == EGL_NO_DISPLAY) {
+                display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+                if (display != EGL_NO_DISPLAY && eglInitialize(display, nullptr, nullptr) == EGL_FALSE) {
+                    display = EGL_NO_DISPLAY;
+                }
+            }
+
+            if (display != EGL_NO_DISPLAY) {
+                references = 1;
+            }
+            return display;
+        }
+
+        void release() noexcept
+        {
+            std::scoped_lock const lock { mutex };
+            if (references != 0 && --references == 0) {
+                eglTerminate(display);
+                display = EGL_NO_DISPLAY;
+            }
+        }
+
+        /**
+         * @brief Load the OpenGL functions, once, with a context current on the calling thread.
+         *
+         */
+        auto load_gl() noexcept -> bool
+        {
+            std::scoped_lock const lock { mutex };
+            if (!gl_loaded) {
+                gl_loaded = gladLoadGLLoader(reinterpret_cast<GLADloadproc>(eglGetProcAddress)) != 0; // NOLINT (reinterpret-cast)
+            }
+            return gl_loaded;
+        }
+    };
+
+    [[nodiscard]] inline auto has_egl_extension(EGLDisplay display, const char* name) noexcept -> bool
+    {
+        const char* extensions = eglQueryString(display, EGL_EXTENSIONS);
+        if (extensions == nullptr) {
+            return false;
+        }
+
+        std::string_view const list { extensions };
+        std::string_view const wanted { name };
+        for (std::size_t begin = 0; begin < list.size();) {
+            auto end = list.find(' ', begin);
+            if (end == std::string_view::npos) {
+                end = list.size();
+            }
+            if (list.substr(begin, end - begin) == wanted) {
+                return true;
+            }
+            begin = end + 1;
+        }
+        return false;
+    }
+
+} // namespace detail
+
+inline headless_context::headless_context(headless_context_options const& options) noexcept
+{
+    auto& shared = detail::headless_display::instance();
+    m_display = shared.acquire();
+    if (m_display == EGL_NO_DISPLAY) [[unlikely]] {
+#ifdef STAPLEGL_DEBUG
+        std::fprintf(stderr, STAPLEGL_LINEINFO ", could not initialize an EGL display\n");
+#endif // STAPLEGL_DEBUG
+        return;
+    }
+
+    eglBindAPI(EGL_OPENGL_API);
+
+    // a shared context must use the same config as the one it shares with.
+    auto const surfaceless = options.share != nullptr
+        ? options.share->m_surface_kind == headless_surface::none
+        : detail::has_egl_extension(m_display, "EGL_KHR_no_config_context")
+            && detail::has_egl_extension(m_display, "EGL_KHR_surfaceless_context");
+
+    if (!surfaceless) {
+        m_surface_kind = headless_surface::pbuffer;
+        m_config = options.share != nullptr ? options.share->m_config : EGL_NO_CONFIG_KHR;
+
+        if (m_config == EGL_NO_CONFIG_KHR) {
+            const std::array<EGLint, 15> config_attribs {
+                EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+                EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+                EGL_RED_SIZE, 8,
+                EGL_GREEN_SIZE, 8,
+                EGL_BLUE_SIZE, 8,
+                EGL_ALPHA_SIZE, 8,
+                EGL_DEPTH_SIZE, 24,
+                EGL_NONE
+            };
+
+            EGLint count {};
+            if (eglChooseConfig(m_display, config_attribs.data(), &m_config, 1, &count) == EGL_FALSE || count == 0) {
+                m_config = EGL_NO_CONFIG_KHR;
+            }
+        }
+
+        const std::array<EGLint, 5> pbuffer_attribs { EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE };
+        if (m_config != EGL_NO_CONFIG_KHR) {
+            m_surface = eglCreatePbufferSurface(m_display, m_config, pbuffer_attribs.data());
+        }
+        if (m_surface == EGL_NO_SURFACE) [[unlikely]] {
+#ifdef STAPLEGL_DEBUG
+            std::fprintf(stderr, STAPLEGL_LINEINFO ", no surfaceless contexts and no pbuffer config\n");
+#endif // STAPLEGL_DEBUG
+            return;
+        }
+    }
+
+    auto const share = options.share != nullptr ? options.share->m_context : EGL_NO_CONTEXT;
+
+    // the newest core profile the driver offers, llvmpipe tops out at 4.5.
+    constexpr std::array<std::pair<std::int32_t, std::int32_t>, 6> versions { {
+        { 4, 6 }, { 4, 5 }, { 4, 3 }, { 4, 2 }, { 4, 1 }, { 3, 3 } } };
+
+    for (auto const& [major, minor] : versions) {
+        if (major > options.major || (major == options.major && minor > options.minor)) {
+            continue;
+        }
+
+        const std::array<EGLint, 9> context_attribs {
+            EGL_CONTEXT_MAJOR_VERSION, major,
+            EGL_CONTEXT_MINOR_VERSION, minor,
+            EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+            EGL_CONTEXT_OPENGL_DEBUG, options.debug ? EGL_TRUE : EGL_FALSE,
+            EGL_NONE
+        };
+
+        m_context = eglCreateContext(m_display, m_config, share, context_attribs.data());
+        if (m_context != EGL_NO_CONTEXT) {
+            m_version = { major, minor };
+            break;
+        }
+    }
+
+    if (m_context == EGL_NO_CONTEXT || !make_current()) [[unlikely]] {
+#ifdef STAPLEGL_DEBUG
+        std::fprintf(stderr, STAPLEGL_LINEINFO ", could not create an OpenGL %d.%d core context\n",
+            options.major, options.minor);
+#endif // STAPLEGL_DEBUG
+        return;
+    }
+
+    if (!shared.load_gl()) [[unlikely]] {
+#ifdef STAPLEGL_DEBUG
+        std::fprintf(stderr, STAPLEGL_LINEINFO ", failed to load the OpenGL functions\n");
+#endif // STAPLEGL_DEBUG
+        return;
+    }
+
+    m_valid = true;
+}
+
+inline headless_context::~headless_context()
+{
+    if (m_display == EGL_NO_DISPLAY) {
+        return;
+    }
+
+    if (eglGetCurrentContext() == m_context) {
+        release();
+    }
+    if (m_context != EGL_NO_CONTEXT) {
+        eglDestroyContext(m_display, m_context);
+    }
+    if (m_surface != EGL_NO_SURFACE) {
+        eglDestroySurface(m_display, m_surface);
+    }
+
+    detail::headless_display::instance().release();
+}
+
+inline auto headless_context::make_current() const noexcept -> bool
+{
+    return eglMakeCurrent(m_display, m_surface, m_surface, m_context) == EGL_TRUE;
+}
+
+inline void headless_context::release() noexcept
+{
+    auto const display = eglGetCurrentDisplay();
+    if (display != EGL_NO_DISPLAY) {
+        eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    }
+}
+
+} // namespace staplegl
@@ -0,0 +1,749 @@
+/**
+ * @file image_writer.hpp
+ * @author Dario Loi
+ * @brief Image files encoded and written on worker threads.
+ *
+ * @date 2026-10-17
+ *
+ * @copyright MIT License
+ *
+ * @details Encoding a frame takes longer than rendering it on most offline workloads: done on the
+ * render thread, it can halve the throughput. image_writer takes the pixels of a readback (e.g. the
+ * span handed to an async_readback sink), copies them into one of its pooled host buffers, and
+ * returns; encoding and writing happen on its own worker threads. <br>
+ *
+ * The buffers are reused from one image to the next. When all of them are queued, write() waits
+ * for one to be released, so a renderer faster than the disk slows down instead of filling the
+ * memory. <br>
+ *
+ * Formats:
+ *
+ * - image_format::png, for `GL_UNSIGNED_BYTE` pixels in `GL_RED`, `GL_RGB` or `GL_RGBA`. The
+ *   encoder is built in, with adaptive row filters and fixed Huffman codes: files are larger
+ *   than those of zlib at its best, but encoding is fast.
+ * - image_format::exr, for `GL_HALF_FLOAT` or `GL_FLOAT` pixels in `GL_RED`, `GL_RGB` or
+ *   `GL_RGBA`, e.g. read back from `GL_RGBA16F` targets. Uncompressed scanline OpenEXR.
+ * - image_format::raw, any pixels, as they are.
+ *
+ * Pixels are given as read back, rows from the bottom; PNG and EXR files store them from the top.
+ *
+ * @code{.cpp}
+ * staplegl::image_writer writer;
+ *
+ * readback.read({ 0, 0, width, height }, frame, [&](std::uint64_t tag, auto const& region, std::span<const std::byte> pixels) {
+ *     writer.write("frame_" + std::to_string(tag) + ".png", staplegl::image_format::png,
+ *         { region.width, region.height }, {}, pixels);
+ * });
+ * @endcode
+ *
+ * @see https://www.w3.org/TR/png/
+ * @see https://openexr.com/en/latest/OpenEXRFileLayout.html
+ */
+
+#pragma once
+
+#include "async_readback.hpp"
+#include "utility.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <span>
+#include <stop_token>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#ifdef STAPLEGL_DEBUG
+#include <cstdio>
+#endif // STAPLEGL_DEBUG
+
+namespace staplegl {
+
+/**
+ * @brief Format of an image file.
+ *
+ */
+enum class image_format : std::uint8_t {
+    png, ///< 8 bits per channel.
+    exr, ///< half or single precision floats.
+    raw, ///< the pixels as given.
+};
+
+/**
+ * @brief Whether pixels of a format can be written in an image format.
+ *
+ */
+[[nodiscard]] constexpr auto can_encode(image_format format, readback_format pixels) noexcept -> bool;
+
+/**
+ * @brief Encode an image in memory.
+ *
+ * @param format the format of the file.
+ * @param size the size of the image.
+ * @param pixel_format the format of the pixels.
+ * @param pixels the pixels, rows from the bottom, tightly packed.
+ * @param out cleared, then filled with the file.
+ * @return true on success, false if the pixels cannot be encoded in that format.
+ */
+[[nodiscard]] auto encode_image(image_format format, resolution size, readback_format pixel_format,
+    std::span<const std::byte> pixels, std::vector<std::byte>& out) -> bool;
+
+/**
+ * @brief Writes image files on worker threads.
+ *
+ */
+class image_writer {
+public:
+    /**
+     * @brief Start the workers.
+     *
+     * @param workers the number of encoding threads.
+     * @param buffers the number of images queued or being encoded before write() waits.
+     */
+    explicit image_writer(std::size_t workers = default_workers(), std::size_t buffers = 8);
+
+    /**
+     * @brief Write every queued image, then stop the workers.
+     *
+     */
+    ~image_writer();
+
+    image_writer(const image_writer&) = delete;
+    auto operator=(const image_writer&) -> image_writer& = delete;
+    image_writer(image_writer&&) = delete;
+    auto operator=(image_writer&&) -> image_writer& = delete;
+
+    /**
+     * @brief Copy the pixels and queue the image, waits while every buffer is in use.
+     *
+     * @details Can be called from several threads.
+     *
+     * @return false if the pixels cannot be encoded in that format, or are too few.
+     */
+    auto write(std::string path, image_format format, resolution size, readback_format pixel_format,
+        std::span<const std::byte> pixels) -> bool;
+
+    /**
+     * @brief Wait until every queued image is written.
+     *
+     */
+    void wait();
+
+    /**
+     * @brief The number of images written, and of those that could not be.
+     *
+     */
+    [[nodiscard]] auto written() -> std::size_t;
+    [[nodiscard]] auto failed() -> std::size_t;
+
+    [[nodiscard]] static auto default_workers() noexcept -> std::size_t
+    {
+        return std::max(std::thread::hardware_concurrency(), 2U) - 1;
+    }
+
+private:
+    struct job {
+        std::string path;
+        image_format format {};
+        resolution size {};
+        readback_format pixel_format {};
+        std::vector<std::byte> pixels;
+    };
+
+    void work(std::stop_token const& stop);
+
+    std::mutex m_mutex;
+    std::condition_variable_any m_work;
+    std::condition_variable m_released;
+    std::deque<job> m_jobs;
+    std::vector<std::vector<std::byte>> m_free;
+    std::size_t m_buffers {}; ///< allocated so far.
+    std::size_t m_max_buffers {};
+    std::size_t m_busy {}; ///< images queued or being encoded.
+    std::size_t m_written {};
+    std::size_t m_failed {};
+
+    std::vector<std::jthread> m_threads; // last, so that the workers stop before the rest is destroyed
+};
+
+/*
+
+        IMPLEMENTATIONS
+
+*/
+
+constexpr auto can_encode(image_format format, readback_format pixels) noexcept -> bool
+{
+    auto const channels = pixels.format == GL_RED || pixels.format == GL_RGB || pixels.format == GL_RGBA;
+
+    switch (format) {
+    case image_format::png:
+        return channels && pixels.datatype == GL_UNSIGNED_BYTE;
+    case image_format::exr:
+        return channels && (pixels.datatype == GL_HALF_FLOAT || pixels.datatype == GL_FLOAT);
+    case image_format::raw:
+        return pixels.pixel_size() != 0;
+    }
+    return false;
+}
+
+namespace detail {
+
+    inline void put_bytes(std::vector<std::byte>& out, std::span<const std::byte> bytes)
+    {
+        out.insert(out.end(), bytes.begin(), bytes.end());
+    }
+
+    inline void put_string(std::vector<std::byte>& out, std::string_view text)
+    {
+        put_bytes(out, std::as_bytes(std::span { text.data(), text.size() }));
+        out.push_back(std::byte { 0 });
+    }
+
+    template <typename T>
+    inline void put_le(std::vector<std::byte>& out, T value)
+    {
+        std::array<unsigned char, sizeof(T)> bytes {};
+        std::memcpy(bytes.data(), &value, sizeof(T));
+        if constexpr (std::endian::native == std::endian::big) {
+            std::reverse(bytes.begin(), bytes.end());
+        }
+        put_bytes(out, std::as_bytes(std::span { bytes }));
+    }
+
+    inline void put_be32(std::vector<std::byte>& out, std::uint32_t value)
+    {
+        for (int shift = 24; shift >= 0; shift -= 8) {
+            out.push_back(static_cast<std::byte>(value >> shift));
+        }
+    }
+
+    inline auto crc32(std::span<const std::byte> bytes, std::uint32_t crc = 0) noexcept -> std::uint32_t
+    {
+        static constexpr auto table = [] {
+            std::array<std::uint32_t, 256> entries {};
+            for (std::uint32_t n = 0; n < 256; ++n) {
+                auto c = n;
+                for (int k = 0; k < 8; ++k) {
+                    c = (c & 1U) != 0 ? 0xEDB88320U ^ (c >> 1U) : c >> 1U;
+                }
+                entries[n] = c;
+            }
+            return entries;
+        }();
+
+        crc = ~crc;
+        for (auto const byte : bytes) {
+            crc = table[(crc ^ static_cast<std::uint32_t>(byte)) & 0xFFU] ^ (crc >> 8U);
+        }
+        return ~crc;
+    }
+
+    inline auto adler32(std::span<const std::byte> bytes) noexcept -> std::uint32_t
+    {
+        constexpr std::uint32_t modulus = 65521;
+        constexpr std::size_t chunk = 5552; // the longest run without overflowing 32 bits
+
+        std::uint32_t a = 1;
+        std::uint32_t b = 0;
+        for (std::size_t begin = 0; begin < bytes.size(); begin += chunk) {
+            auto const end = std::min(bytes.size(), begin + chunk);
+            for (std::size_t i = begin; i < end; ++i) {
+                a += static_cast<std::uint32_t>(bytes[i]);
+                b += a;
+            }
+            a %= modulus;
+            b %= modulus;
+        }
+        return (b << 16U) | a;
+    }
+
+    /**
+     * @brief Deflate stream writer, bits from the least significant.
+     *
+     */
+    class bit_writer {
+    public:
+        explicit bit_writer(std::vector<std::byte>& out) noexcept
+            : m_out { out }
+        {
+        }
+
+        void put(std::uint32_t bits, std::uint32_t count)
+        {
+            m_bits |= static_cast<std::uint64_t>(bits) << m_count;
+            m_count += count;
+            if (m_count >= 32) {
+                put_le(m_out, static_cast<std::uint32_t>(m_bits));
+                m_bits >>= 32U;
+                m_count -= 32;
+            }
+        }
+
+        /**
+         * @brief Reverse the bits of a Huffman code, which deflate stores from the most significant bit.
+         *
+         */
+        [[nodiscard]] static constexpr auto reverse(std::uint32_t code, std::uint32_t count) noexcept -> std::uint32_t
+        {
+            std::uint32_t reversed {};
+            for (std::uint32_t i = 0; i < count; ++i) {
+                reversed |= ((code >> i) & 1U) << (count - 1 - i);
+            }
+            return reversed;
+        }
+
+        void flush()
+        {
+            for (; m_count > 0; m_count -= std::min(m_count, 8U)) {
+                m_out.push_back(static_cast<std::byte>(m_bits & 0xFFU));
+                m_bits >>= 8U;
+            }
+            m_bits = 0;
+        }
+
+    private:
+        std::vector<std::byte>& m_out;
+        std::uint64_t m_bits {};
+        std::uint32_t m_count {};
+    };
+
+    /**
+     * @brief A zlib stream of one fixed Huffman block, with LZ77 matches found through a hash of
+     * the next three bytes (the latest position only, no chains).
+     *
+     */
+    inline void zlib_compress(std::span<const std::byte> data, std::vector<std::byte>& out)
+    {
+        static constexpr std::array<std::uint16_t, 29> length_base { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27,
+            31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+        static constexpr std::array<std::uint8_t, 29> length_extra { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3,
+            3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+        static constexpr std::array<std::uint16_t, 30> distance_base { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97,
+            129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+        static constexpr std::array<std::uint8_t, 30> distance_extra { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7,
+            7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+        constexpr std::size_t window = 32768;
+        constexpr std::size_t min_match = 3;
+        constexpr std::size_t max_match = 258;
+        constexpr std::uint32_t hash_bits = 15;
+
+        out.reserve(out.size() + data.size() + data.size() / 8 + 16); // literals take 9 bits at most
+        out.push_back(std::byte { 0x78 }); // deflate, 32K window
+        out.push_back(std::byte { 0x01 }); // fastest, header check
+
+        bit_writer bits { out };
+        bits.put(1, 1); // last block
+        bits.put(1, 2); // fixed Huffman codes
+
+        // the fixed literal/length codes, already bit-reversed (low byte) with their length (high byte).
+        static constexpr auto literal_codes = [] {
+            std::array<std::uint32_t, 288> codes {};
+            for (std::uint32_t symbol = 0; symbol < codes.size(); ++symbol) {
+                auto const [code, count] = symbol < 144 ? std::pair { 0x30 + symbol, 8U }
+                    : symbol < 256                      ? std::pair { 0x190 + symbol - 144, 9U }
+                    : symbol < 280                      ? std::pair { symbol - 256, 7U }
+                                                        : std::pair { 0xC0 + symbol - 280, 8U };
+                codes[symbol] = bit_writer::reverse(code, count) | (count << 16U);
+            }
+            return codes;
+        }();
+
+        auto const literal = [&bits](std::uint32_t symbol) {
+            auto const code = literal_codes[symbol];
+            bits.put(code & 0xFFFFU, code >> 16U);
+        };
+
+        auto const* bytes = reinterpret_cast<const std::uint8_t*>(data.data()); // NOLINT (reinterpret-cast)
+        auto const hash = [bytes](std::size_t i) {
+            auto const value = static_cast<std::uint32_t>(bytes[i]) | (static_cast<std::uint32_t>(bytes[i + 1]) << 8U)
+                | (static_cast<std::uint32_t>(bytes[i + 2]) << 16U);
+            return (value * 2654435761U) >> (32 - hash_bits);
+        };
+
+        std::vector<std::int64_t> head(std::size_t { 1 } << hash_bits, -1);
+        std::size_t i = 0;
+        while (i < data.size()) {
+            std::size_t length = 0;
+            std::size_t distance = 0;
+
+            if (i + min_match <= data.size()) {
+                auto const h = hash(i);
+                auto const candidate = head[h];
+                head[h] = static_cast<std::int64_t>(i);
+
+                if (candidate >= 0 && i - static_cast<std::size_t>(candidate) <= window) {
+                    auto const from = static_cast<std::size_t>(candidate);
+                    auto const limit = std::min(max_match, data.size() - i);
+                    while (length < limit && bytes[from + length] == bytes[i + length]) {
+                        ++length;
+                    }
+                    distance = i - from;
+                }
+            }
+
+            if (length < min_match) {
+                literal(bytes[i]);
+                ++i;
+                continue;
+            }
+
+            auto const length_code = static_cast<std::size_t>(
+                std::upper_bound(length_base.begin(), length_base.end(), length) - length_base.begin() - 1);
+            literal(static_cast<std::uint32_t>(257 + length_code));
+            bits.put(static_cast<std::uint32_t>(length - length_base[length_code]), length_extra[length_code]);
+
+            auto const distance_code = static_cast<std::size_t>(
+                std::upper_bound(distance_base.begin(), distance_base.end(), distance) - distance_base.begin() - 1);
+            bits.put(bit_writer::reverse(static_cast<std::uint32_t>(distance_code), 5), 5);
+            bits.put(static_cast<std::uint32_t>(distance - distance_base[distance_code]), distance_extra[distance_code]);
+
+            // index the skipped positions too, later matches often start inside this one.
+            auto const end = i + length;
+            for (++i; i < end && i + min_match <= data.size(); ++i) {
+                head[hash(i)] = static_cast<std::int64_t>(i);
+            }
+            i = end;
+        }
+
+        literal(256); // end of block
+        bits.flush();
+        put_be32(out, adler32(data));
+    }
+
+    inline auto paeth(int a, int b, int c) noexcept -> int
+    {
+        auto const p = a + b - c;
+        auto const pa = std::abs(p - a);
+        auto const pb = std::abs(p - b);
+        auto const pc = std::abs(p - c);
+        if (pa <= pb && pa <= pc) {
+            return a;
+        }
+        return pb <= pc ? b : c;
+    }
+
+    inline void png_chunk(std::vector<std::byte>& out, const char* type, std::span<const std::byte> data)
+    {
+        put_be32(out, static_cast<std::uint32_t>(data.size()));
+        auto const begin = out.size();
+        put_bytes(out, std::as_bytes(std::span { type, 4 }));
+        put_bytes(out, data);
+        put_be32(out, crc32(std::span { out }.subspan(begin)));
+    }
+
+    inline void encode_png(resolution size, std::size_t channels, std::span<const std::byte> pixels, std::vector<std::byte>& out)
+    {
+        constexpr std::array<std::uint8_t, 8> signature { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+        put_bytes(out, std::as_bytes(std::span { signature }));
+
+        std::vector<std::byte> header;
+        put_be32(header, static_cast<std::uint32_t>(size.width));
+        put_be32(header, static_cast<std::uint32_t>(size.height));
+        header.push_back(std::byte { 8 }); // bits per channel
+        header.push_back(std::byte { channels == 4 ? std::uint8_t { 6 } : channels == 3 ? std::uint8_t { 2 } : std::uint8_t { 0 } });
+        header.push_back(std::byte { 0 }); // deflate
+        header.push_back(std::byte { 0 }); // adaptive filtering
+        header.push_back(std::byte { 0 }); // not interlaced
+        png_chunk(out, "IHDR", header);
+
+        // every row with the filter that leaves the smallest sum of absolute values, the usual
+        // heuristic: it tends to leave the most repetitive bytes for deflate.
+        auto const stride = static_cast<std::size_t>(size.width) * channels;
+        std::vector<std::byte> filtered;
+        filtered.reserve((stride + 1) * static_cast<std::size_t>(size.height));
+        std::array<std::vector<std::uint8_t>, 5> candidates;
+        for (auto& candidate : candidates) {
+            candidate.resize(stride);
+        }
+
+        // the row above the first one is all zeros, as is the pixel left of the first column.
+        std::vector<std::uint8_t> const zeros(stride);
+
+        auto const* data = reinterpret_cast<const std::uint8_t*>(pixels.data()); // NOLINT (reinterpret-cast)
+        for (std::int32_t y = size.height - 1; y >= 0; --y) {
+            auto const* row = data + static_cast<std::size_t>(y) * stride;
+            auto const* above = y + 1 < size.height ? data + static_cast<std::size_t>(y + 1) * stride : zeros.data();
+
+            std::size_t best = 0;
+            std::uint64_t best_sum = ~std::uint64_t { 0 };
+            auto const try_filter = [&](std::size_t filter, auto predict) {
+                auto* candidate = candidates[filter].data();
+                std::uint64_t sum {};
+                auto const filter_byte = [&](std::size_t x, int a, int c) {
+                    auto const value = static_cast<std::uint8_t>(row[x] - predict(a, int { above[x] }, c));
+                    candidate[x] = value;
+                    sum += static_cast<std::uint64_t>(std::abs(static_cast<std::int8_t>(value)));
+                };
+
+                for (std::size_t x = 0; x < std::min(channels, stride); ++x) {
+                    filter_byte(x, 0, 0);
+                }
+                for (std::size_t x = channels; x < stride; ++x) {
+                    filter_byte(x, row[x - channels], above[x - channels]);
+                }
+
+                if (sum < best_sum) {
+                    best_sum = sum;
+                    best = filter;
+                }
+            };
+
+            try_filter(0, [](int /*a*/, int /*b*/, int /*c*/) { return 0; }); // none
+            try_filter(1, [](int a, int /*b*/, int /*c*/) { return a; }); // sub
+            try_filter(2, [](int /*a*/, int b, int /*c*/) { return b; }); // up
+            try_filter(3, [](int a, int b, int /*c*/) { return (a + b) / 2; }); // average
+            try_filter(4, [](int a, int b, int c) { return paeth(a, b, c); });
+
+            filtered.push_back(static_cast<std::byte>(best));
+            put_bytes(filtered, std::as_bytes(std::span { candidates[best] }));
+        }
+
+        std::vector<std::byte> compressed;
+        zlib_compress(filtered, compressed);
+        png_chunk(out, "IDAT", compressed);
+        png_chunk(out, "IEND", {});
+    }
+
+    inline void encode_exr(resolution size, readback_format format, std::span<const std::byte> pixels, std::vector<std::byte>& out)
+    {
+        auto const channels = format.format == GL_RGBA ? 4U : format.format == GL_RGB ? 3U : 1U;
+        auto const value_size = format.datatype == GL_HALF_FLOAT ? std::size_t { 2 } : std::size_t { 4 };
+        auto const pixel_type = format.datatype == GL_HALF_FLOAT ? std::int32_t { 1 } : std::int32_t { 2 };
+
+        // channels are stored in alphabetical order: A, B, G, R.
+        static constexpr std::array<std::pair<const char*, std::size_t>, 4> rgba { { { "A", 3 }, { "B", 2 }, { "G", 1 }, { "R", 0 } } };
+        std::span<const std::pair<const char*, std::size_t>> const order = std::span { rgba }.subspan(4 - channels);
+
+        put_le(out, std::uint32_t { 20000630 }); // magic number
+        put_le(out, std::uint32_t { 2 });        // version 2, single part scanline
+
+        auto const attribute = [&out](std::string_view name, std::string_view type, std::int32_t bytes) {
+            put_string(out, name);
+            put_string(out, type);
+            put_le(out, bytes);
+        };
+
+        attribute("channels", "chlist", static_cast<std::int32_t>(order.size() * 18 + 1));
+        for (auto const& [name, index] : order) {
+            put_string(out, name);
+            put_le(out, pixel_type);
+            put_le(out, std::uint32_t { 0 }); // pLinear and reserved
+            put_le(out, std::int32_t { 1 });  // x sampling
+            put_le(out, std::int32_t { 1 });  // y sampling
+        }
+        out.push_back(std::byte { 0 });
+
+        attribute("compression", "compression", 1);
+        out.push_back(std::byte { 0 }); // none
+
+        for (auto const* window : { "dataWindow", "displayWindow" }) {
+            attribute(window, "box2i", 16);
+            put_le(out, std::int32_t { 0 });
+            put_le(out, std::int32_t { 0 });
+            put_le(out, size.width - 1);
+            put_le(out, size.height - 1);
+        }
+
+        attribute("lineOrder", "lineOrder", 1);
+        out.push_back(std::byte { 0 }); // increasing y, from the top
+
+        attribute("pixelAspectRatio", "float", 4);
+        put_le(out, 1.0F);
+        attribute("screenWindowCenter", "v2f", 8);
+        put_le(out, 0.0F);
+        put_le(out, 0.0F);
+        attribute("screenWindowWidth", "float", 4);
+        put_le(out, 1.0F);
+        out.push_back(std::byte { 0 }); // end of header
+
+        // the offset table, then one scanline per block.
+        auto const width = static_cast<std::size_t>(size.width);
+        auto const line_bytes = width * order.size() * value_size;
+        auto offset = static_cast<std::uint64_t>(out.size()) + static_cast<std::uint64_t>(size.height) * 8;
+        for (std::int32_t y = 0; y < size.height; ++y) {
+            put_le(out, offset);
+            offset += 8 + line_bytes;
+        }
+
+        auto const pixel_bytes = channels * value_size;
+        for (std::int32_t y = 0; y < size.height; ++y) {
+            put_le(out, y);
+            put_le(out, static_cast<std::int32_t>(line_bytes));
+
+            auto const row = pixels.subspan(static_cast<std::size_t>(size.height - 1 - y) * width * pixel_bytes, width * pixel_bytes);
+            for (auto const& [name, index] : order) {
+                for (std::size_t x = 0; x < width; ++x) {
+                    auto const value = row.subspan(x * pixel_bytes + index * value_size, value_size);
+                    if (value_size == 2) {
+                        std::uint16_t half {};
+                        std::memcpy(&half, value.data(), 2);
+                        put_le(out, half);
+                    } else {
+                        std::uint32_t single {};
+                        std::memcpy(&single, value.data(), 4);
+                        put_le(out, single);
+                    }
+                }
+            }
+        }
+    }
+
+} // namespace detail
+
+inline auto encode_image(image_format format, resolution size, readback_format pixel_format,
+    std::span<const std::byte> pixels, std::vector<std::byte>& out) -> bool
+{
+    out.clear();
+
+    auto const expected = static_cast<std::size_t>(std::max(size.width, 0)) * static_cast<std::size_t>(std::max(size.height, 0))
+        * pixel_format.pixel_size();
+    if (!can_encode(format, pixel_format) || size.width <= 0 || size.height <= 0 || pixels.size() < expected) [[unlikely]] {
+#ifdef STAPLEGL_DEBUG
+        std::fprintf(stderr, STAPLEGL_LINEINFO ", cannot encode %zu bytes as a %dx%d image of format 0x%x and type 0x%x\n",
+            pixels.size(), size.width, size.height, pixel_format.format, pixel_format.datatype);
+#endif // STAPLEGL_DEBUG
+        return false;
+    }
+
+    switch (format) {
+    case image_format::png:
+        detail::encode_png(size, pixel_format.pixel_size(), pixels.first(expected), out);
+        break;
+    case image_format::exr:
+        detail::encode_exr(size, pixel_format, pixels.first(expected), out);
+        break;
+    case image_format::raw:
+        detail::put_bytes(out, pixels.first(expected));
+        break;
+    }
+    return true;
+}
+
+inline image_writer::image_writer(std::size_t workers, std::size_t buffers)
+    : m_max_buffers { std::max<std::size_t>(buffers, 1) }
+{
+    workers = std::max<std::size_t>(workers, 1);
+    m_threads.reserve(workers);
+    for (std::size_t i = 0; i < workers; ++i) {
+        m_threads.emplace_back([this](std::stop_token const& stop) { work(stop); });
+    }
+}
+
+inline image_writer::~image_writer()
+{
+    wait();
+
+    for (auto& thread : m_threads) {
+        thread.request_stop();
+    }
+    m_work.notify_all();
+}
+
+inline auto image_writer::write(std::string path, image_format format, resolution size, readback_format pixel_format,
+    std::span<const std::byte> pixels) -> bool
+{
+    auto const bytes = static_cast<std::size_t>(std::max(size.width, 0)) * static_cast<std::size_t>(std::max(size.height, 0))
+        * pixel_format.pixel_size();
+    if (!can_encode(format, pixel_format) || bytes == 0 || pixels.size() < bytes) [[unlikely]] {
+#ifdef STAPLEGL_DEBUG
+        std::fprintf(stderr, STAPLEGL_LINEINFO ", cannot write %s, the pixels do not fit the format\n", path.c_str());
+#endif // STAPLEGL_DEBUG
+        return false;
+    }
+
+    std::vector<std::byte> buffer;
+    {
+        // backpressure: wait for a buffer to be released rather than allocating without bound.
+        std::unique_lock lock { m_mutex };
+        m_released.wait(lock, [this] { return !m_free.empty() || m_buffers < m_max_buffers; });
+
+        if (!m_free.empty()) {
+            buffer = std::move(m_free.back());
+            m_free.pop_back();
+        } else {
+            ++m_buffers;
+        }
+        ++m_busy;
+    }
+
+    // copy outside of the lock, the other threads keep going.
+    buffer.assign(pixels.begin(), pixels.begin() + static_cast<std::ptrdiff_t>(bytes));
+
+    {
+        std::scoped_lock const lock { m_mutex };
+        m_jobs.push_back({ std::move(path), format, size, pixel_format, std::move(buffer) });
+    }
+    m_work.notify_one();
+    return true;
+}
+
+inline void image_writer::wait()
+{
+    std::unique_lock lock { m_mutex };
+    m_released.wait(lock, [this] { return m_busy == 0; });
+}
+
+inline auto image_writer::written() -> std::size_t
+{
+    std::scoped_lock const lock { m_mutex };
+    return m_written;
+}
+
+inline auto image_writer::failed() -> std::size_t
+{
+    std::scoped_lock const lock { m_mutex };
+    return m_failed;
+}
+
+inline void image_writer::work(std::stop_token const& stop)
+{
+    std::vector<std::byte> encoded; // reused by every image of this worker
+
+    while (true) {
+        job next;
+        {
+            std::unique_lock lock { m_mutex };
+            if (!m_work.wait(lock, stop, [this] { return !m_jobs.empty(); })) {
+                return;
+            }
+            next = std::move(m_jobs.front());
+            m_jobs.pop_front();
+        }
+
+        auto ok = encode_image(next.format, next.size, next.pixel_format, next.pixels, encoded);
+        if (ok) {
+            std::ofstream file { next.path, std::ios::binary | std::ios::trunc };
+            file.write(reinterpret_cast<const char*>(encoded.data()), static_cast<std::streamsize>(encoded.size())); // NOLINT (reinterpret-cast)
+            ok = file.good();
+        }
+
+#ifdef STAPLEGL_DEBUG
+        if (!ok) {
+            std::fprintf(stderr, STAPLEGL_LINEINFO ", could not write %s\n", next.path.c_str());
+        }
+#endif // STAPLEGL_DEBUG
+
+        {
+            std::scoped_lock const lock { m_mutex };
+            m_free.push_back(std::move(next.pixels));
+            --m_busy;
+            ++(ok ? m_written : m_failed);
+        }
+        m_released.notify_all();
+    }
+}
+
+} // namespace staplegl
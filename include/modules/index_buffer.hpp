@@ -19,7 +19,9 @@
 
 #pragma once
 
+#include "deletion_queue.hpp"
 #include "gl_functions.hpp"
+#include "name_pool.hpp"
 #include <cstdint>
 #include <iostream>
 #include <span>
@@ -115,7 +117,7 @@ private:
 inline index_buffer::index_buffer(std::span<const std::uint32_t> indices) noexcept
     : m_count { static_cast<int32_t>(indices.size()) }
 {
-    glGenBuffers(1, &m_id);
+    m_id = acquire_name(gl_object::buffer);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_id);
 
     glBufferData(GL_ELEMENT_ARRAY_BUFFER, 
@@ -127,7 +129,7 @@ inline index_buffer::index_buffer(std::span<const std::uint32_t> indices) noexce
 inline index_buffer::~index_buffer()
 {
     if (m_id != 0) {
-        glDeleteBuffers(1, &m_id);
+        release_object(gl_object::buffer, m_id);
     }
 }
 
@@ -0,0 +1,498 @@
+/**
+ * @file instance_bvh.hpp
+ * @author Dario Loi
+ * @brief Bounding volume hierarchy over instances, for frustum culling.
+ *
+ * @date 2026-10-17
+ *
+ * @copyright MIT License
+ *
+ * @details Drawing every instance of a large set costs as much when a handful are on screen as
+ * when all of them are. An instance_bvh keeps a bounding box per instance, organized in a tree,
+ * and cull() walks it against the view frustum, skipping whole groups of instances at once, to
+ * produce the indices of the visible ones. These can then be written to a smaller instance
+ * buffer as a compact range (see instance_shadow::upload), so that the draw call scales with the
+ * visible instances only. <br>
+ *
+ * The tree follows the instance buffer: insert, update and erase mirror add_instance,
+ * update_instance and delete_instance of vertex_buffer_inst, including the way deletions move the
+ * last instance. Updates refit the boxes from the leaf of the instance up to the root, without
+ * rebuilding anything; new instances are kept aside and tested one by one until there are enough
+ * of them to rebuild the tree, which rebuild() also does on demand, e.g. once instances have moved
+ * far enough that the boxes overlap a lot. <br>
+ *
+ * The test is conservative (a box straddling a corner of the frustum may be reported visible),
+ * and there is no occlusion culling.
+ *
+ * @code{.cpp}
+ * staplegl::instance_bvh bvh;
+ * for (auto const& object : objects) {
+ *     bvh.insert(staplegl::aabb::around(object.position, object.radius));
+ * }
+ *
+ * // every frame:
+ * bvh.update(moved, staplegl::aabb::around(position, radius));
+ * bvh.cull(staplegl::frustum::from_matrix(view_projection), visible);
+ * shadow.upload(visible_instances, visible);
+ * glDrawElementsInstanced(GL_TRIANGLES, count, GL_UNSIGNED_INT, nullptr, visible_instances.instance_count());
+ * @endcode
+ *
+ * @see instance_shadow.hpp
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace staplegl {
+
+/**
+ * @brief Axis-aligned bounding box.
+ *
+ */
+struct aabb {
+    std::array<float, 3> min { std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::max() };
+    std::array<float, 3> max { std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest() };
+
+    /**
+     * @brief The box around a sphere.
+     *
+     */
+    [[nodiscard]] static constexpr auto around(std::span<const float, 3> center, float radius) noexcept -> aabb
+    {
+        return { { center[0] - radius, center[1] - radius, center[2] - radius },
+            { center[0] + radius, center[1] + radius, center[2] + radius } };
+    }
+
+    /**
+     * @brief Grow the box to contain another one.
+     *
+     */
+    constexpr void merge(aabb const& other) noexcept
+    {
+        for (std::size_t axis = 0; axis < 3; ++axis) {
+            min[axis] = std::min(min[axis], other.min[axis]);
+            max[axis] = std::max(max[axis], other.max[axis]);
+        }
+    }
+
+    [[nodiscard]] constexpr auto centroid(std::size_t axis) const noexcept -> float { return (min[axis] + max[axis]) * 0.5F; }
+
+    constexpr auto operator==(aabb const&) const noexcept -> bool = default;
+};
+
+/**
+ * @brief A view frustum, as six planes whose positive side is inside.
+ *
+ */
+struct frustum {
+    std::array<std::array<float, 4>, 6> planes {}; ///< (a, b, c, d) such that `a x + b y + c z + d >= 0` inside.
+
+    /**
+     * @brief Extract the frustum of a view-projection matrix.
+     *
+     * @param view_projection a 4x4 matrix, column-major as in GLSL (e.g. glm::value_ptr).
+     */
+    [[nodiscard]] static constexpr auto from_matrix(std::span<const float, 16> view_projection) noexcept -> frustum;
+
+    /**
+     * @brief Bit mask with a bit set for every plane.
+     *
+     */
+    static constexpr std::uint8_t all_planes = 0b111111;
+
+    /**
+     * @brief Test a box against the planes in `mask`.
+     *
+     * @param box the box.
+     * @param mask the planes to test, updated to the planes the box crosses.
+     * @return true if the box may be inside the frustum, false if it is certainly outside.
+     */
+    [[nodiscard]] constexpr auto test(aabb const& box, std::uint8_t& mask) const noexcept -> bool;
+};
+
+/**
+ * @brief Bounding volume hierarchy over the instances of a buffer.
+ *
+ */
+class instance_bvh {
+public:
+    /**
+     * @brief The maximum number of instances per leaf.
+     *
+     */
+    static constexpr std::size_t leaf_size = 4;
+
+    instance_bvh() = default;
+
+    /**
+     * @brief Build the tree over a set of instances.
+     *
+     * @param bounds the box of every instance, in instance order.
+     */
+    explicit instance_bvh(std::span<const aabb> bounds);
+
+    /**
+     * @brief Add an instance, at the end like vertex_buffer_inst::add_instance.
+     *
+     * @return std::int32_t the index of the instance.
+     */
+    auto insert(aabb const& bounds) -> std::int32_t;
+
+    /**
+     * @brief Change the box of an instance, refitting the tree above it.
+     *
+     * @param index the index of the instance.
+     * @param bounds the new box.
+     */
+    void update(std::int32_t index, aabb const& bounds) noexcept;
+
+    /**
+     * @brief Remove an instance like vertex_buffer_inst::delete_instance: the last instance takes its index.
+     *
+     * @param index the index of the instance.
+     * @return std::int32_t the new index of the last instance.
+     */
+    auto erase(std::int32_t index) -> std::int32_t;
+
+    /**
+     * @brief Rebuild the tree from scratch, over the current boxes.
+     *
+     */
+    void rebuild();
+
+    /**
+     * @brief Collect the instances that may be visible.
+     *
+     * @param view the view frustum.
+     * @param visible cleared, then filled with the indices of the visible instances, in increasing order.
+     */
+    void cull(frustum const& view, std::vector<std::uint32_t>& visible);
+
+    [[nodiscard]] auto size() const noexcept -> std::size_t { return m_bounds.size(); }
+    [[nodiscard]] auto bounds(std::int32_t index) const noexcept -> aabb const& { return m_bounds[static_cast<std::size_t>(index)]; }
+
+private:
+    static constexpr std::uint32_t dead_item = std::numeric_limits<std::uint32_t>::max();
+    static constexpr std::int32_t no_slot = -1;
+
+    struct node {
+        aabb bounds;
+        std::int32_t first {}; ///< first child (the second follows it), or first item for leaves.
+        std::int32_t count {}; ///< number of items, 0 for internal nodes.
+        std::int32_t parent { -1 };
+    };
+
+    void build(std::int32_t index, std::size_t first, std::size_t last);
+    void refit(std::int32_t leaf) noexcept;
+    void emit(std::int32_t node, std::vector<std::uint32_t>& visible) const;
+
+    std::vector<aabb> m_bounds;            ///< per instance.
+    std::vector<std::int32_t> m_slot;      ///< per instance, its position in m_items, or no_slot if pending.
+    std::vector<std::uint32_t> m_items;    ///< instances, grouped by leaf.
+    std::vector<std::int32_t> m_item_leaf; ///< per item, its leaf.
+    std::vector<node> m_nodes;
+    std::vector<std::uint32_t> m_pending;  ///< instances inserted since the last build.
+    std::size_t m_dead {};                 ///< erased items still in m_items.
+    std::vector<std::pair<std::int32_t, std::uint8_t>> m_stack; ///< cull scratch, reused.
+};
+
+/*
+
+        IMPLEMENTATIONS
+
+*/
+
+constexpr auto frustum::from_matrix(std::span<const float, 16> view_projection) noexcept -> frustum
+{
+    auto const& m = view_projection;
+    auto const row = [&m](std::size_t r) { return std::array<float, 4> { m[r], m[4 + r], m[8 + r], m[12 + r] }; };
+    auto const combine = [](std::array<float, 4> const& lhs, std::array<float, 4> const& rhs, float sign) {
+        return std::array<float, 4> { lhs[0] + sign * rhs[0], lhs[1] + sign * rhs[1], lhs[2] + sign * rhs[2], lhs[3] + sign * rhs[3] };
+    };
+
+    // Gribb & Hartmann: the clip-space conditions -w <= x, y, z <= w as planes in world space.
+    auto const w = row(3);
+    frustum result {};
+    for (std::size_t axis = 0; axis < 3; ++axis) {
+        result.planes[axis * 2] = combine(w, row(axis), 1.0F);
+        result.planes[axis * 2 + 1] = combine(w, row(axis), -1.0F);
+    }
+    return result;
+}
+
+constexpr auto frustum::test(aabb const& box, std::uint8_t& mask) const noexcept -> bool
+{
+    for (std::size_t i = 0; i < planes.size(); ++i) {
+        auto const bit = static_cast<std::uint8_t>(1U << i);
+        if ((mask & bit) == 0) {
+            continue;
+        }
+
+        auto const& plane = planes[i];
+        float inner = plane[3]; // the corner of the box furthest along the normal
+        float outer = plane[3]; // the corner of the box furthest against it
+        for (std::size_t axis = 0; axis < 3; ++axis) {
+            auto const near_corner = plane[axis] >= 0.0F ? box.max[axis] : box.min[axis];
+            auto const far_corner = plane[axis] >= 0.0F ? box.min[axis] : box.max[axis];
+            inner += plane[axis] * near_corner;
+            outer += plane[axis] * far_corner;
+        }
+
+        if (inner < 0.0F) {
+            return false;
+        }
+        if (outer >= 0.0F) {
+            mask = static_cast<std::uint8_t>(mask & ~bit); // entirely on the inner side of this plane
+        }
+    }
+
+    return true;
+}
+
+inline instance_bvh::instance_bvh(std::span<const aabb> bounds)
+    : m_bounds { bounds.begin(), bounds.end() }
+{
+    rebuild();
+}
+
+inline auto instance_bvh::insert(aabb const& bounds) -> std::int32_t
+{
+    auto const index = static_cast<std::uint32_t>(m_bounds.size());
+    m_bounds.push_back(bounds);
+    m_slot.push_back(no_slot);
+    m_pending.push_back(index);
+
+    // pending instances are tested one by one, rebuild once they are a sizeable part of the set.
+    if (m_pending.size() > std::max<std::size_t>(64, m_bounds.size() / 8)) {
+        rebuild();
+    }
+
+    return static_cast<std::int32_t>(index);
+}
+
+inline void instance_bvh::update(std::int32_t index, aabb const& bounds) noexcept
+{
+    auto const instance = static_cast<std::size_t>(index);
+    if (instance >= m_bounds.size() || m_bounds[instance] == bounds) {
+        return;
+    }
+
+    m_bounds[instance] = bounds;
+    if (auto const slot = m_slot[instance]; slot != no_slot) {
+        refit(m_item_leaf[static_cast<std::size_t>(slot)]);
+    }
+}
+
+inline auto instance_bvh::erase(std::int32_t index) -> std::int32_t
+{
+    auto const instance = static_cast<std::size_t>(index);
+    if (instance >= m_bounds.size()) [[unlikely]] {
+        return static_cast<std::int32_t>(m_bounds.size()) - 1;
+    }
+
+    auto const remove = [this](std::size_t erased) {
+        if (auto const slot = m_slot[erased]; slot != no_slot) {
+            m_items[static_cast<std::size_t>(slot)] = dead_item; // the leaf box stays, conservatively
+            ++m_dead;
+        } else {
+            std::erase(m_pending, static_cast<std::uint32_t>(erased));
+        }
+    };
+
+    auto const last = m_bounds.size() - 1;
+    remove(instance);
+
+    if (instance != last) {
+        // the last instance moves to the erased index, along with its item.
+        m_bounds[instance] = m_bounds[last];
+        m_slot[instance] = m_slot[last];
+        if (auto const slot = m_slot[instance]; slot != no_slot) {
+            m_items[static_cast<std::size_t>(slot)] = static_cast<std::uint32_t>(instance);
+        } else {
+            std::replace(m_pending.begin(), m_pending.end(), static_cast<std::uint32_t>(last), static_cast<std::uint32_t>(instance));
+        }
+    }
+
+    m_bounds.pop_back();
+    m_slot.pop_back();
+
+    if (m_dead > std::max<std::size_t>(64, m_bounds.size() / 4)) {
+        rebuild(); // erased items are still visited, and their boxes still count in the leaves
+    }
+
+    return index;
+}
+
+inline void instance_bvh::rebuild()
+{
+    m_items.resize(m_bounds.size());
+    for (std::size_t i = 0; i < m_items.size(); ++i) {
+        m_items[i] = static_cast<std::uint32_t>(i);
+    }
+    m_item_leaf.assign(m_items.size(), 0);
+    m_slot.resize(m_bounds.size());
+    m_nodes.clear();
+    m_pending.clear();
+    m_dead = 0;
+
+    if (m_items.empty()) {
+        return;
+    }
+
+    m_nodes.reserve(2 * (m_items.size() / leaf_size + 1));
+    m_nodes.emplace_back();
+    build(0, 0, m_items.size());
+
+    for (std::size_t slot = 0; slot < m_items.size(); ++slot) {
+        m_slot[m_items[slot]] = static_cast<std::int32_t>(slot);
+    }
+}
+
+inline void instance_bvh::build(std::int32_t index, std::size_t first, std::size_t last)
+{
+    aabb bounds {};
+    aabb centroids {};
+    for (std::size_t i = first; i < last; ++i) {
+        auto const& box = m_bounds[m_items[i]];
+        bounds.merge(box);
+        std::array<float, 3> const centroid { box.centroid(0), box.centroid(1), box.centroid(2) };
+        centroids.merge({ centroid, centroid });
+    }
+
+    auto& current = m_nodes[static_cast<std::size_t>(index)];
+    current.bounds = bounds;
+
+    if (last - first <= leaf_size) {
+        current.first = static_cast<std::int32_t>(first);
+        current.count = static_cast<std::int32_t>(last - first);
+        for (std::size_t i = first; i < last; ++i) {
+            m_item_leaf[i] = index;
+        }
+        return;
+    }
+
+    // median split along the axis where the centroids spread the most.
+    std::size_t axis = 0;
+    for (std::size_t candidate = 1; candidate < 3; ++candidate) {
+        if (centroids.max[candidate] - centroids.min[candidate] > centroids.max[axis] - centroids.min[axis]) {
+            axis = candidate;
+        }
+    }
+
+    auto const middle = first + (last - first) / 2;
+    auto const items = m_items.begin();
+    std::nth_element(items + static_cast<std::ptrdiff_t>(first), items + static_cast<std::ptrdiff_t>(middle),
+        items + static_cast<std::ptrdiff_t>(last), [this, axis](std::uint32_t lhs, std::uint32_t rhs) {
+            return m_bounds[lhs].centroid(axis) < m_bounds[rhs].centroid(axis);
+        });
+
+    // the two children are allocated next to each other, before their subtrees.
+    auto const children = static_cast<std::int32_t>(m_nodes.size());
+    current.first = children;
+    m_nodes.push_back({ .bounds = {}, .parent = index });
+    m_nodes.push_back({ .bounds = {}, .parent = index });
+
+    build(children, first, middle);
+    build(children + 1, middle, last);
+}
+
+inline void instance_bvh::refit(std::int32_t leaf) noexcept
+{
+    // the leaf, from its items.
+    auto& leaf_node = m_nodes[static_cast<std::size_t>(leaf)];
+    aabb bounds {};
+    for (std::int32_t i = leaf_node.first; i < leaf_node.first + leaf_node.count; ++i) {
+        if (auto const item = m_items[static_cast<std::size_t>(i)]; item != dead_item) {
+            bounds.merge(m_bounds[item]);
+        }
+    }
+    leaf_node.bounds = bounds;
+
+    // then its ancestors, from their children, stopping as soon as a box is unchanged.
+    for (auto current = leaf_node.parent; current != -1;) {
+        auto& parent = m_nodes[static_cast<std::size_t>(current)];
+        aabb merged = m_nodes[static_cast<std::size_t>(parent.first)].bounds;
+        merged.merge(m_nodes[static_cast<std::size_t>(parent.first) + 1].bounds);
+
+        if (merged == parent.bounds) {
+            break;
+        }
+        parent.bounds = merged;
+        current = parent.parent;
+    }
+}
+
+inline void instance_bvh::cull(frustum const& view, std::vector<std::uint32_t>& visible)
+{
+    visible.clear();
+
+    if (!m_nodes.empty()) {
+        m_stack.clear();
+        m_stack.emplace_back(0, frustum::all_planes);
+
+        while (!m_stack.empty()) {
+            auto [index, mask] = m_stack.back();
+            m_stack.pop_back();
+
+            auto const& current = m_nodes[static_cast<std::size_t>(index)];
+            if (!view.test(current.bounds, mask)) {
+                continue;
+            }
+
+            if (mask == 0) {
+                emit(index, visible); // entirely inside, no need to test further
+                continue;
+            }
+
+            if (current.count == 0) {
+                m_stack.emplace_back(current.first + 1, mask);
+                m_stack.emplace_back(current.first, mask);
+                continue;
+            }
+
+            for (std::int32_t i = current.first; i < current.first + current.count; ++i) {
+                auto const item = m_items[static_cast<std::size_t>(i)];
+                auto item_mask = mask;
+                if (item != dead_item && view.test(m_bounds[item], item_mask)) {
+                    visible.push_back(item);
+                }
+            }
+        }
+    }
+
+    for (auto const instance : m_pending) {
+        auto mask = frustum::all_planes;
+        if (view.test(m_bounds[instance], mask)) {
+            visible.push_back(instance);
+        }
+    }
+
+    // in instance order, so that gathering them reads memory forward.
+    std::sort(visible.begin(), visible.end());
+}
+
+inline void instance_bvh::emit(std::int32_t node, std::vector<std::uint32_t>& visible) const
+{
+    auto const& current = m_nodes[static_cast<std::size_t>(node)];
+    if (current.count == 0) {
+        emit(current.first, visible);
+        emit(current.first + 1, visible);
+        return;
+    }
+
+    for (std::int32_t i = current.first; i < current.first + current.count; ++i) {
+        if (auto const item = m_items[static_cast<std::size_t>(i)]; item != dead_item) {
+            visible.push_back(item);
+        }
+    }
+}
+
+} // namespace staplegl
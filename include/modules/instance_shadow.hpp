@@ -0,0 +1,582 @@
+/**
+ * @file instance_shadow.hpp
+ * @author Dario Loi
+ * @brief Host-side, structure-of-arrays copy of instance data, with SIMD kernels.
+ *
+ * @date 2026-10-17
+ *
+ * @copyright MIT License
+ *
+ * @details Updating instances through vertex_buffer::apply reads mapped GPU memory, which is
+ * uncached and slow to read. An instance_shadow keeps the instance attributes in host memory
+ * instead, one array per component (all the x, then all the y, ...), where bulk operations
+ * vectorize naturally: translate, scale, lerp and matrix transforms run with AVX2, SSE2 or NEON
+ * when available, split over the cores of a thread_pool. The result goes to the GPU with a single
+ * streaming write (see vertex_buffer::stream), which interleaves the components back into the
+ * layout of the buffer. <br>
+ *
+ * Besides the attributes of the buffer, a shadow can hold host-only attributes (e.g. the start
+ * and end positions of an animation), which take part in the kernels but are never uploaded.
+ * Only float attributes are supported.
+ *
+ * @code{.cpp}
+ * staplegl::instance_shadow shadow { instance_layout };
+ * auto const position = shadow.index_of("instancePos");
+ * auto const target = shadow.add_host_attribute(u_type::vec3, "target");
+ * // ... fill the components ...
+ *
+ * // every frame:
+ * shadow.lerp(position, position, target, 0.1F, &pool);
+ * shadow.upload(instance_buffer);
+ * @endcode
+ *
+ * @see thread_pool.hpp
+ */
+
+#pragma once
+
+#include "gl_functions.hpp"
+#include "shader_data_type.hpp"
+#include "thread_pool.hpp"
+#include "vertex_buffer.hpp"
+#include "vertex_buffer_inst.hpp"
+#include "vertex_buffer_layout.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#if defined(__AVX2__)
+#define STAPLEGL_SHADOW_AVX2
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#define STAPLEGL_SHADOW_SSE2
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#define STAPLEGL_SHADOW_NEON
+#include <arm_neon.h>
+#endif
+
+#ifdef STAPLEGL_DEBUG
+#include <cstdio>
+#endif // STAPLEGL_DEBUG
+
+namespace staplegl {
+
+/**
+ * @brief Structure-of-arrays copy of the instance attributes of a buffer.
+ *
+ */
+class instance_shadow {
+public:
+    /**
+     * @brief Number of instances below which kernels do not bother splitting the work.
+     *
+     */
+    static constexpr std::size_t parallel_grain = 16384;
+
+    /**
+     * @brief Construct a new, empty shadow of the instances of a buffer.
+     *
+     * @param layout the layout of the instance buffer, made of float attributes only.
+     */
+    explicit instance_shadow(vertex_buffer_layout const& layout);
+
+    /**
+     * @brief Add an attribute that only lives in host memory.
+     *
+     * @param type the type of the attribute, a float type.
+     * @param name the name of the attribute.
+     * @return std::size_t the index of the attribute.
+     */
+    auto add_host_attribute(shader_data_type::u_type type, std::string_view name) -> std::size_t;
+
+    /**
+     * @brief Look up an attribute by name.
+     *
+     * @return std::size_t the index of the attribute, attribute_count() if there is no such attribute.
+     */
+    [[nodiscard]] auto index_of(std::string_view name) const noexcept -> std::size_t;
+
+    /**
+     * @brief Append an instance.
+     *
+     * @param instance the values of the buffer attributes, interleaved as in the buffer layout.
+     * Host attributes are zeroed.
+     */
+    void push_instance(std::span<const float> instance);
+
+    void resize(std::size_t instances);
+    void clear() noexcept { resize(0); }
+
+    [[nodiscard]] auto size() const noexcept -> std::size_t { return m_size; }
+    [[nodiscard]] auto attribute_count() const noexcept -> std::size_t { return m_attributes.size(); }
+
+    /**
+     * @brief Access the values of one component of an attribute, for every instance.
+     *
+     * @param attribute the index of the attribute.
+     * @param component the component, e.g. 1 for the y of a vec3.
+     * @return std::span<float> one value per instance.
+     */
+    [[nodiscard]] auto component(std::size_t attribute, std::size_t component) noexcept -> std::span<float>;
+    [[nodiscard]] auto component(std::size_t attribute, std::size_t component) const noexcept -> std::span<const float>;
+
+    // KERNELS, all over every instance, in parallel on `pool` if given.
+
+    /**
+     * @brief Add an offset to an attribute.
+     *
+     * @param offset one value per component of the attribute.
+     */
+    void translate(std::size_t attribute, std::span<const float> offset, thread_pool* pool = nullptr);
+
+    /**
+     * @brief Multiply every component of an attribute by a factor.
+     *
+     */
+    void scale(std::size_t attribute, float factor, thread_pool* pool = nullptr);
+
+    /**
+     * @brief Interpolate between two attributes: `attribute = from + (to - from) * t`.
+     *
+     * @details The three attributes must have the same type, `attribute` may be `from` or `to`.
+     */
+    void lerp(std::size_t attribute, std::size_t from, std::size_t to, float t, thread_pool* pool = nullptr);
+
+    /**
+     * @brief Multiply a vec3 (as a point, w = 1) or vec4 attribute by a matrix.
+     *
+     * @param matrix a 4x4 matrix, column-major as in GLSL (e.g. glm::value_ptr).
+     */
+    void transform(std::size_t attribute, std::span<const float, 16> matrix, thread_pool* pool = nullptr);
+
+    /**
+     * @brief Write the buffer attributes of every instance to an instance buffer.
+     *
+     * @details The buffer is rewritten with vertex_buffer::stream, hence without reading anything
+     * back, and according to its streaming mode.
+     *
+     * @param buffer the buffer the shadow was created from, holding size() instances.
+     */
+    void upload(vertex_buffer& buffer) const;
+
+    /**
+     * @brief Write the buffer attributes of a subset of the instances, packed at the start of a buffer.
+     *
+     * @details Used to draw only the visible instances (see instance_bvh::cull): the buffer is
+     * resized to `indices.size()` instances, written in the order of `indices`.
+     *
+     * @param buffer a buffer with the layout the shadow was created from.
+     * @param indices the instances to write.
+     */
+    void upload(vertex_buffer_inst& buffer, std::span<const std::uint32_t> indices) const;
+
+    /**
+     * @brief Interleave the buffer attributes of a range of instances into memory laid out as the buffer.
+     *
+     * @param first the first instance.
+     * @param out room for `out.size() / stride` instances, in floats.
+     */
+    void interleave(std::size_t first, std::span<float> out) const noexcept;
+
+    /**
+     * @brief Interleave the buffer attributes of the given instances, one after the other.
+     *
+     */
+    void interleave(std::span<const std::uint32_t> indices, std::span<float> out) const noexcept;
+
+private:
+    struct attribute_info {
+        std::string name;
+        shader_data_type::u_type type;
+        std::size_t first_component; ///< index of its first array in m_components.
+        std::size_t components;
+        std::size_t offset; ///< offset in the interleaved buffer, in floats, for buffer attributes.
+        bool on_gpu;
+    };
+
+    void add_attribute(shader_data_type::u_type type, std::string_view name, std::size_t elements, std::size_t offset, bool on_gpu);
+
+    template <typename Kernel>
+    void run(std::size_t count, thread_pool* pool, Kernel const& kernel) const;
+
+    std::vector<attribute_info> m_attributes;
+    std::vector<std::vector<float>> m_components;
+    std::size_t m_stride {}; ///< of the buffer, in floats.
+    std::size_t m_size {};
+};
+
+/*
+
+        IMPLEMENTATIONS
+
+*/
+
+namespace detail {
+
+    // a single SIMD register of floats, so that every kernel is written once.
+#if defined(STAPLEGL_SHADOW_AVX2)
+    struct float_lanes {
+        using reg = __m256;
+        static constexpr std::size_t width = 8;
+
+        static auto load(const float* ptr) noexcept -> reg { return _mm256_loadu_ps(ptr); }
+        static void store(float* ptr, reg value) noexcept { _mm256_storeu_ps(ptr, value); }
+        static auto set(float value) noexcept -> reg { return _mm256_set1_ps(value); }
+        static auto add(reg lhs, reg rhs) noexcept -> reg { return _mm256_add_ps(lhs, rhs); }
+        static auto sub(reg lhs, reg rhs) noexcept -> reg { return _mm256_sub_ps(lhs, rhs); }
+        static auto mul(reg lhs, reg rhs) noexcept -> reg { return _mm256_mul_ps(lhs, rhs); }
+#ifdef __FMA__
+        static auto fmadd(reg lhs, reg rhs, reg acc) noexcept -> reg { return _mm256_fmadd_ps(lhs, rhs, acc); }
+#else
+        static auto fmadd(reg lhs, reg rhs, reg acc) noexcept -> reg { return add(mul(lhs, rhs), acc); }
+#endif // __FMA__
+
+        // writes (a[l], b[l], c[l], d[l]) at out + l * stride for every lane l.
+        static void scatter4(reg a, reg b, reg c, reg d, float* out, std::size_t stride) noexcept
+        {
+            auto const ab_low = _mm256_unpacklo_ps(a, b);
+            auto const ab_high = _mm256_unpackhi_ps(a, b);
+            auto const cd_low = _mm256_unpacklo_ps(c, d);
+            auto const cd_high = _mm256_unpackhi_ps(c, d);
+
+            // each holds lane l in its lower half and lane l + 4 in its upper half.
+            auto const store = [out, stride](std::size_t l, __m256 lanes) {
+                _mm_storeu_ps(out + l * stride, _mm256_castps256_ps128(lanes));
+                _mm_storeu_ps(out + (l + 4) * stride, _mm256_extractf128_ps(lanes, 1));
+            };
+            store(0, _mm256_shuffle_ps(ab_low, cd_low, 0x44));
+            store(1, _mm256_shuffle_ps(ab_low, cd_low, 0xEE));
+            store(2, _mm256_shuffle_ps(ab_high, cd_high, 0x44));
+            store(3, _mm256_shuffle_ps(ab_high, cd_high, 0xEE));
+        }
+    };
+#elif defined(STAPLEGL_SHADOW_SSE2)
+    struct float_lanes {
+        using reg = __m128;
+        static constexpr std::size_t width = 4;
+
+        static auto load(const float* ptr) noexcept -> reg { return _mm_loadu_ps(ptr); }
+        static void store(float* ptr, reg value) noexcept { _mm_storeu_ps(ptr, value); }
+        static auto set(float value) noexcept -> reg { return _mm_set1_ps(value); }
+        static auto add(reg lhs, reg rhs) noexcept -> reg { return _mm_add_ps(lhs, rhs); }
+        static auto sub(reg lhs, reg rhs) noexcept -> reg { return _mm_sub_ps(lhs, rhs); }
+        static auto mul(reg lhs, reg rhs) noexcept -> reg { return _mm_mul_ps(lhs, rhs); }
+        static auto fmadd(reg lhs, reg rhs, reg acc) noexcept -> reg { return add(mul(lhs, rhs), acc); }
+
+        // writes (a[l], b[l], c[l], d[l]) at out + l * stride for every lane l.
+        static void scatter4(reg a, reg b, reg c, reg d, float* out, std::size_t stride) noexcept
+        {
+            _MM_TRANSPOSE4_PS(a, b, c, d);
+            _mm_storeu_ps(out, a);
+            _mm_storeu_ps(out + stride, b);
+            _mm_storeu_ps(out + 2 * stride, c);
+            _mm_storeu_ps(out + 3 * stride, d);
+        }
+    };
+#elif defined(STAPLEGL_SHADOW_NEON)
+    struct float_lanes {
+        using reg = float32x4_t;
+        static constexpr std::size_t width = 4;
+
+        static auto load(const float* ptr) noexcept -> reg { return vld1q_f32(ptr); }
+        static void store(float* ptr, reg value) noexcept { vst1q_f32(ptr, value); }
+        static auto set(float value) noexcept -> reg { return vdupq_n_f32(value); }
+        static auto add(reg lhs, reg rhs) noexcept -> reg { return vaddq_f32(lhs, rhs); }
+        static auto sub(reg lhs, reg rhs) noexcept -> reg { return vsubq_f32(lhs, rhs); }
+        static auto mul(reg lhs, reg rhs) noexcept -> reg { return vmulq_f32(lhs, rhs); }
+        static auto fmadd(reg lhs, reg rhs, reg acc) noexcept -> reg { return vmlaq_f32(acc, lhs, rhs); }
+
+        // writes (a[l], b[l], c[l], d[l]) at out + l * stride for every lane l.
+        static void scatter4(reg a, reg b, reg c, reg d, float* out, std::size_t stride) noexcept
+        {
+            auto const ab = vtrnq_f32(a, b); // (a0 b0 a2 b2), (a1 b1 a3 b3)
+            auto const cd = vtrnq_f32(c, d);
+            vst1q_f32(out, vcombine_f32(vget_low_f32(ab.val[0]), vget_low_f32(cd.val[0])));
+            vst1q_f32(out + stride, vcombine_f32(vget_low_f32(ab.val[1]), vget_low_f32(cd.val[1])));
+            vst1q_f32(out + 2 * stride, vcombine_f32(vget_high_f32(ab.val[0]), vget_high_f32(cd.val[0])));
+            vst1q_f32(out + 3 * stride, vcombine_f32(vget_high_f32(ab.val[1]), vget_high_f32(cd.val[1])));
+        }
+    };
+#endif
+
+    struct scalar_lanes {
+        using reg = float;
+        static constexpr std::size_t width = 1;
+
+        static auto load(const float* ptr) noexcept -> reg { return *ptr; }
+        static void store(float* ptr, reg value) noexcept { *ptr = value; }
+        static auto set(float value) noexcept -> reg { return value; }
+        static auto add(reg lhs, reg rhs) noexcept -> reg { return lhs + rhs; }
+        static auto sub(reg lhs, reg rhs) noexcept -> reg { return lhs - rhs; }
+        static auto mul(reg lhs, reg rhs) noexcept -> reg { return lhs * rhs; }
+        static auto fmadd(reg lhs, reg rhs, reg acc) noexcept -> reg { return lhs * rhs + acc; }
+
+        static void scatter4(reg a, reg b, reg c, reg d, float* out, std::size_t /*stride*/) noexcept
+        {
+            out[0] = a;
+            out[1] = b;
+            out[2] = c;
+            out[3] = d;
+        }
+    };
+
+    /**
+     * @brief Run `body.template operator()<Lanes>(i)` over [begin, end), full registers first.
+     *
+     */
+    template <typename Body>
+    inline void for_each_lane(std::size_t begin, std::size_t end, Body const& body) noexcept
+    {
+        std::size_t i = begin;
+#if defined(STAPLEGL_SHADOW_AVX2) || defined(STAPLEGL_SHADOW_SSE2) || defined(STAPLEGL_SHADOW_NEON)
+        for (; i + float_lanes::width <= end; i += float_lanes::width) {
+            body.template operator()<float_lanes>(i);
+        }
+#endif
+        for (; i < end; ++i) {
+            body.template operator()<scalar_lanes>(i);
+        }
+    }
+
+    [[nodiscard]] constexpr auto is_float_type(shader_data_type::u_type type) noexcept -> bool
+    {
+        using shader_data_type::u_type;
+        return type == u_type::float32 || type == u_type::vec2 || type == u_type::vec3
+            || type == u_type::vec4 || type == u_type::mat3 || type == u_type::mat4;
+    }
+
+} // namespace detail
+
+inline instance_shadow::instance_shadow(vertex_buffer_layout const& layout)
+    : m_stride { layout.stride() / sizeof(float) }
+{
+    for (auto const& attribute : layout.get_attributes()) {
+        add_attribute(attribute.type, attribute.name, attribute.element_count, attribute.offset / sizeof(float), true);
+    }
+}
+
+inline void instance_shadow::add_attribute(shader_data_type::u_type type, std::string_view name,
+    std::size_t elements, std::size_t offset, bool on_gpu)
+{
+    if (!detail::is_float_type(type)) [[unlikely]] {
+#ifdef STAPLEGL_DEBUG
+        std::fprintf(stderr, STAPLEGL_LINEINFO ", attribute \"%.*s\" of an instance_shadow is not a float type\n",
+            static_cast<int>(name.size()), name.data());
+#endif // STAPLEGL_DEBUG
+        std::terminate();
+    }
+
+    auto const components = shader_data_type::component_count(type) * elements;
+    m_attributes.push_back({ std::string { name }, type, m_components.size(), components, offset, on_gpu });
+    for (std::size_t i = 0; i < components; ++i) {
+        m_components.emplace_back(m_size, 0.0F);
+    }
+}
+
+inline auto instance_shadow::add_host_attribute(shader_data_type::u_type type, std::string_view name) -> std::size_t
+{
+    add_attribute(type, name, 1, 0, false);
+    return m_attributes.size() - 1;
+}
+
+inline auto instance_shadow::index_of(std::string_view name) const noexcept -> std::size_t
+{
+    auto const found = std::find_if(m_attributes.begin(), m_attributes.end(),
+        [name](attribute_info const& attribute) { return attribute.name == name; });
+    return static_cast<std::size_t>(found - m_attributes.begin());
+}
+
+inline void instance_shadow::push_instance(std::span<const float> instance)
+{
+    for (auto const& attribute : m_attributes) {
+        for (std::size_t c = 0; c < attribute.components; ++c) {
+            auto const index = attribute.offset + c;
+            m_components[attribute.first_component + c].push_back(
+                attribute.on_gpu && index < instance.size() ? instance[index] : 0.0F);
+        }
+    }
+    ++m_size;
+}
+
+inline void instance_shadow::resize(std::size_t instances)
+{
+    for (auto& values : m_components) {
+        values.resize(instances, 0.0F);
+    }
+    m_size = instances;
+}
+
+inline auto instance_shadow::component(std::size_t attribute, std::size_t component) noexcept -> std::span<float>
+{
+    return m_components[m_attributes[attribute].first_component + component];
+}
+
+inline auto instance_shadow::component(std::size_t attribute, std::size_t component) const noexcept -> std::span<const float>
+{
+    return m_components[m_attributes[attribute].first_component + component];
+}
+
+template <typename Kernel>
+inline void instance_shadow::run(std::size_t count, thread_pool* pool, Kernel const& kernel) const
+{
+    if (pool == nullptr || count < parallel_grain) {
+        kernel(std::size_t { 0 }, count);
+        return;
+    }
+
+    pool->parallel_for(count, parallel_grain, kernel);
+}
+
+inline void instance_shadow::translate(std::size_t attribute, std::span<const float> offset, thread_pool* pool)
+{
+    auto const& info = m_attributes[attribute];
+    auto const components = std::min(info.components, offset.size());
+
+    for (std::size_t c = 0; c < components; ++c) {
+        float* values = m_components[info.first_component + c].data();
+        float const delta = offset[c];
+
+        run(m_size, pool, [values, delta](std::size_t begin, std::size_t end) {
+            detail::for_each_lane(begin, end, [values, delta]<typename L>(std::size_t i) {
+                L::store(values + i, L::add(L::load(values + i), L::set(delta)));
+            });
+        });
+    }
+}
+
+inline void instance_shadow::scale(std::size_t attribute, float factor, thread_pool* pool)
+{
+    auto const& info = m_attributes[attribute];
+
+    for (std::size_t c = 0; c < info.components; ++c) {
+        float* values = m_components[info.first_component + c].data();
+
+        run(m_size, pool, [values, factor](std::size_t begin, std::size_t end) {
+            detail::for_each_lane(begin, end, [values, factor]<typename L>(std::size_t i) {
+                L::store(values + i, L::mul(L::load(values + i), L::set(factor)));
+            });
+        });
+    }
+}
+
+inline void instance_shadow::lerp(std::size_t attribute, std::size_t from, std::size_t to, float t, thread_pool* pool)
+{
+    auto const& info = m_attributes[attribute];
+    auto const components = std::min({ info.components, m_attributes[from].components, m_attributes[to].components });
+
+    for (std::size_t c = 0; c < components; ++c) {
+        float* out = m_components[info.first_component + c].data();
+        const float* start = m_components[m_attributes[from].first_component + c].data();
+        const float* end_values = m_components[m_attributes[to].first_component + c].data();
+
+        run(m_size, pool, [=](std::size_t begin, std::size_t end) {
+            detail::for_each_lane(begin, end, [=]<typename L>(std::size_t i) {
+                auto const a = L::load(start + i);
+                L::store(out + i, L::fmadd(L::sub(L::load(end_values + i), a), L::set(t), a));
+            });
+        });
+    }
+}
+
+inline void instance_shadow::transform(std::size_t attribute, std::span<const float, 16> matrix, thread_pool* pool)
+{
+    auto const& info = m_attributes[attribute];
+    auto const components = info.components;
+    if (components != 3 && components != 4) [[unlikely]] {
+#ifdef STAPLEGL_DEBUG
+        std::fprintf(stderr, STAPLEGL_LINEINFO ", instance_shadow::transform needs a vec3 or vec4 attribute\n");
+#endif // STAPLEGL_DEBUG
+        return;
+    }
+
+    std::array<float*, 4> values {};
+    for (std::size_t c = 0; c < components; ++c) {
+        values[c] = m_components[info.first_component + c].data();
+    }
+
+    std::array<float, 16> m {};
+    std::copy(matrix.begin(), matrix.end(), m.begin());
+
+    run(m_size, pool, [values, m, components](std::size_t begin, std::size_t end) {
+        detail::for_each_lane(begin, end, [&values, &m, components]<typename L>(std::size_t i) {
+            auto const x = L::load(values[0] + i);
+            auto const y = L::load(values[1] + i);
+            auto const z = L::load(values[2] + i);
+            auto const w = components == 4 ? L::load(values[3] + i) : L::set(1.0F);
+
+            // row r of the result is m[r] * x + m[4 + r] * y + m[8 + r] * z + m[12 + r] * w.
+            for (std::size_t r = 0; r < components; ++r) {
+                auto row = L::mul(L::set(m[12 + r]), w);
+                row = L::fmadd(L::set(m[8 + r]), z, row);
+                row = L::fmadd(L::set(m[4 + r]), y, row);
+                row = L::fmadd(L::set(m[r]), x, row);
+                L::store(values[r] + i, row);
+            }
+        });
+    });
+}
+
+inline void instance_shadow::interleave(std::size_t first, std::span<float> out) const noexcept
+{
+    if (m_stride == 0) {
+        return;
+    }
+
+    auto const count = std::min(out.size() / m_stride, m_size - std::min(first, m_size));
+    for (auto const& attribute : m_attributes) {
+        if (!attribute.on_gpu) {
+            continue;
+        }
+
+        for (std::size_t c = 0; c < attribute.components; ++c) {
+            const float* values = m_components[attribute.first_component + c].data() + first;
+            float* destination = out.data() + attribute.offset + c;
+            for (std::size_t i = 0; i < count; ++i) {
+                destination[i * m_stride] = values[i];
+            }
+        }
+    }
+}
+
+inline void instance_shadow::interleave(std::span<const std::uint32_t> indices, std::span<float> out) const noexcept
+{
+    if (m_stride == 0) {
+        return;
+    }
+
+    auto const count = std::min(out.size() / m_stride, indices.size());
+    for (auto const& attribute : m_attributes) {
+        if (!attribute.on_gpu) {
+            continue;
+        }
+
+        for (std::size_t c = 0; c < attribute.components; ++c) {
+            const float* values = m_components[attribute.first_component + c].data();
+            float* destination = out.data() + attribute.offset + c;
+            for (std::size_t i = 0; i < count; ++i) {
+                destination[i * m_stride] = values[indices[i]];
+            }
+        }
+    }
+}
+
+inline void instance_shadow::upload(vertex_buffer& buffer) const
+{
+    buffer.stream<float>([this](std::span<float> data) { interleave(0, data); });
+}
+
+inline void instance_shadow::upload(vertex_buffer_inst& buffer, std::span<const std::uint32_t> indices) const
+{
+    buffer.resize(indices.size());
+    buffer.stream<float>([this, indices](std::span<float> data) { interleave(indices, data); });
+}
+
+} // namespace staplegl
@@ -0,0 +1,308 @@
+/**
+ * @file lod.hpp
+ * @author Dario Loi
+ * @brief Level-of-detail selection for instanced meshes.
+ *
+ * @date 2026-10-17
+ *
+ * @copyright MIT License
+ *
+ * @details An instance a few pixels wide costs as many vertices as one filling the screen. A
+ * lod_mesh describes several versions of a mesh, stored one after the other in the same
+ * index_buffer, each with the smallest on-screen size it is meant for. Every frame, lod_buckets
+ * estimates the projected size of every instance from its position and bounding radius, and
+ * sorts the instances by level (a counting sort, linear in the number of instances). Uploaded
+ * in that order (see instance_shadow::upload), each level is then a contiguous range of
+ * instances, drawn with its own instanced draw, or all at once from indirect commands. <br>
+ *
+ * Drawing a range of instances that does not start at 0 takes `glDrawElementsInstancedBaseInstance`
+ * (OpenGL 4.2 or ARB_base_instance), while indirect_commands() targets
+ * `glMultiDrawElementsIndirect` (OpenGL 4.3).
+ *
+ * @code{.cpp}
+ * staplegl::lod_mesh mesh;
+ * mesh.add_level(0, 36864, 64.0F); // full detail above 64 pixels
+ * mesh.add_level(36864, 9216, 16.0F);
+ * mesh.add_level(46080, 2304, 0.0F);
+ *
+ * // every frame:
+ * staplegl::lod_view const view { eye, staplegl::lod_view::projection_scale(fov_y, viewport_height) };
+ * buckets.assign(mesh, view, { shadow.component(position, 0), shadow.component(position, 1), shadow.component(position, 2) }, 0.5F, visible);
+ * shadow.upload(instance_buffer, buckets.order());
+ * buckets.draw(mesh);
+ * @endcode
+ *
+ * @see instance_bvh.hpp
+ * @see https://www.khronos.org/opengl/wiki/Vertex_Rendering#Base_Index
+ */
+
+#pragma once
+
+#include "gl_functions.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <span>
+#include <vector>
+
+#ifdef STAPLEGL_DEBUG
+#include <cstdio>
+#endif // STAPLEGL_DEBUG
+
+namespace staplegl {
+
+/**
+ * @brief A version of a mesh, as a range of its index buffer.
+ *
+ */
+struct lod_level {
+    std::uint32_t first_index {};  ///< first index of the level, in indices.
+    std::int32_t index_count {};   ///< number of indices of the level.
+    float min_screen_size {};      ///< the level is used for instances at least this large, in pixels.
+};
+
+/**
+ * @brief The levels of detail of a mesh, from the most to the least detailed.
+ *
+ */
+class lod_mesh {
+public:
+    static constexpr std::size_t max_levels = 8;
+
+    /**
+     * @brief Add a level, less detailed than the previous ones.
+     *
+     * @param first_index the first index of the level in the index buffer.
+     * @param index_count the number of indices of the level.
+     * @param min_screen_size the smallest projected size the level is used for, in pixels,
+     * smaller than that of the previous level.
+     * @return std::optional<std::size_t> the index of the level, empty if the mesh already holds
+     * max_levels levels.
+     */
+    auto add_level(std::uint32_t first_index, std::int32_t index_count, float min_screen_size) noexcept -> std::optional<std::size_t>;
+
+    /**
+     * @brief Pick the level for a projected size.
+     *
+     * @param screen_size the projected size of the instance, in pixels.
+     * @return std::size_t the most detailed level whose minimum size is met, the last one otherwise.
+     */
+    [[nodiscard]] auto select(float screen_size) const noexcept -> std::size_t;
+
+    [[nodiscard]] auto levels() const noexcept -> std::span<const lod_level> { return { m_levels.data(), m_count }; }
+    [[nodiscard]] auto level_count() const noexcept -> std::size_t { return m_count; }
+
+private:
+    std::array<lod_level, max_levels> m_levels {};
+    std::size_t m_count {};
+};
+
+/**
+ * @brief Where the instances are seen from.
+ *
+ */
+struct lod_view {
+    std::array<float, 3> eye {}; ///< the camera position.
+    float scale {};              ///< pixels covered by an object of size 1 at distance 1.
+
+    /**
+     * @brief The scale of a perspective projection.
+     *
+     * @param fov_y the vertical field of view, in radians.
+     * @param viewport_height the height of the viewport, in pixels.
+     */
+    [[nodiscard]] static auto projection_scale(float fov_y, float viewport_height) noexcept -> float
+    {
+        return viewport_height / (2.0F * std::tan(fov_y * 0.5F));
+    }
+};
+
+/**
+ * @brief A range of instances drawn with the same level.
+ *
+ */
+struct lod_bucket {
+    std::uint32_t first_instance {};
+    std::uint32_t instance_count {};
+};
+
+/**
+ * @brief Indirect draw command, as read by glMultiDrawElementsIndirect.
+ *
+ */
+struct draw_elements_indirect_command {
+    std::uint32_t count {};
+    std::uint32_t instance_count {};
+    std::uint32_t first_index {};
+    std::int32_t base_vertex {};
+    std::uint32_t base_instance {};
+};
+
+/**
+ * @brief Per-frame assignment of instances to levels of detail.
+ *
+ */
+class lod_buckets {
+public:
+    /**
+     * @brief Assign instances to levels, in increasing level order.
+     *
+     * @param mesh the levels of the mesh.
+     * @param view the camera.
+     * @param positions the x, y and z of the center of every instance, one array each.
+     * @param radius the bounding radius of the instances.
+     * @param candidates the instances to consider (e.g. the visible ones), all of them if empty.
+     */
+    void assign(lod_mesh const& mesh, lod_view const& view, std::array<std::span<const float>, 3> const& positions,
+        float radius, std::span<const std::uint32_t> candidates = {});
+
+    /**
+     * @brief The instances, grouped by level: the order to upload them in.
+     *
+     */
+    [[nodiscard]] auto order() const noexcept -> std::span<const std::uint32_t> { return m_order; }
+
+    /**
+     * @brief The range of order() drawn with a level.
+     *
+     */
+    [[nodiscard]] auto bucket(std::size_t level) const noexcept -> lod_bucket { return m_buckets[level]; }
+
+    /**
+     * @brief Issue one instanced draw per non-empty level.
+     *
+     * @details The vertex array must be bound, with the instances uploaded in order().
+     *
+     * @param mesh the levels of the mesh, as given to assign().
+     * @param mode the primitive mode.
+     */
+    void draw(lod_mesh const& mesh, std::uint32_t mode = GL_TRIANGLES) const;
+
+    /**
+     * @brief Build one indirect command per non-empty level.
+     *
+     * @param mesh the levels of the mesh, as given to assign().
+     * @param commands cleared, then filled with the commands.
+     */
+    void indirect_commands(lod_mesh const& mesh, std::vector<draw_elements_indirect_command>& commands) const;
+
+private:
+    std::array<lod_bucket, lod_mesh::max_levels> m_buckets {};
+    std::vector<std::uint8_t> m_levels; ///< per candidate, scratch.
+    std::vector<std::uint32_t> m_order;
+};
+
+/*
+
+        IMPLEMENTATIONS
+
+*/
+
+inline auto lod_mesh::add_level(std::uint32_t first_index, std::int32_t index_count, float min_screen_size) noexcept -> std::optional<std::size_t>
+{
+    if (m_count == max_levels) [[unlikely]] {
+#ifdef STAPLEGL_DEBUG
+        std::fprintf(stderr, STAPLEGL_LINEINFO ", a lod_mesh holds at most %zu levels\n", max_levels);
+#endif // STAPLEGL_DEBUG
+        return std::nullopt;
+    }
+
+    m_levels[m_count] = { first_index, index_count, min_screen_size };
+    return m_count++;
+}
+
+inline auto lod_mesh::select(float screen_size) const noexcept -> std::size_t
+{
+    std::size_t level = 0;
+    while (level + 1 < m_count && screen_size < m_levels[level].min_screen_size) {
+        ++level;
+    }
+    return level;
+}
+
+inline void lod_buckets::assign(lod_mesh const& mesh, lod_view const& view, std::array<std::span<const float>, 3> const& positions,
+    float radius, std::span<const std::uint32_t> candidates)
+{
+    auto const all = candidates.empty();
+    auto const count = all ? std::min({ positions[0].size(), positions[1].size(), positions[2].size() }) : candidates.size();
+
+    // compare squared distances against per-level thresholds: size = 2 * radius * scale / distance,
+    // so size >= threshold  <=>  distance^2 <= (2 * radius * scale / threshold)^2.
+    auto const levels = mesh.levels();
+    std::array<float, lod_mesh::max_levels> max_distance2 {};
+    for (std::size_t level = 0; level < levels.size(); ++level) {
+        auto const threshold = levels[level].min_screen_size;
+        max_distance2[level] = std::numeric_limits<float>::infinity();
+        if (threshold > 0.0F) {
+            auto const distance = 2.0F * radius * view.scale / threshold;
+            max_distance2[level] = distance * distance;
+        }
+    }
+
+    std::array<std::uint32_t, lod_mesh::max_levels> counts {};
+    m_levels.resize(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        auto const instance = all ? i : candidates[i];
+        auto const dx = positions[0][instance] - view.eye[0];
+        auto const dy = positions[1][instance] - view.eye[1];
+        auto const dz = positions[2][instance] - view.eye[2];
+        auto const distance2 = dx * dx + dy * dy + dz * dz;
+
+        std::uint8_t level = 0;
+        while (level + 1U < levels.size() && distance2 > max_distance2[level]) {
+            ++level;
+        }
+        m_levels[i] = level;
+        ++counts[level];
+    }
+
+    std::array<std::uint32_t, lod_mesh::max_levels> offsets {};
+    std::uint32_t first {};
+    for (std::size_t level = 0; level < lod_mesh::max_levels; ++level) {
+        m_buckets[level] = { first, counts[level] };
+        offsets[level] = first;
+        first += counts[level];
+    }
+
+    // scatter, keeping the order of the candidates within each level.
+    m_order.resize(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        m_order[offsets[m_levels[i]]++] = all ? static_cast<std::uint32_t>(i) : candidates[i];
+    }
+}
+
+inline void lod_buckets::draw(lod_mesh const& mesh, std::uint32_t mode) const
+{
+    auto const levels = mesh.levels();
+    for (std::size_t level = 0; level < levels.size(); ++level) {
+        auto const& bucket = m_buckets[level];
+        if (bucket.instance_count == 0) {
+            continue;
+        }
+
+        auto const* offset = reinterpret_cast<const void*>(static_cast<std::uintptr_t>(levels[level].first_index) * sizeof(std::uint32_t)); // NOLINT (reinterpret-cast)
+        glDrawElementsInstancedBaseInstance(mode, levels[level].index_count, GL_UNSIGNED_INT, offset,
+            static_cast<std::int32_t>(bucket.instance_count), bucket.first_instance);
+    }
+}
+
+inline void lod_buckets::indirect_commands(lod_mesh const& mesh, std::vector<draw_elements_indirect_command>& commands) const
+{
+    commands.clear();
+
+    auto const levels = mesh.levels();
+    for (std::size_t level = 0; level < levels.size(); ++level) {
+        auto const& bucket = m_buckets[level];
+        if (bucket.instance_count != 0) {
+            commands.push_back({ static_cast<std::uint32_t>(levels[level].index_count), bucket.instance_count,
+                levels[level].first_index, 0, bucket.first_instance });
+        }
+    }
+}
+
+} // namespace staplegl
@@ -0,0 +1,371 @@
+/**
+ * @file name_pool.hpp
+ * @author Dario Loi
+ * @brief Batched generation and deletion of OpenGL object names.
+ *
+ * @date 2026-10-17
+ *
+ * @copyright MIT License
+ *
+ * @details Every wrapper generates its name with a `glGen*(1, ...)` call, which adds up to
+ * thousands of driver round-trips when loading a level. Once a set of name_pools is installed
+ * through set_name_pools, constructors take their names from a pool instead, which generates
+ * them in blocks (256 by default) with a single call. <br>
+ *
+ * Names released by destructors are not handed out again: an object keeps state a new owner
+ * would inherit (texture targets, vertex attributes, attachments), and a buffer may still be
+ * attached to a vertex array that outlives its wrapper. They are retired instead, and deleted
+ * together by flush() (deletion_queue::flush calls it), e.g. once per frame, or as soon as a
+ * block of them accumulates. The driver is then free to generate the same names again. <br>
+ *
+ * The pools are not synchronized and must only be used on the thread owning the context.
+ * Objects destroyed on other threads must go through a deletion_queue, which hands their
+ * names back to the pools when flushed.
+ *
+ * @code{.cpp}
+ * staplegl::name_pools pools;
+ * staplegl::set_name_pools(&pools);
+ *
+ * load_level(); // 10k buffers and textures, 80 glGen* calls
+ * pools.flush(); // deletes the textures destroyed meanwhile
+ *
+ * staplegl::set_name_pools(nullptr);
+ * @endcode
+ *
+ * @see deletion_queue.hpp
+ */
+
+#pragma once
+
+#include "gl_functions.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <span>
+#include <vector>
+
+namespace staplegl {
+
+/**
+ * @brief The kinds of OpenGL objects the wrappers own.
+ *
+ */
+enum class gl_object : std::uint8_t {
+    buffer,
+    texture,
+    framebuffer,
+    renderbuffer,
+    vertex_array,
+    query,
+    program,
+};
+
+/**
+ * @brief Pool of names of a single kind of OpenGL object, generated in blocks.
+ *
+ */
+class name_pool {
+public:
+    static constexpr std::size_t default_block_size = 256;
+
+    /**
+     * @brief Construct a new, empty name pool.
+     *
+     * @param kind the kind of the objects, anything but gl_object::program.
+     * @param block_size the number of names generated (and deleted) at once.
+     */
+    explicit name_pool(gl_object kind, std::size_t block_size = default_block_size) noexcept
+        : m_kind { kind }
+        , m_block_size { block_size }
+    {
+    }
+
+    ~name_pool() { trim(); }
+
+    name_pool(const name_pool&) = delete;
+    auto operator=(const name_pool&) -> name_pool& = delete;
+    name_pool(name_pool&&) noexcept = default;
+    auto operator=(name_pool&&) noexcept -> name_pool& = default;
+
+    /**
+     * @brief Take a name, generating a new block if the pool is empty.
+     *
+     * @return std::uint32_t the name.
+     */
+    [[nodiscard]] auto acquire() -> std::uint32_t;
+
+    /**
+     * @brief Give names back to the pool, to be deleted by the next flush().
+     *
+     * @details Flushes as soon as a block of names is retired.
+     *
+     * @param names the names, 0 is ignored.
+     */
+    void release(std::span<const std::uint32_t> names);
+    void release(std::uint32_t name) { release(std::span { &name, 1 }); }
+
+    /**
+     * @brief Delete the retired names.
+     *
+     */
+    void flush();
+
+    /**
+     * @brief Delete every name the pool holds, free and retired.
+     *
+     */
+    void trim();
+
+    [[nodiscard]] constexpr auto kind() const noexcept -> gl_object { return m_kind; }
+    [[nodiscard]] auto free_count() const noexcept -> std::size_t { return m_free.size(); }
+    [[nodiscard]] auto retired_count() const noexcept -> std::size_t { return m_retired.size(); }
+
+private:
+    gl_object m_kind;
+    std::size_t m_block_size;
+    std::vector<std::uint32_t> m_free;
+    std::vector<std::uint32_t> m_retired;
+};
+
+/**
+ * @brief One name_pool per kind of generated object.
+ *
+ */
+class name_pools {
+public:
+    static constexpr std::size_t pool_count = static_cast<std::size_t>(gl_object::query) + 1;
+
+    explicit name_pools(std::size_t block_size = name_pool::default_block_size) noexcept
+        : m_pools { name_pool { gl_object::buffer, block_size }, name_pool { gl_object::texture, block_size },
+            name_pool { gl_object::framebuffer, block_size }, name_pool { gl_object::renderbuffer, block_size },
+            name_pool { gl_object::vertex_array, block_size }, name_pool { gl_object::query, block_size } }
+    {
+    }
+
+    /**
+     * @brief Get the pool of a kind of object.
+     *
+     * @return name_pool* the pool, nullptr for programs (which are not generated by glGen*).
+     */
+    [[nodiscard]] auto pool(gl_object kind) noexcept -> name_pool*
+    {
+        auto const index = static_cast<std::size_t>(kind);
+        return index < pool_count ? &m_pools[index] : nullptr;
+    }
+
+    /**
+     * @brief Delete the retired names of every pool, e.g. at the end of a frame.
+     *
+     */
+    void flush()
+    {
+        for (auto& pool : m_pools) {
+            pool.flush();
+        }
+    }
+
+    void trim()
+    {
+        for (auto& pool : m_pools) {
+            pool.trim();
+        }
+    }
+
+private:
+    std::array<name_pool, pool_count> m_pools;
+};
+
+namespace detail {
+
+    inline auto installed_name_pools() noexcept -> name_pools*&
+    {
+        static name_pools* pools {};
+        return pools;
+    }
+
+} // namespace detail
+
+/**
+ * @brief Install the pools the wrappers take their names from.
+ *
+ * @param pools the pools, or nullptr to generate and delete names one at a time again (the default).
+ */
+inline void set_name_pools(name_pools* pools) noexcept
+{
+    detail::installed_name_pools() = pools;
+}
+
+/**
+ * @brief Generate a name, from the installed pools if any.
+ *
+ * @details This is what the constructors of the wrappers call.
+ *
+ * @param kind the kind of the object, anything but gl_object::program.
+ * @return std::uint32_t the name.
+ */
+[[nodiscard]] auto acquire_name(gl_object kind) -> std::uint32_t;
+
+/**
+ * @brief Generate several names at once, from the installed pools if any.
+ *
+ * @details The batched form of acquire_name, a single `glGen*` call without pools.
+ *
+ * @param kind the kind of the objects, anything but gl_object::program.
+ * @param names where the names are written.
+ */
+void acquire_names(gl_object kind, std::span<std::uint32_t> names);
+
+/*
+
+        IMPLEMENTATIONS
+
+*/
+
+namespace detail {
+
+    inline void generate_objects(gl_object kind, std::span<std::uint32_t> names)
+    {
+        auto const count = static_cast<std::int32_t>(names.size());
+
+        switch (kind) {
+        case gl_object::buffer:
+            glGenBuffers(count, names.data());
+            break;
+        case gl_object::texture:
+            glGenTextures(count, names.data());
+            break;
+        case gl_object::framebuffer:
+            glGenFramebuffers(count, names.data());
+            break;
+        case gl_object::renderbuffer:
+            glGenRenderbuffers(count, names.data());
+            break;
+        case gl_object::vertex_array:
+            glGenVertexArrays(count, names.data());
+            break;
+        case gl_object::query:
+            glGenQueries(count, names.data());
+            break;
+        case gl_object::program:
+            break;
+        }
+    }
+
+    inline void delete_objects(gl_object kind, std::span<const std::uint32_t> names)
+    {
+        auto const count = static_cast<std::int32_t>(names.size());
+
+        switch (kind) {
+        case gl_object::buffer:
+            glDeleteBuffers(count, names.data());
+            break;
+        case gl_object::texture:
+            glDeleteTextures(count, names.data());
+            break;
+        case gl_object::framebuffer:
+            glDeleteFramebuffers(count, names.data());
+            break;
+        case gl_object::renderbuffer:
+            glDeleteRenderbuffers(count, names.data());
+            break;
+        case gl_object::vertex_array:
+            glDeleteVertexArrays(count, names.data());
+            break;
+        case gl_object::query:
+            glDeleteQueries(count, names.data());
+            break;
+        case gl_object::program:
+            // programs can only be deleted one at a time.
+            for (auto const name : names) {
+                glDeleteProgram(name);
+            }
+            break;
+        }
+    }
+
+    /**
+     * @brief Hand names back to the installed pools, or delete them if there are none.
+     *
+     */
+    inline void return_objects(gl_object kind, std::span<const std::uint32_t> names)
+    {
+        auto* pools = installed_name_pools();
+        auto* pool = pools != nullptr ? pools->pool(kind) : nullptr;
+        if (pool == nullptr) {
+            delete_objects(kind, names);
+            return;
+        }
+
+        pool->release(names);
+    }
+
+} // namespace detail
+
+inline auto name_pool::acquire() -> std::uint32_t
+{
+    if (m_free.empty()) {
+        // names are handed out from the back, generate them in reverse to keep them increasing.
+        m_free.resize(m_block_size);
+        detail::generate_objects(m_kind, m_free);
+        std::reverse(m_free.begin(), m_free.end());
+    }
+
+    auto const name = m_free.back();
+    m_free.pop_back();
+    return name;
+}
+
+inline void name_pool::release(std::span<const std::uint32_t> names)
+{
+    std::ranges::copy_if(names, std::back_inserter(m_retired), [](std::uint32_t name) { return name != 0; });
+    if (m_retired.size() >= m_block_size) {
+        flush();
+    }
+}
+
+inline void name_pool::flush()
+{
+    if (!m_retired.empty()) {
+        detail::delete_objects(m_kind, m_retired);
+        m_retired.clear();
+    }
+}
+
+inline void name_pool::trim()
+{
+    if (!m_free.empty()) {
+        detail::delete_objects(m_kind, m_free);
+        m_free.clear();
+    }
+    flush();
+}
+
+inline auto acquire_name(gl_object kind) -> std::uint32_t
+{
+    if (auto* pools = detail::installed_name_pools(); pools != nullptr) {
+        if (auto* pool = pools->pool(kind); pool != nullptr) {
+            return pool->acquire();
+        }
+    }
+
+    std::uint32_t name {};
+    detail::generate_objects(kind, std::span { &name, 1 });
+    return name;
+}
+
+inline void acquire_names(gl_object kind, std::span<std::uint32_t> names)
+{
+    if (auto* pools = detail::installed_name_pools(); pools != nullptr) {
+        if (auto* pool = pools->pool(kind); pool != nullptr) {
+            std::ranges::generate(names, [pool] { return pool->acquire(); });
+            return;
+        }
+    }
+
+    detail::generate_objects(kind, names);
+}
+
+} // namespace staplegl
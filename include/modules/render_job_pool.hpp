@@ -0,0 +1,295 @@
+/**
+ * @file render_job_pool.hpp
+ * @author Dario Loi
+ * @brief Offline rendering of independent jobs on several headless contexts.
+ *
+ * @date 2026-10-17
+ *
+ * @copyright MIT License
+ *
+ * @details Server-side rendering of many independent scenes (e.g. thumbnails, or the same scene
+ * with varied parameters) is embarrassingly parallel, but an OpenGL context is only current on
+ * one thread at a time. render_job_pool starts one thread per worker, each with its own
+ * headless_context, and hands jobs out from a shared queue:
+ *
+ * - `setup` runs once per worker, on its context, and returns the worker's state: the programs,
+ *   vertex arrays and render targets reused by all the jobs of the worker;
+ * - `render` draws a job with the worker's state, and returns the region of the read
+ *   framebuffer holding the result;
+ * - `output` receives the pixels of every job, read back asynchronously (see
+ *   async_readback.hpp): a worker renders the next job while the previous ones are copied.
+ *   A job whose region is empty, or whose readback failed, is handed over with no pixels.
+ *
+ * Jobs are plain numbers, e.g. indices into an array of scene parameters. <br>
+ *
+ * On llvmpipe every context also rasterizes on `LP_NUM_THREADS` threads (one per core by
+ * default). With many workers, `LP_NUM_THREADS=1` or a few usually gives better throughput, as
+ * the workers already keep the cores busy.
+ *
+ * @code{.cpp}
+ * staplegl::render_job_pool<scene> pool {
+ *     [] { return scene { ... }; },
+ *     [&](scene& s, std::uint64_t job) { return s.draw(params[job]); },
+ *     [&](std::uint64_t job, staplegl::readback_region const& region, std::span<const std::byte> pixels) {
+ *         save(job, region, pixels); // on the worker's thread
+ *     }
+ * };
+ * pool.submit(0, params.size());
+ * pool.wait();
+ * @endcode
+ *
+ * @warning `setup`, `render` and `output` run on the workers, concurrently. Do not install
+ * name_pools or a deletion_queue while the pool runs, they are global and not meant to be
+ * shared between contexts.
+ *
+ * @see headless_context.hpp
+ */
+
+#pragma once
+
+#include "async_readback.hpp"
+#include "headless_context.hpp"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <latch>
+#include <mutex>
+#include <span>
+#include <stop_token>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace staplegl {
+
+/**
+ * @brief Options of a render job pool.
+ *
+ */
+struct render_job_options {
+    std::size_t workers { std::max(std::thread::hardware_concurrency(), 1U) }; ///< the number of contexts.
+    std::size_t readback_depth { 3 };    ///< readbacks in flight per worker.
+    readback_format format {};           ///< format of the pixels handed to `output`.
+    headless_context_options context {}; ///< options of the contexts, `share` is ignored.
+};
+
+/**
+ * @brief Pool of headless contexts rendering independent jobs.
+ *
+ * @tparam State the per-worker resources, created and destroyed on the worker's thread.
+ */
+template <typename State>
+class render_job_pool {
+public:
+    using setup_function = std::function<State()>;
+    using render_function = std::function<readback_region(State&, std::uint64_t)>;
+    using output_function = std::function<void(std::uint64_t, readback_region const&, std::span<const std::byte>)>;
+
+    /**
+     * @brief Start the workers, and wait until their contexts and states are ready.
+     *
+     * @param setup creates the state of a worker.
+     * @param render draws a job, returns the region to read back.
+     * @param output receives the pixels of a job, on the worker's thread.
+     * @param options the options of the pool.
+     */
+    render_job_pool(setup_function setup, render_function render, output_function output,
+        render_job_options const& options = {});
+
+    /**
+     * @brief Finish the submitted jobs, then stop the workers.
+     *
+     */
+    ~render_job_pool();
+
+    render_job_pool(const render_job_pool&) = delete;
+    auto operator=(const render_job_pool&) -> render_job_pool& = delete;
+    render_job_pool(render_job_pool&&) = delete;
+    auto operator=(render_job_pool&&) -> render_job_pool& = delete;
+
+    /**
+     * @brief Whether every worker got a context, jobs are ignored otherwise.
+     *
+     */
+    [[nodiscard]] auto is_valid() const noexcept -> bool { return m_valid; }
+
+    [[nodiscard]] auto workers() const noexcept -> std::size_t { return m_threads.size(); }
+
+    /**
+     * @brief Queue the jobs [first, first + count).
+     *
+     */
+    void submit(std::uint64_t first, std::uint64_t count = 1);
+
+    /**
+     * @brief Wait until every submitted job has been handed to `output`.
+     *
+     */
+    void wait();
+
+    /**
+     * @brief The number of jobs handed to `output` so far.
+     *
+     */
+    [[nodiscard]] auto completed() -> std::uint64_t;
+
+private:
+    void work(std::stop_token const& stop, std::latch& ready);
+
+    /**
+     * @brief Count jobs as done, once their readbacks have been handed to `output`.
+     *
+     */
+    void complete(std::size_t count);
+
+    setup_function m_setup;
+    render_function m_render;
+    output_function m_output;
+    render_job_options m_options;
+
+    std::mutex m_mutex;
+    std::condition_variable_any m_work;
+    std::condition_variable m_done;
+    std::deque<std::uint64_t> m_jobs;
+    std::uint64_t m_submitted {};
+    std::uint64_t m_completed {};
+    bool m_valid { true };
+
+    std::vector<std::jthread> m_threads; // last, so that the workers stop before the rest is destroyed
+};
+
+/*
+
+        IMPLEMENTATIONS
+
+*/
+
+template <typename State>
+inline render_job_pool<State>::render_job_pool(setup_function setup, render_function render, output_function output,
+    render_job_options const& options)
+    : m_setup { std::move(setup) }
+    , m_render { std::move(render) }
+    , m_output { std::move(output) }
+    , m_options { options }
+{
+    m_options.context.share = nullptr;
+
+    auto const workers = std::max<std::size_t>(m_options.workers, 1);
+    std::latch ready { static_cast<std::ptrdiff_t>(workers) };
+
+    m_threads.reserve(workers);
+    for (std::size_t i = 0; i < workers; ++i) {
+        m_threads.emplace_back([this, &ready](std::stop_token const& stop) { work(stop, ready); });
+    }
+
+    ready.wait();
+}
+
+template <typename State>
+inline render_job_pool<State>::~render_job_pool()
+{
+    wait();
+
+    for (auto& thread : m_threads) {
+        thread.request_stop();
+    }
+    m_work.notify_all();
+}
+
+template <typename State>
+inline void render_job_pool<State>::submit(std::uint64_t first, std::uint64_t count)
+{
+    {
+        std::scoped_lock const lock { m_mutex };
+        if (!m_valid) [[unlikely]] {
+            return;
+        }
+
+        for (std::uint64_t job = first; job < first + count; ++job) {
+            m_jobs.push_back(job);
+        }
+        m_submitted += count;
+    }
+    m_work.notify_all();
+}
+
+template <typename State>
+inline void render_job_pool<State>::wait()
+{
+    std::unique_lock lock { m_mutex };
+    m_done.wait(lock, [this] { return m_completed == m_submitted; });
+}
+
+template <typename State>
+inline auto render_job_pool<State>::completed() -> std::uint64_t
+{
+    std::scoped_lock const lock { m_mutex };
+    return m_completed;
+}
+
+template <typename State>
+inline void render_job_pool<State>::complete(std::size_t count)
+{
+    if (count == 0) {
+        return;
+    }
+
+    std::scoped_lock const lock { m_mutex };
+    m_completed += count;
+    if (m_completed == m_submitted) {
+        m_done.notify_all();
+    }
+}
+
+template <typename State>
+inline void render_job_pool<State>::work(std::stop_token const& stop, std::latch& ready)
+{
+    // declared first, destroyed last: the state and the readbacks are released on their context.
+    headless_context const context { m_options.context };
+    if (!context.is_valid()) [[unlikely]] {
+        {
+            std::scoped_lock const lock { m_mutex };
+            m_valid = false;
+        }
+        ready.count_down();
+        return;
+    }
+
+    State state = m_setup();
+    async_readback readback { m_options.readback_depth };
+    ready.count_down();
+
+    while (true) {
+        std::uint64_t job {};
+        {
+            std::unique_lock lock { m_mutex };
+
+            // out of work: hand out what is still in flight rather than sitting on it.
+            if (m_jobs.empty() && readback.pending() != 0) {
+                lock.unlock();
+                complete(readback.drain(m_output));
+                continue;
+            }
+
+            if (!m_work.wait(lock, stop, [this] { return !m_jobs.empty(); })) {
+                break;
+            }
+
+            job = m_jobs.front();
+            m_jobs.pop_front();
+        }
+
+        // every read reaches the output exactly once, even when there is nothing to read back.
+        auto const region = m_render(state, job);
+        complete(readback.read(region, job, m_output, m_options.format));
+        complete(readback.poll(m_output));
+    }
+
+    complete(readback.drain(m_output));
+}
+
+} // namespace staplegl
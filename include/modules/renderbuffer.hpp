@@ -16,7 +16,9 @@
 
 #pragma once
 
+#include "deletion_queue.hpp"
 #include "gl_functions.hpp"
+#include "name_pool.hpp"
 #include "utility.hpp"
 
 #include <cstdint>
@@ -150,7 +152,7 @@ inline renderbuffer::renderbuffer(resolution res, attachment_type type, tex_samp
         break;
     }
 
-    glGenRenderbuffers(1, &m_id);
+    m_id = acquire_name(gl_object::renderbuffer);
     glBindRenderbuffer(GL_RENDERBUFFER, m_id);
     if(m_samples != tex_samples::MSAA_X1) {
         glRenderbufferStorageMultisample(GL_RENDERBUFFER, static_cast<int32_t>(m_samples), internal_format, res.width, res.height);
@@ -164,7 +166,7 @@ inline renderbuffer::renderbuffer(resolution res, attachment_type type, tex_samp
 inline renderbuffer::~renderbuffer()
 {
     if (m_id != 0)
-        glDeleteRenderbuffers(1, &m_id);
+        release_object(gl_object::renderbuffer, m_id);
 }
 
 inline renderbuffer::renderbuffer(renderbuffer&& other) noexcept
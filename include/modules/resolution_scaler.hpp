@@ -0,0 +1,253 @@
+/**
+ * @file resolution_scaler.hpp
+ * @author Dario Loi
+ * @brief Dynamic resolution scaling, driven by GPU frame times.
+ *
+ * @date 2026-10-17
+ *
+ * @copyright MIT License
+ *
+ * @details Most of the GPU time of a frame is proportional to the number of pixels shaded. When
+ * frames take longer than the budget, resolution_scaler lowers the internal render resolution;
+ * when they are well within it, it raises it again, within bounds. The final pass upscales the
+ * result to the window. <br>
+ *
+ * The render targets are allocated once, at the maximum resolution, and only the region at the
+ * bottom-left corner given by region() is rendered to: changing the resolution takes a new
+ * viewport, not new textures. Passes sampling a target scale their texture coordinates by
+ * uv_scale(), and clamp them half a texel inside the region, so that linear filtering never
+ * reads the stale texels around it. Both take a level, for chains of half-size targets such as
+ * a bloom pyramid. <br>
+ *
+ * Frame times come from a gpu_profiler, a few frames late. The scaler skips the frames rendered
+ * before its last change, and waits for a few samples at the new resolution before deciding
+ * again, so that it does not overshoot while the results catch up.
+ *
+ * @code{.cpp}
+ * staplegl::resolution_scaler scaler { { 1600, 900 }, { .target_ms = 8.0 } };
+ *
+ * while (running) {
+ *     profiler.begin_frame();
+ *     staplegl::framebuffer::set_viewport(scaler.region());
+ *     // ... draw at the internal resolution, then upscale with scaler.uv_scale() ...
+ *     profiler.end_frame();
+ *
+ *     scaler.update(profiler);
+ * }
+ * @endcode
+ *
+ * @see gpu_profiler.hpp
+ */
+
+#pragma once
+
+#include "gpu_profiler.hpp"
+#include "utility.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <optional>
+
+namespace staplegl {
+
+/**
+ * @brief Bounds and tuning of a resolution scaler.
+ *
+ */
+struct resolution_scale_options {
+    double target_ms { 1000.0 / 60.0 }; ///< the GPU time budget of a frame.
+    float min_scale { 0.5F };           ///< the smallest scale, per axis.
+    float max_scale { 1.0F };           ///< the largest scale, per axis, at most 1.
+    float deadband { 0.15F };           ///< the scale is raised once frames take less than (1 - deadband) * target.
+    float max_step { 0.1F };            ///< the largest raise of the scale at once, it is lowered as far as needed.
+    float smoothing { 0.3F };           ///< weight of every new sample in the running average.
+    std::uint32_t settle_frames { 3 };  ///< samples at a new resolution before deciding again.
+    std::int32_t granularity { 8 };     ///< the region is a multiple of this many pixels.
+};
+
+/**
+ * @brief Picks the internal render resolution that keeps the GPU frame time within a budget.
+ *
+ */
+class resolution_scaler {
+public:
+    /**
+     * @brief Construct a new resolution scaler, starting at the maximum scale.
+     *
+     * @param max_size the size the render targets are allocated with.
+     * @param options the bounds and tuning of the scaler.
+     */
+    explicit resolution_scaler(resolution max_size, resolution_scale_options const& options = {}) noexcept;
+
+    /**
+     * @brief Feed the latest results of a profiler, after gpu_profiler::end_frame.
+     *
+     * @return true if the region changed, the next frame renders at the new resolution.
+     */
+    auto update(gpu_profiler const& profiler) noexcept -> bool;
+
+    /**
+     * @brief Feed a GPU frame time.
+     *
+     * @param sample the time of a frame that has completed.
+     * @param next_frame the index of the next frame to be rendered.
+     * @return true if the region changed, the next frame renders at the new resolution.
+     */
+    auto update(gpu_frame_time const& sample, std::uint64_t next_frame) noexcept -> bool;
+
+    /**
+     * @brief Set the scale by hand, e.g. from a quality setting.
+     *
+     * @param scale the scale per axis, clamped to the bounds.
+     * @param next_frame the index of the next frame to be rendered, samples of earlier frames are ignored.
+     * @return true if the region changed.
+     */
+    auto set_scale(float scale, std::uint64_t next_frame = 0) noexcept -> bool;
+
+    /**
+     * @brief The part of a render target to render to, at a level of a chain of half-size targets.
+     *
+     * @param level 0 for full-size targets, 1 for half-size ones, and so on.
+     */
+    [[nodiscard]] auto region(std::uint32_t level = 0) const noexcept -> resolution;
+
+    /**
+     * @brief The size of region() in texture coordinates, for sampling targets of that level.
+     *
+     */
+    [[nodiscard]] auto uv_scale(std::uint32_t level = 0) const noexcept -> std::array<float, 2>;
+
+    [[nodiscard]] auto scale() const noexcept -> float { return m_scale; }
+    [[nodiscard]] auto max_size() const noexcept -> resolution { return m_max_size; }
+    [[nodiscard]] auto options() const noexcept -> resolution_scale_options const& { return m_options; }
+
+    /**
+     * @brief The smoothed GPU frame time at the current resolution, 0 until samples arrive.
+     *
+     */
+    [[nodiscard]] auto frame_ms() const noexcept -> double { return m_smoothed_ms; }
+
+private:
+    [[nodiscard]] static auto level_size(resolution size, std::uint32_t level) noexcept -> resolution;
+    [[nodiscard]] auto snap(float scale) const noexcept -> resolution;
+
+    resolution m_max_size;
+    resolution_scale_options m_options;
+    resolution m_region;
+    float m_scale {};
+
+    double m_smoothed_ms {};
+    std::uint64_t m_changed_at {};  // the first frame rendered at the current resolution.
+    std::uint64_t m_next_sample {}; // the first frame a new sample can come from.
+    std::uint32_t m_samples {};     // samples at the current resolution.
+};
+
+/*
+
+        IMPLEMENTATIONS
+
+*/
+
+inline resolution_scaler::resolution_scaler(resolution max_size, resolution_scale_options const& options) noexcept
+    : m_max_size { std::max(max_size.width, 1), std::max(max_size.height, 1) }
+    , m_options { options }
+{
+    m_options.max_scale = std::clamp(m_options.max_scale, 0.0F, 1.0F);
+    m_options.min_scale = std::clamp(m_options.min_scale, 0.0F, m_options.max_scale);
+    m_options.granularity = std::max(m_options.granularity, 1);
+
+    m_scale = m_options.max_scale;
+    m_region = snap(m_scale);
+}
+
+inline auto resolution_scaler::update(gpu_profiler const& profiler) noexcept -> bool
+{
+    auto const sample = profiler.latest_frame();
+    return sample.has_value() && update(*sample, profiler.current_frame());
+}
+
+inline auto resolution_scaler::update(gpu_frame_time const& sample, std::uint64_t next_frame) noexcept -> bool
+{
+    // the same results are reported until the next frame is collected, and frames rendered
+    // before the last change say nothing about the current resolution.
+    if (sample.frame < m_next_sample || sample.frame < m_changed_at) {
+        return false;
+    }
+    m_next_sample = sample.frame + 1;
+
+    // a plain mean of the first samples at this resolution, then a running average: the first
+    // sample alone would otherwise weigh on every decision until it fades out.
+    ++m_samples;
+    auto const weight = std::max(static_cast<double>(m_options.smoothing), 1.0 / static_cast<double>(m_samples));
+    m_smoothed_ms += (sample.ms - m_smoothed_ms) * weight;
+
+    if (m_samples < std::max(m_options.settle_frames, 1U)) {
+        return false;
+    }
+
+    auto const low_ms = m_options.target_ms * (1.0 - static_cast<double>(m_options.deadband));
+    if (m_smoothed_ms <= m_options.target_ms && m_smoothed_ms >= low_ms) {
+        return false;
+    }
+
+    // the cost goes with the number of pixels, the square of the scale: aim for the middle of
+    // the band rather than its edge, so that noise does not immediately push it back out.
+    auto const goal_ms = (m_options.target_ms + low_ms) * 0.5;
+    // frames over budget are dropped frames, the scale goes down at once; it goes back up in
+    // steps, as raising it too far would drop frames again.
+    auto const wanted = m_scale * static_cast<float>(std::sqrt(goal_ms / std::max(m_smoothed_ms, 1e-3)));
+    return set_scale(std::min(wanted, m_scale + m_options.max_step), next_frame);
+}
+
+inline auto resolution_scaler::set_scale(float scale, std::uint64_t next_frame) noexcept -> bool
+{
+    // the scale moves even when the region does not, so that small steps add up.
+    m_scale = std::clamp(scale, m_options.min_scale, m_options.max_scale);
+    auto const region = snap(m_scale);
+    if (region.width == m_region.width && region.height == m_region.height) {
+        return false;
+    }
+
+    m_region = region;
+    m_smoothed_ms = 0.0;
+    m_changed_at = next_frame;
+    m_samples = 0;
+    return true;
+}
+
+inline auto resolution_scaler::region(std::uint32_t level) const noexcept -> resolution
+{
+    return level_size(m_region, level);
+}
+
+inline auto resolution_scaler::uv_scale(std::uint32_t level) const noexcept -> std::array<float, 2>
+{
+    auto const target = level_size(m_max_size, level);
+    auto const used = region(level);
+    return { static_cast<float>(used.width) / static_cast<float>(target.width),
+        static_cast<float>(used.height) / static_cast<float>(target.height) };
+}
+
+inline auto resolution_scaler::level_size(resolution size, std::uint32_t level) noexcept -> resolution
+{
+    // the same rounding as the sizes of a pyramid built with `size >> level`.
+    return { std::max(size.width >> level, 1), std::max(size.height >> level, 1) };
+}
+
+inline auto resolution_scaler::snap(float scale) const noexcept -> resolution
+{
+    auto const snap_axis = [this, scale](std::int32_t max) {
+        if (scale >= 1.0F) {
+            return max;
+        }
+        auto const grain = m_options.granularity;
+        auto const snapped = static_cast<std::int32_t>(std::lround(static_cast<float>(max) * scale / static_cast<float>(grain))) * grain;
+        return std::clamp(snapped, std::min(grain, max), max);
+    };
+
+    return { snap_axis(m_max_size.width), snap_axis(m_max_size.height) };
+}
+
+} // namespace staplegl
@@ -16,6 +16,7 @@
 
 #pragma once
 
+#include "deletion_queue.hpp"
 #include "gl_functions.hpp"
 #include "utility.hpp"
 #include <cstdint>
@@ -257,28 +258,10 @@ public:
      */
     [[nodiscard]] static auto is_valid(std::uint32_t id) -> bool;
 
-private:
-    /**
-     * @brief Create a program object.
-     *
-     * @return std::uint32_t, the program object id.
-     */
-    [[nodiscard]] auto create_program() const -> std::uint32_t;
-
     /**
-     * @brief Create a shader object.
-     *
-     * @param shader_type The shader type.
-     * @see staplegl::shader_type
-     * @param source The shader source.
-     * @return std::uint32_t, the shader object id.
-     */
-    [[nodiscard]] auto compile(shader_type shader_type, std::string_view source) const -> std::uint32_t;
-
-    /**
-     * @brief Link the shader program.
-     * @details This method acts on the provided source of shaders, it will pre-process the source,
-     * splitting the monolithic source into individual shader sources by scanning for the #type tag.
+     * @brief Split a monolithic shader program source into its individual shaders.
+     * @details This method pre-processes the source, splitting it into individual shader
+     * sources by scanning for the #type tag.
      *
      * @param source The shader program source.
      * @see staplegl::shader_type
@@ -288,17 +271,37 @@ private:
      *
      * @return std::vector<shader>. A vector of shaders.
      */
-    [[nodiscard]] auto parse_shaders(std::string_view source) const -> std::vector<shader>;
+    [[nodiscard]] static auto parse_shaders(std::string_view source) -> std::vector<shader>;
 
-private:
     /**
      * @brief Obtain the location of a uniform in the shader program.
      *
+     * @details Locations are cached after the first lookup, so that repeated uploads to the
+     * same uniform do not query the driver.
+     *
      * @param name Uniform name.
      * @return int, the uniform location.
      */
     [[nodiscard]] auto uniform_location(std::string_view name) -> int;
 
+private:
+    /**
+     * @brief Create a program object.
+     *
+     * @return std::uint32_t, the program object id.
+     */
+    [[nodiscard]] auto create_program() const -> std::uint32_t;
+
+    /**
+     * @brief Create a shader object.
+     *
+     * @param shader_type The shader type.
+     * @see staplegl::shader_type
+     * @param source The shader source.
+     * @return std::uint32_t, the shader object id.
+     */
+    [[nodiscard]] auto compile(shader_type shader_type, std::string_view source) const -> std::uint32_t;
+
 private:
     /**
      * @brief Convert a shader type to its OpenGL equivalent.
@@ -355,7 +358,7 @@ inline shader_program::shader_program(std::string_view path) noexcept
 
 inline shader_program::~shader_program()
 {
-    glDeleteProgram(m_id);
+    release_object(gl_object::program, m_id);
 }
 
 inline void shader_program::bind() const
@@ -514,7 +517,7 @@ inline auto shader_program::compile(shader_type shader_type, std::string_view so
     return id;
 }
 
-inline auto shader_program::parse_shaders(std::string_view source) const -> std::vector<shader>
+inline auto shader_program::parse_shaders(std::string_view source) -> std::vector<shader>
 {
     std::vector<shader> shaders;
     std::string_view const type_token { "#type" };
@@ -49,7 +49,17 @@ enum class shader_array_type : std::uint8_t {
  *
  * @details Enumerator that represents a data type. This is used to define the type of the data that is passed
  * as a uniform to the shader, as well as a runtime type to feed as a parameter to other functions
- * in this module.
+ * in this module. <br>
+ *
+ * Besides the float types, vertex attributes can be stored in more compact formats:
+ *
+ * - `half2`, `half4`: 16-bit floats;
+ * - `*_norm`: 8 or 16-bit integers read by the shader as floats in [0, 1] (unsigned) or [-1, 1] (signed);
+ * - `byte4`, `short2`, ..., `ivec4`, `uvec4`: integers read by the shader as integers (`ivec`/`uvec` inputs);
+ * - `int_2_10_10_10_rev`, `uint_2_10_10_10_rev`: four normalized components packed in 32 bits,
+ * three of 10 bits and one of 2, e.g. for normals and tangents.
+ *
+ * 8 and 16-bit types come in 2 or 4 components so that every attribute stays 4-byte aligned.
  *
  * @see staplegl::shader_data_type::size
  * @see staplegl::shader_data_type::to_opengl_type
@@ -63,6 +73,30 @@ enum class u_type : std::uint8_t {
     vec4,
     mat3,
     mat4,
+    half2,
+    half4,
+    byte4,
+    byte4_norm,
+    ubyte4,
+    ubyte4_norm,
+    short2,
+    short2_norm,
+    short4,
+    short4_norm,
+    ushort2,
+    ushort2_norm,
+    ushort4,
+    ushort4_norm,
+    int32,
+    ivec2,
+    ivec3,
+    ivec4,
+    uint32,
+    uvec2,
+    uvec3,
+    uvec4,
+    int_2_10_10_10_rev,
+    uint_2_10_10_10_rev,
 };
 
 /**
@@ -87,6 +121,34 @@ constexpr static auto size(u_type type) -> std::size_t
         return size(u_type::vec4) * 3;
     case u_type::mat4:
         return size(u_type::vec4) * 4;
+    case u_type::half2:
+    case u_type::byte4:
+    case u_type::byte4_norm:
+    case u_type::ubyte4:
+    case u_type::ubyte4_norm:
+    case u_type::short2:
+    case u_type::short2_norm:
+    case u_type::ushort2:
+    case u_type::ushort2_norm:
+    case u_type::int32:
+    case u_type::uint32:
+    case u_type::int_2_10_10_10_rev:
+    case u_type::uint_2_10_10_10_rev:
+        return sizeof(std::uint32_t);
+    case u_type::half4:
+    case u_type::short4:
+    case u_type::short4_norm:
+    case u_type::ushort4:
+    case u_type::ushort4_norm:
+    case u_type::ivec2:
+    case u_type::uvec2:
+        return sizeof(std::uint32_t) * 2;
+    case u_type::ivec3:
+    case u_type::uvec3:
+        return sizeof(std::uint32_t) * 3;
+    case u_type::ivec4:
+    case u_type::uvec4:
+        return sizeof(std::uint32_t) * 4;
     default:
 #ifdef STAPLEGL_DEBUG
         std::fprintf(stderr, STAPLEGL_LINEINFO ", invalid shader enum %d\n",
@@ -118,6 +180,41 @@ constexpr static auto to_opengl_type(u_type type) -> std::uint32_t
         return GL_FLOAT_MAT4;
     case u_type::float32:
         return GL_FLOAT;
+    case u_type::int32:
+        return GL_INT;
+    case u_type::ivec2:
+        return GL_INT_VEC2;
+    case u_type::ivec3:
+        return GL_INT_VEC3;
+    case u_type::ivec4:
+    case u_type::byte4:
+    case u_type::short4:
+        return GL_INT_VEC4;
+    case u_type::short2:
+        return GL_INT_VEC2;
+    case u_type::uint32:
+        return GL_UNSIGNED_INT;
+    case u_type::uvec2:
+    case u_type::ushort2:
+        return GL_UNSIGNED_INT_VEC2;
+    case u_type::uvec3:
+        return GL_UNSIGNED_INT_VEC3;
+    case u_type::uvec4:
+    case u_type::ubyte4:
+    case u_type::ushort4:
+        return GL_UNSIGNED_INT_VEC4;
+    case u_type::half2:
+    case u_type::short2_norm:
+    case u_type::ushort2_norm:
+        return GL_FLOAT_VEC2;
+    case u_type::half4:
+    case u_type::byte4_norm:
+    case u_type::ubyte4_norm:
+    case u_type::short4_norm:
+    case u_type::ushort4_norm:
+    case u_type::int_2_10_10_10_rev:
+    case u_type::uint_2_10_10_10_rev:
+        return GL_FLOAT_VEC4;
     default:
 
 #ifdef STAPLEGL_DEBUG
@@ -133,7 +230,7 @@ constexpr static auto to_opengl_type(u_type type) -> std::uint32_t
  *
  * @details This function retrieves the OpenGL type of the underlying type of the shader data type.
  * For scalar types, this is the same as to_opengl_type, but for vector types, this is the type of the
- * vector's components.
+ * vector's components, as stored in the buffer (e.g. GL_UNSIGNED_BYTE for ubyte4_norm).
  *
  * @param type
  * @return constexpr std::uint32_t
@@ -148,6 +245,39 @@ constexpr static auto to_opengl_underlying_type(u_type type) -> std::uint32_t
     case u_type::mat4:
     case u_type::float32:
         return GL_FLOAT;
+    case u_type::half2:
+    case u_type::half4:
+        return GL_HALF_FLOAT;
+    case u_type::byte4:
+    case u_type::byte4_norm:
+        return GL_BYTE;
+    case u_type::ubyte4:
+    case u_type::ubyte4_norm:
+        return GL_UNSIGNED_BYTE;
+    case u_type::short2:
+    case u_type::short2_norm:
+    case u_type::short4:
+    case u_type::short4_norm:
+        return GL_SHORT;
+    case u_type::ushort2:
+    case u_type::ushort2_norm:
+    case u_type::ushort4:
+    case u_type::ushort4_norm:
+        return GL_UNSIGNED_SHORT;
+    case u_type::int32:
+    case u_type::ivec2:
+    case u_type::ivec3:
+    case u_type::ivec4:
+        return GL_INT;
+    case u_type::uint32:
+    case u_type::uvec2:
+    case u_type::uvec3:
+    case u_type::uvec4:
+        return GL_UNSIGNED_INT;
+    case u_type::int_2_10_10_10_rev:
+        return GL_INT_2_10_10_10_REV;
+    case u_type::uint_2_10_10_10_rev:
+        return GL_UNSIGNED_INT_2_10_10_10_REV;
     default:
 #ifdef STAPLEGL_DEBUG
         std::fprintf(stderr, STAPLEGL_LINEINFO ", invalid shader enum %d\n",
@@ -179,7 +309,34 @@ constexpr static auto component_count(u_type type) -> std::uint16_t
     case u_type::mat4:
         return 16;
     case u_type::float32:
+    case u_type::int32:
+    case u_type::uint32:
         return 1;
+    case u_type::half2:
+    case u_type::short2:
+    case u_type::short2_norm:
+    case u_type::ushort2:
+    case u_type::ushort2_norm:
+    case u_type::ivec2:
+    case u_type::uvec2:
+        return 2;
+    case u_type::ivec3:
+    case u_type::uvec3:
+        return 3;
+    case u_type::half4:
+    case u_type::byte4:
+    case u_type::byte4_norm:
+    case u_type::ubyte4:
+    case u_type::ubyte4_norm:
+    case u_type::short4:
+    case u_type::short4_norm:
+    case u_type::ushort4:
+    case u_type::ushort4_norm:
+    case u_type::ivec4:
+    case u_type::uvec4:
+    case u_type::int_2_10_10_10_rev:
+    case u_type::uint_2_10_10_10_rev:
+        return 4;
     default:
 #ifdef STAPLEGL_DEBUG
         std::fprintf(stderr, STAPLEGL_LINEINFO ", invalid shader enum %d\n",
@@ -188,4 +345,56 @@ constexpr static auto component_count(u_type type) -> std::uint16_t
         std::terminate();
     }
 }
+
+/**
+ * @brief Whether the data type is fixed-point data that the shader reads as normalized floats.
+ *
+ * @param type the type of the shader data.
+ * @return true for the `*_norm` and the packed 2-10-10-10 types.
+ */
+constexpr static auto is_normalized(u_type type) noexcept -> bool
+{
+    switch (type) {
+    case u_type::byte4_norm:
+    case u_type::ubyte4_norm:
+    case u_type::short2_norm:
+    case u_type::short4_norm:
+    case u_type::ushort2_norm:
+    case u_type::ushort4_norm:
+    case u_type::int_2_10_10_10_rev:
+    case u_type::uint_2_10_10_10_rev:
+        return true;
+    default:
+        return false;
+    }
+}
+
+/**
+ * @brief Whether the data type is read by the shader as integers, through glVertexAttribIPointer.
+ *
+ * @param type the type of the shader data.
+ * @return true for the non-normalized integer types.
+ */
+constexpr static auto is_integer(u_type type) noexcept -> bool
+{
+    switch (type) {
+    case u_type::byte4:
+    case u_type::ubyte4:
+    case u_type::short2:
+    case u_type::short4:
+    case u_type::ushort2:
+    case u_type::ushort4:
+    case u_type::int32:
+    case u_type::ivec2:
+    case u_type::ivec3:
+    case u_type::ivec4:
+    case u_type::uint32:
+    case u_type::uvec2:
+    case u_type::uvec3:
+    case u_type::uvec4:
+        return true;
+    default:
+        return false;
+    }
+}
 };
\ No newline at end of file
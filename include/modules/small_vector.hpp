@@ -0,0 +1,199 @@
+/**
+ * @file small_vector.hpp
+ * @author Dario Loi
+ * @brief Vector with inline storage for its first elements.
+ *
+ * @date 2026-10-17
+ *
+ * @copyright MIT License
+ *
+ * @details A minimal vector whose first elements live inside the object itself, for the small
+ * collections owned by OpenGL wrappers (e.g. the vertex buffers of a vertex array): in the common
+ * case no heap allocation, and the elements sit next to their owner in memory. Past the inline
+ * capacity, the elements move to the heap and the vector grows like a std::vector. <br>
+ *
+ * Growing and moving the vector move its elements: refer to them by index rather than by pointer.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <span>
+#include <utility>
+
+namespace staplegl {
+
+/**
+ * @brief Vector with inline storage for up to N elements, and heap storage past that.
+ *
+ * @tparam T the type of the elements, must be nothrow move constructible.
+ * @tparam N the inline capacity.
+ */
+template <typename T, std::size_t N>
+class small_vector {
+public:
+    small_vector() noexcept = default;
+    ~small_vector();
+
+    small_vector(const small_vector&) = delete;
+    auto operator=(const small_vector&) -> small_vector& = delete;
+
+    small_vector(small_vector&& other) noexcept;
+    auto operator=(small_vector&& other) noexcept -> small_vector&;
+
+    /**
+     * @brief Construct an element at the end of the vector.
+     *
+     * @param args the arguments of T's constructor.
+     * @return T& the new element.
+     */
+    template <typename... Args>
+    auto emplace_back(Args&&... args) -> T&;
+
+    /**
+     * @brief Move an element at the end of the vector.
+     *
+     * @param value the element.
+     * @return T& the new element.
+     */
+    auto push_back(T&& value) -> T& { return emplace_back(std::move(value)); }
+
+    /**
+     * @brief Destroy all the elements, the capacity is kept.
+     *
+     */
+    void clear() noexcept;
+
+    [[nodiscard]] constexpr auto size() const noexcept -> std::size_t { return m_size; }
+    [[nodiscard]] constexpr auto empty() const noexcept -> bool { return m_size == 0; }
+    [[nodiscard]] constexpr auto capacity() const noexcept -> std::size_t { return m_capacity; }
+    [[nodiscard]] static constexpr auto inline_capacity() noexcept -> std::size_t { return N; }
+
+    /**
+     * @brief Whether the elements are stored inside the object.
+     *
+     */
+    [[nodiscard]] constexpr auto is_inline() const noexcept -> bool { return m_heap == nullptr; }
+
+    [[nodiscard]] auto data() noexcept -> T* { return is_inline() ? std::launder(reinterpret_cast<T*>(m_storage)) : m_heap; } // NOLINT (reinterpret-cast)
+    [[nodiscard]] auto data() const noexcept -> const T* { return is_inline() ? std::launder(reinterpret_cast<const T*>(m_storage)) : m_heap; } // NOLINT (reinterpret-cast)
+
+    [[nodiscard]] auto operator[](std::size_t index) noexcept -> T& { return data()[index]; }
+    [[nodiscard]] auto operator[](std::size_t index) const noexcept -> const T& { return data()[index]; }
+
+    [[nodiscard]] auto back() noexcept -> T& { return data()[m_size - 1]; }
+    [[nodiscard]] auto back() const noexcept -> const T& { return data()[m_size - 1]; }
+
+    [[nodiscard]] auto begin() noexcept -> T* { return data(); }
+    [[nodiscard]] auto end() noexcept -> T* { return data() + m_size; }
+    [[nodiscard]] auto begin() const noexcept -> const T* { return data(); }
+    [[nodiscard]] auto end() const noexcept -> const T* { return data() + m_size; }
+
+    /**
+     * @brief View the elements as a span.
+     *
+     */
+    [[nodiscard]] auto span() noexcept -> std::span<T> { return { data(), m_size }; }
+    [[nodiscard]] auto span() const noexcept -> std::span<const T> { return { data(), m_size }; }
+
+private:
+    void take(small_vector& other) noexcept;
+    void release_heap() noexcept;
+
+    alignas(T) std::byte m_storage[sizeof(T) * N] {}; // NOLINT (c-arrays)
+    T* m_heap {};
+    std::size_t m_size {};
+    std::size_t m_capacity { N };
+};
+
+/*
+
+        IMPLEMENTATIONS
+
+*/
+
+template <typename T, std::size_t N>
+inline small_vector<T, N>::~small_vector()
+{
+    clear();
+    release_heap();
+}
+
+template <typename T, std::size_t N>
+inline small_vector<T, N>::small_vector(small_vector&& other) noexcept
+{
+    take(other);
+}
+
+template <typename T, std::size_t N>
+inline auto small_vector<T, N>::operator=(small_vector&& other) noexcept -> small_vector&
+{
+    if (this != &other) {
+        clear();
+        release_heap();
+        take(other);
+    }
+    return *this;
+}
+
+template <typename T, std::size_t N>
+template <typename... Args>
+inline auto small_vector<T, N>::emplace_back(Args&&... args) -> T&
+{
+    if (m_size < m_capacity) [[likely]] {
+        return *std::construct_at(data() + m_size++, std::forward<Args>(args)...);
+    }
+
+    auto const capacity = m_capacity * 2;
+    T* const heap = std::allocator<T> {}.allocate(capacity);
+
+    // the new element first, the arguments may refer to an element about to move.
+    T& element = *std::construct_at(heap + m_size, std::forward<Args>(args)...);
+    std::uninitialized_move_n(data(), m_size, heap);
+    std::destroy_n(data(), m_size);
+    release_heap();
+
+    m_heap = heap;
+    m_capacity = capacity;
+    ++m_size;
+    return element;
+}
+
+template <typename T, std::size_t N>
+inline void small_vector<T, N>::clear() noexcept
+{
+    std::destroy_n(data(), m_size);
+    m_size = 0;
+}
+
+template <typename T, std::size_t N>
+inline void small_vector<T, N>::take(small_vector& other) noexcept
+{
+    if (other.is_inline()) {
+        std::uninitialized_move_n(other.data(), other.m_size, data());
+        m_size = other.m_size;
+        other.clear();
+        return;
+    }
+
+    // heap storage changes hands, the elements stay where they are.
+    m_heap = std::exchange(other.m_heap, nullptr);
+    m_size = std::exchange(other.m_size, 0);
+    m_capacity = std::exchange(other.m_capacity, N);
+}
+
+template <typename T, std::size_t N>
+inline void small_vector<T, N>::release_heap() noexcept
+{
+    if (!is_inline()) {
+        std::allocator<T> {}.deallocate(m_heap, m_capacity);
+        m_heap = nullptr;
+        m_capacity = N;
+    }
+}
+
+} // namespace staplegl
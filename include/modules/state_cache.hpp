@@ -0,0 +1,221 @@
+/**
+ * @file state_cache.hpp
+ * @author Dario Loi
+ * @brief Redundant binding filter for the most frequently changed OpenGL state.
+ *
+ * @date 2026-10-17
+ *
+ * @copyright MIT License
+ *
+ * @details Remembers the bound program, vertex array, textures and uniform buffer ranges, and
+ * only forwards the binds that actually change something to the driver. It also counts the
+ * binds it issues, which makes the effect of draw ordering measurable. <br>
+ *
+ * The cache must see every change to the state it tracks: after binding through other means
+ * (e.g. shader_program::bind), call invalidate().
+ *
+ * @see command_queue.hpp
+ */
+
+#pragma once
+
+#include "gl_functions.hpp"
+
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+namespace staplegl {
+
+/**
+ * @brief Number of binds issued by a state_cache, by kind.
+ *
+ */
+struct state_stats {
+    std::uint32_t programs {};
+    std::uint32_t vertex_arrays {};
+    std::uint32_t textures {};
+    std::uint32_t uniform_ranges {};
+
+    [[nodiscard]] constexpr auto total() const noexcept -> std::uint32_t
+    {
+        return programs + vertex_arrays + textures + uniform_ranges;
+    }
+};
+
+/**
+ * @brief Filters redundant program, vertex array, texture and uniform buffer binds.
+ *
+ */
+class state_cache {
+public:
+    static constexpr std::uint32_t max_texture_units = 32;
+    static constexpr std::uint32_t max_uniform_bindings = 16;
+
+    /**
+     * @brief Construct a new state cache, assuming nothing about the current state.
+     *
+     * @param dry_run if true, binds are only tracked and counted, never issued.
+     */
+    explicit state_cache(bool dry_run = false) noexcept
+        : m_dry_run { dry_run }
+    {
+        invalidate();
+    }
+
+    void use_program(std::uint32_t program) noexcept;
+    void bind_vertex_array(std::uint32_t vertex_array) noexcept;
+
+    /**
+     * @brief Bind a texture to a texture unit.
+     *
+     * @details Units past max_texture_units are bound without caching.
+     *
+     * @param unit the texture unit, as an offset from GL_TEXTURE0.
+     * @param target the texture target, e.g. GL_TEXTURE_2D.
+     * @param texture the texture name.
+     */
+    void bind_texture(std::uint32_t unit, std::uint32_t target, std::uint32_t texture) noexcept;
+
+    /**
+     * @brief Bind a range of a uniform buffer to a binding point (glBindBufferRange).
+     *
+     * @details Binding points past max_uniform_bindings are bound without caching.
+     *
+     * @param binding the uniform block binding point.
+     * @param buffer the buffer name.
+     * @param offset the start of the range, aligned to GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT.
+     * @param size the size of the range.
+     */
+    void bind_uniform_range(std::uint32_t binding, std::uint32_t buffer, std::size_t offset, std::size_t size) noexcept;
+
+    /**
+     * @brief Forget the tracked state, the next binds are always issued.
+     *
+     */
+    void invalidate() noexcept;
+
+    [[nodiscard]] constexpr auto stats() const noexcept -> state_stats const& { return m_stats; }
+    void reset_stats() noexcept { m_stats = {}; }
+
+private:
+    static constexpr std::uint32_t unknown = 0xFFFFFFFFU;
+
+    void issue_texture(std::uint32_t unit, std::uint32_t target, std::uint32_t texture) noexcept;
+    void issue_uniform_range(std::uint32_t binding, std::uint32_t buffer, std::size_t offset, std::size_t size) noexcept;
+
+    struct texture_slot {
+        std::uint32_t target;
+        std::uint32_t texture;
+    };
+
+    struct uniform_slot {
+        std::uint32_t buffer;
+        std::size_t offset;
+        std::size_t size;
+    };
+
+    std::uint32_t m_program {};
+    std::uint32_t m_vertex_array {};
+    std::uint32_t m_active_unit {};
+    std::array<texture_slot, max_texture_units> m_textures {};
+    std::array<uniform_slot, max_uniform_bindings> m_uniforms {};
+    state_stats m_stats {};
+    bool m_dry_run {};
+};
+
+/*
+
+        IMPLEMENTATIONS
+
+*/
+
+inline void state_cache::use_program(std::uint32_t program) noexcept
+{
+    if (program != m_program) {
+        m_program = program;
+        ++m_stats.programs;
+        if (!m_dry_run) {
+            glUseProgram(program);
+        }
+    }
+}
+
+inline void state_cache::bind_vertex_array(std::uint32_t vertex_array) noexcept
+{
+    if (vertex_array != m_vertex_array) {
+        m_vertex_array = vertex_array;
+        ++m_stats.vertex_arrays;
+        if (!m_dry_run) {
+            glBindVertexArray(vertex_array);
+        }
+    }
+}
+
+inline void state_cache::bind_texture(std::uint32_t unit, std::uint32_t target, std::uint32_t texture) noexcept
+{
+    assert(unit < max_texture_units);
+    if (unit >= max_texture_units) [[unlikely]] {
+        issue_texture(unit, target, texture);
+        return;
+    }
+
+    auto& slot = m_textures[unit];
+    if (slot.target == target && slot.texture == texture) {
+        return;
+    }
+
+    slot = { target, texture };
+    issue_texture(unit, target, texture);
+}
+
+inline void state_cache::bind_uniform_range(std::uint32_t binding, std::uint32_t buffer, std::size_t offset, std::size_t size) noexcept
+{
+    assert(binding < max_uniform_bindings);
+    if (binding >= max_uniform_bindings) [[unlikely]] {
+        issue_uniform_range(binding, buffer, offset, size);
+        return;
+    }
+
+    auto& slot = m_uniforms[binding];
+    if (slot.buffer == buffer && slot.offset == offset && slot.size == size) {
+        return;
+    }
+
+    slot = { buffer, offset, size };
+    issue_uniform_range(binding, buffer, offset, size);
+}
+
+inline void state_cache::issue_texture(std::uint32_t unit, std::uint32_t target, std::uint32_t texture) noexcept
+{
+    ++m_stats.textures;
+    if (m_dry_run) {
+        return;
+    }
+
+    if (unit != m_active_unit) {
+        m_active_unit = unit;
+        glActiveTexture(GL_TEXTURE0 + unit);
+    }
+    glBindTexture(target, texture);
+}
+
+inline void state_cache::issue_uniform_range(std::uint32_t binding, std::uint32_t buffer, std::size_t offset, std::size_t size) noexcept
+{
+    ++m_stats.uniform_ranges;
+    if (!m_dry_run) {
+        glBindBufferRange(GL_UNIFORM_BUFFER, binding, buffer, static_cast<GLintptr>(offset), static_cast<GLsizeiptr>(size));
+    }
+}
+
+inline void state_cache::invalidate() noexcept
+{
+    m_program = unknown;
+    m_vertex_array = unknown;
+    m_active_unit = unknown;
+    m_textures.fill({ unknown, unknown });
+    m_uniforms.fill({ unknown, 0, 0 });
+}
+
+} // namespace staplegl
@@ -0,0 +1,226 @@
+/**
+ * @file static_layout.hpp
+ * @author Dario Loi
+ * @brief Vertex buffer layouts known at compile time.
+ *
+ * @date 2026-10-17
+ *
+ * @copyright MIT License
+ *
+ * @details Describes a vertex format as a type, so that its stride, the offset of every attribute
+ * and the arguments of the attribute setup calls are all constant expressions. <br>
+ *
+ * Unlike vertex_buffer_layout, a static layout allocates nothing: the attribute names live in
+ * the type itself and no vector of attributes is built, copied or moved around at runtime.
+ *
+ * @code{.cpp}
+ * using namespace staplegl::shader_data_type;
+ * using layout_3P_3N = staplegl::static_layout<staplegl::attr<u_type::vec3, "aPos">,
+ *                                              staplegl::attr<u_type::vec3, "aNormal">>;
+ *
+ * static_assert(layout_3P_3N::stride() == 6 * sizeof(float));
+ * static_assert(layout_3P_3N::offset(layout_3P_3N::index_of("aNormal")) == 3 * sizeof(float));
+ *
+ * VAO.add_vertex_buffer(std::move(VBO), layout_3P_3N {});
+ * @endcode
+ *
+ * Code that still needs a runtime layout (e.g. instance buffers) can obtain one through
+ * static_layout::to_runtime.
+ *
+ * @see vertex_buffer_layout.hpp
+ * @see vertex_array.hpp
+ */
+
+#pragma once
+
+#include "gl_functions.hpp"
+#include "shader_data_type.hpp"
+#include "vertex_buffer_layout.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace staplegl {
+
+/**
+ * @brief String literal usable as a template argument.
+ *
+ * @tparam N the size of the literal, null terminator included.
+ */
+template <std::size_t N>
+struct fixed_string {
+    std::array<char, N> data {};
+
+    constexpr fixed_string(const char (&str)[N]) noexcept // NOLINT (c-arrays, implicit conversion is the point)
+    {
+        std::copy_n(str, N, data.begin());
+    }
+
+    [[nodiscard]] constexpr auto view() const noexcept -> std::string_view { return { data.data(), N - 1 }; }
+};
+
+/**
+ * @brief A single attribute of a static_layout.
+ *
+ * @tparam Type the type of the attribute.
+ * @tparam Name the name of the attribute in the shader.
+ * @tparam Count the number of elements, for array attributes.
+ */
+template <shader_data_type::u_type Type, fixed_string Name, std::size_t Count = 1>
+struct attr {
+    static constexpr shader_data_type::u_type type = Type;
+    static constexpr std::size_t element_count = Count;
+    static constexpr std::size_t size = shader_data_type::size(Type) * Count;
+
+    [[nodiscard]] static constexpr auto name() noexcept -> std::string_view { return Name.view(); }
+};
+
+/**
+ * @brief Vertex buffer layout known at compile time.
+ *
+ * @details The attributes are tightly packed in declaration order, exactly like in a
+ * vertex_buffer_layout built from the same attributes.
+ *
+ * @tparam Attributes the attributes of the layout, as staplegl::attr types.
+ */
+template <typename... Attributes>
+class static_layout {
+public:
+    static constexpr std::size_t attribute_count = sizeof...(Attributes);
+
+    /**
+     * @brief Get the stride of the layout.
+     *
+     * @return std::size_t the size of a vertex, in bytes.
+     */
+    [[nodiscard]] static constexpr auto stride() noexcept -> std::size_t
+    {
+        return (std::size_t { 0 } + ... + Attributes::size);
+    }
+
+    /**
+     * @brief Get the offset of an attribute.
+     *
+     * @param index the index of the attribute in the layout.
+     * @return std::uint32_t the offset of the attribute from the start of the vertex, in bytes.
+     */
+    [[nodiscard]] static constexpr auto offset(std::size_t index) noexcept -> std::uint32_t
+    {
+        return m_offsets[index];
+    }
+
+    /**
+     * @brief Look up an attribute by name.
+     *
+     * @param name the name of the attribute.
+     * @return std::size_t the index of the attribute, attribute_count if there is no such attribute.
+     */
+    [[nodiscard]] static constexpr auto index_of(std::string_view name) noexcept -> std::size_t
+    {
+        constexpr std::array<std::string_view, attribute_count> names { Attributes::name()... };
+        return static_cast<std::size_t>(std::find(names.begin(), names.end(), name) - names.begin());
+    }
+
+    /**
+     * @brief Enable and describe the attributes of the layout on the bound vertex array.
+     *
+     * @note The vertex buffer holding the data must be bound to GL_ARRAY_BUFFER.
+     *
+     * @param first_index the attribute index of the first attribute of the layout.
+     * @param divisor the attribute divisor, 0 for per-vertex data.
+     * @return std::uint32_t the first attribute index after the ones used by the layout (matrices
+     * and arrays use several).
+     */
+    static auto enable(std::uint32_t first_index, std::uint32_t divisor = 0) noexcept -> std::uint32_t;
+
+    /**
+     * @brief Describe the attributes of the layout on a binding point of the bound vertex array (GL 4.3).
+     *
+     * @param first_index the attribute index of the first attribute of the layout.
+     * @param binding the binding point the attributes read from.
+     * @return std::uint32_t the first attribute index after the ones used by the layout.
+     * @see format_vertex_attribute
+     */
+    static auto format(std::uint32_t first_index, std::uint32_t binding) noexcept -> std::uint32_t;
+
+    /**
+     * @brief Convert the layout to a vertex_buffer_layout, for the APIs that need one.
+     *
+     * @return vertex_buffer_layout a runtime layout with the same attributes, stride and offsets.
+     */
+    [[nodiscard]] static auto to_runtime() -> vertex_buffer_layout;
+
+private:
+    static constexpr std::array<std::uint32_t, attribute_count> m_offsets = [] {
+        std::array<std::uint32_t, attribute_count> offsets {};
+        std::array<std::size_t, attribute_count> const sizes { Attributes::size... };
+        std::uint32_t offset {};
+        for (std::size_t i = 0; i < attribute_count; ++i) {
+            offsets[i] = offset;
+            offset += static_cast<std::uint32_t>(sizes[i]);
+        }
+        return offsets;
+    }();
+};
+
+/**
+ * @brief Whether a type is a static_layout.
+ *
+ */
+template <typename T>
+struct is_static_layout : std::false_type { };
+
+template <typename... Attributes>
+struct is_static_layout<static_layout<Attributes...>> : std::true_type { };
+
+template <typename T>
+concept static_vertex_layout = is_static_layout<std::remove_cvref_t<T>>::value;
+
+/*
+
+        IMPLEMENTATIONS
+
+*/
+
+template <typename... Attributes>
+inline auto static_layout<Attributes...>::enable(std::uint32_t first_index, std::uint32_t divisor) noexcept -> std::uint32_t
+{
+    std::uint32_t index = first_index;
+    std::size_t attribute {};
+    ((index += enable_vertex_attribute(index, Attributes::type, Attributes::element_count, stride(), m_offsets[attribute++], divisor)), ...);
+
+    return index;
+}
+
+template <typename... Attributes>
+inline auto static_layout<Attributes...>::format(std::uint32_t first_index, std::uint32_t binding) noexcept -> std::uint32_t
+{
+    std::uint32_t index = first_index;
+    std::size_t attribute {};
+    ((index += format_vertex_attribute(index, Attributes::type, Attributes::element_count, m_offsets[attribute++], binding)), ...);
+
+    return index;
+}
+
+template <typename... Attributes>
+inline auto static_layout<Attributes...>::to_runtime() -> vertex_buffer_layout
+{
+    std::vector<vertex_attribute> attributes;
+    attributes.reserve(attribute_count);
+    (
+        [&attributes] {
+            auto& attribute = attributes.emplace_back(Attributes::type, Attributes::name());
+            attribute.element_count = Attributes::element_count;
+        }(),
+        ...);
+
+    return vertex_buffer_layout { std::move(attributes) };
+}
+
+} // namespace staplegl
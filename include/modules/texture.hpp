@@ -23,7 +23,9 @@
 
 #pragma once
 
+#include "deletion_queue.hpp"
 #include "gl_functions.hpp"
+#include "name_pool.hpp"
 #include "utility.hpp"
 
 #include <cstdint>
@@ -137,7 +139,7 @@ public:
     ~texture_2d()
     {
         if (m_id != 0) {
-            glDeleteTextures(1, &m_id);
+            release_object(gl_object::texture, m_id);
         }
     }
 
@@ -302,7 +304,7 @@ inline texture_2d::texture_2d(std::span<const T> data, resolution res,
     , m_resolution { res }
     , m_antialias { (samples == tex_samples::MSAA_X1) ? texture_antialias { GL_TEXTURE_2D, samples } : texture_antialias { GL_TEXTURE_2D_MULTISAMPLE, samples } }
 {
-    glGenTextures(1, &m_id);
+    m_id = acquire_name(gl_object::texture);
     glBindTexture(m_antialias.type, m_id);
 
     if (m_antialias.type == GL_TEXTURE_2D) {
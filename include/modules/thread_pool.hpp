@@ -0,0 +1,237 @@
+/**
+ * @file thread_pool.hpp
+ * @author Dario Loi
+ * @brief Work-stealing thread pool for data-parallel CPU work.
+ *
+ * @date 2026-10-17
+ *
+ * @copyright MIT License
+ *
+ * @details A small pool for the CPU side of a frame (e.g. instance_shadow kernels). Work is
+ * split into chunks spread over per-worker queues. Each worker drains its own queue first and
+ * then steals from the others, so that uneven chunks do not leave cores idle. The thread
+ * calling parallel_for works too, and returns once every chunk is done. <br>
+ *
+ * The pool never touches OpenGL, and the functions it runs must not throw.
+ *
+ * @code{.cpp}
+ * staplegl::thread_pool pool;
+ * pool.parallel_for(positions.size(), 4096, [&](std::size_t begin, std::size_t end) {
+ *     for (std::size_t i = begin; i < end; ++i) {
+ *         positions[i] += velocities[i] * dt;
+ *     }
+ * });
+ * @endcode
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stop_token>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace staplegl {
+
+/**
+ * @brief Work-stealing thread pool.
+ *
+ */
+class thread_pool {
+public:
+    /**
+     * @brief Start the workers.
+     *
+     * @param workers the number of worker threads, the calling thread works too. Defaults to one
+     * less than the number of hardware threads.
+     */
+    explicit thread_pool(std::size_t workers = default_workers());
+    ~thread_pool();
+
+    thread_pool(const thread_pool&) = delete;
+    auto operator=(const thread_pool&) -> thread_pool& = delete;
+    thread_pool(thread_pool&&) = delete;
+    auto operator=(thread_pool&&) -> thread_pool& = delete;
+
+    /**
+     * @brief Run a function over [0, count) in chunks, in parallel, and wait for it.
+     *
+     * @param count the number of items.
+     * @param grain the minimum number of items per chunk.
+     * @param func called as `func(begin, end)` for every chunk, from any thread.
+     */
+    template <typename Func>
+    void parallel_for(std::size_t count, std::size_t grain, Func&& func);
+
+    /**
+     * @brief The number of threads working on a parallel_for, the caller included.
+     *
+     */
+    [[nodiscard]] auto concurrency() const noexcept -> std::size_t { return m_threads.size() + 1; }
+
+    [[nodiscard]] static auto default_workers() noexcept -> std::size_t
+    {
+        return std::max(std::thread::hardware_concurrency(), 1U) - 1;
+    }
+
+private:
+    struct task {
+        void (*run)(const void* context, std::size_t begin, std::size_t end);
+        const void* context;
+        std::size_t begin;
+        std::size_t end;
+        std::atomic<std::size_t>* pending;
+    };
+
+    struct worker_queue {
+        std::mutex mutex;
+        std::deque<task> tasks;
+    };
+
+    void work(std::size_t self, std::stop_token const& stop);
+
+    /**
+     * @brief Take a task, from the back of queue `self` or else from the front of another one.
+     *
+     */
+    auto take(std::size_t self) -> std::optional<task>;
+
+    static void execute(task const& job) noexcept;
+
+    std::vector<std::unique_ptr<worker_queue>> m_queues;
+    std::atomic<std::size_t> m_queued {};
+    std::mutex m_sleep_mutex;
+    std::condition_variable_any m_wake;
+    std::vector<std::jthread> m_threads; // last, so that the workers stop before the rest is destroyed
+};
+
+/*
+
+        IMPLEMENTATIONS
+
+*/
+
+inline thread_pool::thread_pool(std::size_t workers)
+{
+    // one queue per worker, plus one for the calling thread.
+    for (std::size_t i = 0; i <= workers; ++i) {
+        m_queues.push_back(std::make_unique<worker_queue>());
+    }
+
+    m_threads.reserve(workers);
+    for (std::size_t i = 0; i < workers; ++i) {
+        m_threads.emplace_back([this, i](std::stop_token const& stop) { work(i, stop); });
+    }
+}
+
+inline thread_pool::~thread_pool()
+{
+    for (auto& thread : m_threads) {
+        thread.request_stop();
+    }
+    m_wake.notify_all();
+    m_threads.clear();
+}
+
+template <typename Func>
+inline void thread_pool::parallel_for(std::size_t count, std::size_t grain, Func&& func)
+{
+    if (count == 0) {
+        return;
+    }
+
+    // a few chunks per thread, so that stealing can balance uneven work.
+    auto const chunks = std::clamp<std::size_t>(count / std::max<std::size_t>(grain, 1), 1, concurrency() * 4);
+    if (chunks == 1) {
+        func(std::size_t { 0 }, count);
+        return;
+    }
+
+    auto const run = [](const void* context, std::size_t begin, std::size_t end) {
+        (*static_cast<const std::remove_reference_t<Func>*>(context))(begin, end);
+    };
+
+    std::atomic<std::size_t> pending { chunks };
+    auto const caller = m_queues.size() - 1;
+
+    // counted before being queued, so that the count never drops below the queued tasks.
+    m_queued.fetch_add(chunks, std::memory_order_release);
+    for (std::size_t chunk = 0; chunk < chunks; ++chunk) {
+        task const job { run, &func, count * chunk / chunks, count * (chunk + 1) / chunks, &pending };
+
+        auto& queue = *m_queues[chunk % m_queues.size()];
+        std::lock_guard const lock { queue.mutex };
+        queue.tasks.push_back(job);
+    }
+
+    {
+        // pairs with the predicate check of the sleeping workers, so that no wakeup is lost.
+        std::lock_guard const lock { m_sleep_mutex };
+    }
+    m_wake.notify_all();
+
+    while (pending.load(std::memory_order_acquire) != 0) {
+        if (auto job = take(caller)) {
+            execute(*job);
+        } else {
+            std::this_thread::yield(); // the last chunks are running on other threads
+        }
+    }
+}
+
+inline void thread_pool::work(std::size_t self, std::stop_token const& stop)
+{
+    while (!stop.stop_requested()) {
+        if (auto job = take(self)) {
+            execute(*job);
+            continue;
+        }
+
+        std::unique_lock lock { m_sleep_mutex };
+        m_wake.wait(lock, stop, [this] { return m_queued.load(std::memory_order_acquire) != 0; });
+    }
+}
+
+inline auto thread_pool::take(std::size_t self) -> std::optional<task>
+{
+    if (m_queued.load(std::memory_order_acquire) == 0) {
+        return std::nullopt;
+    }
+
+    for (std::size_t i = 0; i < m_queues.size(); ++i) {
+        auto& queue = *m_queues[(self + i) % m_queues.size()];
+        std::lock_guard const lock { queue.mutex };
+        if (queue.tasks.empty()) {
+            continue;
+        }
+
+        task job {};
+        if (i == 0) {
+            job = queue.tasks.back();
+            queue.tasks.pop_back();
+        } else {
+            job = queue.tasks.front();
+            queue.tasks.pop_front();
+        }
+        m_queued.fetch_sub(1, std::memory_order_relaxed);
+        return job;
+    }
+
+    return std::nullopt;
+}
+
+inline void thread_pool::execute(task const& job) noexcept
+{
+    job.run(job.context, job.begin, job.end);
+    job.pending->fetch_sub(1, std::memory_order_release);
+}
+
+} // namespace staplegl
@@ -0,0 +1,363 @@
+/**
+ * @file tiled_renderer.hpp
+ * @author Dario Loi
+ * @brief Tiled rendering of images larger than the largest framebuffer.
+ *
+ * @date 2026-10-17
+ *
+ * @copyright MIT License
+ *
+ * @details A framebuffer cannot be larger than `GL_MAX_TEXTURE_SIZE`, `GL_MAX_RENDERBUFFER_SIZE`
+ * and `GL_MAX_VIEWPORT_DIMS`, typically 16384 or 32768 pixels, and a 32k x 32k RGBA8 image takes
+ * 4 GiB anyway. tiled_renderer splits the image into a tile_grid, and renders the scene once per
+ * tile, into a small pool of tile-sized framebuffers used in turn. <br>
+ *
+ * Each tile is drawn with the matrix returned by tile_projection, to be applied after the
+ * projection of the whole image: it maps the part of clip space covered by the tile to the
+ * whole of it, so the tiles line up exactly. Effects working in screen space (bloom, SSAO, ...)
+ * only see the tile they run in, and may show seams. <br>
+ *
+ * The tiles are read back asynchronously (see async_readback.hpp), and handed to a sink as they
+ * arrive. There is a framebuffer per readback in flight, so that drawing a tile never has to
+ * wait for the copy of the previous one out of the same framebuffer. ppm_tile_writer is such a sink: it writes every row of a tile straight to its place in
+ * a binary PPM file, so that the image is never held in memory, only the tiles in flight.
+ *
+ * @code{.cpp}
+ * staplegl::tiled_renderer renderer { { 32768, 32768 } };
+ * staplegl::ppm_tile_writer file { "poster.ppm", renderer.grid().image() };
+ *
+ * renderer.render(
+ *     [&](staplegl::tile const& tile, std::array<float, 16> const& tile_matrix) {
+ *         program.upload_uniform_mat4f("u_tile", tile_matrix.data());
+ *         draw_scene();
+ *     },
+ *     [&](staplegl::tile const& tile, std::span<const std::byte> pixels) { file.write(tile, pixels); });
+ * @endcode
+ *
+ * @see https://www.khronos.org/opengl/wiki/Framebuffer_Object#Framebuffer_Object_Structure
+ */
+
+#pragma once
+
+#include "async_readback.hpp"
+#include "framebuffer.hpp"
+#include "gl_functions.hpp"
+#include "texture.hpp"
+#include "utility.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <span>
+#include <string>
+#include <vector>
+
+#ifdef STAPLEGL_DEBUG
+#include <cstdio>
+#endif // STAPLEGL_DEBUG
+
+namespace staplegl {
+
+/**
+ * @brief A tile of an image, in pixels, from the bottom left corner.
+ *
+ */
+struct tile {
+    std::int32_t x {};
+    std::int32_t y {};
+    std::int32_t width {};
+    std::int32_t height {};
+    std::size_t index {}; ///< row-major, from the bottom row.
+};
+
+/**
+ * @brief Split of an image into tiles, the last row and column may be smaller.
+ *
+ */
+class tile_grid {
+public:
+    /**
+     * @brief Construct a new tile grid object
+     *
+     * @param image the size of the whole image.
+     * @param tile_size the size of the tiles.
+     */
+    tile_grid(resolution image, resolution tile_size) noexcept;
+
+    [[nodiscard]] auto image() const noexcept -> resolution { return m_image; }
+    [[nodiscard]] auto tile_size() const noexcept -> resolution { return m_tile_size; }
+    [[nodiscard]] auto columns() const noexcept -> std::int32_t { return m_columns; }
+    [[nodiscard]] auto rows() const noexcept -> std::int32_t { return m_rows; }
+    [[nodiscard]] auto size() const noexcept -> std::size_t { return static_cast<std::size_t>(m_columns) * static_cast<std::size_t>(m_rows); }
+
+    [[nodiscard]] auto operator[](std::size_t index) const noexcept -> tile;
+
+    /**
+     * @brief The largest framebuffer the current context can render to.
+     *
+     */
+    [[nodiscard]] static auto max_tile_size() noexcept -> resolution;
+
+private:
+    resolution m_image;
+    resolution m_tile_size;
+    std::int32_t m_columns {};
+    std::int32_t m_rows {};
+};
+
+/**
+ * @brief The matrix mapping the part of clip space covered by a tile to the whole of it.
+ *
+ * @details Multiply it on the left of the projection of the whole image, as in
+ * `gl_Position = u_tile * projection * view * model * position`.
+ *
+ * @param area the tile.
+ * @param image the size of the whole image.
+ * @return std::array<float, 16> the matrix, column-major.
+ */
+[[nodiscard]] auto tile_projection(tile const& area, resolution image) noexcept -> std::array<float, 16>;
+
+/**
+ * @brief Renders images tile by tile, and streams the tiles out.
+ *
+ */
+class tiled_renderer {
+public:
+    /**
+     * @brief Construct a new tiled renderer object
+     *
+     * @details Allocates `depth` tile framebuffers, each with a depth-stencil renderbuffer.
+     *
+     * @param image the size of the whole image.
+     * @param tile_size the size of the tiles, clamped to max_tile_size(). Defaults to 2048 x 2048.
+     * @param color the format of the tile textures, and of the pixels handed to the sink.
+     * @param depth the number of tiles read back at the same time, and of tile framebuffers.
+     */
+    explicit tiled_renderer(resolution image, resolution tile_size = { 2048, 2048 },
+        texture_color color = { .internal_format = GL_RGBA8, .format = GL_RGBA, .datatype = GL_UNSIGNED_BYTE },
+        std::size_t depth = 3) noexcept;
+
+    /**
+     * @brief Render every tile, in order.
+     *
+     * @param draw called as `draw(tile, tile_matrix)` with the tile framebuffer bound, its
+     * viewport set and nothing cleared.
+     * @param sink called as `sink(tile, std::span<const std::byte> pixels)` once a tile is read
+     * back, rows from the bottom, tightly packed. The pixels are only valid during the call, and
+     * empty if the readback failed.
+     */
+    template <typename Draw, typename Sink>
+    void render(Draw&& draw, Sink&& sink);
+
+    [[nodiscard]] auto grid() const noexcept -> tile_grid const& { return m_grid; }
+
+    /**
+     * @brief The framebuffer a tile is drawn into.
+     *
+     * @param index the index of the tile.
+     */
+    [[nodiscard]] auto target(std::size_t index) noexcept -> framebuffer& { return m_targets[index % m_targets.size()].fbo; }
+
+    /**
+     * @brief The number of tile framebuffers.
+     *
+     */
+    [[nodiscard]] auto targets() const noexcept -> std::size_t { return m_targets.size(); }
+
+private:
+    struct tile_target {
+        texture_2d texture;
+        framebuffer fbo;
+    };
+
+    tile_grid m_grid;
+    texture_color m_color;
+    std::vector<tile_target> m_targets;
+    async_readback m_readback;
+};
+
+/**
+ * @brief Writes tiles into a binary PPM file, each at its place.
+ *
+ * @details Takes RGBA8 tiles as read back by tiled_renderer (rows from the bottom), drops the
+ * alpha channel, and writes every row with a seek to its offset in the file. Holds a single row
+ * of a tile in memory.
+ */
+class ppm_tile_writer {
+public:
+    /**
+     * @brief Create, or truncate, the file and write its header.
+     *
+     */
+    ppm_tile_writer(std::string const& path, resolution image);
+
+    [[nodiscard]] auto is_open() const noexcept -> bool { return m_file.good(); }
+
+    /**
+     * @brief Write a tile.
+     *
+     * @param area the tile, within the image.
+     * @param pixels its RGBA8 pixels, rows from the bottom.
+     * @return true on success.
+     */
+    auto write(tile const& area, std::span<const std::byte> pixels) -> bool;
+
+private:
+    std::ofstream m_file;
+    resolution m_image;
+    std::streamoff m_data {}; ///< the offset of the first pixel.
+    std::vector<char> m_row;
+};
+
+/*
+
+        IMPLEMENTATIONS
+
+*/
+
+inline tile_grid::tile_grid(resolution image, resolution tile_size) noexcept
+    : m_image { image }
+    , m_tile_size { std::max(tile_size.width, 1), std::max(tile_size.height, 1) }
+    , m_columns { (std::max(image.width, 0) + m_tile_size.width - 1) / m_tile_size.width }
+    , m_rows { (std::max(image.height, 0) + m_tile_size.height - 1) / m_tile_size.height }
+{
+}
+
+inline auto tile_grid::operator[](std::size_t index) const noexcept -> tile
+{
+    auto const column = static_cast<std::int32_t>(index % static_cast<std::size_t>(m_columns));
+    auto const row = static_cast<std::int32_t>(index / static_cast<std::size_t>(m_columns));
+    auto const x = column * m_tile_size.width;
+    auto const y = row * m_tile_size.height;
+
+    return { x, y, std::min(m_tile_size.width, m_image.width - x), std::min(m_tile_size.height, m_image.height - y), index };
+}
+
+inline auto tile_grid::max_tile_size() noexcept -> resolution
+{
+    std::int32_t texture {};
+    std::int32_t renderbuffer {};
+    std::array<std::int32_t, 2> viewport {};
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &texture);
+    glGetIntegerv(GL_MAX_RENDERBUFFER_SIZE, &renderbuffer);
+    glGetIntegerv(GL_MAX_VIEWPORT_DIMS, viewport.data());
+
+    auto const side = std::min(texture, renderbuffer);
+    return { std::min(side, viewport[0]), std::min(side, viewport[1]) };
+}
+
+inline auto tile_projection(tile const& area, resolution image) noexcept -> std::array<float, 16>
+{
+    // scale the tile to [-1, 1], around its center in normalized device coordinates. Applied in
+    // clip space, the translation is scaled by w: x' = sx * x - sx * cx * w.
+    auto const sx = static_cast<float>(image.width) / static_cast<float>(area.width);
+    auto const sy = static_cast<float>(image.height) / static_cast<float>(area.height);
+    auto const cx = (2.0F * static_cast<float>(area.x) + static_cast<float>(area.width)) / static_cast<float>(image.width) - 1.0F;
+    auto const cy = (2.0F * static_cast<float>(area.y) + static_cast<float>(area.height)) / static_cast<float>(image.height) - 1.0F;
+
+    return {
+        sx, 0.0F, 0.0F, 0.0F,
+        0.0F, sy, 0.0F, 0.0F,
+        0.0F, 0.0F, 1.0F, 0.0F,
+        -sx * cx, -sy * cy, 0.0F, 1.0F
+    };
+}
+
+inline tiled_renderer::tiled_renderer(resolution image, resolution tile_size, texture_color color, std::size_t depth) noexcept
+    : m_grid { image, tile_size }
+    , m_color { color }
+    , m_readback { depth }
+{
+    auto const max = tile_grid::max_tile_size();
+    auto const clamped = resolution {
+        std::clamp(tile_size.width, 1, std::max(max.width, 1)),
+        std::clamp(tile_size.height, 1, std::max(max.height, 1))
+    };
+    m_grid = tile_grid { image, clamped };
+
+    // no larger than the image, for small images.
+    auto const size = resolution { std::min(clamped.width, std::max(image.width, 1)), std::min(clamped.height, std::max(image.height, 1)) };
+
+    m_targets.resize(m_readback.depth());
+    for (auto& target : m_targets) {
+        target.texture = texture_2d { std::span<const std::uint8_t> {}, size, color,
+            texture_filter { .min_filter = GL_NEAREST, .mag_filter = GL_NEAREST, .clamping = GL_CLAMP_TO_EDGE } };
+
+        target.fbo.bind();
+        target.fbo.set_texture(target.texture);
+        target.fbo.set_renderbuffer(size);
+        if (!target.fbo.assert_completeness()) [[unlikely]] {
+#ifdef STAPLEGL_DEBUG
+            std::fprintf(stderr, STAPLEGL_LINEINFO ", the %dx%d tile framebuffer is not complete\n", size.width, size.height);
+#endif // STAPLEGL_DEBUG
+        }
+    }
+    framebuffer::bind_default();
+}
+
+template <typename Draw, typename Sink>
+inline void tiled_renderer::render(Draw&& draw, Sink&& sink)
+{
+    auto const forward = [this, &sink](std::uint64_t index, readback_region const& /*region*/, std::span<const std::byte> pixels) {
+        sink(m_grid[static_cast<std::size_t>(index)], pixels);
+    };
+    readback_format const format { m_color.format, m_color.datatype };
+
+    for (std::size_t index = 0; index < m_grid.size(); ++index) {
+        auto const area = m_grid[index];
+
+        // framebuffers in turn: the copy out of the one a tile is drawn into was scheduled
+        // `depth` tiles earlier, not right before. Edge tiles only use part of it.
+        target(index).bind();
+        framebuffer::set_viewport({ area.width, area.height });
+        draw(area, tile_projection(area, m_grid.image()));
+
+        m_readback.read({ 0, 0, area.width, area.height }, index, forward, format);
+        m_readback.poll(forward);
+    }
+
+    m_readback.drain(forward);
+    framebuffer::bind_default();
+}
+
+inline ppm_tile_writer::ppm_tile_writer(std::string const& path, resolution image)
+    : m_file { path, std::ios::binary | std::ios::trunc }
+    , m_image { image }
+{
+    m_file << "P6\n"
+           << image.width << ' ' << image.height << "\n255\n";
+    m_data = m_file.tellp();
+}
+
+inline auto ppm_tile_writer::write(tile const& area, std::span<const std::byte> pixels) -> bool
+{
+    auto const width = static_cast<std::size_t>(area.width);
+    if (pixels.size() < width * static_cast<std::size_t>(area.height) * 4) [[unlikely]] {
+#ifdef STAPLEGL_DEBUG
+        std::fprintf(stderr, STAPLEGL_LINEINFO ", tile %zu holds %zu bytes, not %dx%d RGBA8 pixels\n",
+            area.index, pixels.size(), area.width, area.height);
+#endif // STAPLEGL_DEBUG
+        return false;
+    }
+
+    m_row.resize(width * 3);
+    for (std::int32_t y = 0; y < area.height; ++y) {
+        auto const source = pixels.subspan(static_cast<std::size_t>(y) * width * 4, width * 4);
+        for (std::size_t x = 0; x < width; ++x) {
+            m_row[x * 3 + 0] = static_cast<char>(source[x * 4 + 0]);
+            m_row[x * 3 + 1] = static_cast<char>(source[x * 4 + 1]);
+            m_row[x * 3 + 2] = static_cast<char>(source[x * 4 + 2]);
+        }
+
+        // PPM rows go from the top.
+        auto const row = static_cast<std::streamoff>(m_image.height - 1 - (area.y + y));
+        m_file.seekp(m_data + (row * m_image.width + area.x) * 3);
+        m_file.write(m_row.data(), static_cast<std::streamsize>(m_row.size()));
+    }
+
+    return m_file.good();
+}
+
+} // namespace staplegl
@@ -0,0 +1,235 @@
+/**
+ * @file transform_packing.hpp
+ * @author Dario Loi
+ * @brief Packing of per-instance translations, rotations and scales into instance matrices.
+ *
+ * @date 2026-10-17
+ *
+ * @copyright MIT License
+ *
+ * @details Scene graphs hold the transform of an instance as a position, a rotation quaternion
+ * and a scale, while the vertex shader wants a matrix. pack_transforms builds the matrices of
+ * every instance from arrays of components (one array for all the x positions, one for all the
+ * y, ...), several instances at a time with SIMD, and writes them straight into instance memory,
+ * e.g. a buffer mapped by vertex_buffer::stream, in parallel on a thread_pool if given. <br>
+ *
+ * Two formats are available:
+ *
+ * - transform_format::mat4, a column-major `mat4` attribute (16 floats);
+ * - transform_format::affine_rows, the first three rows of the matrix (12 floats), declared as
+ *   three vec4 attributes and expanded by `affine_from_rows` of transform_packing_glsl. The last
+ *   row of an affine transform is always (0, 0, 0, 1), so this saves a quarter of the bandwidth.
+ *
+ * @code{.cpp}
+ * staplegl::trs_view const trs { { px, py, pz }, { qx, qy, qz, qw }, { sx, sy, sz } };
+ *
+ * instance_buffer.stream<float>([&](std::span<float> data) {
+ *     staplegl::pack_transforms(trs, staplegl::transform_format::affine_rows, data, 12, 0, &pool);
+ * });
+ * @endcode
+ *
+ * @see instance_shadow.hpp
+ */
+
+#pragma once
+
+#include "instance_shadow.hpp"
+#include "thread_pool.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+
+#ifdef STAPLEGL_DEBUG
+#include <cstdio>
+#endif // STAPLEGL_DEBUG
+
+namespace staplegl {
+
+/**
+ * @brief GLSL functions decoding the packed transforms.
+ *
+ */
+inline constexpr std::string_view transform_packing_glsl = R"glsl(
+mat4 affine_from_rows(vec4 row0, vec4 row1, vec4 row2)
+{
+    return transpose(mat4(row0, row1, row2, vec4(0.0, 0.0, 0.0, 1.0)));
+}
+)glsl";
+
+/**
+ * @brief Layout of a packed instance transform.
+ *
+ */
+enum class transform_format : std::uint8_t {
+    mat4,        ///< column-major 4x4 matrix, 16 floats.
+    affine_rows, ///< the first three rows of the matrix, 12 floats.
+};
+
+/**
+ * @brief Number of floats of a packed transform.
+ *
+ */
+[[nodiscard]] constexpr auto transform_floats(transform_format format) noexcept -> std::size_t
+{
+    return format == transform_format::mat4 ? 16 : 12;
+}
+
+/**
+ * @brief Per-instance transforms, one array per component.
+ *
+ */
+struct trs_view {
+    std::array<std::span<const float>, 3> position; ///< x, y, z.
+    std::array<std::span<const float>, 4> rotation; ///< unit quaternion x, y, z, w.
+    std::array<std::span<const float>, 3> scale;    ///< x, y, z.
+
+    /**
+     * @brief The number of instances, that of the shortest array.
+     *
+     */
+    [[nodiscard]] auto size() const noexcept -> std::size_t;
+};
+
+/**
+ * @brief Number of instances below which packing does not bother splitting the work.
+ *
+ */
+inline constexpr std::size_t transform_packing_grain = 8192;
+
+/**
+ * @brief Build the matrices `translate * rotate * scale` of a set of instances.
+ *
+ * @param trs the transforms.
+ * @param format the layout of the packed matrices.
+ * @param out the instance memory, its other attributes are left untouched.
+ * @param stride the distance between two instances in `out`, in floats.
+ * @param offset the offset of the matrix within an instance, in floats.
+ * @param pool the pool to spread the work on, if any.
+ * @return std::size_t the number of instances packed, limited by the size of `out`.
+ */
+auto pack_transforms(trs_view const& trs, transform_format format, std::span<float> out,
+    std::size_t stride, std::size_t offset = 0, thread_pool* pool = nullptr) -> std::size_t;
+
+/*
+
+        IMPLEMENTATIONS
+
+*/
+
+inline auto trs_view::size() const noexcept -> std::size_t
+{
+    std::size_t count = position[0].size();
+    for (auto const& values : position) {
+        count = std::min(count, values.size());
+    }
+    for (auto const& values : rotation) {
+        count = std::min(count, values.size());
+    }
+    for (auto const& values : scale) {
+        count = std::min(count, values.size());
+    }
+    return count;
+}
+
+namespace detail {
+
+    template <typename L>
+    inline void pack_transform_lanes(trs_view const& trs, transform_format format, float* out,
+        std::size_t stride, std::size_t i) noexcept
+    {
+        auto const load = [i](std::span<const float> values) { return L::load(values.data() + i); };
+        auto const one = L::set(1.0F);
+        auto const two = L::set(2.0F);
+
+        auto const x = load(trs.rotation[0]);
+        auto const y = load(trs.rotation[1]);
+        auto const z = load(trs.rotation[2]);
+        auto const w = load(trs.rotation[3]);
+        auto const sx = load(trs.scale[0]);
+        auto const sy = load(trs.scale[1]);
+        auto const sz = load(trs.scale[2]);
+
+        auto const x2 = L::mul(x, two);
+        auto const y2 = L::mul(y, two);
+        auto const z2 = L::mul(z, two);
+        auto const xx = L::mul(x, x2);
+        auto const yy = L::mul(y, y2);
+        auto const zz = L::mul(z, z2);
+        auto const xy = L::mul(x, y2);
+        auto const xz = L::mul(x, z2);
+        auto const yz = L::mul(y, z2);
+        auto const wx = L::mul(w, x2);
+        auto const wy = L::mul(w, y2);
+        auto const wz = L::mul(w, z2);
+
+        // the rotation matrix, whose columns are scaled by sx, sy and sz, then the translation.
+        auto const m00 = L::mul(L::sub(one, L::add(yy, zz)), sx);
+        auto const m01 = L::mul(L::sub(xy, wz), sy);
+        auto const m02 = L::mul(L::add(xz, wy), sz);
+        auto const m10 = L::mul(L::add(xy, wz), sx);
+        auto const m11 = L::mul(L::sub(one, L::add(xx, zz)), sy);
+        auto const m12 = L::mul(L::sub(yz, wx), sz);
+        auto const m20 = L::mul(L::sub(xz, wy), sx);
+        auto const m21 = L::mul(L::add(yz, wx), sy);
+        auto const m22 = L::mul(L::sub(one, L::add(xx, yy)), sz);
+        auto const tx = load(trs.position[0]);
+        auto const ty = load(trs.position[1]);
+        auto const tz = load(trs.position[2]);
+
+        // the output is interleaved: transpose four entries at a time, one store per row (or column).
+        float* const matrix = out + i * stride;
+        if (format == transform_format::affine_rows) {
+            L::scatter4(m00, m01, m02, tx, matrix, stride);
+            L::scatter4(m10, m11, m12, ty, matrix + 4, stride);
+            L::scatter4(m20, m21, m22, tz, matrix + 8, stride);
+            return;
+        }
+
+        auto const zero = L::set(0.0F);
+        L::scatter4(m00, m10, m20, zero, matrix, stride);
+        L::scatter4(m01, m11, m21, zero, matrix + 4, stride);
+        L::scatter4(m02, m12, m22, zero, matrix + 8, stride);
+        L::scatter4(tx, ty, tz, one, matrix + 12, stride);
+    }
+
+} // namespace detail
+
+inline auto pack_transforms(trs_view const& trs, transform_format format, std::span<float> out,
+    std::size_t stride, std::size_t offset, thread_pool* pool) -> std::size_t
+{
+    auto const floats = transform_floats(format);
+    if (stride < floats || offset > stride - floats) [[unlikely]] {
+#ifdef STAPLEGL_DEBUG
+        std::fprintf(stderr, STAPLEGL_LINEINFO ", a packed transform does not fit in a stride of %zu floats at offset %zu\n",
+            stride, offset);
+#endif // STAPLEGL_DEBUG
+        return 0;
+    }
+
+    auto count = trs.size();
+    if (out.size() < offset + floats) {
+        return 0;
+    }
+    count = std::min(count, (out.size() - offset - floats) / stride + 1);
+
+    float* const base = out.data() + offset;
+    auto const kernel = [&trs, format, base, stride](std::size_t begin, std::size_t end) {
+        detail::for_each_lane(begin, end, [&trs, format, base, stride]<typename L>(std::size_t i) {
+            detail::pack_transform_lanes<L>(trs, format, base, stride, i);
+        });
+    };
+
+    if (pool == nullptr || count < transform_packing_grain) {
+        kernel(std::size_t { 0 }, count);
+    } else {
+        pool->parallel_for(count, transform_packing_grain, kernel);
+    }
+
+    return count;
+}
+
+} // namespace staplegl
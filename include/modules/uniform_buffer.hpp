@@ -16,7 +16,9 @@
 
 #pragma once
 
+#include "deletion_queue.hpp"
 #include "gl_functions.hpp"
+#include "name_pool.hpp"
 #include "vertex_buffer_layout.hpp"
 
 #include <span>
@@ -159,7 +161,7 @@ inline uniform_buffer::uniform_buffer(std::span<const float> contents, vertex_bu
     : m_binding_point { binding_point }
     , m_layout { std::move(layout) }
 {
-    glGenBuffers(1, &m_id);
+    m_id = acquire_name(gl_object::buffer);
     glBindBuffer(GL_UNIFORM_BUFFER, m_id);
     glBufferData(GL_UNIFORM_BUFFER,
         static_cast<ptrdiff_t>(contents.size_bytes()),
@@ -179,7 +181,7 @@ inline uniform_buffer::uniform_buffer(vertex_buffer_layout const& layout, int32_
     : m_binding_point { binding_point }
     , m_layout { layout }
 {
-    glGenBuffers(1, &m_id);
+    m_id = acquire_name(gl_object::buffer);
     glBindBuffer(GL_UNIFORM_BUFFER, m_id);
     glBufferData(GL_UNIFORM_BUFFER, static_cast<std::ptrdiff_t>(layout.stride()), nullptr, GL_DYNAMIC_DRAW);
     glBindBufferBase(GL_UNIFORM_BUFFER, m_binding_point, m_id);
@@ -205,7 +207,7 @@ inline void uniform_buffer::unbind()
 inline uniform_buffer::~uniform_buffer()
 {
     if (m_id != 0) {
-        glDeleteBuffers(1, &m_id);
+        release_object(gl_object::buffer, m_id);
     }
 }
 
@@ -221,7 +223,7 @@ inline uniform_buffer::uniform_buffer(uniform_buffer&& other) noexcept
 [[nodiscard]] inline auto uniform_buffer::operator=(uniform_buffer&& other) noexcept -> uniform_buffer&
 {
     if (this != &other) {
-        glDeleteBuffers(1, &m_id);
+        release_object(gl_object::buffer, m_id);
         m_id = other.m_id;
         m_binding_point = other.m_binding_point;
         m_layout = std::move(other.m_layout);
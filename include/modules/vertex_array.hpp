@@ -23,13 +23,18 @@
  */
 
 #pragma once
+#include "deletion_queue.hpp"
 #include "gl_functions.hpp"
 #include "index_buffer.hpp"
+#include "name_pool.hpp"
+#include "small_vector.hpp"
+#include "static_layout.hpp"
 #include "vertex_buffer.hpp"
 #include "vertex_buffer_inst.hpp"
 
+#include <array>
+#include <cassert>
 #include <cstdint>
-#include <list>
 #include <optional>
 
 namespace staplegl {
@@ -78,6 +83,7 @@ public:
         , m_vertex_buffers(std::move(other.m_vertex_buffers))
         , m_instanced_vbo(std::move(other.m_instanced_vbo))
         , m_index_buffer(std::move(other.m_index_buffer))
+        , m_binding_strides(other.m_binding_strides)
         , attrib_index(other.attrib_index)
     {
         other.m_id = 0;
@@ -97,6 +103,7 @@ public:
             m_vertex_buffers = std::move(other.m_vertex_buffers);
             m_instanced_vbo = std::move(other.m_instanced_vbo);
             m_index_buffer = std::move(other.m_index_buffer);
+            m_binding_strides = other.m_binding_strides;
             attrib_index = other.attrib_index;
 
             other.m_id = 0;
@@ -105,10 +112,19 @@ public:
     }
 
     /**
-     * @brief Iterator type returned from add_vertex_buffer.
+     * @brief Number of vertex buffers stored inline in a vertex array, more are stored on the heap.
      *
      */
-    using iterator_t = std::list<vertex_buffer>::iterator;
+    static constexpr std::size_t inline_vertex_buffers = 4;
+
+    /**
+     * @brief Stable handle to a vertex buffer of the vertex array, returned from add_vertex_buffer.
+     *
+     * @details Handles stay valid for the lifetime of the vertex array, even if it is moved.
+     */
+    struct buffer_handle {
+        std::uint32_t index {};
+    };
 
     /**
      * @brief Bind the vertex array object.
@@ -126,13 +142,88 @@ public:
      * @brief Add a vertex buffer to the vertex array object.
      * @param vbo the vertex buffer object to add.
      *
-     * @return iterator_t an iterator to the newly added vertex buffer, it is guaranteed
+     * @return buffer_handle a handle to the newly added vertex buffer, it is guaranteed
      * to be valid for the lifetime of the vertex array object, useful to keep track of
      * the individual VBOs.
      *
      * @see vertex_buffer.hpp
      */
-    auto add_vertex_buffer(vertex_buffer&& vbo) -> vertex_array::iterator_t;
+    auto add_vertex_buffer(vertex_buffer&& vbo) -> buffer_handle;
+
+    /**
+     * @brief Add a vertex buffer whose format is known at compile time.
+     *
+     * @details The attributes are set up from the constant stride and offsets of the layout,
+     * the runtime layout of the vertex buffer is ignored and can be left empty. The vertex
+     * buffer takes the stride of the layout, so that its size and mappings are in vertices.
+     *
+     * @param vbo the vertex buffer object to add.
+     * @param layout the layout of the data in the vertex buffer.
+     * @return buffer_handle a handle to the newly added vertex buffer.
+     *
+     * @see static_layout.hpp
+     */
+    template <static_vertex_layout Layout>
+    auto add_vertex_buffer(vertex_buffer&& vbo, Layout layout) -> buffer_handle;
+
+    /**
+     * @brief Maximum number of buffer binding points usable with set_vertex_format.
+     *
+     * @details The minimum GL_MAX_VERTEX_ATTRIB_BINDINGS guaranteed by the specification.
+     */
+    static constexpr std::uint32_t max_bindings = 16;
+
+    /**
+     * @brief Describe a vertex format on a binding point, without attaching a buffer (GL 4.3).
+     *
+     * @details The attributes take the next free attribute indices, as with add_vertex_buffer, but
+     * they read from whichever buffer is attached to the binding point through bind_vertex_buffer.
+     * A single vertex array per vertex format can then draw any number of meshes, switching only
+     * the buffers (and the index buffer, through index_buffer::bind) in between.
+     *
+     * @param binding the binding point, less than max_bindings.
+     * @param layout the format of the vertices.
+     * @param divisor the divisor of the binding point, 0 for per-vertex data, 1 for per-instance data.
+     *
+     * @see https://www.khronos.org/opengl/wiki/Vertex_Specification#Separate_attribute_format
+     */
+    void set_vertex_format(std::uint32_t binding, vertex_buffer_layout const& layout, std::uint32_t divisor = 0);
+
+    /**
+     * @brief Describe a vertex format known at compile time on a binding point (GL 4.3).
+     *
+     * @param binding the binding point, less than max_bindings.
+     * @param layout the format of the vertices.
+     * @param divisor the divisor of the binding point, 0 for per-vertex data, 1 for per-instance data.
+     * @see static_layout.hpp
+     */
+    template <static_vertex_layout Layout>
+    void set_vertex_format(std::uint32_t binding, Layout layout, std::uint32_t divisor = 0);
+
+    /**
+     * @brief Attach a buffer to a binding point described by set_vertex_format.
+     *
+     * @note The vertex array must be bound, the buffer is not owned by the vertex array.
+     *
+     * @param binding the binding point.
+     * @param buffer_id the buffer holding the vertices.
+     * @param offset the offset of the first vertex in the buffer, in bytes.
+     */
+    void bind_vertex_buffer(std::uint32_t binding, std::uint32_t buffer_id, std::size_t offset = 0) const;
+
+    /**
+     * @brief Attach a vertex buffer to a binding point described by set_vertex_format.
+     *
+     * @note The vertex array must be bound, the buffer is not owned by the vertex array.
+     *
+     * @param binding the binding point.
+     * @param vbo the vertex buffer holding the vertices.
+     * @param offset the offset of the first vertex in the buffer, in bytes.
+     */
+    void bind_vertex_buffer(std::uint32_t binding, vertex_buffer const& vbo, std::size_t offset = 0) const
+    {
+        bind_vertex_buffer(binding, vbo.id(), offset);
+    }
 
     /**
      * @brief Set the instance buffer object
@@ -165,11 +256,19 @@ public:
     [[nodiscard]] constexpr auto id() const -> uint32_t { return m_id; }
 
     /**
-     * @brief Get the vertex buffer object at the specified index.
+     * @brief Get the vertex buffer objects of the vertex array.
      *
-     * @return std::list<vertex_buffer>&  the vertex buffer object at the specified index.
+     * @return std::span<vertex_buffer> the vertex buffer objects, in the order they were added.
      */
-    [[nodiscard]] constexpr auto buffers_data() -> std::list<vertex_buffer>& { return m_vertex_buffers; }
+    [[nodiscard]] auto buffers_data() noexcept -> std::span<vertex_buffer> { return m_vertex_buffers.span(); }
+
+    /**
+     * @brief Get a vertex buffer object from its handle.
+     *
+     * @param handle the handle returned from add_vertex_buffer.
+     * @return vertex_buffer& the vertex buffer object.
+     */
+    [[nodiscard]] auto buffer(buffer_handle handle) noexcept -> vertex_buffer& { return m_vertex_buffers[handle.index]; }
 
     /**
      * @brief Get the instance buffer object.
@@ -187,9 +286,10 @@ public:
 
 private:
     std::uint32_t m_id {};
-    std::list<vertex_buffer> m_vertex_buffers;
+    small_vector<vertex_buffer, inline_vertex_buffers> m_vertex_buffers;
     std::optional<vertex_buffer_inst> m_instanced_vbo;
     index_buffer m_index_buffer;
+    std::array<std::uint32_t, max_bindings> m_binding_strides {};
 
     uint32_t attrib_index {};
 };
@@ -202,12 +302,12 @@ private:
 
 inline vertex_array::vertex_array() noexcept
 {
-    glGenVertexArrays(1, &m_id);
+    m_id = acquire_name(gl_object::vertex_array);
 }
 
 inline vertex_array::~vertex_array()
 {
-    glDeleteVertexArrays(1, &m_id);
+    release_object(gl_object::vertex_array, m_id);
 }
 
 inline void vertex_array::bind() const
@@ -220,28 +320,31 @@ inline void vertex_array::unbind()
     glBindVertexArray(0);
 }
 
-inline auto vertex_array::add_vertex_buffer(vertex_buffer&& vbo) -> vertex_array::iterator_t
+inline auto vertex_array::add_vertex_buffer(vertex_buffer&& vbo) -> buffer_handle
 {
-    m_vertex_buffers.push_back(std::move(vbo));
+    vertex_buffer const& vbo_ref = m_vertex_buffers.push_back(std::move(vbo));
     glBindVertexArray(m_id);
 
-    // get a reference to the newly added vertex buffer from the variant in the vector
-    vertex_buffer const& vbo_ref = m_vertex_buffers.back();
-
     vbo_ref.bind();
 
     for (const auto& [name, element_count, offset, type] : vbo_ref.layout().get_attributes()) {
-        glEnableVertexAttribArray(attrib_index);
-        glVertexAttribPointer(
-            attrib_index++,
-            static_cast<int32_t>(shader_data_type::component_count(type) * element_count),
-            shader_data_type::to_opengl_underlying_type(type),
-            GL_FALSE,
-            static_cast<int32_t>(vbo_ref.layout().stride()),
-            reinterpret_cast<const void*>(offset)); // NOLINT (reinterpret-cast)
+        attrib_index += enable_vertex_attribute(attrib_index, type, element_count, vbo_ref.layout().stride(), offset);
     }
 
-    return std::prev(m_vertex_buffers.end());
+    return { static_cast<std::uint32_t>(m_vertex_buffers.size() - 1) };
+}
+
+template <static_vertex_layout Layout>
+inline auto vertex_array::add_vertex_buffer(vertex_buffer&& vbo, Layout /*layout*/) -> buffer_handle
+{
+    vbo.set_stride(Layout::stride());
+    vertex_buffer const& vbo_ref = m_vertex_buffers.push_back(std::move(vbo));
+    glBindVertexArray(m_id);
+
+    vbo_ref.bind();
+    attrib_index = Layout::enable(attrib_index);
+
+    return { static_cast<std::uint32_t>(m_vertex_buffers.size() - 1) };
 }
 
 inline void vertex_array::set_instance_buffer(vertex_buffer_inst&& vbo)
@@ -252,18 +355,42 @@ inline void vertex_array::set_instance_buffer(vertex_buffer_inst&& vbo)
     m_instanced_vbo->bind();
 
     for (const auto& [name, element_count, offset, type] : m_instanced_vbo->layout().get_attributes()) {
-        glEnableVertexAttribArray(attrib_index);
-        glVertexAttribPointer(
-            attrib_index++,
-            static_cast<int32_t>(shader_data_type::component_count(type) * element_count),
-            shader_data_type::to_opengl_underlying_type(type),
-            GL_FALSE,
-            static_cast<int32_t>(m_instanced_vbo->layout().stride()),
-            reinterpret_cast<const void*>(offset)); // NOLINT (reinterpret-cast)
-        glVertexAttribDivisor(attrib_index - 1, 1);
+        attrib_index += enable_vertex_attribute(attrib_index, type, element_count, m_instanced_vbo->layout().stride(), offset, 1);
     }
 }
 
+inline void vertex_array::set_vertex_format(std::uint32_t binding, vertex_buffer_layout const& layout, std::uint32_t divisor)
+{
+    assert(binding < max_bindings);
+
+    glBindVertexArray(m_id);
+    for (const auto& [name, element_count, offset, type] : layout.get_attributes()) {
+        attrib_index += format_vertex_attribute(attrib_index, type, element_count, offset, binding);
+    }
+
+    glVertexBindingDivisor(binding, divisor);
+    m_binding_strides[binding] = static_cast<std::uint32_t>(layout.stride());
+}
+
+template <static_vertex_layout Layout>
+inline void vertex_array::set_vertex_format(std::uint32_t binding, Layout /*layout*/, std::uint32_t divisor)
+{
+    assert(binding < max_bindings);
+
+    glBindVertexArray(m_id);
+    attrib_index = Layout::format(attrib_index, binding);
+
+    glVertexBindingDivisor(binding, divisor);
+    m_binding_strides[binding] = static_cast<std::uint32_t>(Layout::stride());
+}
+
+inline void vertex_array::bind_vertex_buffer(std::uint32_t binding, std::uint32_t buffer_id, std::size_t offset) const
+{
+    assert(binding < max_bindings);
+
+    glBindVertexBuffer(binding, buffer_id, static_cast<GLintptr>(offset), static_cast<std::int32_t>(m_binding_strides[binding]));
+}
+
 inline void vertex_array::set_index_buffer(index_buffer&& ibo)
 {
     m_index_buffer = std::move(ibo);
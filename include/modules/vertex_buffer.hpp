@@ -21,13 +21,22 @@
  */
 
 #pragma once
+#include "deletion_queue.hpp"
 #include "gl_functions.hpp"
+#include "name_pool.hpp"
 #include "vertex_buffer_layout.hpp"
+#include "vertex_reflection.hpp"
 #include <concepts>
+#include <cstddef>
+#include <cstdint>
 #include <functional>
 #include <span>
 #include <utility>
 
+#ifdef STAPLEGL_DEBUG
+#include <cstdio>
+#endif // STAPLEGL_DEBUG
+
 namespace staplegl {
 
 /**
@@ -67,6 +76,39 @@ enum driver_access_specifier {
     READ_WRITE = GL_READ_WRITE
 };
 
+/**
+ * @brief Flags for mapping a range of a buffer, combined with `|`.
+ *
+ * @details Write-only mappings that invalidate what they map never read the previous contents
+ * back, and unsynchronized ones do not wait for the GPU to finish using the buffer, at the cost
+ * of racing with it if it does.
+ *
+ * @see https://www.khronos.org/opengl/wiki/GLAPI/glMapBufferRange
+ */
+enum driver_map_flags : std::uint32_t {
+    MAP_READ = GL_MAP_READ_BIT,
+    MAP_WRITE = GL_MAP_WRITE_BIT,
+    MAP_INVALIDATE_RANGE = GL_MAP_INVALIDATE_RANGE_BIT,
+    MAP_INVALIDATE_BUFFER = GL_MAP_INVALIDATE_BUFFER_BIT,
+    MAP_UNSYNCHRONIZED = GL_MAP_UNSYNCHRONIZED_BIT
+};
+
+/**
+ * @brief How vertex_buffer::stream rewrites the contents of a buffer.
+ *
+ * @details
+ * - `orphan`: the storage is respecified with no data before mapping, the driver hands out fresh
+ * memory while draws still in flight keep reading the old one. Safe, costs an allocation
+ * (usually recycled by the driver).
+ * - `unsynchronized`: the buffer is mapped as is, without waiting for the GPU. The fastest, but
+ * the application must guarantee that no draw in flight reads the buffer (e.g. with fences or
+ * by rotating between several buffers).
+ */
+enum class streaming_mode : std::uint8_t {
+    orphan,
+    unsynchronized
+};
+
 /**
  * @brief Vertex Buffer Object (VBO) wrapper.
  *
@@ -92,6 +134,33 @@ public:
     vertex_buffer(std::span<const float> vertices, vertex_buffer_layout&& layout) noexcept;
     vertex_buffer(std::span<const float> vertices, vertex_buffer_layout&& layout,
         driver_draw_hint hint) noexcept;
+
+    /**
+     * @brief Construct a new vertex buffer object from an array of vertex structs.
+     *
+     * @details The layout is derived from the members of the struct, so it cannot disagree with
+     * the data, and members of any supported type (not just floats) work as is.
+     *
+     * @param vertices the vertices, copied into the GPU's memory.
+     * @param hint the usage hint of the buffer.
+     * @tparam Vertex the vertex struct.
+     *
+     * @see vertex_reflection.hpp
+     */
+    template <reflectable_vertex Vertex>
+        requires(!std::same_as<Vertex, float>)
+    explicit vertex_buffer(std::span<const Vertex> vertices, driver_draw_hint hint = driver_draw_hint::STATIC_DRAW);
+
+    /**
+     * @brief Construct a new vertex buffer object from raw bytes, e.g. packed vertices.
+     *
+     * @param data the vertex data, copied into the GPU's memory.
+     * @param layout the layout of the data.
+     * @param hint the usage hint of the buffer.
+     *
+     * @see vertex_packing.hpp
+     */
+    vertex_buffer(std::span<const std::byte> data, vertex_buffer_layout&& layout, driver_draw_hint hint) noexcept;
     ~vertex_buffer();
 
     // delete copy and assignment, only move is allowed
@@ -116,18 +185,36 @@ public:
     /**
      * @brief Set the layout object
      *
+     * @details The number of vertices is recomputed from the stride of the new layout.
+     *
      * @param layout the layout to be set.
      * @see vertex_buffer_layout.hpp
      */
     void set_layout(const vertex_buffer_layout& layout);
     [[nodiscard]] constexpr auto layout() const -> const vertex_buffer_layout&;
 
+    /**
+     * @brief Set the size of a vertex, without a runtime layout.
+     *
+     * @details For buffers whose format is only known at compile time, see static_layout.hpp.
+     * The number of vertices is recomputed from the new stride.
+     *
+     * @param stride the size of a vertex, in bytes.
+     */
+    void set_stride(std::size_t stride) noexcept;
+
+    /**
+     * @brief Get the size of a vertex, in bytes.
+     *
+     */
+    [[nodiscard]] constexpr auto stride() const noexcept -> std::size_t { return m_stride; }
+
     /**
      * @brief Give new data to the vertex buffer object, overwriting the old one.
      *
      * @param vertices std::span<const float> the new data to be given to the vertex buffer object.
      */
-    void set_data(std::span<const float> vertices) const noexcept;
+    void set_data(std::span<const float> vertices) noexcept;
 
     /**
      * @brief Give new data to the vertex buffer object, overwriting the old one. Also re-specify the hint.
@@ -137,7 +224,17 @@ public:
      *
      * @see driver_draw_hint
      */
-    void set_data(std::span<const float> vertices, driver_draw_hint hint) const noexcept;
+    void set_data(std::span<const float> vertices, driver_draw_hint hint) noexcept;
+
+    /**
+     * @brief Give new vertex structs to the vertex buffer object, overwriting the old ones.
+     *
+     * @param vertices the new vertices, of the struct the buffer was created with.
+     * @tparam Vertex the vertex struct.
+     */
+    template <reflectable_vertex Vertex>
+        requires(!std::same_as<Vertex, float>)
+    void set_data(std::span<const Vertex> vertices) noexcept;
 
     // UTILITIES
 
@@ -168,7 +265,7 @@ public:
      *
      * @return std::size_t the number of bytes the underlying OpenGL buffer takes up (assuming packed data).
      */
-    [[nodiscard]] constexpr auto size_bytes() const noexcept -> std::size_t { return m_size * m_layout.stride(); }
+    [[nodiscard]] constexpr auto size_bytes() const noexcept -> std::size_t { return m_size * m_stride; }
 
     // APPLY FUNCTION
 
@@ -195,11 +292,55 @@ public:
     template <plain_old_data T>
     void apply(const std::function<void(std::span<T> vertices)>& func, driver_access_specifier access_specifier = staplegl::READ_WRITE) noexcept;
 
+    /**
+     * @brief Applies a function to a range of the vertices, mapped with explicit flags.
+     *
+     * @details Unlike the whole-buffer overload, this maps only what is needed, and lets
+     * write-only updates skip both the readback and (with MAP_INVALIDATE_RANGE or
+     * MAP_UNSYNCHRONIZED) the wait for the GPU.
+     *
+     * @param func the function to be applied to the mapped vertices.
+     * @param first the index of the first mapped element, in units of T.
+     * @param count the number of mapped elements.
+     * @param map_flags a combination of driver_map_flags, e.g. `MAP_WRITE | MAP_INVALIDATE_RANGE`.
+     * @tparam T a type that represents a vertex of the vertex buffer object.
+     *
+     * @see driver_map_flags
+     */
+    template <plain_old_data T>
+    void apply(const std::function<void(std::span<T> vertices)>& func, std::size_t first, std::size_t count, std::uint32_t map_flags) noexcept;
+
+    /**
+     * @brief Rewrite every vertex of the buffer, without reading the old ones back.
+     *
+     * @details The buffer is mapped write-only, according to the streaming mode of the buffer,
+     * hence `func` must write all the vertices it is given: their previous values are undefined.
+     *
+     * @param func the function writing the vertices.
+     * @tparam T a type that represents a vertex of the vertex buffer object.
+     *
+     * @see streaming_mode
+     */
+    template <plain_old_data T>
+    void stream(const std::function<void(std::span<T> vertices)>& func) noexcept;
+
+    /**
+     * @brief Detach the storage of the buffer, replacing it with fresh, uninitialized storage of the same size.
+     *
+     */
+    void orphan() noexcept;
+
+    void set_streaming_mode(streaming_mode mode) noexcept { m_streaming_mode = mode; }
+    [[nodiscard]] constexpr auto get_streaming_mode() const noexcept -> streaming_mode { return m_streaming_mode; }
+
 protected:
     std::uint32_t m_id {};
     staplegl::driver_draw_hint m_hint {};
     vertex_buffer_layout m_layout;
+    std::size_t m_stride {}; ///< the stride of the layout, or of the static layout the buffer is used with.
     std::size_t m_size {};
+    std::size_t m_capacity {}; ///< size of the storage, in bytes.
+    streaming_mode m_streaming_mode { streaming_mode::orphan };
 };
 
 /*
@@ -212,13 +353,27 @@ inline vertex_buffer::vertex_buffer(std::span<const float> vertices, vertex_buff
     driver_draw_hint hint) noexcept
     : m_hint(hint)
     , m_layout(std::move(layout))
-    , m_size((m_layout.stride()) ? vertices.size_bytes() / m_layout.stride() : static_cast<size_t>(0))
+    , m_stride(m_layout.stride())
+    , m_size((m_stride) ? vertices.size_bytes() / m_stride : static_cast<size_t>(0))
+    , m_capacity(vertices.size_bytes())
 {
-    glGenBuffers(1, &m_id);
+    m_id = acquire_name(gl_object::buffer);
     glBindBuffer(GL_ARRAY_BUFFER, m_id);
     glBufferData(GL_ARRAY_BUFFER, static_cast<ptrdiff_t>(vertices.size_bytes()), vertices.data(), hint);
 }
 
+inline vertex_buffer::vertex_buffer(std::span<const std::byte> data, vertex_buffer_layout&& layout, driver_draw_hint hint) noexcept
+    : m_hint(hint)
+    , m_layout(std::move(layout))
+    , m_stride(m_layout.stride())
+    , m_size((m_stride) ? data.size() / m_stride : static_cast<size_t>(0))
+    , m_capacity(data.size())
+{
+    m_id = acquire_name(gl_object::buffer);
+    glBindBuffer(GL_ARRAY_BUFFER, m_id);
+    glBufferData(GL_ARRAY_BUFFER, static_cast<ptrdiff_t>(data.size()), data.data(), hint);
+}
+
 inline vertex_buffer::vertex_buffer(std::span<const float> vertices, driver_draw_hint hint) noexcept
     : vertex_buffer(vertices, vertex_buffer_layout {}, hint)
 {
@@ -234,10 +389,24 @@ inline vertex_buffer::vertex_buffer(std::span<const float> vertices) noexcept
 {
 }
 
+template <reflectable_vertex Vertex>
+    requires(!std::same_as<Vertex, float>)
+inline vertex_buffer::vertex_buffer(std::span<const Vertex> vertices, driver_draw_hint hint)
+    : m_hint(hint)
+    , m_layout(layout_of<Vertex>())
+    , m_stride(m_layout.stride())
+    , m_size(vertices.size())
+    , m_capacity(vertices.size_bytes())
+{
+    m_id = acquire_name(gl_object::buffer);
+    glBindBuffer(GL_ARRAY_BUFFER, m_id);
+    glBufferData(GL_ARRAY_BUFFER, static_cast<ptrdiff_t>(vertices.size_bytes()), vertices.data(), hint);
+}
+
 inline vertex_buffer::~vertex_buffer()
 {
     if (m_id != 0) {
-        glDeleteBuffers(1, &m_id);
+        release_object(gl_object::buffer, m_id);
     }
 }
 
@@ -245,7 +414,10 @@ inline vertex_buffer::vertex_buffer(vertex_buffer&& other) noexcept
     : m_id { other.m_id }
     , m_hint { other.m_hint }
     , m_layout { std::move(other.m_layout) }
+    , m_stride { other.m_stride }
     , m_size { other.m_size }
+    , m_capacity { other.m_capacity }
+    , m_streaming_mode { other.m_streaming_mode }
 {
     other.m_id = 0;
 }
@@ -253,11 +425,14 @@ inline vertex_buffer::vertex_buffer(vertex_buffer&& other) noexcept
 inline auto vertex_buffer::operator=(vertex_buffer&& other) noexcept -> vertex_buffer&
 {
     if (this != &other) {
-        glDeleteBuffers(1, &m_id);
+        release_object(gl_object::buffer, m_id);
         m_id = other.m_id;
-        m_layout = other.m_layout;
+        m_layout = std::move(other.m_layout);
         m_hint = other.m_hint;
+        m_stride = other.m_stride;
         m_size = other.m_size;
+        m_capacity = other.m_capacity;
+        m_streaming_mode = other.m_streaming_mode;
 
         other.m_id = 0;
     }
@@ -278,6 +453,13 @@ inline void vertex_buffer::unbind()
 inline void vertex_buffer::set_layout(const vertex_buffer_layout& layout)
 {
     m_layout = layout;
+    set_stride(m_layout.stride());
+}
+
+inline void vertex_buffer::set_stride(std::size_t stride) noexcept
+{
+    m_stride = stride;
+    m_size = (m_stride) ? m_capacity / m_stride : static_cast<size_t>(0);
 }
 
 [[nodiscard]] constexpr auto vertex_buffer::layout() const -> const vertex_buffer_layout&
@@ -285,18 +467,30 @@ inline void vertex_buffer::set_layout(const vertex_buffer_layout& layout)
     return m_layout;
 }
 
-inline void vertex_buffer::set_data(std::span<const float> vertices) const noexcept
+inline void vertex_buffer::set_data(std::span<const float> vertices) noexcept
 {
 
     this->set_data(vertices, m_hint);
 }
 
-inline void vertex_buffer::set_data(std::span<const float> vertices, driver_draw_hint hint) const noexcept
+inline void vertex_buffer::set_data(std::span<const float> vertices, driver_draw_hint hint) noexcept
 {
+    m_size = (m_stride) ? vertices.size_bytes() / m_stride : static_cast<size_t>(0);
+    m_capacity = vertices.size_bytes();
     glBindBuffer(GL_ARRAY_BUFFER, m_id);
     glBufferData(GL_ARRAY_BUFFER, static_cast<ptrdiff_t>(vertices.size_bytes()), vertices.data(), hint);
 }
 
+template <reflectable_vertex Vertex>
+    requires(!std::same_as<Vertex, float>)
+inline void vertex_buffer::set_data(std::span<const Vertex> vertices) noexcept
+{
+    m_size = vertices.size();
+    m_capacity = vertices.size_bytes();
+    glBindBuffer(GL_ARRAY_BUFFER, m_id);
+    glBufferData(GL_ARRAY_BUFFER, static_cast<ptrdiff_t>(vertices.size_bytes()), vertices.data(), m_hint);
+}
+
 template <plain_old_data T>
 void vertex_buffer::apply(const std::function<void(std::span<T> vertices)>& func, driver_access_specifier access_specifier) noexcept
 {
@@ -308,4 +502,47 @@ void vertex_buffer::apply(const std::function<void(std::span<T> vertices)>& func
     glUnmapBuffer(GL_ARRAY_BUFFER);
 }
 
+template <plain_old_data T>
+void vertex_buffer::apply(const std::function<void(std::span<T> vertices)>& func, std::size_t first, std::size_t count, std::uint32_t map_flags) noexcept
+{
+    if (count == 0) {
+        return;
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, m_id);
+
+    void* data = glMapBufferRange(GL_ARRAY_BUFFER, static_cast<GLintptr>(first * sizeof(T)),
+        static_cast<GLsizeiptr>(count * sizeof(T)), map_flags);
+    if (data == nullptr) [[unlikely]] {
+#ifdef STAPLEGL_DEBUG
+        std::fprintf(stderr, STAPLEGL_LINEINFO ", failed to map range [%zu, %zu) of buffer %u\n",
+            first * sizeof(T), (first + count) * sizeof(T), m_id);
+#endif // STAPLEGL_DEBUG
+        return;
+    }
+
+    func(std::span { static_cast<T*>(data), count });
+
+    glUnmapBuffer(GL_ARRAY_BUFFER);
+}
+
+template <plain_old_data T>
+void vertex_buffer::stream(const std::function<void(std::span<T> vertices)>& func) noexcept
+{
+    auto const count = m_size * m_stride / sizeof(T);
+
+    if (m_streaming_mode == streaming_mode::orphan) {
+        orphan();
+        apply<T>(func, 0, count, MAP_WRITE | MAP_INVALIDATE_BUFFER);
+    } else {
+        apply<T>(func, 0, count, MAP_WRITE | MAP_INVALIDATE_RANGE | MAP_UNSYNCHRONIZED);
+    }
+}
+
+inline void vertex_buffer::orphan() noexcept
+{
+    glBindBuffer(GL_ARRAY_BUFFER, m_id);
+    glBufferData(GL_ARRAY_BUFFER, static_cast<ptrdiff_t>(m_capacity), nullptr, m_hint);
+}
+
 } // namespace staplegl
\ No newline at end of file
@@ -18,7 +18,9 @@
 
 #pragma once
 
+#include "deletion_queue.hpp"
 #include "gl_functions.hpp"
+#include "name_pool.hpp"
 #include "vertex_buffer.hpp"
 #include "vertex_buffer_layout.hpp"
 
@@ -56,12 +58,6 @@ namespace staplegl {
 class vertex_buffer_inst : public vertex_buffer {
 
 private:
-    /**
-     * @brief The capacity of the buffer, in bytes.
-     *
-     */
-    std::size_t m_capacity {};
-
     /**
      * @brief The number of instances in the buffer.
      *
@@ -108,8 +104,7 @@ private:
         // 4. copy new buffer to old buffer
         // 5. delete new buffer
 
-        std::uint32_t new_id {};
-        glGenBuffers(1, &new_id);
+        std::uint32_t const new_id = acquire_name(gl_object::buffer);
 
         glBindBuffer(GL_COPY_WRITE_BUFFER, new_id);
         glBufferData(GL_COPY_WRITE_BUFFER, static_cast<ptrdiff_t>(old_capacity), nullptr, m_hint);
@@ -127,7 +122,7 @@ private:
 
         glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, static_cast<ptrdiff_t>(m_count * m_layout.stride()));
 
-        glDeleteBuffers(1, &new_id);
+        release_object(gl_object::buffer, new_id);
         glBindBuffer(GL_ARRAY_BUFFER, m_id);
         this->m_capacity = new_capacity;
     }
@@ -135,12 +130,10 @@ private:
 public:
     vertex_buffer_inst(std::span<const float> instance_data,
         vertex_buffer_layout&& layout) noexcept
-        : vertex_buffer { instance_data, std::move(layout), driver_draw_hint::DYNAMIC_DRAW }
-        , m_capacity { instance_data.size() } {};
+        : vertex_buffer { instance_data, std::move(layout), driver_draw_hint::DYNAMIC_DRAW } {};
 
     vertex_buffer_inst(std::span<const float> instance_data) noexcept
-        : vertex_buffer { instance_data, driver_draw_hint::DYNAMIC_DRAW }
-        , m_capacity { instance_data.size() } {};
+        : vertex_buffer { instance_data, driver_draw_hint::DYNAMIC_DRAW } {};
 
     ~vertex_buffer_inst() noexcept = default;
 
@@ -150,6 +143,17 @@ public:
     vertex_buffer_inst(vertex_buffer_inst&&) noexcept = default;
     [[nodiscard]] auto operator=(vertex_buffer_inst&&) noexcept -> vertex_buffer_inst& = default;
 
+    /**
+     * @brief Set the layout of an instance, the number of instances is kept.
+     *
+     * @param layout the layout to be set.
+     */
+    void set_layout(const vertex_buffer_layout& layout)
+    {
+        vertex_buffer::set_layout(layout);
+        m_size = static_cast<std::size_t>(m_count);
+    }
+
     /**
      * @brief Add an instance to the buffer.
      *
@@ -168,6 +172,27 @@ public:
      */
     auto delete_instance(std::int32_t index) noexcept -> int32_t;
 
+    /**
+     * @brief Grow the buffer so that it can hold at least the given number of instances.
+     *
+     * @details Similarly to `std::vector::reserve`, this avoids the repeated regrowth of the buffer
+     * when the number of instances to be added is known in advance. Does nothing if the buffer
+     * is already large enough.
+     *
+     * @param instances the number of instances the buffer should be able to hold.
+     */
+    void reserve(std::size_t instances) noexcept;
+
+    /**
+     * @brief Set the number of instances, growing the buffer if needed.
+     *
+     * @details Similarly to `std::vector::resize`, but the new instances are left uninitialized:
+     * this is meant for buffers whose contents are rewritten as a whole, e.g. with stream().
+     *
+     * @param instances the new number of instances.
+     */
+    void resize(std::size_t instances) noexcept;
+
     /**
      * @brief Update the data of an instance in the buffer.
      *
@@ -208,6 +233,22 @@ inline void vertex_buffer_inst::add_instance(std::span<const float> instance_dat
     ++m_size;
 }
 
+inline void vertex_buffer_inst::reserve(std::size_t instances) noexcept
+{
+    auto const new_capacity = instances * instance_size();
+
+    if (new_capacity > m_capacity) {
+        resize_buffer(m_capacity, new_capacity);
+    }
+}
+
+inline void vertex_buffer_inst::resize(std::size_t instances) noexcept
+{
+    reserve(instances);
+    m_count = static_cast<std::int32_t>(instances);
+    m_size = instances;
+}
+
 inline void vertex_buffer_inst::update_instance(std::int32_t index, std::span<const float> instance_data) noexcept
 {
 #ifdef STAPLEGL_DEBUG
@@ -17,9 +17,13 @@
  */
 #pragma once
 
+#include "gl_functions.hpp"
+
+#include <cstdint>
 #include <span>
 #include <string>
 #include <string_view>
+#include <utility>
 #include <vector>
 
 #include "shader_data_type.hpp"
@@ -63,6 +67,107 @@ struct vertex_attribute {
     auto operator=(vertex_attribute&&) noexcept -> vertex_attribute& = default;
 };
 
+namespace detail {
+
+    struct attribute_columns_t {
+        std::uint32_t columns;
+        std::int32_t components;
+        std::size_t column_size;
+    };
+
+    // matrices are passed as columns of (padded) vec4s, one attribute index each.
+    constexpr auto attribute_columns(shader_data_type::u_type type) noexcept -> attribute_columns_t
+    {
+        using shader_data_type::u_type;
+
+        switch (type) {
+        case u_type::mat3:
+            return { 3, 3, shader_data_type::size(u_type::vec4) };
+        case u_type::mat4:
+            return { 4, 4, shader_data_type::size(u_type::vec4) };
+        default:
+            return { 1, static_cast<std::int32_t>(shader_data_type::component_count(type)), shader_data_type::size(type) };
+        }
+    }
+
+} // namespace detail
+
+/**
+ * @brief Enable a vertex attribute and describe its format to the bound vertex array.
+ *
+ * @details Picks the right entry point for the type: glVertexAttribIPointer for integer types,
+ * glVertexAttribPointer (normalizing fixed-point types where needed) for everything else.
+ * Matrices take one attribute index per column, arrays one per element.
+ *
+ * @note The vertex buffer holding the data must be bound to GL_ARRAY_BUFFER.
+ *
+ * @param index the (first) attribute index.
+ * @param type the type of the attribute.
+ * @param element_count the number of elements, for array attributes.
+ * @param stride the stride of the layout, in bytes.
+ * @param offset the offset of the attribute, in bytes.
+ * @param divisor the attribute divisor, 0 for per-vertex data.
+ * @return std::uint32_t the number of attribute indices used.
+ */
+inline auto enable_vertex_attribute(std::uint32_t index, shader_data_type::u_type type, std::size_t element_count,
+    std::size_t stride, std::size_t offset, std::uint32_t divisor = 0) noexcept -> std::uint32_t
+{
+    auto const [columns, components, column_size] = detail::attribute_columns(type);
+    auto const locations = static_cast<std::uint32_t>(columns * element_count);
+    for (std::uint32_t i = 0; i < locations; ++i) {
+        auto const* pointer = reinterpret_cast<const void*>(offset + i * column_size); // NOLINT (reinterpret-cast)
+
+        glEnableVertexAttribArray(index + i);
+        if (shader_data_type::is_integer(type)) {
+            glVertexAttribIPointer(index + i, components, shader_data_type::to_opengl_underlying_type(type),
+                static_cast<std::int32_t>(stride), pointer);
+        } else {
+            glVertexAttribPointer(index + i, components, shader_data_type::to_opengl_underlying_type(type),
+                shader_data_type::is_normalized(type) ? GL_TRUE : GL_FALSE, static_cast<std::int32_t>(stride), pointer);
+        }
+
+        if (divisor != 0) {
+            glVertexAttribDivisor(index + i, divisor);
+        }
+    }
+
+    return locations;
+}
+
+/**
+ * @brief Describe the format of a vertex attribute and attach it to a binding point (GL 4.3).
+ *
+ * @details Unlike enable_vertex_attribute, no buffer is involved: the data comes from whichever
+ * buffer is attached to the binding point through glBindVertexBuffer, which also sets the stride.
+ *
+ * @param index the (first) attribute index.
+ * @param type the type of the attribute.
+ * @param element_count the number of elements, for array attributes.
+ * @param relative_offset the offset of the attribute within a vertex, in bytes.
+ * @param binding the binding point the attribute reads from.
+ * @return std::uint32_t the number of attribute indices used.
+ */
+inline auto format_vertex_attribute(std::uint32_t index, shader_data_type::u_type type, std::size_t element_count,
+    std::size_t relative_offset, std::uint32_t binding) noexcept -> std::uint32_t
+{
+    auto const [columns, components, column_size] = detail::attribute_columns(type);
+    auto const locations = static_cast<std::uint32_t>(columns * element_count);
+    for (std::uint32_t i = 0; i < locations; ++i) {
+        auto const offset = static_cast<std::uint32_t>(relative_offset + i * column_size);
+
+        glEnableVertexAttribArray(index + i);
+        if (shader_data_type::is_integer(type)) {
+            glVertexAttribIFormat(index + i, components, shader_data_type::to_opengl_underlying_type(type), offset);
+        } else {
+            glVertexAttribFormat(index + i, components, shader_data_type::to_opengl_underlying_type(type),
+                shader_data_type::is_normalized(type) ? GL_TRUE : GL_FALSE, offset);
+        }
+        glVertexAttribBinding(index + i, binding);
+    }
+
+    return locations;
+}
+
 /**
  * @brief Vertex buffer layout.
  *
@@ -90,7 +195,18 @@ public:
      * @see vertex_attribute
      */
     vertex_buffer_layout(std::initializer_list<vertex_attribute> attributes)
-        : m_attributes { attributes }
+        : vertex_buffer_layout { std::vector<vertex_attribute> { attributes } }
+    {
+    }
+
+    /**
+     * @brief Construct a new vertex buffer layout object from attributes only known at runtime.
+     *
+     * @param attributes the vertex attributes, offsets are computed by the layout.
+     * @see vertex_attribute
+     */
+    explicit vertex_buffer_layout(std::vector<vertex_attribute> attributes)
+        : m_attributes { std::move(attributes) }
     {
         for (auto& attribute : m_attributes) {
             attribute.offset = m_stride;
@@ -98,6 +214,21 @@ public:
         }
     }
 
+    /**
+     * @brief Construct a new vertex buffer layout object whose offsets are already known.
+     *
+     * @details Useful when the data is not tightly packed, e.g. a struct with padding.
+     *
+     * @param attributes the vertex attributes, with their offsets set.
+     * @param stride the distance between two consecutive vertices, in bytes.
+     * @see vertex_reflection.hpp
+     */
+    vertex_buffer_layout(std::vector<vertex_attribute> attributes, std::size_t stride)
+        : m_attributes { std::move(attributes) }
+        , m_stride { stride }
+    {
+    }
+
     /**
      * @brief Get the stride of the vertex buffer layout.
      *
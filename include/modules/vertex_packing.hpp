@@ -0,0 +1,438 @@
+/**
+ * @file vertex_packing.hpp
+ * @author Dario Loi
+ * @brief CPU-side vertex compression.
+ *
+ * @date 2026-10-17
+ *
+ * @copyright MIT License
+ *
+ * @details Meshes usually arrive as float32 data, like `teapot_vertices`: 32 bytes per vertex for a
+ * position, a normal and a texture coordinate. This module packs them into the compact attribute
+ * types of shader_data_type, halving the vertex bandwidth:
+ *
+ * - positions are quantized to 16 bits against the bounding box of the mesh (`ushort4_norm`),
+ *   the shader rescales them with the uniforms of position_dequantization;
+ * - normals are octahedral-encoded into two 16-bit components (`short2_norm`);
+ * - texture coordinates are converted to half floats (`half2`).
+ *
+ * The other attributes are copied as they are, and all attributes keep their order, hence their
+ * shader locations. The packed layout is returned along with the data, decoding only takes
+ * the GLSL functions in packing_glsl:
+ *
+ * @code{.glsl}
+ * layout(location = 0) in vec3 aPos;    // quantized, in [0, 1]
+ * layout(location = 1) in vec2 aNormal; // octahedral
+ *
+ * vec3 position = dequantize_position(aPos);
+ * vec3 normal = decode_octahedral(aNormal);
+ * @endcode
+ *
+ * The kernels work on one component at a time over contiguous arrays, using SSE2 (and F16C for
+ * half floats, when enabled at compile time) with a scalar fallback.
+ *
+ * @see shader_data_type.hpp
+ */
+
+#pragma once
+
+#include "shader.hpp"
+#include "shader_data_type.hpp"
+#include "vertex_buffer.hpp"
+#include "vertex_buffer_layout.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define STAPLEGL_PACKING_SSE2
+#include <emmintrin.h>
+#endif
+
+#ifdef __F16C__
+#include <immintrin.h>
+#endif
+
+#ifdef STAPLEGL_DEBUG
+#include <cstdio>
+#endif // STAPLEGL_DEBUG
+
+namespace staplegl {
+
+/**
+ * @brief GLSL functions decoding the packed attributes.
+ *
+ */
+inline constexpr std::string_view packing_glsl = R"glsl(
+uniform vec3 u_position_offset;
+uniform vec3 u_position_scale;
+
+vec3 dequantize_position(vec3 quantized)
+{
+    return u_position_offset + quantized * u_position_scale;
+}
+
+vec3 decode_octahedral(vec2 encoded)
+{
+    vec3 n = vec3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+    float t = max(-n.z, 0.0);
+    n.xy += mix(vec2(t), vec2(-t), greaterThanEqual(n.xy, vec2(0.0)));
+    return normalize(n);
+}
+)glsl";
+
+/**
+ * @brief Which attributes of the source layout hold the data to compress.
+ *
+ */
+struct vertex_streams {
+    std::size_t position {};          ///< index of the vec3 position attribute.
+    std::optional<std::size_t> normal; ///< index of the vec3 normal attribute, if any.
+    std::optional<std::size_t> uv;     ///< index of the vec2 texture coordinate attribute, if any.
+};
+
+/**
+ * @brief Maps quantized positions back to object space: `offset + quantized * scale`.
+ *
+ */
+struct position_dequantization {
+    std::array<float, 3> offset {};
+    std::array<float, 3> scale {};
+
+    /**
+     * @brief Upload the dequantization parameters, the program must be bound.
+     *
+     * @param program the shader program using packing_glsl.
+     */
+    void upload(shader_program& program) const
+    {
+        program.upload_uniform3f("u_position_offset", offset[0], offset[1], offset[2]);
+        program.upload_uniform3f("u_position_scale", scale[0], scale[1], scale[2]);
+    }
+};
+
+/**
+ * @brief Size of a mesh before and after packing.
+ *
+ */
+struct packing_report {
+    std::size_t vertex_count {};
+    std::size_t source_bytes {};
+    std::size_t packed_bytes {};
+
+    [[nodiscard]] constexpr auto bytes_saved() const noexcept -> std::size_t { return source_bytes - packed_bytes; }
+    [[nodiscard]] constexpr auto ratio() const noexcept -> double
+    {
+        return source_bytes != 0 ? static_cast<double>(packed_bytes) / static_cast<double>(source_bytes) : 1.0;
+    }
+};
+
+/**
+ * @brief A packed mesh, ready to be uploaded.
+ *
+ */
+struct packed_mesh {
+    std::vector<std::byte> data;
+    vertex_buffer_layout layout;
+    position_dequantization dequantization;
+    packing_report report;
+
+    /**
+     * @brief Create a vertex buffer holding the packed data.
+     *
+     * @param hint the usage hint of the buffer.
+     * @return vertex_buffer a buffer with the packed data and layout.
+     */
+    [[nodiscard]] auto make_buffer(driver_draw_hint hint = driver_draw_hint::STATIC_DRAW) const -> vertex_buffer
+    {
+        return vertex_buffer { std::span<const std::byte> { data }, vertex_buffer_layout { layout }, hint };
+    }
+};
+
+/**
+ * @brief Pack a float32 mesh into compact attribute types.
+ *
+ * @param vertices the interleaved vertex data.
+ * @param layout the layout of the data.
+ * @param streams which attributes are the position, the normal and the texture coordinate.
+ * @return std::optional<packed_mesh> the packed mesh, empty if the streams do not refer to
+ * attributes of the right type (vec3 position and normal, vec2 texture coordinate).
+ */
+[[nodiscard]] inline auto pack_vertices(std::span<const float> vertices, vertex_buffer_layout const& layout,
+    vertex_streams const& streams) -> std::optional<packed_mesh>;
+
+/*
+
+        IMPLEMENTATIONS
+
+*/
+
+namespace detail {
+
+    // float to half, rounding to nearest even (F. Giesen's float_to_half_fast3_rtne).
+    inline auto float_to_half(float value) noexcept -> std::uint16_t
+    {
+        auto bits = std::bit_cast<std::uint32_t>(value);
+        std::uint32_t const sign = (bits >> 16U) & 0x8000U;
+        bits &= 0x7FFFFFFFU;
+
+        std::uint32_t half {};
+        if (bits >= 0x47800000U) { // out of range: infinity, NaN stays NaN
+            half = bits > 0x7F800000U ? 0x7E00U : 0x7C00U;
+        } else if (bits < 0x38800000U) { // subnormal or zero, let the FPU round
+            auto const shifted = std::bit_cast<float>(bits) + 0.5F;
+            half = std::bit_cast<std::uint32_t>(shifted) - 0x3F000000U;
+        } else {
+            std::uint32_t const odd = (bits >> 13U) & 1U;
+            bits += 0xC8000FFFU + odd; // rebias the exponent and round
+            half = bits >> 13U;
+        }
+
+        return static_cast<std::uint16_t>(sign | half);
+    }
+
+    inline auto bounds(std::span<const float> values) noexcept -> std::pair<float, float>
+    {
+        float low = std::numeric_limits<float>::max();
+        float high = std::numeric_limits<float>::lowest();
+        std::size_t i = 0;
+
+#ifdef STAPLEGL_PACKING_SSE2
+        __m128 low4 = _mm_set1_ps(low);
+        __m128 high4 = _mm_set1_ps(high);
+        for (; i + 4 <= values.size(); i += 4) {
+            __m128 const value = _mm_loadu_ps(&values[i]);
+            low4 = _mm_min_ps(low4, value);
+            high4 = _mm_max_ps(high4, value);
+        }
+
+        std::array<float, 4> lows {};
+        std::array<float, 4> highs {};
+        _mm_storeu_ps(lows.data(), low4);
+        _mm_storeu_ps(highs.data(), high4);
+        low = *std::min_element(lows.begin(), lows.end());
+        high = *std::max_element(highs.begin(), highs.end());
+#endif // STAPLEGL_PACKING_SSE2
+
+        for (; i < values.size(); ++i) {
+            low = std::min(low, values[i]);
+            high = std::max(high, values[i]);
+        }
+        return { low, high };
+    }
+
+    // out = round((in - offset) * scale), clamped to [0, 65535].
+    inline void quantize_unorm16(std::span<const float> in, float offset, float scale, std::span<std::uint16_t> out) noexcept
+    {
+        std::size_t i = 0;
+
+#ifdef STAPLEGL_PACKING_SSE2
+        __m128 const offset4 = _mm_set1_ps(offset);
+        __m128 const scale4 = _mm_set1_ps(scale);
+        __m128 const zero = _mm_setzero_ps();
+        __m128 const max = _mm_set1_ps(65535.0F);
+        __m128i const bias = _mm_set1_epi32(32768);
+        for (; i + 8 <= in.size(); i += 8) {
+            __m128 const lo = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(&in[i]), offset4), scale4), zero), max);
+            __m128 const hi = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(&in[i + 4]), offset4), scale4), zero), max);
+
+            // SSE2 only packs with signed saturation, shift to the signed range and back.
+            __m128i const packed = _mm_packs_epi32(_mm_sub_epi32(_mm_cvtps_epi32(lo), bias), _mm_sub_epi32(_mm_cvtps_epi32(hi), bias));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(&out[i]), _mm_xor_si128(packed, _mm_set1_epi16(static_cast<std::int16_t>(0x8000)))); // NOLINT (reinterpret-cast)
+        }
+#endif // STAPLEGL_PACKING_SSE2
+
+        for (; i < in.size(); ++i) {
+            out[i] = static_cast<std::uint16_t>(std::lround(std::clamp((in[i] - offset) * scale, 0.0F, 65535.0F)));
+        }
+    }
+
+    // octahedral encoding of (x, y, z) into (u, v), as signed normalized 16-bit integers.
+    inline void encode_octahedral(std::span<const float> x, std::span<const float> y, std::span<const float> z,
+        std::span<std::int16_t> u, std::span<std::int16_t> v) noexcept
+    {
+        std::size_t i = 0;
+
+#ifdef STAPLEGL_PACKING_SSE2
+        __m128 const sign_mask = _mm_set1_ps(-0.0F);
+        __m128 const one = _mm_set1_ps(1.0F);
+        __m128 const snorm = _mm_set1_ps(32767.0F);
+        for (; i + 4 <= x.size(); i += 4) {
+            __m128 nx = _mm_loadu_ps(&x[i]);
+            __m128 ny = _mm_loadu_ps(&y[i]);
+            __m128 const nz = _mm_loadu_ps(&z[i]);
+
+            // project onto the octahedron |x| + |y| + |z| = 1.
+            __m128 const l1 = _mm_add_ps(_mm_add_ps(_mm_andnot_ps(sign_mask, nx), _mm_andnot_ps(sign_mask, ny)), _mm_andnot_ps(sign_mask, nz));
+            __m128 const inverse = _mm_div_ps(one, _mm_max_ps(l1, _mm_set1_ps(std::numeric_limits<float>::min())));
+            nx = _mm_mul_ps(nx, inverse);
+            ny = _mm_mul_ps(ny, inverse);
+
+            // fold the lower hemisphere over the diagonals.
+            __m128 const sign_x = _mm_or_ps(_mm_and_ps(nx, sign_mask), one);
+            __m128 const sign_y = _mm_or_ps(_mm_and_ps(ny, sign_mask), one);
+            __m128 const folded_x = _mm_mul_ps(_mm_sub_ps(one, _mm_andnot_ps(sign_mask, ny)), sign_x);
+            __m128 const folded_y = _mm_mul_ps(_mm_sub_ps(one, _mm_andnot_ps(sign_mask, nx)), sign_y);
+            __m128 const lower = _mm_cmplt_ps(nz, _mm_setzero_ps());
+            nx = _mm_or_ps(_mm_and_ps(lower, folded_x), _mm_andnot_ps(lower, nx));
+            ny = _mm_or_ps(_mm_and_ps(lower, folded_y), _mm_andnot_ps(lower, ny));
+
+            __m128i const ux = _mm_cvtps_epi32(_mm_mul_ps(nx, snorm));
+            __m128i const vy = _mm_cvtps_epi32(_mm_mul_ps(ny, snorm));
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(&u[i]), _mm_packs_epi32(ux, ux)); // NOLINT (reinterpret-cast)
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(&v[i]), _mm_packs_epi32(vy, vy)); // NOLINT (reinterpret-cast)
+        }
+#endif // STAPLEGL_PACKING_SSE2
+
+        for (; i < x.size(); ++i) {
+            float const l1 = std::max(std::abs(x[i]) + std::abs(y[i]) + std::abs(z[i]), std::numeric_limits<float>::min());
+            float nx = x[i] / l1;
+            float ny = y[i] / l1;
+            if (z[i] < 0.0F) {
+                float const folded_x = (1.0F - std::abs(ny)) * std::copysign(1.0F, nx);
+                ny = (1.0F - std::abs(nx)) * std::copysign(1.0F, ny);
+                nx = folded_x;
+            }
+
+            u[i] = static_cast<std::int16_t>(std::lround(std::clamp(nx, -1.0F, 1.0F) * 32767.0F));
+            v[i] = static_cast<std::int16_t>(std::lround(std::clamp(ny, -1.0F, 1.0F) * 32767.0F));
+        }
+    }
+
+    inline void to_half(std::span<const float> in, std::span<std::uint16_t> out) noexcept
+    {
+        std::size_t i = 0;
+
+#ifdef __F16C__
+        for (; i + 8 <= in.size(); i += 8) {
+            __m128i const lo = _mm_cvtps_ph(_mm_loadu_ps(&in[i]), _MM_FROUND_TO_NEAREST_INT);
+            __m128i const hi = _mm_cvtps_ph(_mm_loadu_ps(&in[i + 4]), _MM_FROUND_TO_NEAREST_INT);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(&out[i]), _mm_unpacklo_epi64(lo, hi)); // NOLINT (reinterpret-cast)
+        }
+#endif // __F16C__
+
+        for (; i < in.size(); ++i) {
+            out[i] = float_to_half(in[i]);
+        }
+    }
+
+    // copies one component of an interleaved stream into a contiguous array.
+    inline void gather(std::span<const float> vertices, std::size_t stride, std::size_t offset, std::span<float> out) noexcept
+    {
+        for (std::size_t i = 0; i < out.size(); ++i) {
+            out[i] = vertices[i * stride + offset];
+        }
+    }
+
+} // namespace detail
+
+inline auto pack_vertices(std::span<const float> vertices, vertex_buffer_layout const& layout,
+    vertex_streams const& streams) -> std::optional<packed_mesh>
+{
+    using shader_data_type::u_type;
+
+    auto const attributes = layout.get_attributes();
+    auto const is = [&attributes](std::optional<std::size_t> index, u_type type) {
+        return !index.has_value() || (*index < attributes.size() && attributes[*index].type == type && attributes[*index].element_count == 1);
+    };
+
+    if (layout.stride() == 0 || layout.stride() % sizeof(float) != 0 || !is(streams.position, u_type::vec3)
+        || !is(streams.normal, u_type::vec3) || !is(streams.uv, u_type::vec2)) [[unlikely]] {
+#ifdef STAPLEGL_DEBUG
+        std::fprintf(stderr, STAPLEGL_LINEINFO ", the vertex streams do not match the layout\n");
+#endif // STAPLEGL_DEBUG
+        return std::nullopt;
+    }
+
+    std::size_t const stride = layout.stride() / sizeof(float);
+    std::size_t const count = vertices.size() / stride;
+
+    // packed layout: the same attributes in the same order, with compact types for the streams.
+    std::vector<vertex_attribute> packed_attributes { attributes.begin(), attributes.end() };
+    packed_attributes[streams.position].type = u_type::ushort4_norm;
+    if (streams.normal) {
+        packed_attributes[*streams.normal].type = u_type::short2_norm;
+    }
+    if (streams.uv) {
+        packed_attributes[*streams.uv].type = u_type::half2;
+    }
+
+    packed_mesh mesh { .data = {}, .layout = vertex_buffer_layout { std::move(packed_attributes) }, .dequantization = {}, .report = {} };
+    std::size_t const packed_stride = mesh.layout.stride();
+    mesh.data.resize(count * packed_stride);
+
+    auto const column = [&](std::size_t attribute, std::size_t component, std::span<float> out) {
+        detail::gather(vertices, stride, attributes[attribute].offset / sizeof(float) + component, out);
+    };
+    auto const scatter = [&](std::size_t attribute, std::size_t component, auto const& values) {
+        std::size_t const offset = mesh.layout[attribute].offset + component * sizeof(values[0]);
+        for (std::size_t i = 0; i < count; ++i) {
+            std::memcpy(&mesh.data[i * packed_stride + offset], &values[i], sizeof(values[0]));
+        }
+    };
+
+    std::vector<float> x(count);
+    std::vector<float> y(count);
+    std::vector<float> z(count);
+    std::vector<std::uint16_t> unorm(count);
+
+    // positions, against the bounding box.
+    for (std::size_t axis = 0; axis < 3; ++axis) {
+        column(streams.position, axis, x);
+        auto const [low, high] = count != 0 ? detail::bounds(x) : std::pair { 0.0F, 0.0F };
+        float const extent = high - low;
+
+        mesh.dequantization.offset[axis] = low;
+        mesh.dequantization.scale[axis] = extent;
+        detail::quantize_unorm16(x, low, extent > 0.0F ? 65535.0F / extent : 0.0F, unorm);
+        scatter(streams.position, axis, unorm);
+    }
+
+    if (streams.normal) {
+        column(*streams.normal, 0, x);
+        column(*streams.normal, 1, y);
+        column(*streams.normal, 2, z);
+
+        std::vector<std::int16_t> u(count);
+        std::vector<std::int16_t> v(count);
+        detail::encode_octahedral(x, y, z, u, v);
+        scatter(*streams.normal, 0, u);
+        scatter(*streams.normal, 1, v);
+    }
+
+    if (streams.uv) {
+        for (std::size_t component = 0; component < 2; ++component) {
+            column(*streams.uv, component, x);
+            detail::to_half(x, unorm);
+            scatter(*streams.uv, component, unorm);
+        }
+    }
+
+    // everything else is copied as is.
+    for (std::size_t attribute = 0; attribute < attributes.size(); ++attribute) {
+        if (attribute == streams.position || attribute == streams.normal || attribute == streams.uv) {
+            continue;
+        }
+
+        std::size_t const size = shader_data_type::size(attributes[attribute].type) * attributes[attribute].element_count;
+        for (std::size_t i = 0; i < count; ++i) {
+            std::memcpy(&mesh.data[i * packed_stride + mesh.layout[attribute].offset],
+                &vertices[i * stride + attributes[attribute].offset / sizeof(float)], size);
+        }
+    }
+
+    mesh.report = { .vertex_count = count, .source_bytes = count * layout.stride(), .packed_bytes = mesh.data.size() };
+    return mesh;
+}
+
+} // namespace staplegl
@@ -0,0 +1,259 @@
+/**
+ * @file vertex_reflection.hpp
+ * @author Dario Loi
+ * @brief Vertex buffer layouts derived from vertex structs.
+ *
+ * @date 2026-10-17
+ *
+ * @copyright MIT License
+ *
+ * @details Describing a layout by hand next to a `std::span<const float>` of data lets the two
+ * silently disagree. This module derives the layout from the vertex type itself: the members
+ * of a plain aggregate are enumerated through structured bindings, each member type is mapped
+ * to a shader data type and the offsets follow the C++ layout rules, padding included.
+ *
+ * @code{.cpp}
+ * struct vertex {
+ *     glm::vec3 position;
+ *     glm::vec3 normal;
+ *     glm::vec2 uv;
+ * };
+ *
+ * std::vector<vertex> vertices = load_model();
+ * staplegl::vertex_buffer VBO { std::span<const vertex> { vertices } }; // layout: vec3, vec3, vec2
+ * @endcode
+ *
+ * Supported members are scalars, `std::array<T, N>` and vector types exposing a `value_type`
+ * (like glm's) of float or integer components, integers being read by the shader as integers.
+ * Other types, e.g. normalized or packed data, can be added by specializing staplegl::vertex_member. C arrays are not supported, as brace elision makes their
+ * elements indistinguishable from separate members, use `std::array` instead.
+ *
+ * @see vertex_buffer_layout.hpp
+ */
+
+#pragma once
+
+#include "shader_data_type.hpp"
+#include "vertex_buffer_layout.hpp"
+
+#include <array>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <optional>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace staplegl {
+
+/**
+ * @brief Maps the type of a member of a vertex struct to a shader data type.
+ *
+ * @details Specializations provide a `static constexpr shader_data_type::u_type type`, types
+ * without a specialization cannot appear in a reflected vertex struct.
+ *
+ * @tparam T the type of the member.
+ */
+template <typename T>
+struct vertex_member { };
+
+namespace detail {
+
+    // the attribute type made of N components of type Scalar, if there is one.
+    template <typename Scalar, std::size_t N>
+    constexpr auto vector_type() noexcept -> std::optional<shader_data_type::u_type>
+    {
+        using shader_data_type::u_type;
+
+        constexpr auto pick = [](std::array<std::optional<u_type>, 4> by_count) { return by_count[N - 1]; };
+        if constexpr (N < 1 || N > 4) {
+            return std::nullopt;
+        } else if constexpr (std::same_as<Scalar, float>) {
+            return pick({ u_type::float32, u_type::vec2, u_type::vec3, u_type::vec4 });
+        } else if constexpr (std::same_as<Scalar, std::int32_t>) {
+            return pick({ u_type::int32, u_type::ivec2, u_type::ivec3, u_type::ivec4 });
+        } else if constexpr (std::same_as<Scalar, std::uint32_t>) {
+            return pick({ u_type::uint32, u_type::uvec2, u_type::uvec3, u_type::uvec4 });
+        } else if constexpr (std::same_as<Scalar, std::int16_t>) {
+            return pick({ std::nullopt, u_type::short2, std::nullopt, u_type::short4 });
+        } else if constexpr (std::same_as<Scalar, std::uint16_t>) {
+            return pick({ std::nullopt, u_type::ushort2, std::nullopt, u_type::ushort4 });
+        } else if constexpr (std::same_as<Scalar, std::int8_t>) {
+            return pick({ std::nullopt, std::nullopt, std::nullopt, u_type::byte4 });
+        } else if constexpr (std::same_as<Scalar, std::uint8_t>) {
+            return pick({ std::nullopt, std::nullopt, std::nullopt, u_type::ubyte4 });
+        } else {
+            return std::nullopt;
+        }
+    }
+
+    template <typename Scalar, std::size_t N>
+    struct vector_member { };
+
+    template <typename Scalar, std::size_t N>
+        requires(vector_type<Scalar, N>().has_value())
+    struct vector_member<Scalar, N> {
+        static constexpr shader_data_type::u_type type = *vector_type<Scalar, N>();
+    };
+
+} // namespace detail
+
+// scalars, integers are read by the shader as integers.
+template <typename T>
+    requires std::is_arithmetic_v<T>
+struct vertex_member<T> : detail::vector_member<T, 1> { };
+
+// std::array and the vector types of math libraries, e.g. glm::vec3 or glm::ivec4.
+template <typename T>
+    requires std::is_arithmetic_v<typename T::value_type> && std::is_trivially_copyable_v<T>
+    && (sizeof(T) % sizeof(typename T::value_type) == 0)
+struct vertex_member<T> : detail::vector_member<typename T::value_type, sizeof(T) / sizeof(typename T::value_type)> { };
+
+/**
+ * @brief Concept for the types that can be a member of a reflected vertex struct.
+ *
+ */
+template <typename T>
+concept vertex_member_type = requires { { vertex_member<T>::type } -> std::convertible_to<shader_data_type::u_type>; };
+
+/**
+ * @brief Concept for the vertex structs whose layout can be derived automatically.
+ *
+ */
+template <typename T>
+concept reflectable_vertex = std::is_aggregate_v<T> && std::is_standard_layout_v<T> && std::is_trivially_copyable_v<T>;
+
+/**
+ * @brief Derive the layout of a vertex struct.
+ *
+ * @details Attribute i describes the i-th member of the struct, with its offset and the
+ * stride of the struct, so that padding between or after the members is honoured.
+ *
+ * @tparam Vertex the vertex struct.
+ * @param names the names of the attributes (for debugging purposes), can be shorter than the
+ * number of members.
+ * @return vertex_buffer_layout the layout of a buffer of Vertex.
+ */
+template <reflectable_vertex Vertex>
+[[nodiscard]] auto layout_of(std::initializer_list<std::string_view> names = {}) -> vertex_buffer_layout;
+
+/*
+
+        IMPLEMENTATIONS
+
+*/
+
+namespace detail {
+
+    template <typename... Ts>
+    struct type_list { };
+
+    // converts to anything, so that T { any_field {}... } only compiles for at most as many fields as T has.
+    struct any_field {
+        template <typename T>
+        constexpr operator T() const noexcept; // NOLINT (implicit conversion is the point)
+    };
+
+    template <typename T, typename... Fields>
+    constexpr auto field_count() noexcept -> std::size_t
+    {
+        if constexpr (requires { T { Fields {}..., any_field {} }; }) {
+            return field_count<T, Fields..., any_field>();
+        } else {
+            return sizeof...(Fields);
+        }
+    }
+
+    // only ever used in unevaluated contexts, to name the member types.
+    template <typename T>
+    auto member_types(T& value)
+    {
+        constexpr std::size_t count = field_count<T>();
+        static_assert(count >= 1 && count <= 12, "vertex structs must have between 1 and 12 members");
+
+        if constexpr (count == 1) {
+            auto& [m0] = value;
+            return type_list<std::remove_cvref_t<decltype(m0)>> {};
+        } else if constexpr (count == 2) {
+            auto& [m0, m1] = value;
+            return type_list<std::remove_cvref_t<decltype(m0)>, std::remove_cvref_t<decltype(m1)>> {};
+        } else if constexpr (count == 3) {
+            auto& [m0, m1, m2] = value;
+            return type_list<std::remove_cvref_t<decltype(m0)>, std::remove_cvref_t<decltype(m1)>, std::remove_cvref_t<decltype(m2)>> {};
+        } else if constexpr (count == 4) {
+            auto& [m0, m1, m2, m3] = value;
+            return type_list<std::remove_cvref_t<decltype(m0)>, std::remove_cvref_t<decltype(m1)>, std::remove_cvref_t<decltype(m2)>, std::remove_cvref_t<decltype(m3)>> {};
+        } else if constexpr (count == 5) {
+            auto& [m0, m1, m2, m3, m4] = value;
+            return type_list<std::remove_cvref_t<decltype(m0)>, std::remove_cvref_t<decltype(m1)>, std::remove_cvref_t<decltype(m2)>, std::remove_cvref_t<decltype(m3)>, std::remove_cvref_t<decltype(m4)>> {};
+        } else if constexpr (count == 6) {
+            auto& [m0, m1, m2, m3, m4, m5] = value;
+            return type_list<std::remove_cvref_t<decltype(m0)>, std::remove_cvref_t<decltype(m1)>, std::remove_cvref_t<decltype(m2)>, std::remove_cvref_t<decltype(m3)>, std::remove_cvref_t<decltype(m4)>, std::remove_cvref_t<decltype(m5)>> {};
+        } else if constexpr (count == 7) {
+            auto& [m0, m1, m2, m3, m4, m5, m6] = value;
+            return type_list<std::remove_cvref_t<decltype(m0)>, std::remove_cvref_t<decltype(m1)>, std::remove_cvref_t<decltype(m2)>, std::remove_cvref_t<decltype(m3)>, std::remove_cvref_t<decltype(m4)>, std::remove_cvref_t<decltype(m5)>, std::remove_cvref_t<decltype(m6)>> {};
+        } else if constexpr (count == 8) {
+            auto& [m0, m1, m2, m3, m4, m5, m6, m7] = value;
+            return type_list<std::remove_cvref_t<decltype(m0)>, std::remove_cvref_t<decltype(m1)>, std::remove_cvref_t<decltype(m2)>, std::remove_cvref_t<decltype(m3)>, std::remove_cvref_t<decltype(m4)>, std::remove_cvref_t<decltype(m5)>, std::remove_cvref_t<decltype(m6)>, std::remove_cvref_t<decltype(m7)>> {};
+        } else if constexpr (count == 9) {
+            auto& [m0, m1, m2, m3, m4, m5, m6, m7, m8] = value;
+            return type_list<std::remove_cvref_t<decltype(m0)>, std::remove_cvref_t<decltype(m1)>, std::remove_cvref_t<decltype(m2)>, std::remove_cvref_t<decltype(m3)>, std::remove_cvref_t<decltype(m4)>, std::remove_cvref_t<decltype(m5)>, std::remove_cvref_t<decltype(m6)>, std::remove_cvref_t<decltype(m7)>, std::remove_cvref_t<decltype(m8)>> {};
+        } else if constexpr (count == 10) {
+            auto& [m0, m1, m2, m3, m4, m5, m6, m7, m8, m9] = value;
+            return type_list<std::remove_cvref_t<decltype(m0)>, std::remove_cvref_t<decltype(m1)>, std::remove_cvref_t<decltype(m2)>, std::remove_cvref_t<decltype(m3)>, std::remove_cvref_t<decltype(m4)>, std::remove_cvref_t<decltype(m5)>, std::remove_cvref_t<decltype(m6)>, std::remove_cvref_t<decltype(m7)>, std::remove_cvref_t<decltype(m8)>, std::remove_cvref_t<decltype(m9)>> {};
+        } else if constexpr (count == 11) {
+            auto& [m0, m1, m2, m3, m4, m5, m6, m7, m8, m9, m10] = value;
+            return type_list<std::remove_cvref_t<decltype(m0)>, std::remove_cvref_t<decltype(m1)>, std::remove_cvref_t<decltype(m2)>, std::remove_cvref_t<decltype(m3)>, std::remove_cvref_t<decltype(m4)>, std::remove_cvref_t<decltype(m5)>, std::remove_cvref_t<decltype(m6)>, std::remove_cvref_t<decltype(m7)>, std::remove_cvref_t<decltype(m8)>, std::remove_cvref_t<decltype(m9)>, std::remove_cvref_t<decltype(m10)>> {};
+        } else if constexpr (count == 12) {
+            auto& [m0, m1, m2, m3, m4, m5, m6, m7, m8, m9, m10, m11] = value;
+            return type_list<std::remove_cvref_t<decltype(m0)>, std::remove_cvref_t<decltype(m1)>, std::remove_cvref_t<decltype(m2)>, std::remove_cvref_t<decltype(m3)>, std::remove_cvref_t<decltype(m4)>, std::remove_cvref_t<decltype(m5)>, std::remove_cvref_t<decltype(m6)>, std::remove_cvref_t<decltype(m7)>, std::remove_cvref_t<decltype(m8)>, std::remove_cvref_t<decltype(m9)>, std::remove_cvref_t<decltype(m10)>, std::remove_cvref_t<decltype(m11)>> {};
+        }
+    }
+
+    struct reflected_member {
+        shader_data_type::u_type type;
+        std::uint32_t offset;
+    };
+
+    template <typename... Members>
+    constexpr auto reflect_members(type_list<Members...> /*unused*/) noexcept
+    {
+        static_assert((vertex_member_type<Members> && ...), "unsupported vertex member type, see staplegl::vertex_member");
+
+        constexpr std::array<std::size_t, sizeof...(Members)> sizes { sizeof(Members)... };
+        constexpr std::array<std::size_t, sizeof...(Members)> alignments { alignof(Members)... };
+        std::array<reflected_member, sizeof...(Members)> members { reflected_member { vertex_member<Members>::type, 0 }... };
+
+        std::size_t offset {};
+        for (std::size_t i = 0; i < members.size(); ++i) {
+            offset = (offset + alignments[i] - 1) / alignments[i] * alignments[i];
+            members[i].offset = static_cast<std::uint32_t>(offset);
+            offset += sizes[i];
+        }
+        return members;
+    }
+
+    template <typename Vertex>
+    inline constexpr auto reflected_members = reflect_members(decltype(member_types(std::declval<Vertex&>())) {});
+
+} // namespace detail
+
+template <reflectable_vertex Vertex>
+inline auto layout_of(std::initializer_list<std::string_view> names) -> vertex_buffer_layout
+{
+    constexpr auto const& members = detail::reflected_members<Vertex>;
+
+    std::vector<vertex_attribute> attributes;
+    attributes.reserve(members.size());
+    for (std::size_t i = 0; i < members.size(); ++i) {
+        auto& attribute = attributes.emplace_back(members[i].type, i < names.size() ? names.begin()[i] : std::string_view {});
+        attribute.offset = members[i].offset;
+    }
+
+    return vertex_buffer_layout { std::move(attributes), sizeof(Vertex) };
+}
+
+} // namespace staplegl
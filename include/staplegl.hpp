@@ -17,16 +17,34 @@
 
 #pragma once
 
+#include "modules/async_readback.hpp"
+#include "modules/command_buffer.hpp"
+#include "modules/command_queue.hpp"
 #include "modules/cubemap.hpp"
+#include "modules/deletion_queue.hpp"
 #include "modules/framebuffer.hpp"
+#include "modules/gpu_profiler.hpp"
+#include "modules/image_writer.hpp"
 #include "modules/index_buffer.hpp"
+#include "modules/instance_bvh.hpp"
+#include "modules/instance_shadow.hpp"
+#include "modules/lod.hpp"
+#include "modules/name_pool.hpp"
+#include "modules/resolution_scaler.hpp"
 #include "modules/shader.hpp"
+#include "modules/state_cache.hpp"
+#include "modules/static_layout.hpp"
 #include "modules/texture.hpp"
+#include "modules/thread_pool.hpp"
+#include "modules/tiled_renderer.hpp"
+#include "modules/transform_packing.hpp"
 #include "modules/uniform_buffer.hpp"
 #include "modules/vertex_array.hpp"
 #include "modules/vertex_buffer.hpp"
 #include "modules/vertex_buffer_inst.hpp"
 #include "modules/vertex_buffer_layout.hpp"
+#include "modules/vertex_packing.hpp"
+#include "modules/vertex_reflection.hpp"
 #include "modules/renderbuffer.hpp"
 
 /*
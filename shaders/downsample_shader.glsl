@@ -23,31 +23,44 @@ layout(location = 0) out vec3 downsample;
 
 uniform vec2 uResolution;
 
+// the part of the scene texture that was rendered to, see resolution_scaler.hpp.
+uniform vec2 uUVScale;
+
 layout(binding = 1) uniform sampler2D scene;
 
+// samples outside of the rendered part are clamped to its edge, like those outside of the texture.
+// a little more than half a texel in, filtering at the exact texel center can still round some
+// weight onto the stale texel next to it.
+vec3 sample_scene(vec2 uv)
+{
+    vec2 uv_max = uUVScale - 0.51F / vec2(textureSize(scene, 0));
+    return texture(scene, min(uv, uv_max)).rgb;
+}
+
 void main()
 {
+    vec2 uv = TexCoord * uUVScale;
 
     vec2 src_uv = 1.0F / uResolution;
     float x = src_uv.x;
     float y = src_uv.y;
 
-    vec3 a = texture(scene, vec2(TexCoord.x - 2 * x, TexCoord.y + 2 * y)).rgb;
-    vec3 b = texture(scene, vec2(TexCoord.x, TexCoord.y + 2 * y)).rgb;
-    vec3 c = texture(scene, vec2(TexCoord.x + 2 * x, TexCoord.y + 2 * y)).rgb;
+    vec3 a = sample_scene(vec2(uv.x - 2 * x, uv.y + 2 * y));
+    vec3 b = sample_scene(vec2(uv.x, uv.y + 2 * y));
+    vec3 c = sample_scene(vec2(uv.x + 2 * x, uv.y + 2 * y));
 
-    vec3 d = texture(scene, vec2(TexCoord.x - 2 * x, TexCoord.y)).rgb;
-    vec3 e = texture(scene, vec2(TexCoord.x, TexCoord.y)).rgb;
-    vec3 f = texture(scene, vec2(TexCoord.x + 2 * x, TexCoord.y)).rgb;
+    vec3 d = sample_scene(vec2(uv.x - 2 * x, uv.y));
+    vec3 e = sample_scene(vec2(uv.x, uv.y));
+    vec3 f = sample_scene(vec2(uv.x + 2 * x, uv.y));
 
-    vec3 g = texture(scene, vec2(TexCoord.x - 2 * x, TexCoord.y - 2 * y)).rgb;
-    vec3 h = texture(scene, vec2(TexCoord.x, TexCoord.y - 2 * y)).rgb;
-    vec3 i = texture(scene, vec2(TexCoord.x + 2 * x, TexCoord.y - 2 * y)).rgb;
+    vec3 g = sample_scene(vec2(uv.x - 2 * x, uv.y - 2 * y));
+    vec3 h = sample_scene(vec2(uv.x, uv.y - 2 * y));
+    vec3 i = sample_scene(vec2(uv.x + 2 * x, uv.y - 2 * y));
 
-    vec3 j = texture(scene, vec2(TexCoord.x - x, TexCoord.y + y)).rgb;
-    vec3 k = texture(scene, vec2(TexCoord.x + x, TexCoord.y + y)).rgb;
-    vec3 l = texture(scene, vec2(TexCoord.x - x, TexCoord.y - y)).rgb;
-    vec3 m = texture(scene, vec2(TexCoord.x + x, TexCoord.y - y)).rgb;
+    vec3 j = sample_scene(vec2(uv.x - x, uv.y + y));
+    vec3 k = sample_scene(vec2(uv.x + x, uv.y + y));
+    vec3 l = sample_scene(vec2(uv.x - x, uv.y - y));
+    vec3 m = sample_scene(vec2(uv.x + x, uv.y - y));
 
     downsample = e * 0.125;
     downsample += (a + c + g + i) * 0.03125;
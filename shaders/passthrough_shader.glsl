@@ -21,9 +21,14 @@ layout(location = 0) in vec2 TexCoord;
 
 layout(binding = 1) uniform sampler2D scene;
 
+// the part of the scene texture that was rendered to, see resolution_scaler.hpp.
+uniform vec2 uUVScale;
+
 layout(location = 0) out vec3 outColor;
 
 void main()
 {
-    outColor = vec3(texture(scene, TexCoord));
+    // clamped a little more than half a texel inside, see downsample_shader.glsl.
+    vec2 uv_max = uUVScale - 0.51F / vec2(textureSize(scene, 0));
+    outColor = vec3(texture(scene, min(TexCoord * uUVScale, uv_max)));
 }
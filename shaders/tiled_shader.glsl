@@ -0,0 +1,31 @@
+#type vertex
+
+#version 420 core
+
+layout(location = 0) in vec3 aPos;
+layout(location = 1) in vec3 instancePos;
+
+layout(location = 0) out vec3 pos;
+
+// maps the tile being rendered to the whole viewport, identity when rendering in one go.
+uniform mat4 u_tile;
+
+void main()
+{
+    pos = aPos + vec3(instancePos.xy, 0.0);
+    gl_Position = u_tile * vec4(pos, 1.0);
+}
+
+#type fragment
+
+#version 420 core
+
+layout(location = 0) in vec3 pos;
+
+layout(location = 0) out vec4 FragColor;
+
+void main()
+{
+    // a smooth gradient across the whole image, so that misplaced tiles stand out.
+    FragColor = vec4(pos.x * 0.5 + 0.5, pos.y * 0.5 + 0.5, 1.0 - abs(pos.x * pos.y), 1.0);
+}
@@ -23,6 +23,10 @@ layout(location = 0) out vec4 FragColor;
 layout(binding = 1) uniform sampler2D scene;
 layout(binding = 2) uniform sampler2D bloom;
 
+// the part of the scene and bloom textures that was rendered to, see resolution_scaler.hpp.
+// drawn to the whole screen, it is upscaled by the linear filtering of the textures.
+uniform vec2 uUVScale;
+
 float luminance(vec3 v)
 {
     return dot(v, vec3(0.2126f, 0.7152f, 0.0722f));
@@ -52,8 +56,10 @@ vec3 aces(vec3 v)
 void main()
 {
     const float gamma = 2.2F;
-    vec3 hdrColor = texture(scene, TexCoord).rgb;
-    vec3 bloomColor = texture(bloom, TexCoord).rgb;
+    // clamped a little more than half a texel inside, see downsample_shader.glsl.
+    vec2 uv = min(TexCoord * uUVScale, uUVScale - 0.51F / vec2(textureSize(scene, 0)));
+    vec3 hdrColor = texture(scene, uv).rgb;
+    vec3 bloomColor = texture(bloom, uv).rgb;
 
     // exposure tone mapping and gamma correction
 
@@ -22,24 +22,38 @@ layout(location = 0) in vec2 TexCoord;
 layout(binding = 1) uniform sampler2D scene;
 layout(location = 0) out vec3 outColor;
 
+// the part of the scene texture that was rendered to, see resolution_scaler.hpp.
+uniform vec2 uUVScale;
+
+// samples outside of the rendered part are clamped to its edge, like those outside of the texture.
+// a little more than half a texel in, filtering at the exact texel center can still round some
+// weight onto the stale texel next to it.
+vec3 sample_scene(vec2 uv)
+{
+    vec2 uv_max = uUVScale - 0.51F / vec2(textureSize(scene, 0));
+    return texture(scene, min(uv, uv_max)).rgb;
+}
+
 void main()
 {
+    vec2 uv = TexCoord * uUVScale;
     vec3 upsample = vec3(0.F);
 
-    float x = 0.003F; // sample distance
-    float y = 0.003F;
+    // sample distance, relative to the rendered part so that the bloom keeps its size on screen.
+    float x = 0.003F * uUVScale.x;
+    float y = 0.003F * uUVScale.y;
 
-    vec3 a = texture(scene, vec2(TexCoord.x - x, TexCoord.y + y)).rgb;
-    vec3 b = texture(scene, vec2(TexCoord.x, TexCoord.y + y)).rgb;
-    vec3 c = texture(scene, vec2(TexCoord.x + x, TexCoord.y + y)).rgb;
+    vec3 a = sample_scene(vec2(uv.x - x, uv.y + y));
+    vec3 b = sample_scene(vec2(uv.x, uv.y + y));
+    vec3 c = sample_scene(vec2(uv.x + x, uv.y + y));
 
-    vec3 d = texture(scene, vec2(TexCoord.x - x, TexCoord.y)).rgb;
-    vec3 e = texture(scene, vec2(TexCoord.x, TexCoord.y)).rgb;
-    vec3 f = texture(scene, vec2(TexCoord.x + x, TexCoord.y)).rgb;
+    vec3 d = sample_scene(vec2(uv.x - x, uv.y));
+    vec3 e = sample_scene(vec2(uv.x, uv.y));
+    vec3 f = sample_scene(vec2(uv.x + x, uv.y));
 
-    vec3 g = texture(scene, vec2(TexCoord.x - x, TexCoord.y - y)).rgb;
-    vec3 h = texture(scene, vec2(TexCoord.x, TexCoord.y - y)).rgb;
-    vec3 i = texture(scene, vec2(TexCoord.x + x, TexCoord.y - y)).rgb;
+    vec3 g = sample_scene(vec2(uv.x - x, uv.y - y));
+    vec3 h = sample_scene(vec2(uv.x, uv.y - y));
+    vec3 i = sample_scene(vec2(uv.x + x, uv.y - y));
 
     upsample = e * 4.0;
     upsample += (b + d + f + h) * 2.0;
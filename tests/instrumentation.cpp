@@ -0,0 +1,465 @@
+/**
+ * @file instrumentation.cpp
+ * @author Dario Loi
+ * @brief Checks of the wrappers against the mock backend, no OpenGL context needed.
+ *
+ * @date 2026-10-17
+ *
+ * @copyright MIT License
+ *
+ * @details Built with `STAPLEGL_INSTRUMENT`: every call goes through
+ * staplegl::instrument::mock_gl, which records it instead of reaching a driver. The checks
+ * assert on the recorded calls, e.g. that a code path reaches the backend at all (a call that
+ * bypasses the wrappers would go straight to an unloaded entry point and crash). <br>
+ *
+ * Usage: `instrumentation`, exits with a non-zero status if a check fails.
+ */
+
+#include "staplegl.hpp"
+
+#include "gl_recorder.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <cstring>
+#include <source_location>
+#include <span>
+#include <vector>
+
+namespace {
+
+using namespace staplegl::instrument;
+using namespace staplegl::shader_data_type;
+
+bool failed {};
+
+void expect(bool condition, char const* what, std::source_location const where = std::source_location::current())
+{
+    if (!condition) {
+        std::fprintf(stderr, "%s:%u: check failed: %s\n", where.file_name(), where.line(), what);
+        failed = true;
+    }
+}
+
+auto count(mock_gl const& mock, gl_call call) -> std::size_t
+{
+    return static_cast<std::size_t>(std::ranges::count(mock.calls(), call, &call_record::call));
+}
+
+auto last(mock_gl const& mock, gl_call call) -> call_record
+{
+    auto const calls = mock.calls();
+    auto const found = std::ranges::find(calls.rbegin(), calls.rend(), call, &call_record::call);
+    return found == calls.rend() ? call_record {} : *found;
+}
+
+// a vertex buffer is sized in vertices of the layout it is used with, static or set later.
+void static_layout_buffer()
+{
+    mock_gl mock;
+    scoped_backend const guard { mock };
+
+    using layout_3P_3N = staplegl::static_layout<staplegl::attr<u_type::vec3, "aPos">, staplegl::attr<u_type::vec3, "aNormal">>;
+    std::array<float, 24> const vertices {};
+
+    staplegl::vertex_array vao;
+    vao.add_vertex_buffer(staplegl::vertex_buffer { vertices }, layout_3P_3N {});
+    auto& vbo = vao.buffers_data().front();
+    expect(vbo.size() == 4 && vbo.size_bytes() == sizeof(vertices), "static layout buffer size");
+
+    std::size_t mapped {};
+    vbo.apply<std::array<float, 6>>([&mapped](std::span<std::array<float, 6>> data) { mapped = data.size(); });
+    expect(mapped == 4, "static layout buffer mapping");
+
+    staplegl::vertex_buffer later { vertices };
+    later.set_layout({ { u_type::vec3, "aPos" }, { u_type::vec3, "aNormal" } });
+    expect(later.size() == 4, "size recomputed by set_layout");
+}
+
+// attributes of a vertex buffer, integer ones read as integers.
+void vertex_attributes()
+{
+    mock_gl mock;
+    scoped_backend const guard { mock };
+
+    std::array<float, 8> const vertices {};
+    staplegl::vertex_array vao;
+    vao.add_vertex_buffer({ vertices, { { u_type::vec4, "position" }, { u_type::ivec4, "ids" } } });
+
+    expect(count(mock, gl_call::vertex_attrib_pointer) == 1, "float attribute");
+    expect(count(mock, gl_call::vertex_attrib_i_pointer) == 1, "integer attribute");
+
+    auto const attribute = last(mock, gl_call::vertex_attrib_i_pointer);
+    expect(attribute.arg<std::uint32_t>(0) == 1 && attribute.arg<std::int32_t>(1) == 4, "integer attribute location and size");
+    expect(attribute.arg<std::int32_t>(3) == 32, "integer attribute stride");
+}
+
+// separate vertex formats, attached to their buffers through binding points.
+void vertex_format()
+{
+    mock_gl mock;
+    scoped_backend const guard { mock };
+
+    std::array<float, 6> const positions {};
+    staplegl::vertex_array vao;
+    staplegl::vertex_buffer const vbo { positions, staplegl::driver_draw_hint::STATIC_DRAW };
+    vao.set_vertex_format(0, staplegl::vertex_buffer_layout { { u_type::vec3, "position" } });
+    vao.set_vertex_format(1, staplegl::vertex_buffer_layout { { u_type::ivec4, "ids" } }, 1);
+    vao.bind_vertex_buffer(0, vbo, 16);
+
+    expect(count(mock, gl_call::vertex_attrib_format) == 1, "one float attribute formatted");
+    expect(count(mock, gl_call::vertex_attrib_i_format) == 1, "one integer attribute formatted");
+    expect(count(mock, gl_call::vertex_attrib_binding) == 2, "both attributes attached to a binding");
+    expect(last(mock, gl_call::vertex_binding_divisor).arg<std::uint32_t>(1) == 1, "divisor of the second binding");
+
+    auto const bind = last(mock, gl_call::bind_vertex_buffer);
+    expect(bind.call == gl_call::bind_vertex_buffer, "buffer attached to the binding point");
+    expect(bind.arg<std::uint32_t>(1) == vbo.id(), "attached buffer name");
+    expect(bind.arg<std::int64_t>(2) == 16, "binding offset");
+    expect(bind.arg<std::int32_t>(3) == 12, "binding stride, from the format");
+
+    // the attached buffer is renamed on replay, like any other name argument.
+    mock_gl target;
+    scoped_backend const replay_guard { target };
+    replayer replay;
+    replay.replay(mock.log());
+    expect(last(target, gl_call::bind_vertex_buffer).arg<std::uint32_t>(1) == replay.remap(object_kind::buffer, vbo.id()),
+        "attached buffer remapped on replay");
+}
+
+// more vertex buffers than are stored inline, and a move of the vertex array holding them.
+void many_vertex_buffers()
+{
+    mock_gl mock;
+    scoped_backend const guard { mock };
+
+    constexpr std::size_t buffers = staplegl::vertex_array::inline_vertex_buffers * 2 + 1;
+    std::array<float, 4> const vertices {};
+    staplegl::vertex_array vao;
+    std::array<staplegl::vertex_array::buffer_handle, buffers> handles {};
+    std::array<std::uint32_t, buffers> names {};
+    for (std::size_t i = 0; i < buffers; ++i) {
+        handles.at(i) = vao.add_vertex_buffer({ vertices, { { u_type::vec4, "attribute" } } });
+        names.at(i) = vao.buffer(handles.at(i)).id();
+    }
+
+    staplegl::vertex_array moved { std::move(vao) };
+    expect(moved.buffers_data().size() == buffers, "every buffer kept");
+    expect(count(mock, gl_call::vertex_attrib_pointer) == buffers, "one attribute per buffer");
+    for (std::size_t i = 0; i < buffers; ++i) {
+        expect(moved.buffer(handles.at(i)).id() == names.at(i), "handles valid after the move");
+    }
+}
+
+// uniform buffer ranges bound through the state cache, only when they change.
+void uniform_ranges()
+{
+    mock_gl mock;
+    scoped_backend const guard { mock };
+
+    staplegl::state_cache cache;
+    cache.bind_uniform_range(2, 7, 256, 64);
+    cache.bind_uniform_range(2, 7, 256, 64);
+    cache.bind_uniform_range(2, 7, 512, 64);
+
+    expect(count(mock, gl_call::bind_buffer_range) == 2, "redundant range filtered");
+    expect(cache.stats().uniform_ranges == 2, "binds counted");
+
+    auto const bind = last(mock, gl_call::bind_buffer_range);
+    expect(bind.arg<std::uint32_t>(1) == 2 && bind.arg<std::uint32_t>(2) == 7, "binding point and buffer");
+    expect(bind.arg<std::int64_t>(3) == 512 && bind.arg<std::int64_t>(4) == 64, "bound range");
+}
+
+// every draw sees the uniform values recorded before it, and only those.
+void command_buffer_order()
+{
+    mock_gl mock;
+    scoped_backend const guard { mock };
+
+    staplegl::draw_packet const packet { .program = 5, .vertex_array = 3, .count = 3 };
+    std::array<float, 4> const first { 1.0F, 2.0F, 3.0F, 4.0F };
+    std::array<float, 4> const second { 5.0F, 6.0F, 7.0F, 8.0F };
+
+    staplegl::command_buffer buffer;
+    buffer.set_uniform(5, 0, u_type::vec4, first);
+    buffer.draw(packet);
+    buffer.set_uniform(5, 0, u_type::vec4, second);
+    buffer.draw(packet);
+    expect(buffer.phase_count() == 2, "an update after a draw starts a phase");
+
+    staplegl::command_queue queue;
+    staplegl::state_cache cache;
+    auto const stats = staplegl::execute_command_buffers(std::span { &buffer, 1 }, queue, cache);
+    expect(stats.packets == 2, "both draws submitted");
+
+    std::vector<float> drawn; // the x component set when each draw is issued.
+    float current {};
+    for (auto const& call : mock.calls()) {
+        if (call.call == gl_call::uniform_4f) {
+            current = call.arg<float>(1);
+        } else if (call.call == gl_call::draw_elements) {
+            drawn.push_back(current);
+        }
+    }
+    expect(drawn == std::vector<float> { 1.0F, 5.0F }, "draws interleaved with their uniforms");
+}
+
+// uniform values shorter than their type, and integer ones.
+void command_buffer_uniforms()
+{
+    mock_gl mock;
+    scoped_backend const guard { mock };
+
+    std::array<float, 3> const partial { 1.0F, 2.0F, 3.0F };
+    staplegl::command_buffer buffer;
+    buffer.set_uniform(5, 1, u_type::mat4, partial);
+    buffer.set_uniform(5, 2, 7);
+
+    staplegl::command_queue queue;
+    staplegl::state_cache cache;
+    staplegl::execute_command_buffers(std::span { &buffer, 1 }, queue, cache);
+
+    std::array<float, 16> matrix {};
+    auto const payload = mock.payload(last(mock, gl_call::uniform_matrix_4fv));
+    expect(payload.size() == sizeof(matrix), "whole matrix uploaded");
+    std::memcpy(matrix.data(), payload.data(), std::min(payload.size(), sizeof(matrix)));
+    expect(matrix[2] == 3.0F && std::ranges::all_of(std::span { matrix }.subspan(3), [](float value) { return value == 0.0F; }),
+        "missing components are zero");
+
+    auto const integer = last(mock, gl_call::uniform_1i);
+    expect(integer.arg<std::int32_t>(0) == 2 && integer.arg<std::int32_t>(1) == 7, "integer uniform");
+}
+
+// data that goes with its draw does not split the buffer.
+void command_buffer_draw_data()
+{
+    mock_gl mock;
+    scoped_backend const guard { mock };
+
+    staplegl::command_buffer buffer;
+    for (std::uint32_t i = 0; i < 4; ++i) {
+        staplegl::draw_packet const packet { .program = 5, .vertex_array = 3, .uniforms = { 0, 9, i * 16, 16 }, .count = 3 };
+        std::array<float, 4> const data { static_cast<float>(i) };
+        buffer.draw(packet, std::span { data });
+    }
+    expect(buffer.phase_count() == 1, "one phase");
+
+    staplegl::command_queue queue;
+    staplegl::state_cache cache;
+    staplegl::execute_command_buffers(std::span { &buffer, 1 }, queue, cache);
+
+    expect(count(mock, gl_call::buffer_sub_data) == 4, "one upload per draw");
+    auto const upload = last(mock, gl_call::buffer_sub_data);
+    expect(upload.arg<std::int64_t>(1) == 48 && upload.arg<std::int64_t>(2) == 16, "upload into the draw's range");
+}
+
+// objects released together are deleted together, queued or not.
+void batched_release()
+{
+    mock_gl mock;
+    scoped_backend const guard { mock };
+
+    std::array<std::uint32_t, 3> names {};
+    glGenQueries(static_cast<std::int32_t>(names.size()), names.data());
+    staplegl::release_objects(staplegl::gl_object::query, names);
+    expect(count(mock, gl_call::delete_queries) == 1 && last(mock, gl_call::delete_queries).arg<std::int32_t>(0) == 3,
+        "one deletion for the batch");
+
+    staplegl::deletion_queue deletions;
+    staplegl::set_deletion_queue(&deletions);
+    staplegl::release_objects(staplegl::gl_object::texture, names);
+    staplegl::release_object(staplegl::gl_object::buffer, names[0]);
+    staplegl::release_object(staplegl::gl_object::buffer, 0);
+    staplegl::set_deletion_queue(nullptr);
+
+    expect(count(mock, gl_call::delete_textures) == 0 && !deletions.empty(), "deletion deferred");
+    expect(deletions.flush() == 4 && deletions.empty(), "every queued name flushed");
+    expect(count(mock, gl_call::delete_textures) == 1 && count(mock, gl_call::delete_buffers) == 1, "one deletion per kind");
+}
+
+// released names are not handed out again, but deleted together on flush.
+void name_pool_release()
+{
+    mock_gl mock;
+    scoped_backend const guard { mock };
+
+    staplegl::name_pools pools;
+    staplegl::deletion_queue deletions;
+    staplegl::set_name_pools(&pools);
+    staplegl::set_deletion_queue(&deletions);
+
+    std::uint32_t buffer {};
+    {
+        std::array<float, 64> const vertices {};
+        staplegl::vertex_buffer const vbo { vertices, staplegl::driver_draw_hint::STATIC_DRAW };
+        buffer = vbo.id();
+    }
+    auto const texture = staplegl::acquire_name(staplegl::gl_object::texture);
+    staplegl::release_object(staplegl::gl_object::texture, texture);
+    deletions.flush();
+
+    expect(count(mock, gl_call::buffer_data) == 1, "buffer storage left untouched on release");
+    expect(staplegl::acquire_name(staplegl::gl_object::buffer) != buffer, "buffer name not handed out again");
+    expect(count(mock, gl_call::delete_buffers) == 1 && count(mock, gl_call::delete_textures) == 1
+            && pools.pool(staplegl::gl_object::buffer)->retired_count() == 0
+            && pools.pool(staplegl::gl_object::texture)->retired_count() == 0,
+        "retired names deleted on flush");
+
+    staplegl::set_deletion_queue(nullptr);
+    staplegl::set_name_pools(nullptr);
+}
+
+// timer queries come from the name pools like the other objects.
+void profiler_queries()
+{
+    mock_gl mock;
+    scoped_backend const guard { mock };
+
+    {
+        staplegl::gpu_profiler profiler;
+        profiler.begin_frame();
+        {
+            auto const scope = profiler.scope("frame");
+        }
+        profiler.end_frame();
+    }
+    expect(count(mock, gl_call::gen_queries) == 1 && last(mock, gl_call::gen_queries).arg<std::int32_t>(0) == 16,
+        "queries generated in one block without pools");
+    expect(count(mock, gl_call::delete_queries) == 1, "queries deleted together");
+
+    staplegl::name_pools pools;
+    staplegl::set_name_pools(&pools);
+    {
+        staplegl::gpu_profiler profiler;
+        profiler.begin_frame();
+        {
+            auto const scope = profiler.scope("frame");
+        }
+        profiler.end_frame();
+    }
+    expect(count(mock, gl_call::gen_queries) == 2
+            && last(mock, gl_call::gen_queries).arg<std::int32_t>(0) == staplegl::name_pool::default_block_size,
+        "queries taken from the pool");
+    expect(pools.pool(staplegl::gl_object::query)->retired_count() == 16, "queries handed back to the pool");
+    staplegl::set_name_pools(nullptr);
+}
+
+// a lod mesh refuses levels past its capacity.
+void lod_levels()
+{
+    staplegl::lod_mesh mesh;
+    for (std::size_t level = 0; level < staplegl::lod_mesh::max_levels; ++level) {
+        expect(mesh.add_level(0, 3, 0.0F) == level, "level added");
+    }
+    expect(!mesh.add_level(0, 3, 0.0F).has_value() && mesh.level_count() == staplegl::lod_mesh::max_levels, "full mesh");
+}
+
+// pixels read back through the pixel buffer ring, failed waits still reach the sink.
+void async_readback()
+{
+    struct failing_gl : mock_gl {
+        auto emulate(call_record const& call) -> std::uint64_t override
+        {
+            return call.call == gl_call::client_wait_sync ? GL_WAIT_FAILED : mock_gl::emulate(call);
+        }
+    };
+
+    std::vector<std::uint64_t> tags;
+    std::vector<std::size_t> sizes;
+    auto const sink = [&](std::uint64_t tag, staplegl::readback_region const& /*region*/, std::span<const std::byte> pixels) {
+        tags.push_back(tag);
+        sizes.push_back(pixels.size());
+    };
+
+    {
+        mock_gl mock;
+        scoped_backend const guard { mock };
+        reset();
+
+        staplegl::async_readback readback { 2 };
+        std::size_t handed {};
+        for (std::uint64_t frame = 0; frame < 3; ++frame) {
+            handed += readback.read({ 0, 0, 4, 2 }, frame, sink);
+        }
+        handed += readback.read({ 0, 0, 0, 0 }, 3, sink);
+        handed += readback.drain(sink);
+
+        expect(handed == 4 && tags == std::vector<std::uint64_t> { 0, 3, 1, 2 }, "every readback handed over once");
+        expect(sizes == std::vector<std::size_t> { 32, 0, 32, 32 }, "pixels of each readback");
+        expect(count(mock, gl_call::read_pixels) == 3 && count(mock, gl_call::fence_sync) == 3
+                && count(mock, gl_call::delete_sync) == 3 && count(mock, gl_call::flush) == 3,
+            "readback calls recorded");
+        expect(frame_counters().read_pixels_bytes == 96, "bytes read back counted");
+
+        staplegl::async_readback target;
+        target.read({ 0, 0, 1, 1 }, 4, sink);
+        target = std::move(readback);
+        expect(count(mock, gl_call::delete_sync) == 3, "fences of the target kept by the moved-from readback");
+    }
+
+    tags.clear();
+    sizes.clear();
+    {
+        failing_gl mock;
+        scoped_backend const guard { mock };
+
+        staplegl::async_readback readback;
+        readback.read({ 0, 0, 4, 4 }, 7, sink);
+        expect(readback.drain(sink) == 1 && tags == std::vector<std::uint64_t> { 7 } && sizes == std::vector<std::size_t> { 0 },
+            "failed readback handed over with no pixels");
+    }
+}
+
+// tiles drawn into the framebuffers of the pool in turn, and all read back.
+void tiled_renderer()
+{
+    mock_gl mock;
+    scoped_backend const guard { mock };
+
+    staplegl::tiled_renderer renderer { { 5000, 3000 }, { 2048, 2048 } };
+    expect(count(mock, gl_call::get_integerv) == 3 && renderer.grid().size() == 6, "tile size within the limits");
+    expect(renderer.targets() == 3 && count(mock, gl_call::gen_framebuffers) == 3, "pool of tile framebuffers");
+
+    std::vector<std::uint32_t> drawn_into;
+    std::vector<std::size_t> tiles;
+    bool sizes = true;
+    renderer.render(
+        [&](staplegl::tile const& /*tile*/, std::array<float, 16> const& /*tile_matrix*/) {
+            drawn_into.push_back(last(mock, gl_call::bind_framebuffer).arg<std::uint32_t>(1));
+        },
+        [&](staplegl::tile const& tile, std::span<const std::byte> pixels) {
+            tiles.push_back(tile.index);
+            sizes = sizes && pixels.size() == static_cast<std::size_t>(tile.width) * static_cast<std::size_t>(tile.height) * 4;
+        });
+
+    expect(tiles == std::vector<std::size_t> { 0, 1, 2, 3, 4, 5 } && sizes, "every tile read back, in order");
+    expect(drawn_into.size() == 6 && drawn_into[0] != drawn_into[1] && drawn_into[1] != drawn_into[2]
+            && drawn_into[0] != drawn_into[2] && drawn_into[3] == drawn_into[0],
+        "framebuffers used in turn");
+}
+
+} // namespace
+
+auto main() -> int
+{
+    static_layout_buffer();
+    vertex_attributes();
+    vertex_format();
+    many_vertex_buffers();
+    uniform_ranges();
+    command_buffer_order();
+    command_buffer_uniforms();
+    command_buffer_draw_data();
+    batched_release();
+    name_pool_release();
+    profiler_queries();
+    lod_levels();
+    async_readback();
+    tiled_renderer();
+
+    if (!failed) {
+        std::puts("instrumentation: all checks passed");
+    }
+    return failed ? 1 : 0;
+}
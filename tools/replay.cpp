@@ -0,0 +1,207 @@
+/**
+ * @file replay.cpp
+ * @author Dario Loi
+ * @brief Headless replayer for staplegl captures, with per-call timing.
+ *
+ * @date 2026-10-17
+ *
+ * @copyright MIT License
+ *
+ * @details Re-executes a capture written by staplegl::instrument::write_capture on a windowless
+ * EGL context (Mesa's llvmpipe is enough) and reports where the time went:
+ *
+ * - the time of the setup (every call before the first frame mark) and of every frame;
+ * - per entry point: number of calls, total, mean and maximum time.
+ *
+ * Usage: `replay <capture> [--loop=<n>] [--sync] [--top=<n>]`
+ *
+ * - `--loop` replays the captured frames n times after the setup (default 1);
+ * - `--sync` waits for the GPU after every call, so that the timings include the GPU work;
+ * - `--top` number of entry points listed, by total time (default 20).
+ *
+ * Draws to the default framebuffer are redirected to an offscreen framebuffer as large as the
+ * first viewport of the capture.
+ */
+
+#include "gl_capture.hpp"
+#include "headless_context.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <numeric>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+using namespace staplegl::instrument;
+using clock_type = std::chrono::steady_clock;
+
+struct call_stats {
+    std::uint64_t calls {};
+    double total_ns {};
+    double max_ns {};
+};
+
+/**
+ * @brief Backend that forwards every call and measures how long it takes.
+ *
+ */
+class call_timer : public gl_backend {
+public:
+    explicit call_timer(bool sync) noexcept
+        : m_sync { sync }
+    {
+    }
+
+    auto dispatch(call_record& call, call_forwarder forward) -> std::uint64_t override
+    {
+        auto const begin = clock_type::now();
+        auto const result = forward();
+        if (m_sync) {
+            glFinish();
+        }
+        double const elapsed = std::chrono::duration<double, std::nano>(clock_type::now() - begin).count();
+
+        auto& stats = m_stats[static_cast<std::size_t>(call.call)];
+        ++stats.calls;
+        stats.total_ns += elapsed;
+        stats.max_ns = std::max(stats.max_ns, elapsed);
+
+        return result;
+    }
+
+    [[nodiscard]] auto stats() const noexcept -> std::array<call_stats, gl_call_count> const& { return m_stats; }
+
+private:
+    std::array<call_stats, gl_call_count> m_stats {};
+    bool m_sync {};
+};
+
+auto make_offscreen_target(std::int32_t width, std::int32_t height) -> std::uint32_t
+{
+    std::uint32_t fbo {};
+    std::array<std::uint32_t, 2> attachments {};
+
+    glGenFramebuffers(1, &fbo);
+    glGenRenderbuffers(2, attachments.data());
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+
+    glBindRenderbuffer(GL_RENDERBUFFER, attachments[0]);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, attachments[0]);
+
+    glBindRenderbuffer(GL_RENDERBUFFER, attachments[1]);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, attachments[1]);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    return fbo;
+}
+
+auto milliseconds_since(clock_type::time_point begin) -> double
+{
+    return std::chrono::duration<double, std::milli>(clock_type::now() - begin).count();
+}
+
+} // namespace
+
+auto main(int argc, char** argv) -> int
+{
+    std::string path;
+    std::size_t loops = 1;
+    std::size_t top = 20;
+    bool sync = false;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string_view const arg { argv[i] }; // NOLINT (pointer-arithmetic)
+        if (arg.starts_with("--loop=")) {
+            loops = std::stoul(std::string { arg.substr(7) });
+        } else if (arg.starts_with("--top=")) {
+            top = std::stoul(std::string { arg.substr(6) });
+        } else if (arg == "--sync") {
+            sync = true;
+        } else if (!arg.starts_with("--")) {
+            path = arg;
+        }
+    }
+
+    if (path.empty()) {
+        std::fprintf(stderr, "usage: %s <capture> [--loop=<n>] [--sync] [--top=<n>]\n", argv[0]); // NOLINT
+        return 1;
+    }
+
+    std::ifstream file { path, std::ios::binary };
+    auto const log = read_capture(file);
+    if (!log.has_value()) {
+        std::fprintf(stderr, "%s: not a valid capture\n", path.c_str());
+        return 1;
+    }
+
+    staplegl::headless_context const context;
+    if (!context.is_valid()) {
+        std::fprintf(stderr, "could not create a headless OpenGL context\n");
+        return 1;
+    }
+
+    // size the offscreen target after the first viewport, like the window the capture was made in.
+    std::int32_t width = 1280;
+    std::int32_t height = 720;
+    auto const viewport = std::find_if(log->calls.begin(), log->calls.end(),
+        [](call_record const& call) { return call.call == gl_call::viewport; });
+    if (viewport != log->calls.end()) {
+        width = std::max(viewport->arg<std::int32_t>(2), 1);
+        height = std::max(viewport->arg<std::int32_t>(3), 1);
+    }
+
+    replayer player;
+    player.set_default_framebuffer(make_offscreen_target(width, height));
+
+    call_timer timer { sync };
+    scoped_backend const guard { timer };
+
+    std::printf("replaying %zu calls, %zu frames, %zu payload bytes on %s (%dx%d)\n", log->calls.size(), // NOLINT
+        log->frame_ends.size(), log->payloads.size(), staplegl::headless_context::renderer(), width, height);
+
+    std::size_t const setup_end = log->frame_ends.empty() ? log->calls.size() : log->frame_ends.front();
+
+    auto begin = clock_type::now();
+    player.replay(*log, 0, setup_end);
+    glFinish();
+    std::printf("setup: %.3f ms\n", milliseconds_since(begin)); // NOLINT
+
+    std::vector<double> frame_ms;
+    for (std::size_t loop = 0; loop < loops; ++loop) {
+        // frame i spans from the end of frame i-1 (the first one starts after the setup).
+        for (std::size_t frame = 1; frame < log->frame_ends.size(); ++frame) {
+            begin = clock_type::now();
+            player.replay(*log, log->frame_ends[frame - 1], log->frame_ends[frame]);
+            glFinish();
+            frame_ms.push_back(milliseconds_since(begin));
+        }
+    }
+
+    if (!frame_ms.empty()) {
+        auto const [min, max] = std::minmax_element(frame_ms.begin(), frame_ms.end());
+        double const mean = std::accumulate(frame_ms.begin(), frame_ms.end(), 0.0) / static_cast<double>(frame_ms.size());
+        std::printf("frames: %zu, min %.3f ms, mean %.3f ms, max %.3f ms\n", frame_ms.size(), *min, mean, *max); // NOLINT
+    }
+
+    std::vector<std::size_t> order(gl_call_count);
+    std::iota(order.begin(), order.end(), 0);
+    auto const& stats = timer.stats();
+    std::sort(order.begin(), order.end(), [&stats](auto lhs, auto rhs) { return stats[lhs].total_ns > stats[rhs].total_ns; });
+
+    std::printf("\n%-36s %10s %12s %12s %12s\n", "function", "calls", "total (ms)", "mean (us)", "max (us)"); // NOLINT
+    for (std::size_t i = 0; i < std::min(top, order.size()) && stats[order[i]].calls != 0; ++i) {
+        auto const& [calls, total_ns, max_ns] = stats[order[i]];
+        auto const function = name(static_cast<gl_call>(order[i]));
+        std::printf("%-36.*s %10llu %12.3f %12.3f %12.3f\n", static_cast<int>(function.size()), function.data(), // NOLINT
+            static_cast<unsigned long long>(calls), total_ns / 1e6, total_ns / static_cast<double>(calls) / 1e3, max_ns / 1e3);
+    }
+
+    return 0;
+}